@@ -0,0 +1,104 @@
+#include <memory.h>
+#include <memory_batch.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * Batch insert benchmark
+ * Replays a history of chat entries into a store once through a loop of
+ * single adds and once through eliza_memory_add_batch, whole and in
+ * chunks, and reports the time to add, search and free the entries.
+ *
+ * Usage: batch_benchmark [entries] [chunk]
+ */
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e3 + (double)ts.tv_nsec / 1e6;
+}
+
+/*
+ * Fill a store from entries, chunk at a time, or one by one for 0
+ * Returns 0 on success, -1 on failure
+ */
+static int run(const char* name, const MemoryEntry* entries, size_t count, size_t chunk) {
+    MemoryStore* store = eliza_memory_create(1024);
+    if (!store) return -1;
+
+    double start = now_ms();
+    for (size_t i = 0; i < count; i += chunk ? chunk : 1) {
+        int result;
+        if (chunk) {
+            result = eliza_memory_add_batch(store, entries + i, count - i < chunk ? count - i : chunk);
+        } else {
+            result = eliza_memory_add_copy(store, &entries[i]);
+        }
+        if (result < 0) {
+            fprintf(stderr, "Add failed\n");
+            eliza_memory_destroy(store);
+            return -1;
+        }
+    }
+    double add_ms = now_ms() - start;
+
+    const char* queries[] = { "project 17", "city 42 in", "user 5 mentioned" };
+    size_t matches = 0;
+    start = now_ms();
+    for (size_t q = 0; q < sizeof(queries) / sizeof(queries[0]); q++) {
+        MemoryEntry** results = eliza_memory_search(store, queries[q], count);
+        for (size_t i = 0; results && results[i]; i++) matches++;
+        free(results);
+    }
+    double search_ms = now_ms() - start;
+
+    MemoryBatchStats stats;
+    eliza_memory_batch_get_stats(store, &stats);
+
+    start = now_ms();
+    eliza_memory_destroy(store);
+    double free_ms = now_ms() - start;
+
+    printf("%-18s %7.0f ms add (%5.2f M entries/s), %5.1f ms search (%zu matches), "
+           "%5.0f ms free, %zu blocks\n",
+           name, add_ms, (double)count / add_ms / 1e3, search_ms, matches, free_ms, stats.blocks);
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    size_t count = argc > 1 ? (size_t)atol(argv[1]) : 1000000;
+    size_t chunk = argc > 2 ? (size_t)atol(argv[2]) : 10000;
+    if (count == 0 || chunk == 0) return 1;
+
+    /* The history to replay, formatted once up front */
+    MemoryEntry* entries = (MemoryEntry*)malloc(count * sizeof(MemoryEntry));
+    char* text = (char*)malloc(count * 96);
+    if (!entries || !text) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    time_t now = time(NULL);
+    for (size_t i = 0; i < count; i++) {
+        char* content = text + i * 96;
+        snprintf(content, 96, "user %zu mentioned project %zu and city %zu in message %zu",
+                 i % 977, i % 331, i % 97, i);
+        entries[i].content = content;
+        entries[i].timestamp = now - (time_t)(count - i);
+        entries[i].importance = 0.5f;
+        entries[i].context = "chat";
+        entries[i].category = "fact";
+    }
+
+    char name[64];
+    snprintf(name, sizeof(name), "batches of %zu:", chunk);
+    int failed = run("per-entry loop:", entries, count, 0) < 0 ||
+                 run("single batch:", entries, count, count) < 0 ||
+                 run(name, entries, count, chunk) < 0;
+
+    free(text);
+    free(entries);
+    return failed ? 1 : 0;
+}
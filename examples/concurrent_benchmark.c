@@ -0,0 +1,231 @@
+#define _GNU_SOURCE
+#include <memory.h>
+#include <memory_concurrent.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * Concurrent store benchmark
+ * Runs reader threads searching while writer threads each add a fixed
+ * number of memories, first against the lock-free concurrent store and
+ * then against a plain store behind a writer-preferring read-write lock.
+ * Reports searches and adds per second, and checks that readers never see
+ * the entry count go backwards or a result that does not match.
+ *
+ * Usage: concurrent_benchmark [readers] [writers] [adds per writer] [prefill]
+ */
+
+#define MAX_RESULTS 1000
+#define QUERY "topic777"
+
+typedef struct {
+    MemoryConcurrentStore* concurrent;
+    MemoryStore* locked;
+    pthread_rwlock_t lock;
+    size_t adds;             /* Adds per writer */
+    atomic_int stop;         /* Set once every writer is done */
+    atomic_size_t next_id;
+} Shared;
+
+typedef struct {
+    Shared* shared;
+    size_t operations;
+    size_t errors;
+} Worker;
+
+/* Content of the id-th memory; one in 1000 matches QUERY */
+static void make_content(size_t id, char* out, size_t len) {
+    snprintf(out, len, "memory %zu about topic%zu from user %zu", id, id % 1000, id % 97);
+}
+
+static double elapsed_seconds(const struct timespec* start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec) + (double)(now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/* Check a result set against the query */
+static size_t count_errors(MemoryEntry** results) {
+    size_t errors = 0;
+    for (size_t i = 0; results[i]; i++) {
+        if (!strstr(results[i]->content, QUERY)) errors++;
+    }
+    return errors;
+}
+
+static void* concurrent_reader(void* arg) {
+    Worker* worker = (Worker*)arg;
+    Shared* shared = worker->shared;
+
+    MemoryReader* reader = eliza_memory_concurrent_reader(shared->concurrent);
+    if (!reader) {
+        worker->errors++;
+        return NULL;
+    }
+
+    size_t last_size = 0;
+    while (!atomic_load_explicit(&shared->stop, memory_order_relaxed)) {
+        MemoryEntry** results = eliza_memory_concurrent_search(reader, QUERY, MAX_RESULTS);
+        if (!results) {
+            worker->errors++;
+            continue;
+        }
+        worker->errors += count_errors(results);
+        free(results);
+
+        size_t size = eliza_memory_concurrent_size(shared->concurrent);
+        if (size < last_size) worker->errors++;
+        last_size = size;
+        worker->operations++;
+    }
+
+    eliza_memory_concurrent_reader_release(reader);
+    return NULL;
+}
+
+static void* concurrent_writer(void* arg) {
+    Worker* worker = (Worker*)arg;
+    Shared* shared = worker->shared;
+    char content[128];
+
+    for (size_t i = 0; i < shared->adds; i++) {
+        make_content(atomic_fetch_add(&shared->next_id, 1), content, sizeof(content));
+        if (eliza_memory_concurrent_add(shared->concurrent, content, 0.5f, NULL, "chat") != 0) {
+            worker->errors++;
+        }
+        worker->operations++;
+    }
+    return NULL;
+}
+
+static void* locked_reader(void* arg) {
+    Worker* worker = (Worker*)arg;
+    Shared* shared = worker->shared;
+
+    while (!atomic_load_explicit(&shared->stop, memory_order_relaxed)) {
+        pthread_rwlock_rdlock(&shared->lock);
+        MemoryEntry** results = eliza_memory_search(shared->locked, QUERY, MAX_RESULTS);
+        if (results) worker->errors += count_errors(results);
+        pthread_rwlock_unlock(&shared->lock);
+
+        if (!results) worker->errors++;
+        free(results);
+        worker->operations++;
+    }
+    return NULL;
+}
+
+static void* locked_writer(void* arg) {
+    Worker* worker = (Worker*)arg;
+    Shared* shared = worker->shared;
+    char content[128];
+
+    for (size_t i = 0; i < shared->adds; i++) {
+        make_content(atomic_fetch_add(&shared->next_id, 1), content, sizeof(content));
+        pthread_rwlock_wrlock(&shared->lock);
+        if (eliza_memory_add(shared->locked, content, 0.5f, NULL, "chat") != 0) worker->errors++;
+        pthread_rwlock_unlock(&shared->lock);
+        worker->operations++;
+    }
+    return NULL;
+}
+
+/* Run readers until the writers are done and print their throughput */
+static void run(const char* label, Shared* shared, size_t readers, size_t writers,
+                void* (*read_main)(void*), void* (*write_main)(void*)) {
+    size_t threads = readers + writers;
+    pthread_t* ids = (pthread_t*)malloc(threads * sizeof(pthread_t));
+    Worker* workers = (Worker*)calloc(threads, sizeof(Worker));
+    if (!ids || !workers) {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    atomic_store(&shared->stop, 0);
+    for (size_t i = 0; i < threads; i++) {
+        workers[i].shared = shared;
+        pthread_create(&ids[i], NULL, i < readers ? read_main : write_main, &workers[i]);
+    }
+
+    for (size_t i = readers; i < threads; i++) pthread_join(ids[i], NULL);
+    atomic_store(&shared->stop, 1);
+    for (size_t i = 0; i < readers; i++) pthread_join(ids[i], NULL);
+    double elapsed = elapsed_seconds(&start);
+
+    size_t searches = 0, adds = 0, errors = 0;
+    for (size_t i = 0; i < threads; i++) {
+        if (i < readers) searches += workers[i].operations;
+        else adds += workers[i].operations;
+        errors += workers[i].errors;
+    }
+
+    printf("%-12s %10.2f %14.0f %14.0f %8zu\n", label, elapsed,
+           (double)searches / elapsed, (double)adds / elapsed, errors);
+
+    free(ids);
+    free(workers);
+}
+
+int main(int argc, char* argv[]) {
+    size_t readers = argc > 1 ? (size_t)atol(argv[1]) : 8;
+    size_t writers = argc > 2 ? (size_t)atol(argv[2]) : 2;
+    size_t adds = argc > 3 ? (size_t)atol(argv[3]) : 50000;
+    size_t prefill = argc > 4 ? (size_t)atol(argv[4]) : 100000;
+
+    if (readers > MEMORY_CONCURRENT_MAX_READERS) readers = MEMORY_CONCURRENT_MAX_READERS;
+
+    Shared shared;
+    memset(&shared, 0, sizeof(shared));
+    shared.adds = adds;
+    shared.concurrent = eliza_memory_concurrent_create();
+    shared.locked = eliza_memory_create(prefill);
+    pthread_rwlockattr_t attr;
+    pthread_rwlockattr_init(&attr);
+#ifdef __GLIBC__
+    /* Otherwise a steady stream of readers starves the writers */
+    pthread_rwlockattr_setkind_np(&attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+#endif
+    pthread_rwlock_init(&shared.lock, &attr);
+    pthread_rwlockattr_destroy(&attr);
+    if (!shared.concurrent || !shared.locked) {
+        fprintf(stderr, "Failed to create memory stores\n");
+        return 1;
+    }
+
+    char content[128];
+    for (size_t i = 0; i < prefill; i++) {
+        make_content(i, content, sizeof(content));
+        eliza_memory_add(shared.locked, content, 0.5f, NULL, "chat");
+    }
+    if (eliza_memory_concurrent_import(shared.concurrent, shared.locked) != 0) {
+        fprintf(stderr, "Failed to fill concurrent store\n");
+        return 1;
+    }
+
+    printf("readers %zu, writers %zu, %zu adds per writer, %zu entries prefilled\n\n",
+           readers, writers, adds, prefill);
+    printf("%-12s %10s %14s %14s %8s\n", "store", "seconds", "searches/s", "adds/s", "errors");
+
+    atomic_store(&shared.next_id, prefill);
+    run("lock-free", &shared, readers, writers, concurrent_reader, concurrent_writer);
+    atomic_store(&shared.next_id, prefill);
+    run("rwlock", &shared, readers, writers, locked_reader, locked_writer);
+
+    MemoryConcurrentStats stats;
+    eliza_memory_concurrent_get_stats(shared.concurrent, &stats);
+    printf("\nconcurrent store: %zu entries, %zu segments, %llu directories retired, %llu reclaimed\n",
+           stats.entries, stats.segments, (unsigned long long)stats.retired,
+           (unsigned long long)stats.reclaimed);
+
+    pthread_rwlock_destroy(&shared.lock);
+    eliza_memory_concurrent_destroy(shared.concurrent);
+    eliza_memory_destroy(shared.locked);
+    return 0;
+}
@@ -0,0 +1,84 @@
+#include <config.h>
+#include <config_cache.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * Configuration cache benchmark
+ * Generates a configuration with a section per channel, then compares
+ * parsing it with loading it through its cached image, and reads a
+ * nested value from each.
+ *
+ * Usage: config_cache_benchmark [channels] [rounds]
+ */
+
+static double now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e6 + (double)ts.tv_nsec / 1e3;
+}
+
+int main(int argc, char* argv[]) {
+    size_t channels = argc > 1 ? (size_t)atol(argv[1]) : 20000;
+    int rounds = argc > 2 ? atoi(argv[2]) : 20;
+    if (channels == 0 || rounds <= 0) return 1;
+
+    const char* source = "config_cache_benchmark.conf";
+    const char* image = "config_cache_benchmark.img";
+    FILE* file = fopen(source, "w");
+    if (!file) {
+        fprintf(stderr, "Cannot write %s\n", source);
+        return 1;
+    }
+    fprintf(file, "name = eliza\n");
+    for (size_t i = 0; i < channels; i++) {
+        fprintf(file, "channel_%zu {\n    persona = helpful assistant %zu\n    temperature = 0.%zu\n"
+                      "    max_tokens = %zu\n    enabled = true\n    backend {\n        timeout = %zu\n"
+                      "    }\n}\n", i, i, i % 10, 256 + i % 1024, 30 + i % 60);
+    }
+    fclose(file);
+    unlink(image);
+
+    char path[64];
+    snprintf(path, sizeof(path), "channel_%zu.backend.timeout", channels / 2);
+    long checksum = 0;
+
+    double start = now_us();
+    for (int r = 0; r < rounds; r++) {
+        ConfigObject* config = eliza_config_parse_file(source);
+        if (!config) return 1;
+        checksum += eliza_config_get_path(config, path)->value.int_val;
+        eliza_config_destroy(config);
+    }
+    double parse_us = (now_us() - start) / rounds;
+
+    start = now_us();
+    ConfigCache* cache = eliza_config_cache_load(source, image);
+    double build_us = now_us() - start;
+    if (!cache) return 1;
+    eliza_config_cache_close(cache);
+
+    start = now_us();
+    for (int r = 0; r < rounds; r++) {
+        cache = eliza_config_cache_load(source, image);
+        if (!cache || cache->origin != CONFIG_CACHE_MAPPED) {
+            fprintf(stderr, "Image was not reused\n");
+            return 1;
+        }
+        checksum += eliza_config_get_path(cache->config, path)->value.int_val;
+        eliza_config_cache_close(cache);
+    }
+    double mapped_us = (now_us() - start) / rounds;
+
+    printf("%zu channels\n", channels);
+    printf("parse:             %10.1f us\n", parse_us);
+    printf("parse and cache:   %10.1f us\n", build_us);
+    printf("mapped image:      %10.1f us (%.0fx faster, checksum %ld)\n",
+           mapped_us, parse_us / mapped_us, checksum);
+
+    unlink(source);
+    unlink(image);
+    return 0;
+}
@@ -0,0 +1,95 @@
+#include <memory.h>
+#include <memory_dedup.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * Deduplication benchmark
+ * Feeds the same stream of agent facts to a plain store and to one with
+ * deduplication. Most facts are restated several times with different
+ * casing, punctuation or spacing, the way a chat agent records them.
+ * Reports the duplicate rate, the bytes not stored and the cost per add.
+ *
+ * Usage: dedup_benchmark [adds] [distinct facts]
+ */
+
+static const char* const subjects[] = {
+    "the user", "user's sister", "the team lead", "their landlord", "the new intern",
+};
+
+static const char* const facts[] = {
+    "prefers vegetarian food and dislikes mushrooms",
+    "is flying to Lisbon on the %zuth for a conference",
+    "asked to be reminded about invoice %zu before Friday",
+    "moved the weekly sync to Thursday at %zu pm",
+    "is allergic to peanuts and carries an epipen",
+    "wants the report %zu formatted as a PDF with page numbers",
+};
+
+/*
+ * Write one restatement of fact number id
+ */
+static void restate(char* out, size_t size, size_t id, unsigned int variant) {
+    char fact[160];
+    snprintf(fact, sizeof(fact), facts[id % 6], id / 30 + 2);
+    int n = snprintf(out, size, "%s%s %s%s", variant & 1 ? "Note: " : "",
+                     subjects[(id / 6) % 5], fact, variant & 2 ? "." : "");
+
+    /* Case and spacing vary between restatements */
+    if (variant & 4 && n > 0) out[0] = (char)(out[0] >= 'a' && out[0] <= 'z' ? out[0] - 32 : out[0]);
+    if (variant & 8) {
+        char* space = strchr(out, ' ');
+        if (space && (size_t)n + 1 < size) {
+            memmove(space + 1, space, strlen(space) + 1);
+        }
+    }
+}
+
+static double run(MemoryStore* store, size_t adds, size_t distinct) {
+    char content[256];
+    struct timespec start, end;
+
+    srand(7);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (size_t i = 0; i < adds; i++) {
+        size_t id = (size_t)rand() % distinct;
+        restate(content, sizeof(content), id, (unsigned int)rand());
+        eliza_memory_add(store, content, 0.4f, "chat", "fact");
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    return ((double)(end.tv_sec - start.tv_sec) * 1e9 + (double)(end.tv_nsec - start.tv_nsec)) / (double)adds;
+}
+
+int main(int argc, char* argv[]) {
+    size_t adds = argc > 1 ? (size_t)atol(argv[1]) : 200000;
+    size_t distinct = argc > 2 ? (size_t)atol(argv[2]) : 20000;
+
+    MemoryStore* plain = eliza_memory_create(1024);
+    MemoryStore* dedup = eliza_memory_create(1024);
+    MemoryDedupOptions options;
+    eliza_memory_dedup_options_default(&options);
+    if (!plain || !dedup || eliza_memory_enable_dedup(dedup, &options) < 0) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    double plain_ns = run(plain, adds, distinct);
+    double dedup_ns = run(dedup, adds, distinct);
+
+    MemoryDedupStats stats;
+    eliza_memory_dedup_get_stats(dedup, &stats);
+    printf("%zu adds of %zu distinct facts\n", adds, distinct);
+    printf("plain store:  %zu entries, %.0f ns/add\n", plain->size, plain_ns);
+    printf("dedup store:  %zu entries, %.0f ns/add\n", dedup->size, dedup_ns);
+    printf("  duplicate rate %.1f%% (%llu merged, %llu rejected)\n", stats.rate * 100.0,
+           (unsigned long long)stats.merged, (unsigned long long)stats.rejected);
+    printf("  %.1f MB of entries not stored, %.2f signatures compared per add\n",
+           (double)stats.bytes_saved / 1e6, (double)stats.candidates / (double)stats.checked);
+
+    eliza_memory_destroy(plain);
+    eliza_memory_destroy(dedup);
+    return 0;
+}
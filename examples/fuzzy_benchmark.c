@@ -0,0 +1,86 @@
+#include <memory.h>
+#include <memory_fuzzy.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * Fuzzy search benchmark
+ * Searches chat-like entries for misspelled names, once through the
+ * trigram index and once by running the edit distance over every entry,
+ * and reports the time per query and how many entries each one verified.
+ *
+ * Usage: fuzzy_benchmark [entries] [queries]
+ */
+
+static const char* const names[] = {
+    "Jonathan", "Katherine", "Mohammed", "Aleksandr", "Philadelphia", "Guadalajara",
+    "Christopher", "Bartholomew", "Anastasia", "Wolfgang", "Saskatchewan", "Reykjavik",
+};
+
+static const char* const typos[] = {
+    "Jonathon", "Katharine", "Mohamed", "Alexandr", "Philadelfia", "Guadalahara",
+    "Cristopher", "Bartolomew", "Anastacia", "Wolfgan", "Saskatchewen", "Reykjavick",
+};
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e3 + (double)ts.tv_nsec / 1e6;
+}
+
+int main(int argc, char* argv[]) {
+    size_t entries = argc > 1 ? (size_t)atol(argv[1]) : 200000;
+    size_t queries = argc > 2 ? (size_t)atol(argv[2]) : 240;
+
+    MemoryStore* store = eliza_memory_create(1024);
+    if (!store || eliza_memory_enable_fuzzy(store) < 0) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    char content[200];
+    srand(11);
+    double start = now_ms();
+    for (size_t i = 0; i < entries; i++) {
+        snprintf(content, sizeof(content), "talked with %s about order %d and the %s trip on day %zu",
+                 names[rand() % 12], rand() % 100000, names[rand() % 12], i % 365);
+        eliza_memory_add(store, content, 0.5f, "chat", NULL);
+    }
+    printf("%zu entries indexed in %.0f ms\n", entries, now_ms() - start);
+
+    size_t capacity = entries;
+    MemoryFuzzyMatch* results = (MemoryFuzzyMatch*)malloc(capacity * sizeof(MemoryFuzzyMatch));
+    if (!results) return 1;
+
+    MemoryFuzzyStats before, after;
+    eliza_memory_fuzzy_get_stats(store, &before);
+    size_t indexed_matches = 0;
+    start = now_ms();
+    for (size_t q = 0; q < queries; q++) {
+        indexed_matches += eliza_memory_search_fuzzy(store, typos[q % 12], 1, results, capacity);
+    }
+    double indexed_ms = (now_ms() - start) / (double)queries;
+    eliza_memory_fuzzy_get_stats(store, &after);
+
+    size_t scan_matches = 0;
+    size_t scan_queries = queries < 12 ? queries : 12;
+    start = now_ms();
+    for (size_t q = 0; q < scan_queries; q++) {
+        for (size_t i = 0; i < store->size; i++) {
+            if (eliza_memory_fuzzy_distance(typos[q % 12], store->entries[i]->content) <= 1) scan_matches++;
+        }
+    }
+    double scan_ms = (now_ms() - start) / (double)scan_queries;
+
+    printf("trigram index: %.2f ms/query, %.0f matches, %.0f verified per query\n",
+           indexed_ms, (double)indexed_matches / (double)queries,
+           (double)(after.verified - before.verified) / (double)queries);
+    printf("full scan:     %.2f ms/query, %.0f matches, %zu verified per query\n",
+           scan_ms, (double)scan_matches / (double)scan_queries, store->size);
+
+    free(results);
+    eliza_memory_destroy(store);
+    return 0;
+}
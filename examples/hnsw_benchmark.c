@@ -0,0 +1,132 @@
+#include <memory.h>
+#include <memory_vector.h>
+#include <memory_hnsw.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * HNSW benchmark
+ * Fills a memory store with clustered random embeddings, then compares
+ * approximate recall through the HNSW index against the exact vector scan.
+ * For each ef it reports recall@k (share of the exact top k found) and
+ * queries per second.
+ *
+ * Usage: hnsw_benchmark [entries] [dim] [queries] [m]
+ */
+
+#define TOP_K 10
+#define CLUSTERS 256
+
+/* Uniform float in [-1, 1) */
+static float random_unit(void) {
+    return (float)rand() / ((float)RAND_MAX + 1.0f) * 2.0f - 1.0f;
+}
+
+/* A point near a random cluster center */
+static void random_point(const float* centers, size_t dim, float* out) {
+    const float* center = centers + (size_t)(rand() % CLUSTERS) * dim;
+    for (size_t d = 0; d < dim; d++) out[d] = center[d] + 0.35f * random_unit();
+}
+
+static double elapsed_seconds(const struct timespec* start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec) + (double)(now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+int main(int argc, char* argv[]) {
+    size_t entries = argc > 1 ? (size_t)atol(argv[1]) : 100000;
+    size_t dim = argc > 2 ? (size_t)atol(argv[2]) : 128;
+    size_t queries = argc > 3 ? (size_t)atol(argv[3]) : 1000;
+
+    MemoryHnswOptions options;
+    eliza_memory_hnsw_options_default(&options);
+    if (argc > 4) options.m = (size_t)atol(argv[4]);
+
+    MemoryStore* store = eliza_memory_create(entries);
+    if (!store ||
+        eliza_memory_enable_vectors(store, dim, MEMORY_VECTOR_FLOAT32, NULL, NULL) != 0 ||
+        eliza_memory_enable_hnsw(store, dim, &options) != 0) {
+        fprintf(stderr, "Failed to create memory store\n");
+        return 1;
+    }
+
+    float* centers = (float*)malloc(CLUSTERS * dim * sizeof(float));
+    float* vector = (float*)malloc(dim * sizeof(float));
+    float* query_vectors = (float*)malloc(queries * dim * sizeof(float));
+    MemoryRankedResult* exact = (MemoryRankedResult*)malloc(queries * TOP_K * sizeof(MemoryRankedResult));
+    MemoryRankedResult results[TOP_K];
+    if (!centers || !vector || !query_vectors || !exact) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    srand(42);
+    for (size_t i = 0; i < CLUSTERS * dim; i++) centers[i] = random_unit();
+
+    /* Build */
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (size_t i = 0; i < entries; i++) {
+        char content[32];
+        snprintf(content, sizeof(content), "memory %zu", i);
+        random_point(centers, dim, vector);
+        if (eliza_memory_add_vector(store, content, 0.5f, NULL, NULL, vector) != 0) {
+            fprintf(stderr, "Failed to add entry %zu\n", i);
+            return 1;
+        }
+    }
+    double build = elapsed_seconds(&start);
+    printf("entries %zu, dim %zu, M %zu, ef_construction %zu\n",
+           entries, dim, options.m, options.ef_construction);
+    printf("build: %.2f s (%.0f inserts/s)\n\n", build, (double)entries / build);
+
+    /* Exact answers */
+    for (size_t q = 0; q < queries; q++) random_point(centers, dim, query_vectors + q * dim);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (size_t q = 0; q < queries; q++) {
+        eliza_memory_search_similar(store, query_vectors + q * dim, exact + q * TOP_K, TOP_K);
+    }
+    double scan = elapsed_seconds(&start);
+
+    printf("%-10s %10s %12s\n", "search", "recall@10", "QPS");
+    printf("%-10s %10.4f %12.0f\n", "exact", 1.0, (double)queries / scan);
+
+    /* Approximate answers at increasing effort */
+    static const size_t efs[] = { 10, 16, 32, 64, 128, 256, 512 };
+    for (size_t e = 0; e < sizeof(efs) / sizeof(efs[0]); e++) {
+        eliza_memory_hnsw_set_ef(store->hnsw, efs[e]);
+
+        size_t hits = 0;
+        double total = 0.0;
+        for (size_t q = 0; q < queries; q++) {
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            size_t found = eliza_memory_search_hnsw(store, query_vectors + q * dim, results, TOP_K);
+            total += elapsed_seconds(&start);
+
+            for (size_t i = 0; i < found; i++) {
+                for (size_t j = 0; j < TOP_K; j++) {
+                    if (results[i].entry == exact[q * TOP_K + j].entry) {
+                        hits++;
+                        break;
+                    }
+                }
+            }
+        }
+
+        char label[16];
+        snprintf(label, sizeof(label), "ef=%zu", efs[e]);
+        printf("%-10s %10.4f %12.0f\n", label,
+               (double)hits / (double)(queries * TOP_K), (double)queries / total);
+    }
+
+    free(centers);
+    free(vector);
+    free(query_vectors);
+    free(exact);
+    eliza_memory_destroy(store);
+    return 0;
+}
@@ -0,0 +1,71 @@
+#include <memory.h>
+#include <memory_load.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/*
+ * Text loader benchmark
+ * Saves a store of chat-like entries, then loads the file back with a
+ * single parser and with one parser per CPU. Every load must bring back
+ * every entry.
+ *
+ * Usage: load_benchmark [entries] [path]
+ */
+
+static int load(const char* path, size_t threads, size_t entries) {
+    MemoryStore* store = eliza_memory_create(16);
+    if (!store) return -1;
+
+    MemoryLoadOptions options;
+    eliza_memory_load_options_default(&options);
+    options.threads = threads;
+
+    MemoryLoadStats stats;
+    int result = eliza_memory_load_text(store, path, &options, &stats);
+    if (result == 0 && stats.entries != entries) result = -1;
+
+    printf("%2zu parser threads: %9.1f ms, %zu chunks, %.1f MB/s\n",
+           stats.threads, stats.elapsed_ms, stats.chunks,
+           (double)stats.bytes / 1e3 / stats.elapsed_ms);
+    eliza_memory_destroy(store);
+    return result;
+}
+
+int main(int argc, char* argv[]) {
+    size_t entries = argc > 1 ? (size_t)atol(argv[1]) : 1000000;
+    const char* path = argc > 2 ? argv[2] : "load_benchmark.mem";
+
+    MemoryStore* store = eliza_memory_create(entries);
+    if (!store) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    char content[160];
+    for (size_t i = 0; i < entries; i++) {
+        snprintf(content, sizeof(content),
+                 "user %zu asked about order %zu: delivery window moved to %zu:00, follow up tomorrow",
+                 i % 5000, i, 8 + i % 10);
+        if (eliza_memory_add(store, content, (float)(i % 100) / 100.0f,
+                             i % 2 ? "support" : "sales", i % 3 ? "message" : "fact") < 0) {
+            fprintf(stderr, "Add failed\n");
+            return 1;
+        }
+    }
+    if (eliza_memory_save(store, path) < 0) {
+        fprintf(stderr, "Save failed\n");
+        return 1;
+    }
+    eliza_memory_destroy(store);
+    printf("%zu entries\n", entries);
+
+    int result = load(path, 1, entries);
+    if (result == 0) result = load(path, 0, entries);
+
+    remove(path);
+    if (result < 0) {
+        fprintf(stderr, "Load failed\n");
+        return 1;
+    }
+    return 0;
+}
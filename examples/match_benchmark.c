@@ -0,0 +1,132 @@
+#define _GNU_SOURCE
+#include <memory.h>
+#include <memory_match.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * Substring matcher benchmark
+ * Builds a corpus of chat-like messages and counts the messages containing
+ * each of a set of typical queries, once with strstr and once with a
+ * compiled matcher, then the same case-insensitively against strcasestr.
+ * Counts must agree; times are per message scanned.
+ *
+ * Usage: match_benchmark [messages] [rounds]
+ */
+
+static const char* const names[] = {
+    "alice", "Bob", "carol", "Dave", "eve", "Mallory", "trent", "Peggy", "victor", "Walter"
+};
+
+static const char* const templates[] = {
+    "hey %s, are we still on for lunch tomorrow? I was thinking pizza again",
+    "%s said the deploy broke staging last night, can someone take a look",
+    "lol %s that meme is amazing",
+    "Reminder: the weekly sync with %s moved to Thursday at 3pm, same room as before",
+    "thanks %s! I'll send over the notes from the meeting in a bit",
+    "Has anyone tried the new ramen place near the office? %s recommended it",
+    "%s: I pushed a fix for the websocket reconnect bug, it should retry with backoff now "
+        "instead of hammering the gateway every 100ms like it did before",
+    "good morning everyone",
+    "Can you remind me what %s's birthday is? I want to get a present this week",
+    "ok",
+    "%s is flying to New York next Monday and will be back on the 21st",
+    "I think the issue is that the cache never expires entries, so memory just keeps growing "
+        "until the process gets killed; %s saw the same thing on the other cluster",
+};
+
+static const char* const queries[] = {
+    "pizza", "New York", "the", "reconnect", "birthday", "deploy broke", "xylophone", "ok", "Mallory",
+};
+
+static double elapsed_seconds(const struct timespec* start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec) + (double)(now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+int main(int argc, char* argv[]) {
+    size_t messages = argc > 1 ? (size_t)atol(argv[1]) : 200000;
+    size_t rounds = argc > 2 ? (size_t)atol(argv[2]) : 5;
+
+    char** corpus = (char**)malloc(messages * sizeof(char*));
+    if (!corpus) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    srand(42);
+    size_t bytes = 0;
+    for (size_t i = 0; i < messages; i++) {
+        char text[512];
+        const char* name = names[rand() % (int)(sizeof(names) / sizeof(names[0]))];
+        snprintf(text, sizeof(text), templates[rand() % (int)(sizeof(templates) / sizeof(templates[0]))], name);
+        corpus[i] = strdup(text);
+        bytes += strlen(text);
+    }
+    printf("%zu messages, %.1f bytes on average, %zu rounds\n\n", messages, (double)bytes / (double)messages, rounds);
+    printf("%-14s %8s %12s %12s %12s %12s %8s\n", "query", "matches",
+           "strstr ns", "matcher ns", "strcasestr", "nocase ns", "errors");
+
+    double total_libc = 0.0, total_matcher = 0.0, total_libc_nocase = 0.0, total_nocase = 0.0;
+    for (size_t q = 0; q < sizeof(queries) / sizeof(queries[0]); q++) {
+        const char* query = queries[q];
+        MemoryMatcher matcher, nocase;
+        if (eliza_memory_matcher_init(&matcher, query, 0) != 0 ||
+            eliza_memory_matcher_init(&nocase, query, MEMORY_MATCH_IGNORE_CASE) != 0) {
+            fprintf(stderr, "Failed to compile query\n");
+            return 1;
+        }
+
+        size_t counts[4] = { 0, 0, 0, 0 };
+        double times[4];
+        struct timespec start;
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (size_t r = 0; r < rounds; r++) {
+            for (size_t i = 0; i < messages; i++) counts[0] += strstr(corpus[i], query) != NULL;
+        }
+        times[0] = elapsed_seconds(&start);
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (size_t r = 0; r < rounds; r++) {
+            for (size_t i = 0; i < messages; i++) counts[1] += (size_t)eliza_memory_matcher_contains(&matcher, corpus[i]);
+        }
+        times[1] = elapsed_seconds(&start);
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (size_t r = 0; r < rounds; r++) {
+            for (size_t i = 0; i < messages; i++) counts[2] += strcasestr(corpus[i], query) != NULL;
+        }
+        times[2] = elapsed_seconds(&start);
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (size_t r = 0; r < rounds; r++) {
+            for (size_t i = 0; i < messages; i++) counts[3] += (size_t)eliza_memory_matcher_contains(&nocase, corpus[i]);
+        }
+        times[3] = elapsed_seconds(&start);
+
+        double scans = (double)(messages * rounds);
+        int errors = (counts[0] != counts[1]) + (counts[2] != counts[3]);
+        printf("%-14s %8zu %12.1f %12.1f %12.1f %12.1f %8d\n", query, counts[0] / rounds,
+               times[0] / scans * 1e9, times[1] / scans * 1e9,
+               times[2] / scans * 1e9, times[3] / scans * 1e9, errors);
+
+        total_libc += times[0];
+        total_matcher += times[1];
+        total_libc_nocase += times[2];
+        total_nocase += times[3];
+
+        eliza_memory_matcher_destroy(&matcher);
+        eliza_memory_matcher_destroy(&nocase);
+    }
+
+    printf("\nspeedup: %.2fx over strstr, %.2fx over strcasestr\n",
+           total_libc / total_matcher, total_libc_nocase / total_nocase);
+
+    for (size_t i = 0; i < messages; i++) free(corpus[i]);
+    free(corpus);
+    return 0;
+}
@@ -0,0 +1,108 @@
+#include <memory.h>
+#include <memory_snapshot.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * Background save benchmark
+ * Fills a store, then checkpoints it twice while adding new entries: once
+ * with eliza_memory_save, which blocks the adds for the whole write, and
+ * once with a saver, which blocks them only for the snapshot. Reports how
+ * long the caller was blocked by each checkpoint, how many adds got
+ * through while the file was being written and the slowest of them (index
+ * growth included).
+ *
+ * Usage: snapshot_benchmark [entries] [path]
+ */
+
+static double now_ms(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec * 1e3 + (double)now.tv_nsec / 1e6;
+}
+
+static int add_one(MemoryStore* store, size_t i, double* worst_ms) {
+    char content[96];
+    snprintf(content, sizeof(content), "note %zu: follow up with user %zu about topic %zu",
+             i, i % 1000, i % 37);
+
+    double start = now_ms();
+    int result = eliza_memory_add(store, content, 0.5f, "chat", i % 4 ? "message" : "fact");
+    double stall = now_ms() - start;
+    if (stall > *worst_ms) *worst_ms = stall;
+    return result;
+}
+
+int main(int argc, char* argv[]) {
+    size_t entries = argc > 1 ? (size_t)atol(argv[1]) : 1000000;
+    const char* path = argc > 2 ? argv[2] : "snapshot_benchmark.mem";
+
+    MemoryStore* store = eliza_memory_create(1024);
+    if (!store) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    double worst_fill = 0.0;
+    for (size_t i = 0; i < entries; i++) {
+        if (add_one(store, i, &worst_fill) < 0) {
+            fprintf(stderr, "Add failed\n");
+            return 1;
+        }
+    }
+    printf("%zu entries\n", entries);
+
+    /* Blocking save: adds wait behind the whole write */
+    double start = now_ms();
+    if (eliza_memory_save(store, path) < 0) {
+        fprintf(stderr, "Save failed\n");
+        return 1;
+    }
+    printf("blocking save:   caller blocked %10.3f ms\n", now_ms() - start);
+
+    /* Background save: adds keep going while the saver writes */
+    MemorySaver* saver = eliza_memory_saver_create(store);
+    if (!saver) {
+        fprintf(stderr, "Could not start saver\n");
+        return 1;
+    }
+
+    double worst = 0.0;
+    start = now_ms();
+    if (eliza_memory_saver_save(saver, path) < 0) {
+        fprintf(stderr, "Snapshot failed\n");
+        return 1;
+    }
+    double blocked = now_ms() - start;
+
+    size_t added = 0;
+    MemorySaverStats stats;
+    for (;;) {
+        add_one(store, entries + added, &worst);
+        added++;
+
+        eliza_memory_saver_get_stats(saver, &stats);
+        if (stats.saves + stats.failures > 0) break;
+    }
+    if (eliza_memory_saver_wait(saver) < 0) {
+        fprintf(stderr, "Background save failed\n");
+        return 1;
+    }
+
+    eliza_memory_saver_get_stats(saver, &stats);
+    printf("background save: caller blocked %10.3f ms\n", blocked);
+    printf("  %zu adds during the write, slowest %.2f ms\n", added, worst);
+    printf("  snapshot %.1f us, write %.2f ms, %llu bytes, %llu entries\n",
+           stats.last_freeze_us, stats.last_duration_ms,
+           (unsigned long long)stats.last_bytes, (unsigned long long)stats.last_entries);
+    printf("  %llu array copies, %llu entry copies, %llu deferred frees\n",
+           (unsigned long long)stats.array_copies, (unsigned long long)stats.entry_copies,
+           (unsigned long long)stats.deferred);
+
+    eliza_memory_saver_destroy(saver);
+    eliza_memory_destroy(store);
+    remove(path);
+    return 0;
+}
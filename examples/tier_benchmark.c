@@ -0,0 +1,112 @@
+#include <memory.h>
+#include <memory_tier.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * Tiered memory benchmark
+ * Adds a history of entries, most of them old enough to go cold, to a
+ * store that keeps a fraction of them in RAM. Then repeats a set of
+ * searches so the first pass reads the cold segments from disk and later
+ * passes find their blocks in the cache, reporting the cost of each.
+ * Runs with plain segments, compressed ones and compressed ones held in
+ * RAM, so a cache smaller than the cold strings shows the decode cost.
+ *
+ * Usage: tier_benchmark [directory] [entries] [max hot entries] [cache MB]
+ */
+
+static double elapsed_ms(const struct timespec* start) {
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (double)(end.tv_sec - start->tv_sec) * 1e3 + (double)(end.tv_nsec - start->tv_nsec) / 1e6;
+}
+
+/*
+ * Fill a tiered store in directory and search it, returning 0 on success
+ */
+static int run(const char* directory, size_t entries, size_t max_hot, size_t cache_mb,
+               int compress, int resident) {
+    MemoryTierOptions options;
+    eliza_memory_tier_options_default(&options);
+    options.directory = directory;
+    options.max_hot_entries = max_hot;
+    options.cache_bytes = cache_mb * 1024 * 1024;
+    options.compress = compress;
+    options.resident = resident;
+
+    MemoryStore* store = eliza_memory_create(1024);
+    if (!store || eliza_memory_enable_tier(store, &options) < 0) {
+        fprintf(stderr, "Cannot open tier directory %s\n", directory);
+        return -1;
+    }
+
+    /* Nine in ten entries are a day old, the rest arrive now */
+    char content[160];
+    time_t now = time(NULL);
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (size_t i = 0; i < entries; i++) {
+        snprintf(content, sizeof(content), "user %zu mentioned project %zu and city %zu in message %zu",
+                 i % 977, i % 331, i % 97, i);
+        MemoryEntry entry = { content, i % 10 == 0 ? now : now - 86400, 0.5f, "chat", "fact" };
+        if (eliza_memory_add_copy(store, &entry) < 0) {
+            fprintf(stderr, "Add failed\n");
+            return -1;
+        }
+    }
+    double add_ms = elapsed_ms(&start);
+
+    MemoryTierStats stats;
+    eliza_memory_tier_get_stats(store, &stats);
+    printf("%s%s segments:\n", compress ? "compressed" : "plain", resident ? ", resident" : "");
+    printf("  %zu adds in %.0f ms: %zu hot, %zu cold in %zu segments\n",
+           entries, add_ms, stats.hot_entries, stats.cold_entries, stats.segments);
+    printf("  %.1f MB of cold strings stored in %.1f MB (ratio %.2f), %.1f MB resident\n",
+           (double)stats.raw_bytes / 1e6, (double)stats.stored_bytes / 1e6,
+           stats.compression_ratio, (double)stats.resident_bytes / 1e6);
+
+    const char* queries[] = { "project 17 ", "city 42 ", "user 5 mentioned", "message 12345" };
+    for (int pass = 0; pass < 3; pass++) {
+        MemoryTierStats before;
+        eliza_memory_tier_get_stats(store, &before);
+
+        size_t matches = 0;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (size_t q = 0; q < sizeof(queries) / sizeof(queries[0]); q++) {
+            MemoryEntry** results = eliza_memory_search(store, queries[q], 100000);
+            for (size_t i = 0; results && results[i]; i++) matches++;
+            free(results);
+        }
+        double search_ms = elapsed_ms(&start);
+
+        eliza_memory_tier_get_stats(store, &stats);
+        printf("  pass %d: %zu matches in %.1f ms, %llu blocks filled, %.1f ms decoding\n",
+               pass + 1, matches, search_ms,
+               (unsigned long long)(stats.cache.misses - before.cache.misses),
+               (double)(stats.decode_ns - before.decode_ns) / 1e6);
+    }
+    printf("  hit rate %.1f%%, %llu evictions, decode %.0f MB/s\n", stats.hit_rate * 100.0,
+           (unsigned long long)stats.cache.evictions, stats.decode_mb_per_s);
+
+    eliza_memory_destroy(store);
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    const char* directory = argc > 1 ? argv[1] : "tier_benchmark.d";
+    size_t entries = argc > 2 ? (size_t)atol(argv[2]) : 500000;
+    size_t max_hot = argc > 3 ? (size_t)atol(argv[3]) : 50000;
+    size_t cache_mb = argc > 4 ? (size_t)atol(argv[4]) : 64;
+
+    /* Each layout gets its own directory so the runs do not share segments */
+    char path[4096];
+    snprintf(path, sizeof(path), "%s-plain", directory);
+    if (run(path, entries, max_hot, cache_mb, 0, 0) < 0) return 1;
+    snprintf(path, sizeof(path), "%s-compressed", directory);
+    if (run(path, entries, max_hot, cache_mb, 1, 0) < 0) return 1;
+    snprintf(path, sizeof(path), "%s-resident", directory);
+    if (run(path, entries, max_hot, cache_mb, 1, 1) < 0) return 1;
+    return 0;
+}
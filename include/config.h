@@ -2,6 +2,7 @@
 #define ELIZA_CONFIG_H
 
 #include <stddef.h>
+#include <stdint.h>
 
 /*
  * Configuration System
@@ -36,15 +37,36 @@ typedef struct {
 
 /*
  * Configuration object structure
- * Holds key-value pairs
+ * Holds key-value pairs in insertion order, indexed by an open-addressing
+ * hash table of their keys
  */
 typedef struct ConfigObject {
     char** keys;
     ConfigValue* values;
     size_t size;
     size_t capacity;
+    uint32_t* hashes;        /* Hash of each key */
+    uint32_t* slots;         /* Key index + 1 per slot, 0 when empty */
+    size_t slot_count;       /* Always a power of two */
 } ConfigObject;
 
+/*
+ * Configuration key handle
+ * A key looked up once in an object. Keys are never removed, so the
+ * handle stays valid for the life of the object and reads its value
+ * without hashing. A handle resolved from a dotted path points into a
+ * nested section and stays valid until a section on the path is set
+ * again. The fields are private.
+ */
+typedef struct {
+    const struct ConfigObject* root;   /* Object the key was resolved from */
+    const struct ConfigObject* object; /* Section holding the key */
+    size_t index;            /* Position of the key, CONFIG_KEY_NONE if missing */
+} ConfigKey;
+
+/* Index of a handle whose key was not found */
+#define CONFIG_KEY_NONE ((size_t)-1)
+
 /*
  * Function Declarations
  */
@@ -55,12 +77,34 @@ ConfigObject* eliza_config_create(void);
 /* Destroy a configuration object */
 void eliza_config_destroy(ConfigObject* config);
 
-/* Parse a configuration file */
+/* Parse a configuration file. The file is mapped and parsed in one pass
+ * with no limit on line length or section depth. A section opened twice
+ * in the same scope is merged. Returns NULL if it cannot be read. */
 ConfigObject* eliza_config_parse_file(const char* filepath);
 
+/* Parse configuration text of length bytes, as eliza_config_parse_file
+ * does; the text need not be terminated */
+ConfigObject* eliza_config_parse_buffer(const char* text, size_t length);
+
 /* Get a value from the configuration */
 ConfigValue* eliza_config_get(ConfigObject* config, const char* key);
 
+/* Resolve a key once for later reads with eliza_config_get_key. A key
+ * missing from config gives a handle that reads as missing. */
+ConfigKey eliza_config_resolve(const ConfigObject* config, const char* key);
+
+/* Get the value of a resolved key in O(1). Returns NULL if the key was
+ * missing or the handle belongs to another object. */
+ConfigValue* eliza_config_get_key(ConfigObject* config, ConfigKey key);
+
+/* Get a value by a dotted path through nested sections, such as
+ * "model.backend.timeout". Keys that contain a dot cannot be reached
+ * this way. Returns NULL if any part of the path is missing. */
+ConfigValue* eliza_config_get_path(ConfigObject* config, const char* path);
+
+/* Resolve a dotted path once for later reads with eliza_config_get_key */
+ConfigKey eliza_config_resolve_path(const ConfigObject* config, const char* path);
+
 /* Set a value in the configuration */
 int eliza_config_set_string(ConfigObject* config, const char* key, const char* value);
 int eliza_config_set_int(ConfigObject* config, const char* key, int value);
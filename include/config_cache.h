@@ -0,0 +1,105 @@
+#ifndef ELIZA_CONFIG_CACHE_H
+#define ELIZA_CONFIG_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "config.h"
+
+/*
+ * Configuration Cache
+ * Binary image of a parsed configuration, written beside its source file
+ * so later starts map it instead of parsing the source. The image holds
+ * the configuration objects of the tree in one table, their key, value
+ * and hash index arrays, and a string heap, all in their in-memory form
+ * with pointers set for an address picked when the image is written.
+ * Loading maps the file read-only at that address and uses it in place:
+ * nothing is hashed or copied, and processes loading the same image
+ * share its pages. Every pointer is checked to land inside the image
+ * before it is used, as a matching header says nothing about the rest of
+ * the file. When the address is taken, the image is mapped elsewhere and
+ * its pointers are moved by the same pass. Images are written to a file
+ * of their own and renamed into place, so concurrent writers never mix.
+ *
+ * An image records the size, modification time and FNV-1a hash of the
+ * source it was built from. A source with the same size and time is
+ * taken as unchanged; one whose time moved is hashed and the image kept
+ * if the contents match. Any other source is parsed again and the image
+ * rewritten.
+ *
+ * Layout (host byte order, checked through byte_order on open):
+ *   ConfigCacheHeader
+ *   ConfigObject[object_count]      at objects_offset, the root first
+ *   keys, values, hashes and slots of each object, 8-byte aligned
+ *   NUL-terminated strings          at heap_offset, to the end of the file
+ * An image only opens on a build with the same struct sizes; any other is
+ * rebuilt.
+ */
+
+#define CONFIG_CACHE_MAGIC "ELZCFGC"
+#define CONFIG_CACHE_VERSION 1
+#define CONFIG_CACHE_BYTE_ORDER 0x01020304u
+
+/*
+ * Cache header structure
+ * Always stored at offset 0 of the file
+ */
+typedef struct {
+    char magic[8];           /* CONFIG_CACHE_MAGIC, NUL padded */
+    uint32_t version;        /* Format version */
+    uint32_t byte_order;     /* CONFIG_CACHE_BYTE_ORDER as written */
+    uint32_t object_size;    /* sizeof(ConfigObject) when written */
+    uint32_t value_size;     /* sizeof(ConfigValue) when written */
+    uint64_t source_size;    /* Size of the source file */
+    int64_t source_mtime_sec; /* Modification time of the source */
+    int64_t source_mtime_nsec;
+    uint64_t source_hash;    /* FNV-1a hash of the source contents */
+    uint64_t image_size;     /* Size of the whole file */
+    uint64_t base_address;   /* Address the pointers were written for */
+    uint64_t object_count;   /* Objects in the table */
+    uint64_t objects_offset; /* File offset of the object table */
+    uint64_t heap_offset;    /* File offset of the string heap */
+} ConfigCacheHeader;
+
+/*
+ * How a cached configuration was obtained
+ */
+typedef enum {
+    CONFIG_CACHE_MAPPED,     /* Image matched the source's size and time */
+    CONFIG_CACHE_VERIFIED,   /* Image matched the source's contents */
+    CONFIG_CACHE_PARSED      /* Source parsed, image rewritten if possible */
+} ConfigCacheOrigin;
+
+/*
+ * Cached configuration structure
+ * A configuration either living in a mapped image or parsed from source
+ */
+typedef struct ConfigCache {
+    ConfigObject* config;    /* Root of the configuration */
+    void* map;               /* Mapped image, NULL when parsed */
+    size_t map_size;
+    ConfigCacheOrigin origin;
+    int relocated;           /* Image mapped away from its address */
+} ConfigCache;
+
+/*
+ * Function Declarations
+ */
+
+/* Write the image of config, which was parsed from source_path, to
+ * cache_path. The file is written beside the target and renamed into
+ * place. */
+int eliza_config_cache_write(const ConfigObject* config, const char* source_path,
+                             const char* cache_path);
+
+/* Load the configuration of source_path through the image at cache_path,
+ * mapping the image when it matches the source and otherwise parsing the
+ * source and rewriting the image. A failure to write the image is not an
+ * error. cache->config is read-only, however it was loaded: it must not
+ * be modified or destroyed, only released with eliza_config_cache_close.
+ * Returns NULL if the source cannot be read. */
+ConfigCache* eliza_config_cache_load(const char* source_path, const char* cache_path);
+
+/* Release a cached configuration and unmap its image */
+void eliza_config_cache_close(ConfigCache* cache);
+
+#endif /* ELIZA_CONFIG_CACHE_H */
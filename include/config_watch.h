@@ -0,0 +1,149 @@
+#ifndef ELIZA_CONFIG_WATCH_H
+#define ELIZA_CONFIG_WATCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "config.h"
+
+/*
+ * Configuration Hot Reload
+ * Keeps a parsed configuration current while its file changes. A
+ * background thread watches the file's directory with inotify, so
+ * editors that replace the file by renaming are seen too, waits for the
+ * changes to settle, parses the file again and runs a validation
+ * callback. A configuration that passes is published by swapping one
+ * atomic pointer; a file that fails leaves the current one in place.
+ *
+ * Readers take no locks, as in memory_concurrent.h. Each registers a
+ * reader slot once and announces the global epoch in it while reading,
+ * so the configuration it loaded cannot be freed under it. A replaced
+ * configuration is retired with the epoch of its replacement and freed
+ * once no reader announces an older epoch. Published configurations are
+ * never modified, so a reader sees either the old one or the new one.
+ */
+
+/* Reader slots per watch */
+#define CONFIG_WATCH_MAX_READERS 64
+
+/* Epoch announced by a reader that is not reading */
+#define CONFIG_EPOCH_IDLE UINT64_MAX
+
+/* Accepts a freshly parsed configuration with 0, rejects it with -1 */
+typedef int (*ConfigValidator)(const ConfigObject* config, void* user_data);
+
+/*
+ * Watch options structure
+ */
+typedef struct {
+    ConfigValidator validate; /* Check before publishing, NULL to accept any */
+    void* user_data;         /* Passed to validate */
+    unsigned int settle_ms;  /* Quiet time after the last change before reloading */
+} ConfigWatchOptions;
+
+/*
+ * Published configuration and its generation, immutable once published
+ */
+typedef struct {
+    ConfigObject* config;
+    uint64_t generation;     /* 1 for the first configuration, then one per reload */
+} ConfigVersion;
+
+/*
+ * Version waiting for readers to move past its epoch
+ */
+typedef struct ConfigRetired {
+    ConfigVersion* version;
+    uint64_t epoch;          /* Global epoch when it was replaced */
+    struct ConfigRetired* next;
+} ConfigRetired;
+
+/*
+ * Reader slot, one cache line each so announcements do not contend
+ */
+typedef struct ConfigReader {
+    _Alignas(64) _Atomic uint64_t epoch; /* Announced epoch, or CONFIG_EPOCH_IDLE */
+    atomic_int in_use;
+    struct ConfigWatch* watch;
+    uint64_t generation;     /* Generation read by the current section */
+} ConfigReader;
+
+/*
+ * Watch statistics structure
+ */
+typedef struct {
+    uint64_t generation;     /* Generation of the current configuration */
+    uint64_t changes;        /* Change events seen for the file */
+    uint64_t reloads;        /* Configurations published after the first */
+    uint64_t failed;         /* Reloads whose file could not be read */
+    uint64_t rejected;       /* Reloads refused by validation */
+    uint64_t retired;        /* Configurations replaced */
+    uint64_t reclaimed;      /* Replaced configurations freed */
+    size_t readers;          /* Registered readers */
+} ConfigWatchStats;
+
+/*
+ * Watch structure
+ */
+typedef struct ConfigWatch {
+    _Atomic(ConfigVersion*) current;
+    _Atomic uint64_t epoch;  /* Global epoch, advanced on every retirement */
+
+    char* path;              /* Watched file */
+    const char* name;        /* File name within its directory, inside path */
+    ConfigWatchOptions options;
+    int inotify_fd;
+    int stop_fds[2];         /* Pipe that wakes the thread to stop */
+    pthread_t thread;
+
+    pthread_mutex_t reload_lock; /* Held from parse to publish, so reloads apply in order */
+    pthread_mutex_t lock;    /* Guards the fields below */
+    ConfigRetired* retired;  /* Versions awaiting reclamation */
+    ConfigWatchStats stats;
+
+    ConfigReader readers[CONFIG_WATCH_MAX_READERS];
+} ConfigWatch;
+
+/*
+ * Function Declarations
+ */
+
+/* Fill watch options with defaults: no validation, 50 ms to settle */
+void eliza_config_watch_options_default(ConfigWatchOptions* options);
+
+/* Parse and validate a configuration file, then watch it for changes.
+ * options may be NULL for defaults. Returns NULL if the file cannot be
+ * read or is rejected. */
+ConfigWatch* eliza_config_watch_start(const char* filepath, const ConfigWatchOptions* options);
+
+/* Stop watching and free every configuration. No reader may be inside
+ * a section, and no configuration pointer may be used afterwards. */
+void eliza_config_watch_stop(ConfigWatch* watch);
+
+/* Parse, validate and publish the file now, as a change would. Reloads
+ * run one at a time, so the last to finish read the newest file. Returns 0
+ * when a new configuration was published, -1 otherwise. */
+int eliza_config_watch_reload(ConfigWatch* watch);
+
+/* Register the calling thread as a reader. Each reading thread needs its
+ * own reader; returns NULL when all slots are taken. */
+ConfigReader* eliza_config_watch_reader(ConfigWatch* watch);
+
+/* Give a reader slot back */
+void eliza_config_watch_reader_release(ConfigReader* reader);
+
+/* Enter a read-side section and return the current configuration, which
+ * stays valid and unchanged until eliza_config_read_end. It must not be
+ * modified. Key handles (eliza_config_resolve) belong to one generation;
+ * resolve again when reader->generation changes. Sections must not nest.
+ * Never blocks. */
+ConfigObject* eliza_config_read_begin(ConfigReader* reader);
+
+/* Leave a read-side section */
+void eliza_config_read_end(ConfigReader* reader);
+
+/* Collect watch statistics */
+void eliza_config_watch_get_stats(ConfigWatch* watch, ConfigWatchStats* stats);
+
+#endif /* ELIZA_CONFIG_WATCH_H */
@@ -2,6 +2,19 @@
 #define ELIZA_MEMORY_H
 
 #include <time.h>
+#include "memory_index.h"
+
+struct MemoryWal;
+struct MemoryArena;
+struct MemoryColumns;
+struct MemoryVectors;
+struct MemoryHnsw;
+struct MemoryEviction;
+struct MemorySnapshot;
+struct MemoryDedup;
+struct MemoryTier;
+struct MemoryTrigrams;
+struct MemoryBatches;
 
 /*
  * Memory System Interface
@@ -12,7 +25,7 @@
  * Memory Entry structure
  * Represents a single memory/conversation entry
  */
-typedef struct {
+typedef struct MemoryEntry {
     char* content;           /* The content of the memory */
     time_t timestamp;        /* When the memory was created */
     float importance;        /* Importance score (0.0 to 1.0) */
@@ -24,10 +37,23 @@ typedef struct {
  * Memory Store structure
  * Manages a collection of memories with search and retrieval capabilities
  */
-typedef struct {
-    MemoryEntry** entries;   /* Array of memory entries */
+typedef struct MemoryStore {
+    MemoryEntry** entries;   /* Array of memory entries, NULL where removed */
     size_t capacity;         /* Maximum number of entries */
     size_t size;            /* Current number of entries */
+    size_t removed;          /* NULL slots awaiting compaction */
+    MemoryIndex* index;      /* Inverted index over entry content */
+    struct MemoryWal* wal;   /* Write-ahead log, NULL when not persisted */
+    struct MemoryArena* arena; /* Entry storage in arena mode, else NULL */
+    struct MemoryColumns* columns; /* Columnar copy of entry fields, or NULL */
+    struct MemoryVectors* vectors; /* Entry embeddings, or NULL */
+    struct MemoryHnsw* hnsw; /* Nearest-neighbor graph over embeddings, or NULL */
+    struct MemoryEviction* eviction; /* Budget of a bounded store, or NULL */
+    struct MemorySnapshot* snapshot; /* Snapshot sharing the entries, or NULL */
+    struct MemoryDedup* dedup; /* Near-duplicate check on add, or NULL */
+    struct MemoryTier* tier; /* On-disk cold tier, or NULL */
+    struct MemoryTrigrams* trigrams; /* Trigram index for fuzzy search, or NULL */
+    struct MemoryBatches* batches; /* Blocks of batch-added entries (memory_batch.h), or NULL */
     
     /* Memory management functions */
     int (*add_memory)(struct MemoryStore* store, const char* content, 
@@ -45,6 +71,11 @@ typedef struct {
 /* Create a new memory store with specified capacity */
 MemoryStore* eliza_memory_create(size_t initial_capacity);
 
+/* Create a memory store whose entries live in an arena (memory_arena.h)
+ * instead of individual allocations. Entries must not be destroyed
+ * individually; they are released with the store. */
+MemoryStore* eliza_memory_create_arena(size_t initial_capacity);
+
 /* Destroy a memory store and free all associated resources */
 void eliza_memory_destroy(MemoryStore* store);
 
@@ -55,18 +86,67 @@ MemoryEntry* eliza_memory_entry_create(const char* content, float importance,
 /* Destroy a memory entry */
 void eliza_memory_entry_destroy(MemoryEntry* entry);
 
-/* Add a new memory to the store */
+/* Add a new memory to the store. With deduplication on (memory_dedup.h),
+ * a near-duplicate is merged or dropped instead and 0 is still returned. */
 int eliza_memory_add(MemoryStore* store, const char* content,
                     float importance, const char* context, const char* category);
 
-/* Search for memories based on a query */
+/* Add a new memory with its embedding (memory_vector.h, memory_hnsw.h).
+ * The vector is ignored by stores without vectors or an HNSW index; NULL
+ * embeds the content instead. */
+int eliza_memory_add_vector(MemoryStore* store, const char* content,
+                           float importance, const char* context, const char* category,
+                           const float* vector);
+
+/* Add an entry created with eliza_memory_entry_create, taking ownership */
+int eliza_memory_add_entry(MemoryStore* store, MemoryEntry* entry);
+
+/* Add a copy of an entry, keeping its timestamp */
+int eliza_memory_add_copy(MemoryStore* store, const MemoryEntry* source);
+
+/* Add copies of count entries, keeping their timestamps, as if each were
+ * passed to eliza_memory_add_copy in turn. Capacity is reserved once, the
+ * copies and their strings share one allocation (memory_batch.h) and the
+ * inverted index takes the whole batch in one pass. Entries added before
+ * a failure stay in the store. */
+int eliza_memory_add_batch(MemoryStore* store, const MemoryEntry* entries, size_t count);
+
+/* Make room for at least capacity entries */
+int eliza_memory_reserve(MemoryStore* store, size_t capacity);
+
+/* Remove and destroy all entries, including the cold tier's */
+void eliza_memory_clear(MemoryStore* store);
+
+/* Remove the entry at position. Its slot reads NULL until the store is
+ * compacted, which happens on its own once half the slots are empty and
+ * renumbers the entries behind it. */
+int eliza_memory_remove(MemoryStore* store, size_t position);
+
+/* Reclaim the slots of removed entries, keeping the others in order */
+int eliza_memory_compact(MemoryStore* store);
+
+/* Change the importance of the entry at position */
+int eliza_memory_set_importance(MemoryStore* store, size_t position, float importance);
+
+/* Change the importance and timestamp of the entry at position */
+int eliza_memory_touch(MemoryStore* store, size_t position, float importance, time_t timestamp);
+
+/* Search for memories whose content contains the query.
+ * Queries with several terms take their candidates from the inverted
+ * index; single terms scan the entries. Cold matches of a tiered store
+ * are copied into the allocation of the returned array and freed with it. */
 MemoryEntry** eliza_memory_search(MemoryStore* store, const char* query,
                                 size_t max_results);
 
-/* Save memory store to a file */
+/* Save memory store to a file, cold entries included; vectors go to
+ * filepath + ".vec" and the HNSW index to filepath + ".hnsw" */
 int eliza_memory_save(MemoryStore* store, const char* filepath);
 
-/* Load memory store from a file */
+/* Load memory store from a file (text or binary segment format).
+ * Binary segments skip the text parse; their entries are still copied
+ * into the store and indexed.
+ * Vectors and the HNSW index are read from their files when these match
+ * the entries, otherwise rebuilt with the embedding function. */
 int eliza_memory_load(MemoryStore* store, const char* filepath);
 
 #endif /* ELIZA_MEMORY_H */ 
\ No newline at end of file
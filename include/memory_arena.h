@@ -0,0 +1,111 @@
+#ifndef ELIZA_MEMORY_ARENA_H
+#define ELIZA_MEMORY_ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Memory Arena
+ * Backing storage for arena-mode stores: entries are carved out of
+ * contiguous slabs, content is bump-allocated from large heap blocks and
+ * context/category strings are interned once and shared by every entry
+ * using them. Individual entries are never freed; the whole arena is
+ * released at once.
+ */
+
+struct MemoryEntry;
+
+/* Entries per slab */
+#define MEMORY_ARENA_SLAB_ENTRIES 1024
+
+/* Default size of a content heap block */
+#define MEMORY_ARENA_BLOCK_SIZE (256 * 1024)
+
+/* Id returned for strings that are not interned */
+#define MEMORY_STRING_NONE UINT32_MAX
+
+/*
+ * Arena block structure
+ * A singly linked chunk of raw storage, filled front to back
+ */
+typedef struct MemoryArenaBlock {
+    struct MemoryArenaBlock* next;
+    size_t size;             /* Usable bytes in data */
+    size_t used;             /* Bytes handed out */
+    char data[];
+} MemoryArenaBlock;
+
+/*
+ * String table structure
+ * Interns strings to dense ids starting at 0
+ */
+typedef struct {
+    char** strings;          /* Id to string */
+    uint32_t* hashes;        /* Id to hash */
+    size_t size;             /* Number of interned strings */
+    size_t capacity;         /* Allocated ids */
+    uint32_t* slots;         /* Hash slots holding id + 1, 0 when empty */
+    size_t slot_count;       /* Always a power of two */
+    MemoryArenaBlock* heap;  /* Storage for the string bytes */
+} MemoryStringTable;
+
+/*
+ * Arena statistics structure
+ */
+typedef struct {
+    size_t entries;          /* Entries allocated */
+    size_t slabs;            /* Entry slabs allocated */
+    size_t heap_blocks;      /* Content blocks allocated */
+    size_t heap_used;        /* Content bytes in use */
+    size_t heap_reserved;    /* Content bytes allocated */
+    size_t strings;          /* Distinct interned strings */
+} MemoryArenaStats;
+
+/*
+ * Arena structure
+ */
+typedef struct MemoryArena {
+    MemoryArenaBlock* slabs; /* Entry slabs, newest first */
+    MemoryArenaBlock* heap;  /* Content blocks, newest first */
+    MemoryStringTable strings;
+    size_t entries;
+} MemoryArena;
+
+/*
+ * Function Declarations
+ */
+
+/* Initialize an empty string table */
+void eliza_memory_strings_init(MemoryStringTable* table);
+
+/* Free all strings of a table */
+void eliza_memory_strings_free(MemoryStringTable* table);
+
+/* Intern a string, returning its id or MEMORY_STRING_NONE on failure */
+uint32_t eliza_memory_strings_intern(MemoryStringTable* table, const char* str);
+
+/* Look up the id of a string without interning it */
+uint32_t eliza_memory_strings_find(const MemoryStringTable* table, const char* str);
+
+/* Get the interned string for an id, or NULL */
+const char* eliza_memory_strings_get(const MemoryStringTable* table, uint32_t id);
+
+/* Create an empty arena */
+MemoryArena* eliza_memory_arena_create(void);
+
+/* Free the arena and everything allocated from it */
+void eliza_memory_arena_destroy(MemoryArena* arena);
+
+/* Free everything allocated from the arena, keeping it usable */
+void eliza_memory_arena_reset(MemoryArena* arena);
+
+/* Allocate an entry with its content copied into the arena and its
+ * context and category interned */
+struct MemoryEntry* eliza_memory_arena_entry(MemoryArena* arena, const char* content,
+                                             float importance, const char* context,
+                                             const char* category);
+
+/* Collect allocation statistics */
+void eliza_memory_arena_get_stats(const MemoryArena* arena, MemoryArenaStats* stats);
+
+#endif /* ELIZA_MEMORY_ARENA_H */
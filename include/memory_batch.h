@@ -0,0 +1,69 @@
+#ifndef ELIZA_MEMORY_BATCH_H
+#define ELIZA_MEMORY_BATCH_H
+
+#include <stddef.h>
+#include "memory.h"
+
+/*
+ * Memory Batch Blocks
+ * Storage for entries added with eliza_memory_add_batch to a store that is
+ * not in arena mode. A batch is copied into a single allocation holding
+ * its entry structures followed by all their strings, instead of four
+ * allocations per entry. Entries of a block are removed one at a time
+ * like any other; the block counts the ones still in the store and is
+ * freed, or handed to a snapshot, with the last. The store finds the
+ * block of an entry from its address, so entries need no extra field.
+ */
+
+/*
+ * Batch block structure
+ */
+typedef struct {
+    char* base;              /* Entry structures, then their strings */
+    size_t bytes;            /* Size of the allocation */
+    size_t live;             /* Entries not yet released */
+} MemoryBatchBlock;
+
+/*
+ * Batch statistics structure
+ */
+typedef struct {
+    size_t blocks;           /* Blocks allocated */
+    size_t entries;          /* Entries still in blocks */
+    size_t bytes;            /* Bytes held by blocks */
+} MemoryBatchStats;
+
+/*
+ * Batch block set structure
+ * Blocks sorted by address
+ */
+typedef struct MemoryBatches {
+    MemoryBatchBlock* blocks;
+    size_t count;
+    size_t capacity;
+} MemoryBatches;
+
+/*
+ * Function Declarations
+ */
+
+/* Copy count entries, keeping their timestamps, into a new block of the
+ * store. Returns the copies, all counted as live, or NULL on failure. */
+MemoryEntry* eliza_memory_batch_copy(MemoryStore* store, const MemoryEntry* entries, size_t count);
+
+/* Release an entry that is no longer in the store. Returns 1 if it lives
+ * in a batch block, which is retired with its last entry, or 0 if it was
+ * allocated on its own and is left to the caller. */
+int eliza_memory_batch_release(MemoryStore* store, MemoryEntry* entry);
+
+/* Retire every entry of a store that is not in arena mode, and all of its
+ * batch blocks */
+void eliza_memory_batch_release_all(MemoryStore* store);
+
+/* Destroy the block set of a store whose blocks are all released */
+void eliza_memory_batches_destroy(MemoryBatches* batches);
+
+/* Collect batch block statistics; zeros without batches */
+void eliza_memory_batch_get_stats(const MemoryStore* store, MemoryBatchStats* stats);
+
+#endif /* ELIZA_MEMORY_BATCH_H */
@@ -0,0 +1,90 @@
+#ifndef ELIZA_MEMORY_CACHE_H
+#define ELIZA_MEMORY_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Memory Block Cache
+ * Fixed-size blocks of on-disk data kept in RAM within a byte budget.
+ * Blocks are identified by their source (an opaque pointer, such as an
+ * open segment) and block number, found through a hash table and evicted
+ * least recently used first. The cache does no I/O itself: a miss calls
+ * the fill function given with the request.
+ */
+
+/* Default block size */
+#define MEMORY_CACHE_BLOCK_SIZE (64 * 1024)
+
+/* Fill out with block number block of source, at most capacity bytes.
+ * Returns the bytes filled (short at the end of the source), -1 on
+ * failure. */
+typedef long (*MemoryCacheFill)(void* source, uint64_t block, char* out, size_t capacity);
+
+/*
+ * Cached block structure
+ */
+typedef struct MemoryCacheBlock {
+    void* source;
+    uint64_t block;
+    size_t size;             /* Valid bytes in data */
+    struct MemoryCacheBlock* prev;     /* Towards the most recently used */
+    struct MemoryCacheBlock* next;     /* Towards the least recently used */
+    struct MemoryCacheBlock* hash_next;
+    char data[];
+} MemoryCacheBlock;
+
+/*
+ * Cache statistics structure
+ */
+typedef struct {
+    uint64_t hits;           /* Requests served from RAM */
+    uint64_t misses;         /* Requests that had to fill a block */
+    uint64_t evictions;      /* Blocks dropped to stay within budget */
+    uint64_t bytes_read;     /* Bytes filled on misses */
+    size_t blocks;           /* Blocks held */
+    size_t bytes;            /* Bytes held, counting whole blocks */
+    size_t budget;           /* Byte budget */
+} MemoryCacheStats;
+
+/*
+ * Block cache structure
+ */
+typedef struct MemoryBlockCache {
+    size_t block_size;
+    size_t budget;           /* Bytes of blocks kept, at least one block */
+    MemoryCacheBlock** buckets;
+    size_t bucket_count;     /* Always a power of two */
+    MemoryCacheBlock* head;  /* Most recently used */
+    MemoryCacheBlock* tail;  /* Least recently used */
+    MemoryCacheStats stats;
+} MemoryBlockCache;
+
+/*
+ * Function Declarations
+ */
+
+/* Create a cache of blocks of block_size bytes within budget bytes */
+MemoryBlockCache* eliza_memory_cache_create(size_t block_size, size_t budget);
+
+/* Destroy a cache and its blocks */
+void eliza_memory_cache_destroy(MemoryBlockCache* cache);
+
+/* Data of a block, filled on a miss. Writes its valid length to size.
+ * The data stays valid until the next request to the cache. Returns
+ * NULL on failure. */
+const char* eliza_memory_cache_get(MemoryBlockCache* cache, void* source, uint64_t block,
+                                  MemoryCacheFill fill, size_t* size);
+
+/* Copy length bytes at offset of a source, through the cache.
+ * Returns 0 on success, -1 if they could not all be read. */
+int eliza_memory_cache_read(MemoryBlockCache* cache, void* source, uint64_t offset,
+                           char* out, size_t length, MemoryCacheFill fill);
+
+/* Drop every block of a source */
+void eliza_memory_cache_drop(MemoryBlockCache* cache, void* source);
+
+/* Copy the current statistics */
+void eliza_memory_cache_get_stats(const MemoryBlockCache* cache, MemoryCacheStats* stats);
+
+#endif /* ELIZA_MEMORY_CACHE_H */
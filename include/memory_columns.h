@@ -0,0 +1,129 @@
+#ifndef ELIZA_MEMORY_COLUMNS_H
+#define ELIZA_MEMORY_COLUMNS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "memory.h"
+#include "memory_arena.h"
+
+/*
+ * Memory Columns
+ * Optional struct-of-arrays copy of the fixed-size entry fields. Filters
+ * on time, importance and category run over these contiguous arrays with
+ * AVX2 or SSE4.2 kernels (selected at runtime, scalar otherwise), so
+ * narrowing a search no longer dereferences every entry.
+ *
+ * The columns also keep two secondary indexes: the rows in timestamp
+ * order, and a posting list of rows per interned category. A filter whose
+ * time range or category selects only a small share of the rows is
+ * answered from the narrower of the two instead of a full scan.
+ * Timestamps mostly arrive in order, so keeping the time index is
+ * usually an append.
+ */
+
+/* Filter predicate flags */
+#define MEMORY_FILTER_TIME       0x1
+#define MEMORY_FILTER_IMPORTANCE 0x2
+#define MEMORY_FILTER_CATEGORY   0x4
+
+/*
+ * Ascending list of rows
+ */
+typedef struct {
+    uint32_t* rows;
+    size_t size;
+    size_t capacity;
+} MemoryRowList;
+
+/*
+ * Columns structure
+ * Row i describes store->entries[i]
+ */
+typedef struct MemoryColumns {
+    int64_t* timestamps;     /* Entry timestamps */
+    float* importance;       /* Entry importance scores */
+    uint32_t* category_ids;  /* Interned categories, MEMORY_STRING_NONE if absent */
+    size_t size;             /* Number of rows */
+    size_t capacity;         /* Allocated rows */
+    MemoryStringTable categories;
+
+    /* Secondary indexes */
+    uint32_t* time_order;    /* Rows sorted by timestamp, ties by row */
+    MemoryRowList* category_rows; /* Rows of each category id */
+    size_t category_lists;   /* Allocated category lists */
+} MemoryColumns;
+
+/*
+ * Filter structure
+ * Only the predicates named in flags are applied
+ */
+typedef struct {
+    unsigned int flags;      /* MEMORY_FILTER_* */
+    time_t min_timestamp;    /* Inclusive lower bound */
+    time_t max_timestamp;    /* Inclusive upper bound */
+    float min_importance;    /* Inclusive lower bound */
+    uint32_t category_id;    /* Category to match */
+} MemoryFilter;
+
+/*
+ * Function Declarations
+ */
+
+/* Build the columns of a store and keep them updated on every add */
+int eliza_memory_enable_columns(MemoryStore* store);
+
+/* Destroy a set of columns */
+void eliza_memory_columns_destroy(MemoryColumns* columns);
+
+/* Make room for capacity rows */
+int eliza_memory_columns_reserve(MemoryColumns* columns, size_t capacity);
+
+/* Append the row of an entry (capacity must already be reserved) */
+int eliza_memory_columns_append(MemoryColumns* columns, const MemoryEntry* entry);
+
+/* Refresh the row of an entry whose importance or timestamp changed */
+void eliza_memory_columns_update(MemoryColumns* columns, size_t row, const MemoryEntry* entry);
+
+/* Remove all rows */
+void eliza_memory_columns_clear(MemoryColumns* columns);
+
+/* Drop the rows from size on, undoing a failed append */
+void eliza_memory_columns_truncate(MemoryColumns* columns, size_t size);
+
+/* Drop the rows of removed entries (see eliza_memory_index_remap) */
+void eliza_memory_columns_remap(MemoryColumns* columns, const uint32_t* map, size_t count);
+
+/* Number of rows with timestamps within [from, to] */
+size_t eliza_memory_columns_count_time(const MemoryColumns* columns, time_t from, time_t to);
+
+/* Number of rows in a category, 0 for a category never seen */
+size_t eliza_memory_columns_count_category(const MemoryColumns* columns, const char* category);
+
+/* Initialize a filter that matches everything */
+void eliza_memory_filter_init(MemoryFilter* filter);
+
+/* Restrict a filter to entries created within [from, to] */
+void eliza_memory_filter_time(MemoryFilter* filter, time_t from, time_t to);
+
+/* Restrict a filter to entries with importance >= min_importance */
+void eliza_memory_filter_importance(MemoryFilter* filter, float min_importance);
+
+/* Restrict a filter to a category. A category never seen by the store
+ * makes the filter match nothing. Requires columns to be enabled. */
+int eliza_memory_filter_category(MemoryFilter* filter, MemoryStore* store,
+                                const char* category);
+
+/* Write the positions of up to max entries passing the filter to out,
+ * in store order. Returns the number written. Requires columns. */
+size_t eliza_memory_filter(MemoryStore* store, const MemoryFilter* filter,
+                          uint32_t* out, size_t max);
+
+/* Search restricted to entries passing the filter; same result format
+ * as eliza_memory_search. Text matches are intersected with the rows
+ * the secondary indexes select, e.g. "pizza" in category "chat" from the
+ * last day only looks at that day's chat rows. The filter columns cover
+ * the entries in RAM; cold entries of a tiered store are not searched. */
+MemoryEntry** eliza_memory_search_filtered(MemoryStore* store, const char* query,
+                                         const MemoryFilter* filter, size_t max_results);
+
+#endif /* ELIZA_MEMORY_COLUMNS_H */
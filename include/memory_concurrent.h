@@ -0,0 +1,150 @@
+#ifndef ELIZA_MEMORY_CONCURRENT_H
+#define ELIZA_MEMORY_CONCURRENT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "memory.h"
+
+/*
+ * Concurrent Memory Store
+ * An append-only store that many threads can search while others add.
+ *
+ * Entries live in fixed-size segments that never move once allocated, and
+ * a directory of segment pointers is replaced wholesale when it fills.
+ * Writers serialize on a mutex, fill the next slot and then publish the
+ * new entry count with a release store, so a reader that sees a count
+ * also sees every entry below it.
+ *
+ * Readers take no locks. Each registers a reader slot once and announces
+ * the global epoch in it while reading. A replaced directory is retired
+ * with the epoch of its replacement and freed once no reader announces an
+ * older epoch. Entries themselves are only freed with the store, so the
+ * pointers a search returns stay valid until then.
+ */
+
+/* Entries per segment, as a power of two */
+#define MEMORY_CONCURRENT_SEGMENT_BITS 12
+#define MEMORY_CONCURRENT_SEGMENT_SIZE ((size_t)1 << MEMORY_CONCURRENT_SEGMENT_BITS)
+
+/* Reader slots per store */
+#define MEMORY_CONCURRENT_MAX_READERS 128
+
+/* Epoch announced by a reader that is not reading */
+#define MEMORY_EPOCH_IDLE UINT64_MAX
+
+/*
+ * Segment of entries, filled in order
+ */
+typedef struct {
+    MemoryEntry* entries[MEMORY_CONCURRENT_SEGMENT_SIZE];
+} MemoryConcurrentSegment;
+
+/*
+ * Segment directory, immutable once published apart from appending
+ * segment pointers past the published count
+ */
+typedef struct {
+    size_t capacity;         /* Segment pointers allocated */
+    MemoryConcurrentSegment* segments[];
+} MemoryConcurrentDirectory;
+
+/*
+ * Directory waiting for readers to move past its epoch
+ */
+typedef struct MemoryRetired {
+    void* ptr;
+    uint64_t epoch;          /* Global epoch when it was replaced */
+    struct MemoryRetired* next;
+} MemoryRetired;
+
+/*
+ * Reader slot, one cache line each so announcements do not contend
+ */
+typedef struct MemoryReader {
+    _Alignas(64) _Atomic uint64_t epoch; /* Announced epoch, or MEMORY_EPOCH_IDLE */
+    atomic_int in_use;
+    struct MemoryConcurrentStore* store;
+} MemoryReader;
+
+/*
+ * Concurrent store statistics structure
+ */
+typedef struct {
+    size_t entries;          /* Published entries */
+    size_t segments;         /* Allocated segments */
+    size_t readers;          /* Registered readers */
+    uint64_t epoch;          /* Current global epoch */
+    uint64_t retired;        /* Directories replaced */
+    uint64_t reclaimed;      /* Replaced directories freed */
+} MemoryConcurrentStats;
+
+/*
+ * Concurrent store structure
+ */
+typedef struct MemoryConcurrentStore {
+    _Atomic(MemoryConcurrentDirectory*) directory;
+    _Atomic size_t size;     /* Published entries */
+    _Atomic uint64_t epoch;  /* Global epoch, advanced on every retirement */
+
+    pthread_mutex_t write_lock; /* Serializes writers; guards the fields below */
+    size_t segments;         /* Allocated segments */
+    MemoryRetired* retired;  /* Directories awaiting reclamation */
+    uint64_t retired_count;
+    uint64_t reclaimed_count;
+
+    MemoryReader readers[MEMORY_CONCURRENT_MAX_READERS];
+} MemoryConcurrentStore;
+
+/*
+ * Function Declarations
+ */
+
+/* Create an empty concurrent store */
+MemoryConcurrentStore* eliza_memory_concurrent_create(void);
+
+/* Destroy a concurrent store and its entries. No thread may be using it. */
+void eliza_memory_concurrent_destroy(MemoryConcurrentStore* store);
+
+/* Add a new memory; safe to call from any number of threads */
+int eliza_memory_concurrent_add(MemoryConcurrentStore* store, const char* content,
+                               float importance, const char* context, const char* category);
+
+/* Add an entry created with eliza_memory_entry_create, taking ownership */
+int eliza_memory_concurrent_add_entry(MemoryConcurrentStore* store, MemoryEntry* entry);
+
+/* Add a copy of every entry of a store, keeping their timestamps */
+int eliza_memory_concurrent_import(MemoryConcurrentStore* store, const MemoryStore* source);
+
+/* Register the calling thread as a reader. Each reading thread needs its
+ * own reader; returns NULL when all slots are taken. */
+MemoryReader* eliza_memory_concurrent_reader(MemoryConcurrentStore* store);
+
+/* Give a reader slot back */
+void eliza_memory_concurrent_reader_release(MemoryReader* reader);
+
+/* Enter and leave a read-side critical section. The searches below do
+ * this themselves; explicit sections are for reading entries in place
+ * through eliza_memory_concurrent_get. Sections must not nest. */
+void eliza_memory_concurrent_read_begin(MemoryReader* reader);
+void eliza_memory_concurrent_read_end(MemoryReader* reader);
+
+/* Number of published entries */
+size_t eliza_memory_concurrent_size(MemoryConcurrentStore* store);
+
+/* Entry at position, or NULL past the published count. Must be called
+ * inside a read-side critical section. */
+MemoryEntry* eliza_memory_concurrent_get(MemoryReader* reader, size_t position);
+
+/* Search for memories whose content contains query, as
+ * eliza_memory_search does for single terms. Returns an array of
+ * matching entries terminated with a NULL pointer; free the array, not
+ * the entries. */
+MemoryEntry** eliza_memory_concurrent_search(MemoryReader* reader, const char* query,
+                                           size_t max_results);
+
+/* Copy the current statistics */
+void eliza_memory_concurrent_get_stats(MemoryConcurrentStore* store, MemoryConcurrentStats* stats);
+
+#endif /* ELIZA_MEMORY_CONCURRENT_H */
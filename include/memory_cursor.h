@@ -0,0 +1,79 @@
+#ifndef ELIZA_MEMORY_CURSOR_H
+#define ELIZA_MEMORY_CURSOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "memory.h"
+#include "memory_match.h"
+#include "memory_tier.h"
+
+/*
+ * Memory Search Cursors
+ * The matches of eliza_memory_search, in the same order, without the
+ * result array. A cursor lives wherever the caller puts it, usually on
+ * the stack, and pulls one match at a time straight out of the inverted
+ * index or the substring scan, so a search that stops after the first
+ * few matches does no more work than that. Queries of up to
+ * MEMORY_CURSOR_QUERY_BYTES - 1 bytes allocate nothing, unless their
+ * first or last term is only part of a word and the index merges the
+ * postings of every word it could be part of.
+ *
+ * Entries are handed out read-only and stay valid until the store is
+ * next modified; a cursor must not be advanced across a modification.
+ * On a tiered store (memory_tier.h) the hot matches are followed by the
+ * cold ones, which have the id MEMORY_ID_REMOVED. They are decoded into
+ * storage owned by the cursor and stay valid until it is closed. Reading
+ * the cold tier modifies it, so tiered stores must not be searched by
+ * several threads at once.
+ */
+
+/* Query bytes kept inside the cursor */
+#define MEMORY_CURSOR_QUERY_BYTES 64
+
+/*
+ * Cursor structure
+ */
+typedef struct {
+    const MemoryStore* store;
+    MemoryMatcher matcher;   /* Compiled query */
+    char needle[MEMORY_CURSOR_QUERY_BYTES]; /* Matcher storage for short queries */
+    MemoryIndexQuery index_query; /* Candidates from the inverted index */
+    int use_index;           /* Candidates come from index_query */
+    size_t position;         /* Next entry to scan otherwise */
+    int cold;                /* The hot tier is exhausted */
+    size_t cold_segment;     /* Position in the cold tier */
+    size_t cold_record;
+    struct MemoryArena* cold_entries; /* Cold matches handed out, or NULL */
+    size_t returned;         /* Matches handed out so far */
+} MemoryCursor;
+
+/* Called for each match with its entry id; return nonzero to stop */
+typedef int (*MemoryVisitFn)(const MemoryEntry* entry, uint32_t id, void* arg);
+
+/*
+ * Function Declarations
+ */
+
+/* Start a search. Returns 0 on success, -1 on failure. */
+int eliza_memory_cursor_open(MemoryCursor* cursor, const MemoryStore* store, const char* query);
+
+/* Next match, or NULL when there are no more. Writes the entry id to id
+ * unless it is NULL. */
+const MemoryEntry* eliza_memory_cursor_next(MemoryCursor* cursor, uint32_t* id);
+
+/* Release a cursor and the cold matches it handed out; needed only for
+ * long queries, merged postings and tiered stores, harmless otherwise */
+void eliza_memory_cursor_close(MemoryCursor* cursor);
+
+/* Write up to max matches to results. Cold matches of a tiered store
+ * need storage of their own and are left out; use a cursor or
+ * eliza_memory_search for those. Returns the number written. */
+size_t eliza_memory_search_into(const MemoryStore* store, const char* query,
+                               const MemoryEntry** results, size_t max);
+
+/* Call visit for each match until it returns nonzero. Returns the number
+ * of matches visited, or 0 if the query could not be compiled. */
+size_t eliza_memory_search_each(const MemoryStore* store, const char* query,
+                               MemoryVisitFn visit, void* arg);
+
+#endif /* ELIZA_MEMORY_CURSOR_H */
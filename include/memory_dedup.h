@@ -0,0 +1,115 @@
+#ifndef ELIZA_MEMORY_DEDUP_H
+#define ELIZA_MEMORY_DEDUP_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "memory.h"
+
+/*
+ * Memory Deduplication
+ * Optional near-duplicate check in front of every add. Each entry gets a
+ * 64-bit SimHash of its words and word pairs, so texts that differ in a
+ * few words get signatures that differ in a few bits. The signature is
+ * cut into four 16-bit bands, and each band indexes a table of the
+ * entries sharing it. Two signatures at most three bits apart agree on
+ * at least one band, so those tables find every such candidate without
+ * comparing against the whole store.
+ *
+ * A new entry whose signature is within max_distance bits of a live
+ * entry in the same category is a duplicate. It is either merged into
+ * that entry, which gets the higher importance plus a boost and the newer
+ * timestamp, or dropped. Either way the add succeeds without storing it.
+ */
+
+/* What happens to duplicates */
+#define MEMORY_DEDUP_MERGE  0
+#define MEMORY_DEDUP_REJECT 1
+
+/* Signature bands and their width */
+#define MEMORY_DEDUP_BANDS 4
+#define MEMORY_DEDUP_BAND_BITS 16
+
+/*
+ * Dedup options structure
+ */
+typedef struct {
+    int mode;                /* MEMORY_DEDUP_* */
+    unsigned int max_distance; /* Differing signature bits still counted as a duplicate;
+                                * only up to MEMORY_DEDUP_BANDS - 1 is always found */
+    float merge_boost;       /* Importance added on a merge, capped at 1.0 */
+    size_t max_candidates;   /* Entries compared per band before giving up */
+} MemoryDedupOptions;
+
+/*
+ * Dedup statistics structure
+ */
+typedef struct {
+    uint64_t checked;        /* Adds checked */
+    uint64_t duplicates;     /* Adds found to be duplicates */
+    uint64_t merged;         /* Duplicates merged into an existing entry */
+    uint64_t rejected;       /* Duplicates dropped */
+    uint64_t bytes_saved;    /* Entry bytes not stored because of duplicates */
+    uint64_t candidates;     /* Signatures compared */
+    double rate;             /* duplicates / checked */
+} MemoryDedupStats;
+
+/*
+ * Dedup state structure
+ * Signatures and chain links are indexed by entry id
+ */
+typedef struct MemoryDedup {
+    MemoryDedupOptions options;
+    uint64_t* signatures;    /* Signature of each id */
+    uint32_t* next;          /* Per id and band, the previous id in the chain + 1 */
+    uint32_t* heads;         /* Per band and band value, the newest id + 1, 0 if none */
+    size_t size;             /* Ids tracked */
+    size_t capacity;         /* Allocated ids */
+    MemoryDedupStats stats;
+} MemoryDedup;
+
+/*
+ * Function Declarations
+ */
+
+/* Fill dedup options with defaults: merge, three bits, 0.05 boost */
+void eliza_memory_dedup_options_default(MemoryDedupOptions* options);
+
+/* Check every later add of a store for near-duplicates. Entries already
+ * in the store are indexed but not deduplicated among themselves. Calling
+ * it again replaces the options. */
+int eliza_memory_enable_dedup(MemoryStore* store, const MemoryDedupOptions* options);
+
+/* Destroy dedup state */
+void eliza_memory_dedup_destroy(MemoryDedup* dedup);
+
+/* Make room for capacity entry ids */
+int eliza_memory_dedup_reserve(MemoryDedup* dedup, size_t capacity);
+
+/* 64-bit SimHash of a text */
+uint64_t eliza_memory_simhash(const char* text);
+
+/* Handle an entry about to be added. Returns 1 if it was a duplicate and
+ * has been merged or dropped (the caller still owns and frees it), 0 if
+ * it should be added, -1 on failure. */
+int eliza_memory_dedup_check(MemoryStore* store, const MemoryEntry* entry, uint64_t* signature);
+
+/* Track the entry just added at id */
+int eliza_memory_dedup_add(MemoryDedup* dedup, uint32_t id, uint64_t signature);
+
+/* Stop tracking the ids from size on, which must be the newest; undoes
+ * a failed add */
+void eliza_memory_dedup_truncate(MemoryDedup* dedup, size_t size);
+
+/* Renumber tracked entries (see eliza_memory_index_remap) */
+void eliza_memory_dedup_remap(MemoryDedup* dedup, const uint32_t* map, size_t count);
+
+/* Forget all entries, keeping the options and counters */
+void eliza_memory_dedup_clear(MemoryDedup* dedup);
+
+/* Forget all entries and track the entries of store instead */
+int eliza_memory_dedup_track(MemoryDedup* dedup, const MemoryStore* store);
+
+/* Collect dedup statistics; zeros when dedup is off */
+void eliza_memory_dedup_get_stats(const MemoryStore* store, MemoryDedupStats* stats);
+
+#endif /* ELIZA_MEMORY_DEDUP_H */
@@ -0,0 +1,105 @@
+#ifndef ELIZA_MEMORY_EVICT_H
+#define ELIZA_MEMORY_EVICT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "memory.h"
+
+/*
+ * Memory Eviction
+ * Bounded stores keep their entries within a count and byte budget. When
+ * an add goes over budget, the entries with the lowest value
+ *
+ *   importance * 0.5 ^ (age / half_life)
+ *
+ * are evicted first. For a fixed half-life, ranking by that value is the
+ * same as ranking by log2(importance) + timestamp / half_life, which does
+ * not change as time passes. Entries therefore sit in an indexed min-heap
+ * on that key: eviction, removal and importance updates are O(log n) and
+ * nothing is rescored over time.
+ */
+
+/*
+ * Budget structure
+ */
+typedef struct {
+    size_t max_entries;      /* Live entries kept, 0 for no limit */
+    size_t max_bytes;        /* Entry and string bytes kept, 0 for no limit */
+    double half_life;        /* Seconds after which an entry's value halves */
+} MemoryBudget;
+
+/*
+ * Eviction statistics structure
+ */
+typedef struct {
+    uint64_t evictions;      /* Entries evicted to meet the budget */
+    uint64_t evicted_bytes;  /* Bytes released by evictions */
+    uint64_t compactions;    /* Times removed slots were reclaimed */
+    size_t entries;          /* Live entries */
+    size_t bytes;            /* Bytes of the live entries */
+} MemoryEvictionStats;
+
+/*
+ * Eviction state structure
+ * Heap and key arrays are indexed by entry id
+ */
+typedef struct MemoryEviction {
+    MemoryBudget budget;
+    uint32_t* heap;          /* Entry ids, lowest value at the root */
+    uint32_t* positions;     /* Heap position of each id, MEMORY_ID_REMOVED if none */
+    double* keys;            /* Value key of each id */
+    size_t size;             /* Entries in the heap */
+    size_t capacity;         /* Allocated ids */
+    size_t bytes;            /* Bytes of the entries in the heap */
+    MemoryEvictionStats stats;
+} MemoryEviction;
+
+/*
+ * Function Declarations
+ */
+
+/* Fill a budget with defaults: no limits, three day half-life */
+void eliza_memory_budget_default(MemoryBudget* budget);
+
+/* Bound a store by a budget, evicting at once if it is already over.
+ * Calling it again replaces the budget. On failure the previous budget,
+ * if any, is back in place; entries evicted before the failure stay
+ * evicted. */
+int eliza_memory_set_budget(MemoryStore* store, const MemoryBudget* budget);
+
+/* Evict entries until the store is within budget; called after every
+ * add to a bounded store */
+int eliza_memory_enforce_budget(MemoryStore* store);
+
+/* Destroy eviction state */
+void eliza_memory_eviction_destroy(MemoryEviction* eviction);
+
+/* Make room for capacity entry ids */
+int eliza_memory_eviction_reserve(MemoryEviction* eviction, size_t capacity);
+
+/* Track a newly added entry */
+int eliza_memory_eviction_add(MemoryEviction* eviction, uint32_t id, const MemoryEntry* entry);
+
+/* Stop tracking an entry that is being removed */
+void eliza_memory_eviction_forget(MemoryEviction* eviction, uint32_t id, const MemoryEntry* entry);
+
+/* Reposition an entry whose importance changed */
+void eliza_memory_eviction_update(MemoryEviction* eviction, uint32_t id, const MemoryEntry* entry);
+
+/* Entry to evict next, or MEMORY_ID_REMOVED when the store is within
+ * budget */
+uint32_t eliza_memory_eviction_victim(const MemoryEviction* eviction);
+
+/* Renumber tracked entries (see eliza_memory_index_remap) */
+void eliza_memory_eviction_remap(MemoryEviction* eviction, const uint32_t* map, size_t count);
+
+/* Forget all entries, keeping the budget and counters */
+void eliza_memory_eviction_clear(MemoryEviction* eviction);
+
+/* Bytes an entry counts against the byte budget */
+size_t eliza_memory_entry_bytes(const MemoryEntry* entry);
+
+/* Collect eviction statistics; zeros for unbounded stores */
+void eliza_memory_eviction_get_stats(const MemoryStore* store, MemoryEvictionStats* stats);
+
+#endif /* ELIZA_MEMORY_EVICT_H */
@@ -0,0 +1,123 @@
+#ifndef ELIZA_MEMORY_FUZZY_H
+#define ELIZA_MEMORY_FUZZY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "memory.h"
+
+/*
+ * Fuzzy Memory Search
+ * Finds entries containing a query with a few typos. An optional trigram
+ * index maps every three-byte window of each entry's content, with ASCII
+ * letters lower-cased, to the ids of the entries containing it.
+ *
+ * A text within k edits of a query keeps all but at most 3k of the
+ * query's distinct trigrams, because each edit touches at most three
+ * windows. So a candidate must share at least (trigrams - 3k) of them.
+ * Such a candidate appears in at least one of the 3k + 1 shortest posting
+ * lists. Only those lists are walked; the rest are probed per candidate.
+ * Survivors are checked with Myers' bit-parallel edit distance, which
+ * finds the best match of the query anywhere in the content in one pass.
+ *
+ * The index covers the entries in RAM; cold entries of a tiered store are
+ * not searched.
+ */
+
+/* Longest query, one bit per byte of a machine word */
+#define MEMORY_FUZZY_MAX_QUERY 64
+
+/*
+ * Fuzzy match structure
+ */
+typedef struct {
+    const MemoryEntry* entry;
+    uint32_t id;             /* Entry id */
+    uint32_t distance;       /* Edits between the query and its best match in the content */
+} MemoryFuzzyMatch;
+
+/*
+ * Fuzzy search statistics structure
+ */
+typedef struct {
+    size_t trigrams;         /* Distinct trigrams indexed */
+    uint64_t postings;       /* Entry ids in all posting lists */
+    uint64_t searches;       /* Fuzzy searches run */
+    uint64_t candidates;     /* Entries found in the walked posting lists */
+    uint64_t verified;       /* Candidates with enough shared trigrams to verify */
+    uint64_t matches;        /* Candidates within the edit distance */
+} MemoryFuzzyStats;
+
+/*
+ * Trigram posting list structure
+ */
+typedef struct {
+    uint32_t key;            /* Three folded bytes, 0 for an empty slot */
+    uint32_t size;           /* Number of ids */
+    uint32_t capacity;       /* Allocated ids */
+    uint32_t* ids;           /* Entry ids in ascending order */
+} MemoryTrigramPosting;
+
+/*
+ * Trigram index structure
+ * Open-addressing hash table of posting lists, plus per-search scratch
+ */
+typedef struct MemoryTrigrams {
+    MemoryTrigramPosting* slots;
+    size_t slot_count;       /* Always a power of two */
+    size_t size;             /* Trigrams in use */
+    uint8_t* counts;         /* Shared-trigram count of each id during a search */
+    size_t capacity;         /* Allocated counts */
+    uint32_t* touched;       /* Ids with a nonzero count */
+    size_t touched_capacity;
+    MemoryFuzzyMatch* matches; /* Matches of the current search */
+    size_t match_capacity;
+    MemoryFuzzyStats stats;
+} MemoryTrigrams;
+
+/*
+ * Function Declarations
+ */
+
+/* Build a trigram index over the entries of a store and keep it up to
+ * date. Returns 0 on success, -1 on failure. */
+int eliza_memory_enable_fuzzy(MemoryStore* store);
+
+/* Destroy a trigram index */
+void eliza_memory_trigrams_destroy(MemoryTrigrams* trigrams);
+
+/* Make room for capacity entry ids */
+int eliza_memory_trigrams_reserve(MemoryTrigrams* trigrams, size_t capacity);
+
+/* Index the content of the entry just added at id. Ids must be added in
+ * ascending order. */
+int eliza_memory_trigrams_add(MemoryTrigrams* trigrams, uint32_t id, const char* content);
+
+/* Drop the postings of ids from size on, which must be the newest;
+ * undoes a failed add */
+void eliza_memory_trigrams_truncate(MemoryTrigrams* trigrams, uint32_t size);
+
+/* Renumber entries (see eliza_memory_index_remap). Trigrams left without
+ * postings are dropped. */
+int eliza_memory_trigrams_remap(MemoryTrigrams* trigrams, const uint32_t* map, size_t count);
+
+/* Forget all entries, keeping the counters */
+void eliza_memory_trigrams_clear(MemoryTrigrams* trigrams);
+
+/* Edit distance between a query and its closest substring of text,
+ * ignoring ASCII case. The query must be 1 to MEMORY_FUZZY_MAX_QUERY
+ * bytes. Returns the distance, or -1 for a query out of range. */
+int eliza_memory_fuzzy_distance(const char* query, const char* text);
+
+/* Find entries containing the query within max_distance edits, closest
+ * first and in id order among equals. max_distance is lowered to what the
+ * index can prune: a third of the query's distinct trigrams, less one.
+ * Queries must be 3 to MEMORY_FUZZY_MAX_QUERY bytes and the store must
+ * have a trigram index. Writes up to max_results matches, which stay
+ * valid until the store is modified. Returns the number written. */
+size_t eliza_memory_search_fuzzy(MemoryStore* store, const char* query, unsigned int max_distance,
+                                MemoryFuzzyMatch* results, size_t max_results);
+
+/* Collect fuzzy search statistics; zeros without a trigram index */
+void eliza_memory_fuzzy_get_stats(const MemoryStore* store, MemoryFuzzyStats* stats);
+
+#endif /* ELIZA_MEMORY_FUZZY_H */
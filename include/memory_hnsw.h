@@ -0,0 +1,162 @@
+#ifndef ELIZA_MEMORY_HNSW_H
+#define ELIZA_MEMORY_HNSW_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "memory.h"
+#include "memory_rank.h"
+#include "memory_vector.h"
+
+/*
+ * Memory HNSW Index
+ * Hierarchical navigable small world graph over entry embeddings for
+ * approximate nearest-neighbor recall. Each node keeps up to 2 * M links
+ * on the bottom layer and M on the sparser layers above; a search
+ * descends greedily from the top and explores ef candidates at the
+ * bottom. Larger M and ef trade speed for recall.
+ */
+
+#define MEMORY_HNSW_MAGIC "ELZMHNS"
+#define MEMORY_HNSW_VERSION 1
+
+/* Bounds on the graph shape */
+#define MEMORY_HNSW_MAX_M 64
+#define MEMORY_HNSW_MAX_LEVEL 16
+
+/*
+ * HNSW options structure
+ */
+typedef struct {
+    size_t m;                /* Links per node on upper layers */
+    size_t ef_construction;  /* Candidates explored while inserting */
+    size_t ef_search;        /* Candidates explored while searching */
+    uint64_t seed;           /* Seed of the level generator */
+} MemoryHnswOptions;
+
+/*
+ * HNSW candidate, a node and its similarity to the query
+ */
+typedef struct {
+    float score;
+    uint32_t id;
+} MemoryHnswCandidate;
+
+/*
+ * Binary max-heap of candidates
+ */
+typedef struct {
+    MemoryHnswCandidate* items;
+    size_t size;
+    size_t capacity;
+} MemoryHnswHeap;
+
+/*
+ * HNSW index structure
+ * Node i describes store->entries[i]
+ */
+typedef struct MemoryHnsw {
+    size_t dim;              /* Dimension of every vector */
+    size_t m;                /* Links per node on upper layers */
+    size_t m0;               /* Links per node on the bottom layer */
+    size_t ef_construction;
+    size_t ef_search;
+    float* vectors;          /* size * dim normalized floats */
+    uint8_t* levels;         /* Top layer of each node */
+    uint32_t* links0;        /* Bottom layer: per node a count and m0 ids */
+    uint32_t** links;        /* Upper layers: per node level * (m + 1) ids */
+    size_t size;             /* Number of nodes */
+    size_t capacity;         /* Allocated nodes */
+    uint32_t entry_point;    /* Node on the top layer */
+    int max_level;           /* Top layer, -1 when empty */
+    double level_mult;       /* 1 / ln(M) */
+    uint64_t rng;            /* Level generator state */
+    MemoryDotFn dot;         /* Similarity kernel */
+
+    /* Search scratch space */
+    uint32_t* visited;       /* Visit tag per node */
+    uint32_t visit_tag;
+    MemoryHnswHeap candidates;
+    MemoryHnswHeap results;
+    MemoryHnswCandidate* found; /* Results of a layer, best first */
+    size_t found_capacity;
+    float* query;            /* dim floats */
+} MemoryHnsw;
+
+/*
+ * Index file header
+ * Followed by the vectors, the levels, the bottom layer links and the
+ * upper layer links of every node with a level above zero
+ */
+typedef struct {
+    char magic[8];           /* MEMORY_HNSW_MAGIC */
+    uint32_t version;        /* MEMORY_HNSW_VERSION */
+    uint32_t byte_order;     /* MEMORY_SEGMENT_BYTE_ORDER as written */
+    uint64_t count;          /* Number of nodes */
+    uint32_t dim;
+    uint32_t m;
+    uint32_t ef_construction;
+    uint32_t ef_search;
+    uint32_t entry_point;
+    int32_t max_level;
+    uint64_t rng;
+} MemoryHnswHeader;
+
+/*
+ * Function Declarations
+ */
+
+/* Fill options with defaults: M = 16, ef_construction = 200,
+ * ef_search = 64 */
+void eliza_memory_hnsw_options_default(MemoryHnswOptions* options);
+
+/* Attach an HNSW index of dimension dim to a store and keep it updated on
+ * every add. Vectors come from eliza_memory_add_vector, or from the
+ * store's embedding column when added without one. Existing entries are
+ * indexed from the embedding column, or as zero vectors without it.
+ * options may be NULL for defaults. */
+int eliza_memory_enable_hnsw(MemoryStore* store, size_t dim, const MemoryHnswOptions* options);
+
+/* Create an empty index */
+MemoryHnsw* eliza_memory_hnsw_create(size_t dim, const MemoryHnswOptions* options);
+
+/* Destroy an index */
+void eliza_memory_hnsw_destroy(MemoryHnsw* hnsw);
+
+/* Make room for capacity nodes */
+int eliza_memory_hnsw_reserve(MemoryHnsw* hnsw, size_t capacity);
+
+/* Insert the next node; a NULL vector inserts a zero vector */
+int eliza_memory_hnsw_add(MemoryHnsw* hnsw, const float* vector);
+
+/* Remove all nodes */
+void eliza_memory_hnsw_clear(MemoryHnsw* hnsw);
+
+/* Drop the nodes of removed entries (see eliza_memory_index_remap).
+ * Survivors lose their links to removed nodes; nodes left with few links
+ * are reconnected through a fresh search. */
+int eliza_memory_hnsw_remap(MemoryHnsw* hnsw, const uint32_t* map, size_t count);
+
+/* Rebuild the index of a store from its embedding column */
+int eliza_memory_hnsw_rebuild(MemoryStore* store);
+
+/* Change the number of candidates explored per search */
+void eliza_memory_hnsw_set_ef(MemoryHnsw* hnsw, size_t ef_search);
+
+/* Write the ids of the k nodes nearest to a query to ids and their
+ * cosine similarity to scores, best first. Returns the number written. */
+size_t eliza_memory_hnsw_search(MemoryHnsw* hnsw, const float* query, size_t k,
+                               uint32_t* ids, float* scores);
+
+/* Write the k entries most similar to a query vector to results, best
+ * first, using the store's HNSW index. Returns the number written. */
+size_t eliza_memory_search_hnsw(MemoryStore* store, const float* query,
+                               MemoryRankedResult* results, size_t k);
+
+/* Write an index to a file */
+int eliza_memory_hnsw_save(const MemoryHnsw* hnsw, const char* filepath);
+
+/* Replace the index of a store with one read from a file. Fails unless
+ * the file matches the store's entry count and dimension. */
+int eliza_memory_hnsw_load(MemoryStore* store, const char* filepath);
+
+#endif /* ELIZA_MEMORY_HNSW_H */
@@ -0,0 +1,135 @@
+#ifndef ELIZA_MEMORY_INDEX_H
+#define ELIZA_MEMORY_INDEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Memory Inverted Index
+ * Maps content tokens to posting lists of entry ids so that
+ * multi-term searches only visit entries sharing every term
+ */
+
+/* Longest token kept by the tokenizer, longer runs are truncated */
+#define MEMORY_INDEX_MAX_TOKEN 64
+
+/* Maximum number of distinct terms used from a single query */
+#define MEMORY_INDEX_MAX_QUERY_TERMS 16
+
+/* Marks a removed entry in a renumbering map */
+#define MEMORY_ID_REMOVED UINT32_MAX
+
+/*
+ * Posting list structure
+ * Holds the ascending ids of all entries containing a term
+ */
+typedef struct {
+    char* term;              /* Normalized (lower-case) term */
+    uint32_t hash;           /* Cached hash of the term */
+    uint32_t* ids;           /* Entry ids in ascending order */
+    uint16_t* freqs;         /* Occurrences of the term in each entry (saturating) */
+    size_t size;             /* Number of ids */
+    size_t capacity;         /* Allocated ids */
+} MemoryPosting;
+
+/*
+ * Inverted index structure
+ * Open-addressing hash table of posting lists keyed by term
+ */
+typedef struct MemoryIndex {
+    MemoryPosting* buckets;  /* Hash table slots (term == NULL when empty) */
+    size_t capacity;         /* Number of slots, always a power of two */
+    size_t size;             /* Number of distinct terms */
+    uint32_t* lengths;       /* Token count of each entry id */
+    size_t documents;        /* Number of entries indexed */
+    size_t lengths_capacity; /* Allocated lengths */
+    uint64_t total_length;   /* Sum of all entry token counts */
+} MemoryIndex;
+
+/*
+ * Index query structure
+ * Streams the intersection of the posting lists of all query terms, so
+ * callers can stop as soon as they have enough. Only the partial terms
+ * of a substring query allocate, for their merged postings.
+ */
+typedef struct {
+    const MemoryPosting* postings[MEMORY_INDEX_MAX_QUERY_TERMS];
+    size_t positions[MEMORY_INDEX_MAX_QUERY_TERMS];
+    size_t num_terms;        /* Number of distinct terms in the query */
+    int empty;               /* Set when a term has no postings */
+    MemoryPosting partial[2]; /* Merged postings of the partial terms, ids only */
+} MemoryIndexQuery;
+
+/*
+ * Function Declarations
+ */
+
+/* Create an empty inverted index */
+MemoryIndex* eliza_memory_index_create(void);
+
+/* Destroy an index and all posting lists */
+void eliza_memory_index_destroy(MemoryIndex* index);
+
+/* Remove all terms from the index */
+void eliza_memory_index_clear(MemoryIndex* index);
+
+/* Index the tokens of content under the given entry id.
+ * Ids must be added in ascending order. */
+int eliza_memory_index_add(MemoryIndex* index, uint32_t id, const char* content);
+
+/* Index count entries at once under the ids first_id onwards, which
+ * must follow every id already added. Same result as adding them one by
+ * one, but terms recurring across the batch are only hashed into the
+ * table once while they stay recent. A failure leaves none of the batch
+ * indexed. */
+int eliza_memory_index_add_batch(MemoryIndex* index, uint32_t first_id,
+                                 const char* const* contents, size_t count);
+
+/* Look up the posting list of a term (len bytes, any case) */
+const MemoryPosting* eliza_memory_index_lookup(const MemoryIndex* index,
+                                             const char* term, size_t len);
+
+/* Drop an entry from the relevance statistics; its postings stay until
+ * the next remap and must be skipped by callers */
+void eliza_memory_index_forget(MemoryIndex* index, uint32_t id);
+
+/* Drop the postings of every id from size on, which must be the newest.
+ * Entries that were fully added are forgotten first; this undoes a
+ * failed add. */
+void eliza_memory_index_truncate(MemoryIndex* index, uint32_t size);
+
+/* Renumber entries after removals. map[id] is the new id of each of the
+ * count old ids, or MEMORY_ID_REMOVED. New ids must keep the order of the
+ * old ones. Terms left without postings are dropped. */
+int eliza_memory_index_remap(MemoryIndex* index, const uint32_t* map, size_t count);
+
+/* Token count of an indexed entry */
+uint32_t eliza_memory_index_length(const MemoryIndex* index, uint32_t id);
+
+/* Read the next token from *text, writing its normalized form to out.
+ * Returns the token length, or 0 at the end of the text. */
+size_t eliza_memory_next_token(const char** text, char* out);
+
+/* Prepare a query over the terms of a query string.
+ * Returns the number of terms read from the query. */
+size_t eliza_memory_index_query_init(MemoryIndexQuery* query,
+                                   const MemoryIndex* index, const char* text);
+
+/* Prepare a candidate query for a substring search of text. Terms with
+ * separators on both sides must be whole tokens; a term at the start of
+ * text may be the end of a token and a term at its end the start of one,
+ * so these take the merged postings of every such token. They are only
+ * looked up when no whole term constrains the query, since that walks
+ * the whole index. A term spanning the whole text constrains nothing. Returns the number of terms
+ * constraining the candidates, 0 when the query needs a scan. */
+size_t eliza_memory_index_query_init_substring(MemoryIndexQuery* query,
+                                             const MemoryIndex* index, const char* text);
+
+/* Free the merged postings of a query */
+void eliza_memory_index_query_release(MemoryIndexQuery* query);
+
+/* Fetch the next entry id containing every query term.
+ * Returns 1 when an id was written, 0 when the query is exhausted. */
+int eliza_memory_index_query_next(MemoryIndexQuery* query, uint32_t* id);
+
+#endif /* ELIZA_MEMORY_INDEX_H */
@@ -0,0 +1,66 @@
+#ifndef ELIZA_MEMORY_LOAD_H
+#define ELIZA_MEMORY_LOAD_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "memory.h"
+
+/*
+ * Memory Text Loader
+ * Reads the text format written by eliza_memory_save. The file is mapped
+ * rather than read line by line, the store is sized once from the SIZE:
+ * header, and the body is cut at ---ENTRY--- lines into chunks that a
+ * pool of threads turns into entries. Once every chunk is parsed the
+ * calling thread clears the store and adds the entries in file order.
+ * Lines may be of any length.
+ *
+ * Files announce their format in a FORMAT: header. From format 2 on,
+ * backslashes and line breaks in text fields are escaped as \\, \n and
+ * \r; files without the header are read verbatim, as they were written.
+ */
+
+/* Text format written by eliza_memory_save */
+#define MEMORY_TEXT_FORMAT 2
+
+/* Default bytes of text per chunk */
+#define MEMORY_LOAD_CHUNK_BYTES (4 * 1024 * 1024)
+
+/* Upper bound on parser threads */
+#define MEMORY_LOAD_MAX_THREADS 64
+
+/*
+ * Load options structure
+ */
+typedef struct {
+    size_t threads;          /* Parser threads, 0 for one per online CPU */
+    size_t chunk_bytes;      /* Bytes of text per chunk */
+} MemoryLoadOptions;
+
+/*
+ * Load statistics structure
+ */
+typedef struct {
+    size_t entries;          /* Entries added to the store */
+    size_t skipped;          /* Entries without content */
+    size_t size_hint;        /* Entries announced by the SIZE: header */
+    size_t bytes;            /* Size of the file */
+    size_t chunks;           /* Chunks the body was cut into */
+    size_t threads;          /* Parser threads used, 0 when parsed inline */
+    double elapsed_ms;       /* Wall time of the load */
+} MemoryLoadStats;
+
+/*
+ * Function Declarations
+ */
+
+/* Fill load options with defaults */
+void eliza_memory_load_options_default(MemoryLoadOptions* options);
+
+/* Replace the entries of a store with those of a text file. Timestamps
+ * are kept. options may be NULL for defaults; stats may be NULL. A file
+ * that fails to parse leaves the store, cold tier included, untouched;
+ * entries added before a later failure stay in the store. */
+int eliza_memory_load_text(MemoryStore* store, const char* filepath,
+                          const MemoryLoadOptions* options, MemoryLoadStats* stats);
+
+#endif /* ELIZA_MEMORY_LOAD_H */
@@ -0,0 +1,31 @@
+#ifndef ELIZA_MEMORY_LZ_H
+#define ELIZA_MEMORY_LZ_H
+
+#include <stddef.h>
+
+/*
+ * Memory Block Codec
+ * Byte-oriented LZ77 compression in the LZ4 block format: a token byte
+ * holding literal and match lengths, the literals, then a two-byte
+ * little-endian offset back into the output. Matches are found through a
+ * hash table of four-byte sequences, which suits the repeated words and
+ * phrases of chat text and decodes at memory speed. The decoder checks
+ * every length and offset, so corrupt input fails instead of overrunning.
+ */
+
+/*
+ * Function Declarations
+ */
+
+/* Largest compressed size of length bytes */
+size_t eliza_memory_lz_bound(size_t length);
+
+/* Compress length bytes of src into dst. Returns the compressed size, or
+ * 0 if it does not fit in capacity bytes. */
+size_t eliza_memory_lz_compress(const char* src, size_t length, char* dst, size_t capacity);
+
+/* Decompress length bytes of src into dst. Returns the decompressed size,
+ * or -1 for corrupt input or output larger than capacity bytes. */
+long eliza_memory_lz_decompress(const char* src, size_t length, char* dst, size_t capacity);
+
+#endif /* ELIZA_MEMORY_LZ_H */
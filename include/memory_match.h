@@ -0,0 +1,72 @@
+#ifndef ELIZA_MEMORY_MATCH_H
+#define ELIZA_MEMORY_MATCH_H
+
+#include <stddef.h>
+#include "memory.h"
+
+/*
+ * Memory Substring Matcher
+ * A query compiled once and then matched against many short texts. On
+ * CPUs with AVX2, 32 candidate positions are tested per step by comparing
+ * the needle's first and last bytes at once; only positions where both
+ * agree are verified byte by byte. NUL-terminated texts are scanned in
+ * the same pass that finds their end, so short messages are not read
+ * twice. Other CPUs use a scalar loop.
+ *
+ * Case-insensitive matchers fold ASCII letters only; other bytes,
+ * including UTF-8 sequences, must match exactly.
+ */
+
+/* Matcher flags */
+#define MEMORY_MATCH_IGNORE_CASE 1
+
+struct MemoryMatcher;
+
+/* Find kernel: first match of the needle in length bytes of haystack */
+typedef const char* (*MemoryMatchFn)(const struct MemoryMatcher* matcher,
+                                     const char* haystack, size_t length);
+
+/* Scan kernel: first match of the needle in a NUL-terminated text */
+typedef const char* (*MemoryScanFn)(const struct MemoryMatcher* matcher, const char* text);
+
+/*
+ * Compiled query structure
+ */
+typedef struct MemoryMatcher {
+    char* needle;            /* Query, lower-cased when ignoring case */
+    size_t length;           /* Query length */
+    int flags;               /* MEMORY_MATCH_* */
+    int owns_needle;         /* needle was allocated by the matcher */
+    unsigned char first;     /* First and last needle bytes */
+    unsigned char last;
+    MemoryMatchFn find;      /* Kernels picked for this CPU and the flags */
+    MemoryScanFn scan;
+} MemoryMatcher;
+
+/*
+ * Function Declarations
+ */
+
+/* Compile a query. Returns 0 on success, -1 on failure. */
+int eliza_memory_matcher_init(MemoryMatcher* matcher, const char* query, int flags);
+
+/* Compile a query into caller storage of size bytes, which must outlive
+ * the matcher. Queries that do not fit are copied to the heap as usual. */
+int eliza_memory_matcher_init_buffer(MemoryMatcher* matcher, const char* query, int flags,
+                                    char* buffer, size_t size);
+
+/* Release a compiled query */
+void eliza_memory_matcher_destroy(MemoryMatcher* matcher);
+
+/* First match in length bytes of haystack, or NULL */
+const char* eliza_memory_matcher_find(const MemoryMatcher* matcher, const char* haystack, size_t length);
+
+/* Whether a NUL-terminated text contains the query */
+int eliza_memory_matcher_contains(const MemoryMatcher* matcher, const char* text);
+
+/* Search for memories whose content contains a compiled query. Returns an
+ * array of matching entries terminated with a NULL pointer. */
+MemoryEntry** eliza_memory_search_matching(MemoryStore* store, const MemoryMatcher* matcher,
+                                         size_t max_results);
+
+#endif /* ELIZA_MEMORY_MATCH_H */
@@ -0,0 +1,79 @@
+#ifndef ELIZA_MEMORY_RANK_H
+#define ELIZA_MEMORY_RANK_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "memory.h"
+
+/*
+ * Ranked Memory Recall
+ * Scores every entry sharing at least one term with the query by
+ *
+ *   text_weight * bm25 / (bm25 + 1)
+ *   + importance_weight * importance
+ *   + recency_weight * 0.5 ^ (age / half_life)
+ *
+ * and keeps the best k in a bounded min-heap, so the candidate set is
+ * never sorted as a whole.
+ *
+ * Only the entries in RAM are scored; cold entries of a tiered store are
+ * not ranked.
+ */
+
+/*
+ * Ranking options structure
+ */
+typedef struct {
+    float text_weight;       /* Weight of the squashed BM25 score */
+    float importance_weight; /* Weight of the entry importance */
+    float recency_weight;    /* Weight of the recency decay */
+    double half_life;        /* Seconds after which recency halves */
+    float k1;                /* BM25 term frequency saturation */
+    float b;                 /* BM25 length normalization */
+    time_t now;              /* Reference time, 0 for the current time */
+} MemoryRankOptions;
+
+/*
+ * Ranked result structure
+ */
+typedef struct {
+    MemoryEntry* entry;      /* Matching entry (owned by the store) */
+    float score;             /* Combined score */
+} MemoryRankedResult;
+
+/*
+ * Top-k structure
+ * Bounded min-heap over caller-provided storage; the root is the worst
+ * result kept so far
+ */
+typedef struct {
+    MemoryRankedResult* items;
+    size_t size;
+    size_t capacity;
+} MemoryTopK;
+
+/*
+ * Function Declarations
+ */
+
+/* Start collecting the k best results into storage */
+void eliza_memory_topk_init(MemoryTopK* topk, MemoryRankedResult* storage, size_t k);
+
+/* Offer a scored entry; once full it must beat the current worst */
+void eliza_memory_topk_offer(MemoryTopK* topk, MemoryEntry* entry, float score);
+
+/* Sort the kept results best first and return how many there are */
+size_t eliza_memory_topk_finish(MemoryTopK* topk);
+
+/* Fill options with defaults: weights 1.0 / 0.3 / 0.2, three day
+ * half-life, k1 = 1.2, b = 0.75 */
+void eliza_memory_rank_options_default(MemoryRankOptions* options);
+
+/* Write the k best entries for a query to results, best first.
+ * A query without terms ranks every entry by importance and recency.
+ * options may be NULL for defaults. Returns the number written. */
+size_t eliza_memory_search_ranked(MemoryStore* store, const char* query,
+                                 const MemoryRankOptions* options,
+                                 MemoryRankedResult* results, size_t k);
+
+#endif /* ELIZA_MEMORY_RANK_H */
@@ -0,0 +1,197 @@
+#ifndef ELIZA_MEMORY_SEGMENT_H
+#define ELIZA_MEMORY_SEGMENT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "memory.h"
+
+/*
+ * Memory Segment Format
+ * Versioned binary file holding a header, a fixed-size record table and
+ * a string heap. An open segment is a read-only mapping used in place, so
+ * opening one costs the same regardless of its size and records are only
+ * touched when they are read through eliza_memory_segment_get. A
+ * MemoryStore always owns its entries: copying a segment into a store
+ * saves the parse of the text format but still copies and indexes every
+ * entry. Lazy reads for a store come from the cold tier (memory_tier.h).
+ *
+ * Layout (host byte order, checked through byte_order on open):
+ *   MemorySegmentHeader
+ *   NUL-terminated strings          at heap_offset
+ *   MemorySegmentRecord[count]     at records_offset
+ *
+ * Compressed segments (version 2, MEMORY_SEGMENT_COMPRESSED) cut the
+ * string heap into blocks of block_size bytes, each compressed with the
+ * block codec (memory_lz.h). Records still hold offsets into the
+ * uncompressed heap. The heap_size bytes at heap_offset hold:
+ *   compressed blocks, back to back
+ *   uint64_t[block_count]           end of each block in the region
+ *   MemorySegmentBlocks             in the last bytes of the region
+ * Compressed segments are read through the cold tier (memory_tier.h);
+ * eliza_memory_segment_open maps plain segments only.
+ *
+ * Snapshots of a write-ahead log (memory_wal.h, MEMORY_SEGMENT_IDS) follow
+ * the record table with the log id of each entry:
+ *   uint64_t[count]                 after the record table
+ */
+
+#define MEMORY_SEGMENT_MAGIC "ELZMSEG"
+#define MEMORY_SEGMENT_VERSION 1
+#define MEMORY_SEGMENT_VERSION_COMPRESSED 2
+#define MEMORY_SEGMENT_BYTE_ORDER 0x01020304u
+
+/* Header flag of segments with a compressed heap */
+#define MEMORY_SEGMENT_COMPRESSED 1u
+
+/* Header flag of segments holding a write-ahead log id per record */
+#define MEMORY_SEGMENT_IDS 2u
+
+/* Length value marking an absent context or category */
+#define MEMORY_SEGMENT_NO_STRING 0xFFFFFFFFu
+
+/*
+ * Segment header structure
+ * Always stored at offset 0 of the file
+ */
+typedef struct {
+    char magic[8];           /* MEMORY_SEGMENT_MAGIC, NUL padded */
+    uint32_t version;        /* Format version */
+    uint32_t byte_order;     /* MEMORY_SEGMENT_BYTE_ORDER as written */
+    uint64_t count;          /* Number of records */
+    uint64_t records_offset; /* File offset of the record table */
+    uint64_t heap_offset;    /* File offset of the string heap */
+    uint64_t heap_size;      /* Size of the string heap in bytes */
+    uint32_t record_size;    /* sizeof(MemorySegmentRecord) when written */
+    uint32_t flags;          /* MEMORY_SEGMENT_* flags */
+    uint64_t last_lsn;       /* Last write-ahead log record folded in */
+} MemorySegmentHeader;
+
+/*
+ * Segment record structure
+ * One fixed-size record per entry, strings live in the heap
+ */
+typedef struct {
+    int64_t timestamp;       /* Creation time of the entry */
+    uint64_t content_offset; /* Heap offset of the content */
+    uint64_t context_offset; /* Heap offset of the context */
+    uint64_t category_offset;/* Heap offset of the category */
+    uint32_t content_length; /* Content length without the terminator */
+    uint32_t context_length; /* Context length or MEMORY_SEGMENT_NO_STRING */
+    uint32_t category_length;/* Category length or MEMORY_SEGMENT_NO_STRING */
+    float importance;        /* Importance score */
+} MemorySegmentRecord;
+
+/*
+ * Compressed heap trailer structure
+ */
+typedef struct {
+    uint64_t raw_size;       /* Uncompressed heap bytes */
+    uint32_t block_size;     /* Uncompressed bytes per block, except the last */
+    uint32_t block_count;    /* Number of blocks */
+} MemorySegmentBlocks;
+
+/*
+ * Open segment structure
+ * Read-only view of a mapped segment file
+ */
+typedef struct MemorySegment {
+    void* map;               /* Start of the mapping */
+    size_t map_size;         /* Length of the mapping */
+    const MemorySegmentHeader* header;
+    const MemorySegmentRecord* records;
+    const uint64_t* ids;     /* Log id of each record, or NULL */
+    const char* heap;
+} MemorySegment;
+
+/*
+ * Segment writer structure
+ * Streams strings to the file and keeps the record table in memory
+ * until the segment is finished
+ */
+typedef struct MemorySegmentWriter {
+    FILE* file;
+    char* filepath;          /* Final path */
+    char* tmp_path;          /* Path written until finish */
+    MemorySegmentRecord* records;
+    uint64_t* ids;           /* Log id of each record, NULL until one is given */
+    size_t count;
+    size_t capacity;
+    uint64_t heap_size;      /* Bytes of strings written so far */
+    int failed;              /* Set after any write error */
+    uint32_t block_size;     /* Heap bytes per compressed block, 0 when not compressing */
+    char* block;             /* Heap bytes of the block being filled */
+    size_t block_used;
+    char* packed;            /* Compressor output */
+    uint64_t* block_ends;    /* End of each compressed block in the heap region */
+    size_t block_count;
+    size_t block_capacity;
+    uint64_t stored_size;    /* Compressed bytes written so far */
+} MemorySegmentWriter;
+
+/*
+ * Function Declarations
+ */
+
+/* Start writing a segment file */
+MemorySegmentWriter* eliza_memory_segment_writer_open(const char* filepath);
+
+/* Start writing a segment file with its heap compressed in blocks of
+ * block_size bytes */
+MemorySegmentWriter* eliza_memory_segment_writer_open_compressed(const char* filepath,
+                                                               uint32_t block_size);
+
+/* Append an entry to a segment being written */
+int eliza_memory_segment_writer_add(MemorySegmentWriter* writer, const MemoryEntry* entry);
+
+/* Append an entry with its write-ahead log id. Entries of one segment
+ * either all have ids or none do. */
+int eliza_memory_segment_writer_add_id(MemorySegmentWriter* writer, const MemoryEntry* entry,
+                                     uint64_t id);
+
+/* Write the record table and header, sync and rename into place.
+ * The writer is freed whether or not this succeeds. */
+int eliza_memory_segment_writer_finish(MemorySegmentWriter* writer, uint64_t last_lsn);
+
+/* Discard a segment being written */
+void eliza_memory_segment_writer_abort(MemorySegmentWriter* writer);
+
+/* Write the entries of a store to a segment file.
+ * The file is written beside the target and renamed into place. */
+int eliza_memory_segment_write(MemoryStore* store, const char* filepath);
+
+/* Check a header against the size of its file, including the alignment
+ * of the record table. Returns 1 if valid. */
+int eliza_memory_segment_header_valid(const MemorySegmentHeader* header, uint64_t file_size);
+
+/* Map a plain segment file and validate its header */
+MemorySegment* eliza_memory_segment_open(const char* filepath);
+
+/* Unmap a segment */
+void eliza_memory_segment_close(MemorySegment* segment);
+
+/* Last write-ahead log record contained in a segment */
+uint64_t eliza_memory_segment_last_lsn(const MemorySegment* segment);
+
+/* Number of entries in a segment */
+size_t eliza_memory_segment_count(const MemorySegment* segment);
+
+/* Write-ahead log id of record index, 0 if the segment has none */
+uint64_t eliza_memory_segment_id(const MemorySegment* segment, size_t index);
+
+/* Fill entry with a view of record index. The strings point into the
+ * mapping and stay valid until the segment is closed; they must not be
+ * modified or freed. Returns 0 on success, -1 on a corrupt record. */
+int eliza_memory_segment_get(const MemorySegment* segment, size_t index,
+                            MemoryEntry* entry);
+
+/* Copy every entry of a segment into a store, replacing its contents.
+ * Entries are copied in batches (memory_batch.h) and indexed again, so
+ * this is linear in the segment; read through eliza_memory_segment_get
+ * to use the mapping without copying. */
+int eliza_memory_segment_copy(MemoryStore* store, const MemorySegment* segment);
+
+/* Check whether a file starts with the segment magic */
+int eliza_memory_segment_probe(const char* filepath);
+
+#endif /* ELIZA_MEMORY_SEGMENT_H */
@@ -0,0 +1,124 @@
+#ifndef ELIZA_MEMORY_SHARD_H
+#define ELIZA_MEMORY_SHARD_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "memory.h"
+
+/*
+ * Sharded Memory Store
+ * Keeps one MemoryStore per conversation, keyed by a string such as a
+ * sender or channel id, so a query from one conversation only scans that
+ * conversation's history. Conversations are hash-partitioned over a fixed
+ * number of partitions, each with its own read-write lock and its own
+ * table of sub-stores: writers to different partitions never contend, and
+ * readers only wait for writers of their own partition.
+ *
+ * A search may also fan out over every conversation, in parallel across
+ * partitions when the store was created with worker threads. Entries a
+ * search returns stay valid until their conversation is dropped.
+ */
+
+/* Default number of partitions (must be a power of two) */
+#define MEMORY_SHARD_DEFAULT_PARTITIONS 64
+
+/*
+ * Sharded store options structure
+ */
+typedef struct {
+    size_t partitions;       /* Lock partitions, rounded up to a power of two */
+    size_t initial_capacity; /* Capacity of each new conversation store */
+    size_t threads;          /* Fan-out workers, 0 or 1 to fan out inline */
+} MemoryShardOptions;
+
+/*
+ * Conversation slot in a partition table
+ */
+typedef struct {
+    char* key;               /* NULL when the slot is free */
+    uint32_t hash;
+    MemoryStore* store;
+} MemoryShard;
+
+/*
+ * Partition of the conversation directory
+ */
+typedef struct {
+    pthread_rwlock_t lock;
+    MemoryShard* shards;     /* Open-addressed table of conversations */
+    size_t capacity;         /* Table slots, a power of two */
+    size_t count;            /* Conversations in the table */
+} MemoryShardPartition;
+
+/*
+ * Sharded store statistics structure
+ */
+typedef struct {
+    size_t conversations;    /* Conversation stores */
+    size_t entries;          /* Entries across all conversations */
+    size_t largest;          /* Entries in the largest conversation */
+    size_t busiest_partition; /* Conversations in the fullest partition */
+} MemoryShardStats;
+
+/*
+ * Sharded store structure
+ */
+typedef struct MemoryShardedStore {
+    MemoryShardPartition* partitions;
+    size_t partition_count;
+    size_t initial_capacity;
+
+    /* Fan-out workers; one fan-out runs at a time */
+    pthread_t* workers;
+    size_t worker_count;
+    pthread_mutex_t fanout_lock;
+    pthread_mutex_t pool_lock;
+    pthread_cond_t work_cond;
+    pthread_cond_t done_cond;
+    struct MemoryShardFanout* fanout; /* Fan-out in progress, or NULL */
+    uint64_t generation;     /* Bumped for every fan-out */
+    size_t busy;             /* Workers still on the current fan-out */
+    int running;
+} MemoryShardedStore;
+
+/*
+ * Function Declarations
+ */
+
+/* Fill options with defaults: 64 partitions, conversation stores of 16
+ * entries, fan-out inline */
+void eliza_memory_shard_options_default(MemoryShardOptions* options);
+
+/* Create a sharded store; options may be NULL for defaults */
+MemoryShardedStore* eliza_memory_sharded_create(const MemoryShardOptions* options);
+
+/* Destroy a sharded store and every conversation in it */
+void eliza_memory_sharded_destroy(MemoryShardedStore* store);
+
+/* Add a memory to the conversation under key, creating it if needed */
+int eliza_memory_sharded_add(MemoryShardedStore* store, const char* key, const char* content,
+                            float importance, const char* context, const char* category);
+
+/* Search one conversation as eliza_memory_search does. Returns a NULL
+ * terminated array, empty when the conversation does not exist; free the
+ * array, not the entries. */
+MemoryEntry** eliza_memory_sharded_search(MemoryShardedStore* store, const char* key,
+                                        const char* query, size_t max_results);
+
+/* Search every conversation, partitions in parallel when the store has
+ * workers. Results are grouped by partition. */
+MemoryEntry** eliza_memory_sharded_search_all(MemoryShardedStore* store, const char* query,
+                                            size_t max_results);
+
+/* Number of entries in one conversation */
+size_t eliza_memory_sharded_count(MemoryShardedStore* store, const char* key);
+
+/* Remove a conversation and destroy its entries. Returns 0 when it was
+ * removed, -1 when it did not exist. */
+int eliza_memory_sharded_drop(MemoryShardedStore* store, const char* key);
+
+/* Collect statistics over all partitions */
+void eliza_memory_sharded_get_stats(MemoryShardedStore* store, MemoryShardStats* stats);
+
+#endif /* ELIZA_MEMORY_SHARD_H */
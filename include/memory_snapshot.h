@@ -0,0 +1,163 @@
+#ifndef ELIZA_MEMORY_SNAPSHOT_H
+#define ELIZA_MEMORY_SNAPSHOT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <pthread.h>
+#include "memory.h"
+
+/*
+ * Memory Snapshots
+ * A snapshot freezes the entries of a store in O(1) by sharing its entry
+ * array instead of copying it. While the snapshot is held, the store
+ * copies on write: growing, compacting or clearing the store moves it to
+ * a fresh array, and entries that are removed or changed are replaced
+ * rather than freed or modified in place. Storage the store stops using
+ * is handed to the snapshot and freed when both are done with it.
+ *
+ * Snapshots cover the entries only. The store itself stays
+ * single-threaded; only the snapshot may be read from another thread.
+ *
+ * A saver owns a background thread that writes snapshots to disk, so a
+ * checkpoint costs the caller one snapshot and adds continue while the
+ * file is written.
+ *
+ * A snapshot holds the hot entries of a store only. The cold segments of
+ * a tiered store (memory_tier.h) can be deleted or added while a file is
+ * being written, so savers refuse tiered stores rather than write a file
+ * that silently lacks them; use eliza_memory_save there.
+ */
+
+/* Kinds of retired storage */
+#define MEMORY_RETIRED_ARRAY 1
+#define MEMORY_RETIRED_ENTRY 2
+#define MEMORY_RETIRED_ARENA 3
+
+/*
+ * Storage retired while a snapshot still needed it
+ */
+typedef struct MemoryRetiredBlock {
+    int kind;                /* MEMORY_RETIRED_* */
+    void* ptr;
+    struct MemoryRetiredBlock* next;
+} MemoryRetiredBlock;
+
+/*
+ * Snapshot structure
+ * entries[0, size) is the frozen view; NULL slots are removed entries
+ */
+typedef struct MemorySnapshot {
+    MemoryEntry** entries;
+    size_t size;
+
+    pthread_mutex_t lock;    /* Guards the fields below */
+    int refs;                /* One for the store, one for the holder */
+    int released;            /* Set once the holder is done */
+    MemoryRetiredBlock* retired;
+    uint64_t array_copies;   /* Entry arrays copied on write */
+    uint64_t entry_copies;   /* Entries copied on write */
+    uint64_t deferred;       /* Blocks whose release was deferred */
+} MemorySnapshot;
+
+/*
+ * Saver statistics structure
+ */
+typedef struct {
+    uint64_t saves;          /* Snapshots written */
+    uint64_t failures;       /* Snapshots that could not be written */
+    uint64_t busy;           /* Requests refused while a save was running */
+    uint64_t bytes_written;  /* Bytes written by all saves */
+    uint64_t last_bytes;     /* Bytes written by the last save */
+    uint64_t last_entries;   /* Entries written by the last save */
+    double last_freeze_us;   /* Time the caller spent taking the last snapshot */
+    double last_duration_ms; /* Time the last save spent writing */
+    double max_duration_ms;
+    double total_duration_ms;
+    uint64_t array_copies;   /* Copy-on-write work caused by saves */
+    uint64_t entry_copies;
+    uint64_t deferred;
+} MemorySaverStats;
+
+/*
+ * Background saver structure
+ */
+typedef struct MemorySaver {
+    MemoryStore* store;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t work_cond;    /* Wakes the saver thread */
+    pthread_cond_t idle_cond;    /* Signals a finished save */
+    MemorySnapshot* pending;     /* Snapshot to write, or NULL */
+    char* path;                  /* Where to write it */
+    int busy;                    /* A save is queued or running */
+    int result;                  /* Result of the last save */
+    int running;
+    MemorySaverStats stats;
+} MemorySaver;
+
+/*
+ * Function Declarations
+ */
+
+/* Freeze the entries of a store in O(1). Returns NULL if the store already
+ * has a snapshot that is still held. */
+MemorySnapshot* eliza_memory_snapshot(MemoryStore* store);
+
+/* Let go of a snapshot; safe from any thread */
+void eliza_memory_snapshot_release(MemorySnapshot* snapshot);
+
+/* Number of live entries in a snapshot */
+size_t eliza_memory_snapshot_count(const MemorySnapshot* snapshot);
+
+/* Write a snapshot in the text format of eliza_memory_save. The file is
+ * written under a temporary name, synced and renamed into place. Writes
+ * the number of bytes written to bytes unless it is NULL. */
+int eliza_memory_snapshot_save(const MemorySnapshot* snapshot, const char* filepath, uint64_t* bytes);
+
+/* Write count entries in the text format of eliza_memory_save, skipping
+ * NULL slots. Backslashes and line breaks in text fields are escaped, and
+ * importance is written with enough digits to read back exactly. */
+int eliza_memory_write_text(FILE* file, MemoryEntry* const* entries, size_t count);
+
+/* Write the header of the text format for a file of count entries */
+int eliza_memory_write_text_header(FILE* file, size_t count);
+
+/* Write one entry in the text format, after the header */
+int eliza_memory_write_text_entry(FILE* file, const MemoryEntry* entry);
+
+/* Copy-on-write hooks used by the store */
+
+/* The store's snapshot if its holder still has it, else NULL. Finishes
+ * snapshots whose holder is done. */
+MemorySnapshot* eliza_memory_snapshot_active(MemoryStore* store);
+
+/* Move the store to a private entry array of capacity slots if it shares
+ * its array with a snapshot */
+int eliza_memory_snapshot_unshare(MemoryStore* store, size_t capacity);
+
+/* Free storage the store no longer uses, or hand it to the snapshot */
+void eliza_memory_snapshot_retire(MemoryStore* store, int kind, void* ptr);
+
+/* Hand everything a snapshot may still read to it before the store is
+ * destroyed */
+void eliza_memory_snapshot_detach(MemoryStore* store);
+
+/* Start a saver thread for a store. Returns NULL for a tiered store. */
+MemorySaver* eliza_memory_saver_create(MemoryStore* store);
+
+/* Wait for a running save, then stop the thread */
+void eliza_memory_saver_destroy(MemorySaver* saver);
+
+/* Snapshot the store and write it to filepath in the background.
+ * Returns 0 once queued, -1 if a save is still running, the store has
+ * been tiered since the saver started or the snapshot failed. */
+int eliza_memory_saver_save(MemorySaver* saver, const char* filepath);
+
+/* Block until no save is running. Returns the result of the last save. */
+int eliza_memory_saver_wait(MemorySaver* saver);
+
+/* Copy the current statistics */
+void eliza_memory_saver_get_stats(MemorySaver* saver, MemorySaverStats* stats);
+
+#endif /* ELIZA_MEMORY_SNAPSHOT_H */
@@ -0,0 +1,155 @@
+#ifndef ELIZA_MEMORY_TIER_H
+#define ELIZA_MEMORY_TIER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+#include "memory.h"
+#include "memory_segment.h"
+#include "memory_cache.h"
+#include "memory_match.h"
+
+/*
+ * Tiered Memory
+ * Keeps recent and important entries in RAM (the hot tier) and moves the
+ * rest to immutable segment files in a directory (the cold tier). Cold
+ * segments are not mapped: their record tables are read into RAM on open
+ * and their strings are read through a block cache bounded by a byte
+ * budget, so the resident size of the cold tier does not grow with it.
+ *
+ * Cold segments are written compressed by default (memory_segment.h), and
+ * the cache then holds decoded blocks. A resident tier also keeps the
+ * compressed segments in RAM, so searches never touch the disk and the
+ * cold tier costs its compressed size plus the cache budget.
+ *
+ * Searches consult the hot tier first and then the cold segments, newest
+ * first. Cold matches are decoded into an arena owned by the search, so
+ * they outlive later searches; they have no entry id (MEMORY_ID_REMOVED)
+ * and cannot be modified or removed.
+ *
+ * The cold tier is part of the store: saving a store writes its cold
+ * entries along with the hot ones, clearing or loading it deletes the
+ * cold segments, and enabling tiering on a directory picks up the
+ * segments already in it. Cold entries are not in the write-ahead log;
+ * a store restored from its log keeps the segments as they are.
+ */
+
+/* Cold segment files are named with this prefix and a sequence number */
+#define MEMORY_TIER_SEGMENT_PREFIX "cold-"
+
+/*
+ * Tier options structure
+ */
+typedef struct {
+    const char* directory;   /* Where cold segments live, created if missing */
+    size_t max_hot_entries;  /* Migrate once the hot tier holds more entries */
+    double hot_age;          /* Entries newer than this many seconds stay hot */
+    float hot_importance;    /* Entries at least this important stay hot */
+    size_t cache_bytes;      /* Byte budget of the cold block cache */
+    size_t block_size;       /* Bytes per cached and compressed block */
+    int compress;            /* Write compressed segments */
+    int resident;            /* Keep compressed segments in RAM */
+} MemoryTierOptions;
+
+/*
+ * Open cold segment structure
+ */
+typedef struct {
+    int fd;
+    uint32_t number;         /* Sequence number in the file name */
+    struct MemoryTier* tier;
+    MemorySegmentHeader header;
+    MemorySegmentRecord* records; /* Record table, held in RAM */
+    uint64_t heap_size;      /* Uncompressed string heap bytes */
+    MemorySegmentBlocks blocks; /* Block layout of a compressed heap */
+    uint64_t* block_ends;    /* Block table of a compressed heap, else NULL */
+    char* resident;          /* Compressed blocks held in RAM, or NULL */
+} MemoryColdSegment;
+
+/*
+ * Tier statistics structure
+ */
+typedef struct {
+    size_t hot_entries;      /* Live entries in RAM */
+    size_t cold_entries;     /* Entries in cold segments */
+    size_t segments;         /* Cold segments open */
+    uint64_t migrations;     /* Segments written */
+    uint64_t migrated;       /* Entries moved to the cold tier */
+    uint64_t cold_scanned;   /* Cold records examined by searches */
+    uint64_t cold_matches;   /* Cold entries returned by searches */
+    uint64_t raw_bytes;      /* Uncompressed string heap bytes of all segments */
+    uint64_t stored_bytes;   /* Heap bytes as stored, after compression */
+    uint64_t resident_bytes; /* Compressed bytes held in RAM */
+    double compression_ratio;/* raw_bytes over stored_bytes */
+    uint64_t blocks_decoded; /* Compressed blocks decoded on cache misses */
+    uint64_t decoded_bytes;  /* Bytes they decoded to */
+    uint64_t decode_ns;      /* Time spent decoding */
+    double decode_mb_per_s;  /* decoded_bytes over decode_ns */
+    MemoryCacheStats cache;  /* Block cache hits, misses and evictions */
+    double hit_rate;         /* cache.hits over all cache requests */
+} MemoryTierStats;
+
+/*
+ * Tier structure
+ */
+typedef struct MemoryTier {
+    MemoryTierOptions options;
+    char* directory;         /* Copy of options.directory */
+    MemoryColdSegment** segments; /* Oldest first */
+    size_t segment_count;
+    size_t segment_capacity;
+    uint32_t next_number;    /* Sequence number of the next segment */
+    MemoryBlockCache* cache;
+    char* scratch;           /* Buffer for strings read from the cache */
+    size_t scratch_capacity;
+    char* packed;            /* Compressed block read from disk */
+    size_t packed_capacity;
+    char* decoded;           /* Block decoded for a cache of another block size */
+    size_t decoded_capacity;
+    size_t next_check;       /* Hot entries at which to try migrating again */
+    MemoryTierStats stats;
+} MemoryTier;
+
+/*
+ * Function Declarations
+ */
+
+/* Fill tier options with defaults. The directory must still be set. */
+void eliza_memory_tier_options_default(MemoryTierOptions* options);
+
+/* Turn on tiering, opening the cold segments already in the directory.
+ * Returns 0 on success, -1 on failure. */
+int eliza_memory_enable_tier(MemoryStore* store, const MemoryTierOptions* options);
+
+/* Close the cold segments and free tier state */
+void eliza_memory_tier_destroy(MemoryTier* tier);
+
+/* Move every entry that is neither recent nor important enough to a new
+ * cold segment. Returns the number of entries moved, -1 on failure. */
+long eliza_memory_tier_migrate(MemoryStore* store);
+
+/* Migrate if the hot tier has outgrown its limit; called after each add.
+ * Returns 0 on success, -1 on failure. */
+int eliza_memory_tier_check(MemoryStore* store);
+
+/* Next cold entry matching a compiled query, resuming at *segment and
+ * *record (both 0 to start). The entry is decoded into arena and lives
+ * as long as it does. Returns NULL when there are no more. */
+const MemoryEntry* eliza_memory_tier_next_match(MemoryTier* tier, const MemoryMatcher* matcher,
+                                              struct MemoryArena* arena, size_t* segment, size_t* record);
+
+/* Call visit for every cold entry, oldest first. The entry is valid only
+ * during the call; visit returns 0 to go on and -1 to fail. Returns 0 on
+ * success, -1 if a record cannot be read or visit fails. */
+int eliza_memory_tier_each(MemoryTier* tier, int (*visit)(const MemoryEntry* entry, void* arg), void* arg);
+
+/* Close every cold segment and delete its file (called by eliza_memory_clear) */
+void eliza_memory_tier_clear(MemoryTier* tier);
+
+/* Total number of cold entries */
+size_t eliza_memory_tier_count(const MemoryTier* tier);
+
+/* Collect tier statistics */
+void eliza_memory_tier_get_stats(const MemoryStore* store, MemoryTierStats* stats);
+
+#endif /* ELIZA_MEMORY_TIER_H */
@@ -0,0 +1,132 @@
+#ifndef ELIZA_MEMORY_VECTOR_H
+#define ELIZA_MEMORY_VECTOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "memory.h"
+#include "memory_rank.h"
+
+/*
+ * Memory Vectors
+ * Optional fixed-dimension embedding per entry, stored row by row next to
+ * the entries. Rows are normalized on insert so cosine similarity is a
+ * plain dot product, computed with AVX-512 or AVX2 kernels (selected at
+ * runtime, scalar otherwise). Int8 rows keep a per-row scale and take a
+ * quarter of the space of float rows.
+ */
+
+#define MEMORY_VECTOR_MAGIC "ELZMVEC"
+#define MEMORY_VECTOR_VERSION 1
+
+/* Largest supported embedding dimension */
+#define MEMORY_VECTOR_MAX_DIM 4096
+
+/*
+ * Row storage formats
+ */
+typedef enum {
+    MEMORY_VECTOR_FLOAT32 = 0,
+    MEMORY_VECTOR_INT8 = 1
+} MemoryVectorFormat;
+
+/* Dot product of two float vectors of dimension dim */
+typedef float (*MemoryDotFn)(const float* a, const float* b, size_t dim);
+
+/*
+ * Embedding function
+ * Writes the dim-dimensional embedding of text to out.
+ * Returns 0 on success, -1 on failure
+ */
+typedef int (*MemoryEmbedFn)(const char* text, float* out, size_t dim, void* user_data);
+
+/*
+ * Vectors structure
+ * Row i describes store->entries[i]
+ */
+typedef struct MemoryVectors {
+    size_t dim;                  /* Dimension of every row */
+    MemoryVectorFormat format;   /* Row storage format */
+    void* rows;                  /* size * dim floats or int8 values */
+    float* scales;               /* Per-row scale of int8 rows, else NULL */
+    size_t size;                 /* Number of rows */
+    size_t capacity;             /* Allocated rows */
+    MemoryEmbedFn embed;         /* Embeds entries added without a vector */
+    void* user_data;             /* Passed to embed */
+    float* scratch;              /* dim floats; holds the last appended row,
+                                    normalized, until the next append */
+    size_t embed_failures;       /* Rows left zero because embed failed */
+} MemoryVectors;
+
+/*
+ * Sidecar file header
+ * Followed by count scales (int8 only) and count * dim row values
+ */
+typedef struct {
+    char magic[8];               /* MEMORY_VECTOR_MAGIC */
+    uint32_t version;            /* MEMORY_VECTOR_VERSION */
+    uint32_t byte_order;         /* MEMORY_SEGMENT_BYTE_ORDER as written */
+    uint64_t count;              /* Number of rows */
+    uint32_t dim;                /* Dimension of every row */
+    uint32_t format;             /* MemoryVectorFormat */
+} MemoryVectorHeader;
+
+/*
+ * Function Declarations
+ */
+
+/* Attach vectors of dimension dim to a store and keep them updated on
+ * every add. embed may be NULL, in which case entries added without a
+ * vector get a zero row. Existing entries are embedded immediately. */
+int eliza_memory_enable_vectors(MemoryStore* store, size_t dim, MemoryVectorFormat format,
+                               MemoryEmbedFn embed, void* user_data);
+
+/* Destroy a set of vectors */
+void eliza_memory_vectors_destroy(MemoryVectors* vectors);
+
+/* Make room for capacity rows */
+int eliza_memory_vectors_reserve(MemoryVectors* vectors, size_t capacity);
+
+/* Append a row (capacity must already be reserved). A NULL vector is
+ * computed from content with the embedding function. */
+int eliza_memory_vectors_append(MemoryVectors* vectors, const char* content,
+                               const float* vector);
+
+/* Remove all rows */
+void eliza_memory_vectors_clear(MemoryVectors* vectors);
+
+/* Drop the rows from size on, undoing a failed append */
+void eliza_memory_vectors_truncate(MemoryVectors* vectors, size_t size);
+
+/* Drop the rows of removed entries (see eliza_memory_index_remap) */
+void eliza_memory_vectors_remap(MemoryVectors* vectors, const uint32_t* map, size_t count);
+
+/* Write the row at position to out as dim floats */
+int eliza_memory_vectors_get(const MemoryVectors* vectors, size_t position, float* out);
+
+/* Replace the row of the entry at position */
+int eliza_memory_vectors_set(MemoryStore* store, size_t position, const float* vector);
+
+/* Scale a vector to unit length; zero vectors stay zero */
+void eliza_memory_vector_normalize(float* vector, size_t dim);
+
+/* The fastest float dot product kernel this CPU supports */
+MemoryDotFn eliza_memory_vector_dot_kernel(void);
+
+/* Write the k entries most similar to a query vector to results, best
+ * first, scored by cosine similarity. Returns the number written. */
+size_t eliza_memory_search_similar(MemoryStore* store, const float* query,
+                                  MemoryRankedResult* results, size_t k);
+
+/* Same as eliza_memory_search_similar with the query embedded by the
+ * store's embedding function */
+size_t eliza_memory_search_similar_text(MemoryStore* store, const char* text,
+                                       MemoryRankedResult* results, size_t k);
+
+/* Write the rows of a store to a vector file */
+int eliza_memory_vectors_save(MemoryStore* store, const char* filepath);
+
+/* Read the rows of a store from a vector file. Fails unless the file
+ * matches the store's entry count, dimension and format. */
+int eliza_memory_vectors_load(MemoryStore* store, const char* filepath);
+
+#endif /* ELIZA_MEMORY_VECTOR_H */
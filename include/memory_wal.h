@@ -0,0 +1,148 @@
+#ifndef ELIZA_MEMORY_WAL_H
+#define ELIZA_MEMORY_WAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "memory.h"
+
+/*
+ * Memory Write-Ahead Log
+ * Persists a store incrementally: every added, removed or changed entry
+ * is appended to a log as a checksummed frame, a background thread writes
+ * and fsyncs pending frames in groups, and a second thread periodically
+ * folds the log into a segment snapshot (see memory_segment.h) holding
+ * only the entries still live. This covers entries evicted from a bounded
+ * store, merged by deduplication or moved to a cold tier.
+ *
+ * The log knows an entry by the sequence number of the frame that added
+ * it. Snapshots keep that id for each entry (MEMORY_SEGMENT_IDS), so
+ * removals and updates logged after a compaction still find it.
+ *
+ * Files for a store at <path>:
+ *   <path>          segment snapshot
+ *   <path>.wal      active log
+ *   <path>.wal.old  log being compacted into the snapshot
+ *
+ * The active log is only moved aside once the previous one has been
+ * folded in; a failed compaction is retried first when the next one is
+ * due, so no log is ever overwritten.
+ */
+
+#define MEMORY_WAL_MAGIC "ELZMWAL"
+#define MEMORY_WAL_VERSION 2
+
+/* Frame types */
+#define MEMORY_WAL_RECORD_ADD 1
+#define MEMORY_WAL_RECORD_REMOVE 2
+#define MEMORY_WAL_RECORD_UPDATE 3
+#define MEMORY_WAL_RECORD_CLEAR 4
+
+/*
+ * WAL options structure
+ */
+typedef struct {
+    unsigned int sync_interval_ms;  /* Longest a frame waits for its fsync */
+    size_t sync_batch;              /* Pending frames that force an early fsync */
+    size_t compact_bytes;           /* Log size that triggers compaction */
+    unsigned int compact_interval_ms; /* Age of a non-empty log that triggers compaction, 0 for size only */
+} MemoryWalOptions;
+
+/*
+ * WAL statistics structure
+ */
+typedef struct {
+    uint64_t records;        /* Frames appended since open */
+    uint64_t syncs;          /* Group commits performed */
+    uint64_t bytes_written;  /* Log bytes written since open */
+    uint64_t compactions;    /* Completed compactions */
+    uint64_t compact_failures; /* Failed compactions, retried before the next rotation */
+    uint64_t replayed;       /* Frames replayed on open */
+} MemoryWalStats;
+
+/*
+ * WAL structure
+ * Attached to a store through store->wal
+ */
+typedef struct MemoryWal {
+    MemoryStore* store;
+    MemoryWalOptions options;
+    char* snapshot_path;
+    char* log_path;
+    char* old_log_path;
+    int fd;                  /* Active log, written by the sync thread only */
+    uint64_t* ids;           /* Id of the entry at each store position */
+    size_t ids_capacity;
+    int replaying;           /* Restoring the store on open, nothing is logged */
+    uint64_t replay_id;      /* Id of the entry being restored */
+
+    pthread_mutex_t lock;
+    pthread_cond_t work_cond;    /* Wakes the sync thread */
+    pthread_cond_t synced_cond;  /* Signals durable progress */
+    pthread_cond_t compact_cond; /* Wakes the compaction thread */
+    pthread_t sync_thread;
+    pthread_t compact_thread;
+
+    char* pending;           /* Encoded frames not yet written */
+    size_t pending_len;
+    size_t pending_capacity;
+    size_t pending_records;
+
+    uint64_t next_lsn;       /* Sequence number of the next frame */
+    uint64_t synced_lsn;     /* Highest durable sequence number */
+    uint64_t log_bytes;      /* Size of the active log */
+    uint64_t compact_at;     /* Log size that triggers the next compaction */
+    struct timespec compact_deadline; /* When the active log is old enough to compact */
+    int flush_requested;     /* A caller is waiting in eliza_memory_wal_sync */
+    int compact_requested;
+    int compacting;
+    int failed;              /* Set once a log write fails */
+    int running;
+    MemoryWalStats stats;
+} MemoryWal;
+
+/*
+ * Function Declarations
+ */
+
+/* Fill options with defaults: 10 ms sync window, 256-frame batches,
+ * compaction every 64 MB of log or once it is ten minutes old */
+void eliza_memory_wal_options_default(MemoryWalOptions* options);
+
+/* Load the snapshot and replay the logs at filepath into an empty store,
+ * then attach a log so later changes to the store are persisted.
+ * options may be NULL for defaults. Fails if a snapshot exists but is
+ * not a readable segment. */
+MemoryWal* eliza_memory_wal_open(MemoryStore* store, const char* filepath,
+                                const MemoryWalOptions* options);
+
+/* Flush pending frames, stop the background threads and detach the log */
+void eliza_memory_wal_close(MemoryWal* wal);
+
+/* Append an entry about to take a store position to the log (called by
+ * the add functions of memory.h) */
+int eliza_memory_wal_append(MemoryWal* wal, const MemoryEntry* entry, size_t position);
+
+/* Log the removal of the entry at position (called by eliza_memory_remove) */
+int eliza_memory_wal_remove(MemoryWal* wal, size_t position);
+
+/* Log a new importance and timestamp for the entry at position (called by
+ * eliza_memory_touch) */
+int eliza_memory_wal_update(MemoryWal* wal, size_t position, float importance, time_t timestamp);
+
+/* Log the removal of every entry (called by eliza_memory_clear) */
+int eliza_memory_wal_clear(MemoryWal* wal);
+
+/* Renumber entry positions after removals, as eliza_memory_index_remap */
+void eliza_memory_wal_remap(MemoryWal* wal, const uint32_t* map, size_t count);
+
+/* Block until every frame appended so far is durable */
+int eliza_memory_wal_sync(MemoryWal* wal);
+
+/* Ask the background thread to compact the log into the snapshot */
+void eliza_memory_wal_compact(MemoryWal* wal);
+
+/* Copy the current statistics */
+void eliza_memory_wal_get_stats(MemoryWal* wal, MemoryWalStats* stats);
+
+#endif /* ELIZA_MEMORY_WAL_H */
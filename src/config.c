@@ -2,6 +2,11 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 /*
  * Implementation of the Configuration System
@@ -10,6 +15,24 @@
 /* Initial capacity for configuration objects */
 #define INITIAL_CAPACITY 16
 
+/* Initial capacity of the parser's section stack */
+#define INITIAL_DEPTH 8
+
+/* Longest number converted with strtof; longer ones stay strings */
+#define NUMBER_MAX 64
+
+/*
+ * FNV-1a hash of a key of length bytes
+ */
+static uint32_t hash_key(const char* key, size_t length) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (unsigned char)key[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
 /*
  * Create a new configuration object
  */
@@ -17,19 +40,24 @@ ConfigObject* eliza_config_create(void) {
     ConfigObject* config = (ConfigObject*)malloc(sizeof(ConfigObject));
     if (!config) return NULL;
 
-    /* Allocate initial arrays */
+    /* Allocate initial arrays; the table stays at most half full */
     config->keys = (char**)malloc(INITIAL_CAPACITY * sizeof(char*));
     config->values = (ConfigValue*)malloc(INITIAL_CAPACITY * sizeof(ConfigValue));
+    config->hashes = (uint32_t*)malloc(INITIAL_CAPACITY * sizeof(uint32_t));
+    config->slots = (uint32_t*)calloc(INITIAL_CAPACITY * 2, sizeof(uint32_t));
     
-    if (!config->keys || !config->values) {
+    if (!config->keys || !config->values || !config->hashes || !config->slots) {
         free(config->keys);
         free(config->values);
+        free(config->hashes);
+        free(config->slots);
         free(config);
         return NULL;
     }
 
     config->size = 0;
     config->capacity = INITIAL_CAPACITY;
+    config->slot_count = INITIAL_CAPACITY * 2;
 
     return config;
 }
@@ -66,79 +94,227 @@ void eliza_config_destroy(ConfigObject* config) {
 
     free(config->keys);
     free(config->values);
+    free(config->hashes);
+    free(config->slots);
     free(config);
 }
 
 /*
- * Find a key in the configuration
- * Returns the index if found, -1 if not found
+ * Find the table slot of a key of length bytes, or the empty slot where
+ * it belongs
  */
-static int find_key(ConfigObject* config, const char* key) {
-    for (size_t i = 0; i < config->size; i++) {
-        if (strcmp(config->keys[i], key) == 0) {
-            return (int)i;
+static uint32_t* find_slot(const ConfigObject* config, const char* key, size_t length, uint32_t hash) {
+    size_t mask = config->slot_count - 1;
+    size_t i = hash & mask;
+
+    while (config->slots[i]) {
+        size_t index = config->slots[i] - 1;
+        if (config->hashes[index] == hash && strncmp(config->keys[index], key, length) == 0 &&
+            config->keys[index][length] == '\0') {
+            break;
         }
+        i = (i + 1) & mask;
     }
-    return -1;
+    return &config->slots[i];
+}
+
+/*
+ * Find a key of length bytes in the configuration
+ * Returns the index if found, -1 if not found
+ */
+static int find_key(const ConfigObject* config, const char* key, size_t length) {
+    uint32_t slot = *find_slot(config, key, length, hash_key(key, length));
+    return slot ? (int)(slot - 1) : -1;
 }
 
 /*
  * Ensure capacity for new entries
+ * The hash table is rebuilt at twice the entry capacity
  */
 static int ensure_capacity(ConfigObject* config) {
-    if (config->size >= config->capacity) {
-        size_t new_capacity = config->capacity * 2;
-        char** new_keys = (char**)realloc(config->keys, new_capacity * sizeof(char*));
-        ConfigValue* new_values = (ConfigValue*)realloc(config->values, new_capacity * sizeof(ConfigValue));
-
-        if (!new_keys || !new_values) {
-            free(new_keys);
-            free(new_values);
-            return -1;
-        }
+    if (config->size < config->capacity) return 0;
+
+    size_t new_capacity = config->capacity * 2;
+    char** new_keys = (char**)realloc(config->keys, new_capacity * sizeof(char*));
+    if (!new_keys) return -1;
+    config->keys = new_keys;
+
+    ConfigValue* new_values = (ConfigValue*)realloc(config->values, new_capacity * sizeof(ConfigValue));
+    if (!new_values) return -1;
+    config->values = new_values;
 
-        config->keys = new_keys;
-        config->values = new_values;
-        config->capacity = new_capacity;
+    uint32_t* new_hashes = (uint32_t*)realloc(config->hashes, new_capacity * sizeof(uint32_t));
+    if (!new_hashes) return -1;
+    config->hashes = new_hashes;
+
+    size_t slot_count = new_capacity * 2;
+    uint32_t* slots = (uint32_t*)calloc(slot_count, sizeof(uint32_t));
+    if (!slots) return -1;
+    for (size_t i = 0; i < config->size; i++) {
+        size_t j = config->hashes[i] & (slot_count - 1);
+        while (slots[j]) j = (j + 1) & (slot_count - 1);
+        slots[j] = (uint32_t)i + 1;
     }
+
+    free(config->slots);
+    config->slots = slots;
+    config->slot_count = slot_count;
+    config->capacity = new_capacity;
     return 0;
 }
 
+/*
+ * Find a key of length bytes, adding it with an unset value if it is
+ * missing
+ * *added tells the caller whether the value slot holds an old value
+ * Returns the index, or -1 on failure
+ */
+static int insert_key(ConfigObject* config, const char* key, size_t length, int* added) {
+    uint32_t hash = hash_key(key, length);
+    uint32_t* slot = find_slot(config, key, length, hash);
+    *added = !*slot;
+    if (*slot) return (int)(*slot - 1);
+
+    /* Growing rebuilds the table, so the slot is looked up again */
+    if (config->size >= config->capacity) {
+        if (ensure_capacity(config) < 0) return -1;
+        slot = find_slot(config, key, length, hash);
+    }
+
+    char* copy = (char*)malloc(length + 1);
+    if (!copy) return -1;
+    memcpy(copy, key, length);
+    copy[length] = '\0';
+
+    size_t index = config->size++;
+    config->keys[index] = copy;
+    config->hashes[index] = hash;
+    *slot = (uint32_t)index + 1;
+    return (int)index;
+}
+
 /*
  * Get a value from the configuration
  */
 ConfigValue* eliza_config_get(ConfigObject* config, const char* key) {
     if (!config || !key) return NULL;
 
-    int index = find_key(config, key);
+    int index = find_key(config, key, strlen(key));
     if (index < 0) return NULL;
 
     return &config->values[index];
 }
 
+/*
+ * Resolve a key once for later reads
+ */
+ConfigKey eliza_config_resolve(const ConfigObject* config, const char* key) {
+    ConfigKey handle;
+    handle.root = config;
+    handle.object = config;
+    handle.index = CONFIG_KEY_NONE;
+    if (!config || !key) return handle;
+
+    int index = find_key(config, key, strlen(key));
+    if (index >= 0) handle.index = (size_t)index;
+    return handle;
+}
+
+/*
+ * Get the value of a resolved key
+ */
+ConfigValue* eliza_config_get_key(ConfigObject* config, ConfigKey key) {
+    if (!config || key.root != config || !key.object || key.index >= key.object->size) return NULL;
+    return &((ConfigObject*)key.object)->values[key.index];
+}
+
+/*
+ * Follow a dotted path through nested sections
+ * Returns the section holding the last key and sets *index to its
+ * position, or returns NULL if the path does not lead to a value
+ */
+static ConfigObject* follow_path(const ConfigObject* config, const char* path, int* index) {
+    for (;;) {
+        const char* dot = strchr(path, '.');
+        size_t length = dot ? (size_t)(dot - path) : strlen(path);
+        if (length == 0) return NULL;
+
+        *index = find_key(config, path, length);
+        if (*index < 0) return NULL;
+        if (!dot) return (ConfigObject*)config;
+
+        const ConfigValue* value = &config->values[*index];
+        if (value->type != CONFIG_TYPE_OBJECT) return NULL;
+        config = value->value.object_val;
+        path = dot + 1;
+    }
+}
+
+/*
+ * Get a value by a dotted path
+ */
+ConfigValue* eliza_config_get_path(ConfigObject* config, const char* path) {
+    if (!config || !path) return NULL;
+
+    int index;
+    ConfigObject* section = follow_path(config, path, &index);
+    return section ? &section->values[index] : NULL;
+}
+
+/*
+ * Resolve a dotted path once for later reads
+ */
+ConfigKey eliza_config_resolve_path(const ConfigObject* config, const char* path) {
+    ConfigKey handle;
+    handle.root = config;
+    handle.object = NULL;
+    handle.index = CONFIG_KEY_NONE;
+    if (!config || !path) return handle;
+
+    int index;
+    ConfigObject* section = follow_path(config, path, &index);
+    if (section) {
+        handle.object = section;
+        handle.index = (size_t)index;
+    }
+    return handle;
+}
+
+/*
+ * Find or add a key for a setter, releasing the value it replaces
+ * An object set again under its own key is kept
+ * Returns the index, or -1 on failure
+ */
+static int set_key(ConfigObject* config, const char* key, size_t length,
+                   const ConfigValue* replacement) {
+    int added;
+    int index = insert_key(config, key, length, &added);
+    if (index < 0) return -1;
+
+    ConfigValue* old = &config->values[index];
+    if (!added && !(old->type == CONFIG_TYPE_OBJECT && replacement->type == CONFIG_TYPE_OBJECT &&
+                    old->value.object_val == replacement->value.object_val)) {
+        free_config_value(old);
+    }
+    *old = *replacement;
+    return index;
+}
+
 /*
  * Set a string value
  */
 int eliza_config_set_string(ConfigObject* config, const char* key, const char* value) {
     if (!config || !key || !value) return -1;
 
-    int index = find_key(config, key);
-    if (index < 0) {
-        /* Add new key-value pair */
-        if (ensure_capacity(config) < 0) return -1;
-        
-        index = config->size++;
-        config->keys[index] = strdup(key);
-    } else {
-        /* Free existing value if it's a string */
-        if (config->values[index].type == CONFIG_TYPE_STRING) {
-            free(config->values[index].value.string_val);
-        }
-    }
-
-    config->values[index].type = CONFIG_TYPE_STRING;
-    config->values[index].value.string_val = strdup(value);
+    ConfigValue replacement;
+    replacement.type = CONFIG_TYPE_STRING;
+    replacement.value.string_val = strdup(value);
+    if (!replacement.value.string_val) return -1;
 
+    if (set_key(config, key, strlen(key), &replacement) < 0) {
+        free(replacement.value.string_val);
+        return -1;
+    }
     return 0;
 }
 
@@ -148,18 +324,10 @@ int eliza_config_set_string(ConfigObject* config, const char* key, const char* v
 int eliza_config_set_int(ConfigObject* config, const char* key, int value) {
     if (!config || !key) return -1;
 
-    int index = find_key(config, key);
-    if (index < 0) {
-        if (ensure_capacity(config) < 0) return -1;
-        
-        index = config->size++;
-        config->keys[index] = strdup(key);
-    }
-
-    config->values[index].type = CONFIG_TYPE_INT;
-    config->values[index].value.int_val = value;
-
-    return 0;
+    ConfigValue replacement;
+    replacement.type = CONFIG_TYPE_INT;
+    replacement.value.int_val = value;
+    return set_key(config, key, strlen(key), &replacement) < 0 ? -1 : 0;
 }
 
 /*
@@ -168,18 +336,10 @@ int eliza_config_set_int(ConfigObject* config, const char* key, int value) {
 int eliza_config_set_float(ConfigObject* config, const char* key, float value) {
     if (!config || !key) return -1;
 
-    int index = find_key(config, key);
-    if (index < 0) {
-        if (ensure_capacity(config) < 0) return -1;
-        
-        index = config->size++;
-        config->keys[index] = strdup(key);
-    }
-
-    config->values[index].type = CONFIG_TYPE_FLOAT;
-    config->values[index].value.float_val = value;
-
-    return 0;
+    ConfigValue replacement;
+    replacement.type = CONFIG_TYPE_FLOAT;
+    replacement.value.float_val = value;
+    return set_key(config, key, strlen(key), &replacement) < 0 ? -1 : 0;
 }
 
 /*
@@ -188,127 +348,290 @@ int eliza_config_set_float(ConfigObject* config, const char* key, float value) {
 int eliza_config_set_bool(ConfigObject* config, const char* key, int value) {
     if (!config || !key) return -1;
 
-    int index = find_key(config, key);
-    if (index < 0) {
-        if (ensure_capacity(config) < 0) return -1;
-        
-        index = config->size++;
-        config->keys[index] = strdup(key);
+    ConfigValue replacement;
+    replacement.type = CONFIG_TYPE_BOOL;
+    replacement.value.bool_val = value;
+    return set_key(config, key, strlen(key), &replacement) < 0 ? -1 : 0;
+}
+
+/*
+ * Set an object value
+ */
+int eliza_config_set_object(ConfigObject* config, const char* key, ConfigObject* value) {
+    if (!config || !key || !value) return -1;
+
+    ConfigValue replacement;
+    replacement.type = CONFIG_TYPE_OBJECT;
+    replacement.value.object_val = value;
+    return set_key(config, key, strlen(key), &replacement) < 0 ? -1 : 0;
+}
+
+/*
+ * Bytes of the parsed text, not terminated
+ */
+typedef struct {
+    const char* data;
+    size_t length;
+} ConfigView;
+
+/*
+ * Section stack of the parser, the root at the bottom
+ */
+typedef struct {
+    ConfigObject** sections;
+    size_t depth;
+    size_t capacity;
+} ConfigStack;
+
+static int is_blank(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static int is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+/*
+ * Strip blanks from both ends of a view
+ */
+static ConfigView trim_view(ConfigView view) {
+    while (view.length > 0 && is_blank(view.data[0])) {
+        view.data++;
+        view.length--;
+    }
+    while (view.length > 0 && is_blank(view.data[view.length - 1])) view.length--;
+    return view;
+}
+
+static int view_equals(ConfigView view, const char* text) {
+    size_t length = strlen(text);
+    return view.length == length && memcmp(view.data, text, length) == 0;
+}
+
+/*
+ * Store a value under a key, telling its type from the text in one pass:
+ * [+-]digits is an int if it fits, decimals and exponents make a float,
+ * true and false are bools, and anything else is a string
+ * Returns 0 on success, -1 on failure
+ */
+static int parse_value(ConfigObject* section, ConfigView key, ConfigView text) {
+    const char* p = text.data;
+    size_t n = text.length;
+    size_t i = 0;
+
+    int negative = 0;
+    if (i < n && (p[i] == '+' || p[i] == '-')) negative = p[i++] == '-';
+
+    long long integer = 0;
+    size_t digits = 0;
+    for (; i < n && is_digit(p[i]); i++, digits++) {
+        if (integer <= (long long)INT_MAX + 1) integer = integer * 10 + (p[i] - '0');
     }
 
-    config->values[index].type = CONFIG_TYPE_BOOL;
-    config->values[index].value.bool_val = value;
+    int fraction = 0;
+    if (i < n && p[i] == '.') {
+        fraction = 1;
+        for (i++; i < n && is_digit(p[i]); i++) digits++;
+    }
+
+    int exponent = 0;
+    if (digits > 0 && i < n && (p[i] == 'e' || p[i] == 'E')) {
+        size_t start = ++i;
+        if (i < n && (p[i] == '+' || p[i] == '-')) start = ++i;
+        for (; i < n && is_digit(p[i]); i++) {
+        }
+        exponent = i > start ? 1 : -1;
+    }
+
+    ConfigValue replacement;
+    if (digits > 0 && i == n && exponent >= 0) {
+        if (negative) integer = -integer;
+        if (!fraction && !exponent && integer >= INT_MIN && integer <= INT_MAX) {
+            replacement.type = CONFIG_TYPE_INT;
+            replacement.value.int_val = (int)integer;
+            return set_key(section, key.data, key.length, &replacement) < 0 ? -1 : 0;
+        }
+
+        /* strtof rounds correctly but needs a terminated copy */
+        char number[NUMBER_MAX];
+        if (n < sizeof(number)) {
+            memcpy(number, p, n);
+            number[n] = '\0';
+            replacement.type = CONFIG_TYPE_FLOAT;
+            replacement.value.float_val = strtof(number, NULL);
+            return set_key(section, key.data, key.length, &replacement) < 0 ? -1 : 0;
+        }
+    }
+
+    if (view_equals(text, "true") || view_equals(text, "false")) {
+        replacement.type = CONFIG_TYPE_BOOL;
+        replacement.value.bool_val = p[0] == 't';
+        return set_key(section, key.data, key.length, &replacement) < 0 ? -1 : 0;
+    }
 
+    replacement.type = CONFIG_TYPE_STRING;
+    replacement.value.string_val = (char*)malloc(n + 1);
+    if (!replacement.value.string_val) return -1;
+    memcpy(replacement.value.string_val, p, n);
+    replacement.value.string_val[n] = '\0';
+
+    if (set_key(section, key.data, key.length, &replacement) < 0) {
+        free(replacement.value.string_val);
+        return -1;
+    }
     return 0;
 }
 
 /*
- * Set an object value
+ * Enter the section called name in the innermost one, reusing a section
+ * of that name so a repeated block adds to it
+ * Returns 0 on success, -1 on failure
  */
-int eliza_config_set_object(ConfigObject* config, const char* key, ConfigObject* value) {
-    if (!config || !key || !value) return -1;
+static int open_section(ConfigStack* stack, ConfigView name) {
+    if (stack->depth == stack->capacity) {
+        size_t capacity = stack->capacity * 2;
+        ConfigObject** sections = (ConfigObject**)realloc(stack->sections,
+                                  capacity * sizeof(ConfigObject*));
+        if (!sections) return -1;
+        stack->sections = sections;
+        stack->capacity = capacity;
+    }
 
-    int index = find_key(config, key);
-    if (index < 0) {
-        if (ensure_capacity(config) < 0) return -1;
-        
-        index = config->size++;
-        config->keys[index] = strdup(key);
-    } else if (config->values[index].type == CONFIG_TYPE_OBJECT) {
-        eliza_config_destroy(config->values[index].value.object_val);
+    /* An unnamed block stays in the enclosing section */
+    ConfigObject* parent = stack->sections[stack->depth - 1];
+    if (name.length == 0) {
+        stack->sections[stack->depth++] = parent;
+        return 0;
     }
 
-    config->values[index].type = CONFIG_TYPE_OBJECT;
-    config->values[index].value.object_val = value;
+    int index = find_key(parent, name.data, name.length);
+    if (index >= 0 && parent->values[index].type == CONFIG_TYPE_OBJECT) {
+        stack->sections[stack->depth++] = parent->values[index].value.object_val;
+        return 0;
+    }
 
+    ConfigValue replacement;
+    replacement.type = CONFIG_TYPE_OBJECT;
+    replacement.value.object_val = eliza_config_create();
+    if (!replacement.value.object_val) return -1;
+    if (set_key(parent, name.data, name.length, &replacement) < 0) {
+        eliza_config_destroy(replacement.value.object_val);
+        return -1;
+    }
+    stack->sections[stack->depth++] = replacement.value.object_val;
     return 0;
 }
 
+/*
+ * Parse one trimmed, non-empty line
+ * Returns 0 on success, -1 on failure
+ */
+static int parse_line(ConfigStack* stack, ConfigView line) {
+    if (line.data[0] == '#') return 0;
+
+    /* Closing brace; a stray one at the root is ignored */
+    if (line.data[0] == '}') {
+        if (stack->depth > 1) stack->depth--;
+        return 0;
+    }
+
+    /* "name {" or, as saved, "name = {" */
+    if (line.data[line.length - 1] == '{') {
+        ConfigView name = { line.data, line.length - 1 };
+        name = trim_view(name);
+        if (name.length > 0 && name.data[name.length - 1] == '=') {
+            name.length--;
+            name = trim_view(name);
+        }
+        return open_section(stack, name);
+    }
+
+    const char* equals = (const char*)memchr(line.data, '=', line.length);
+    if (!equals) return 0;
+
+    ConfigView key = { line.data, (size_t)(equals - line.data) };
+    ConfigView value = { equals + 1, line.length - key.length - 1 };
+    key = trim_view(key);
+    value = trim_view(value);
+    if (key.length == 0 || value.length == 0) return 0;
+
+    return parse_value(stack->sections[stack->depth - 1], key, value);
+}
+
+/*
+ * Parse configuration text
+ * Returns the configuration, or NULL on failure
+ */
+ConfigObject* eliza_config_parse_buffer(const char* text, size_t length) {
+    if (!text && length > 0) return NULL;
+
+    ConfigObject* config = eliza_config_create();
+    if (!config) return NULL;
+
+    ConfigStack stack;
+    stack.capacity = INITIAL_DEPTH;
+    stack.depth = 1;
+    stack.sections = (ConfigObject**)malloc(stack.capacity * sizeof(ConfigObject*));
+    if (!stack.sections) {
+        eliza_config_destroy(config);
+        return NULL;
+    }
+    stack.sections[0] = config;
+
+    const char* end = text + length;
+    for (const char* p = text; p < end;) {
+        const char* newline = (const char*)memchr(p, '\n', (size_t)(end - p));
+        const char* line_end = newline ? newline : end;
+
+        ConfigView line = { p, (size_t)(line_end - p) };
+        line = trim_view(line);
+        if (line.length > 0 && parse_line(&stack, line) < 0) {
+            free(stack.sections);
+            eliza_config_destroy(config);
+            return NULL;
+        }
+        p = line_end + 1;
+    }
+
+    free(stack.sections);
+    return config;
+}
+
 /*
  * Parse a configuration file
- * Supports a simple key-value format:
+ * Supports a simple key-value format, with sections nested to any depth:
  * key = value
  * section {
  *     key = value
  * }
+ * The file is mapped and read in place
  */
 ConfigObject* eliza_config_parse_file(const char* filepath) {
     if (!filepath) return NULL;
 
-    FILE* file = fopen(filepath, "r");
-    if (!file) return NULL;
+    int fd = open(filepath, O_RDONLY);
+    if (fd < 0) return NULL;
 
-    ConfigObject* config = eliza_config_create();
-    if (!config) {
-        fclose(file);
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
         return NULL;
     }
 
-    char line[1024];
-    char key[256];
-    char value[768];
-    ConfigObject* current_section = config;
-
-    while (fgets(line, sizeof(line), file)) {
-        /* Skip comments and empty lines */
-        if (line[0] == '#' || line[0] == '\n') continue;
-
-        /* Handle section */
-        if (strchr(line, '{')) {
-            if (sscanf(line, "%s {", key) == 1) {
-                ConfigObject* section = eliza_config_create();
-                if (section) {
-                    eliza_config_set_object(current_section, key, section);
-                    current_section = section;
-                }
-            }
-            continue;
-        }
-
-        /* Handle section end */
-        if (strchr(line, '}')) {
-            if (current_section != config) {
-                current_section = config;
-            }
-            continue;
-        }
-
-        /* Parse key-value pair */
-        if (sscanf(line, "%[^=] = %[^\n]", key, value) == 2) {
-            /* Trim whitespace */
-            char* k = key;
-            char* v = value;
-            while (*k == ' ') k++;
-            while (*v == ' ') v++;
-            char* end = k + strlen(k) - 1;
-            while (end > k && *end == ' ') *end-- = '\0';
-            end = v + strlen(v) - 1;
-            while (end > v && *end == ' ') *end-- = '\0';
-
-            /* Try to parse as different types */
-            char* endptr;
-            long int_val = strtol(v, &endptr, 10);
-            if (*endptr == '\0') {
-                eliza_config_set_int(current_section, k, (int)int_val);
-                continue;
-            }
-
-            float float_val = strtof(v, &endptr);
-            if (*endptr == '\0') {
-                eliza_config_set_float(current_section, k, float_val);
-                continue;
-            }
-
-            if (strcmp(v, "true") == 0 || strcmp(v, "false") == 0) {
-                eliza_config_set_bool(current_section, k, strcmp(v, "true") == 0);
-                continue;
-            }
-
-            eliza_config_set_string(current_section, k, v);
-        }
+    /* Empty files cannot be mapped */
+    size_t size = (size_t)st.st_size;
+    if (size == 0) {
+        close(fd);
+        return eliza_config_create();
     }
 
-    fclose(file);
+    void* map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return NULL;
+    madvise(map, size, MADV_SEQUENTIAL);
+
+    ConfigObject* config = eliza_config_parse_buffer((const char*)map, size);
+    munmap(map, size);
     return config;
 }
 
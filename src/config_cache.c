@@ -0,0 +1,568 @@
+#include "../include/config_cache.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/*
+ * Implementation of the Configuration Cache
+ */
+
+/* Alignment of the object table and every array in the image */
+#define IMAGE_ALIGN 8
+
+/* Images are mapped at one of IMAGE_SPREAD addresses IMAGE_STRIDE apart
+ * from IMAGE_BASE, chosen by source hash, far from where the kernel
+ * places mappings and the heap on 64-bit Linux */
+#define IMAGE_BASE 0x500000000000ull
+#define IMAGE_SPREAD 4096
+#define IMAGE_STRIDE (1ull << 32)
+
+/* Older headers lack the flag; older kernels treat it as a hint */
+#ifndef MAP_FIXED_NOREPLACE
+#define MAP_FIXED_NOREPLACE 0x100000
+#endif
+
+/*
+ * Identity of a source file
+ */
+typedef struct {
+    uint64_t size;
+    int64_t mtime_sec;
+    int64_t mtime_nsec;
+    uint64_t hash;
+} SourceKey;
+
+/*
+ * Objects of a tree in breadth-first order, the root first
+ */
+typedef struct {
+    const ConfigObject** objects;
+    size_t count;
+    size_t capacity;
+} ObjectList;
+
+static uint64_t align_up(uint64_t n) {
+    return (n + IMAGE_ALIGN - 1) & ~(uint64_t)(IMAGE_ALIGN - 1);
+}
+
+/*
+ * FNV-1a hash of the source contents
+ */
+static uint64_t hash_source(const char* data, size_t length) {
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (unsigned char)data[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+/*
+ * Slots of the compact hash table written for count keys, at most half
+ * full like the in-memory one
+ */
+static size_t table_size(size_t count) {
+    size_t slots = 2;
+    while (slots < count * 2) slots *= 2;
+    return slots;
+}
+
+/*
+ * Image bytes taken by the arrays of an object
+ */
+static uint64_t array_bytes(size_t size) {
+    return align_up(size * sizeof(char*)) + align_up(size * sizeof(ConfigValue)) +
+           align_up(size * sizeof(uint32_t)) + align_up(table_size(size) * sizeof(uint32_t));
+}
+
+/*
+ * Map an open source file and identify it
+ * Returns the mapping, NULL for an empty file, or MAP_FAILED on failure
+ */
+static void* map_source(int fd, SourceKey* key) {
+    struct stat st;
+    if (fstat(fd, &st) != 0) return MAP_FAILED;
+
+    key->size = (uint64_t)st.st_size;
+    key->mtime_sec = (int64_t)st.st_mtim.tv_sec;
+    key->mtime_nsec = (int64_t)st.st_mtim.tv_nsec;
+    key->hash = hash_source(NULL, 0);
+    if (st.st_size == 0) return NULL;
+
+    void* map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) return MAP_FAILED;
+    madvise(map, (size_t)st.st_size, MADV_SEQUENTIAL);
+    key->hash = hash_source((const char*)map, (size_t)st.st_size);
+    return map;
+}
+
+/*
+ * Collect the objects of a tree, the root first
+ * Returns 0 on success, -1 on failure
+ */
+static int list_objects(const ConfigObject* root, ObjectList* list) {
+    list->count = 0;
+    list->capacity = 16;
+    list->objects = (const ConfigObject**)malloc(list->capacity * sizeof(ConfigObject*));
+    if (!list->objects) return -1;
+    list->objects[list->count++] = root;
+
+    for (size_t i = 0; i < list->count; i++) {
+        const ConfigObject* object = list->objects[i];
+        for (size_t j = 0; j < object->size; j++) {
+            if (object->values[j].type != CONFIG_TYPE_OBJECT) continue;
+
+            if (list->count == list->capacity) {
+                size_t capacity = list->capacity * 2;
+                const ConfigObject** objects = (const ConfigObject**)realloc(list->objects,
+                                               capacity * sizeof(ConfigObject*));
+                if (!objects) {
+                    free(list->objects);
+                    return -1;
+                }
+                list->objects = objects;
+                list->capacity = capacity;
+            }
+            list->objects[list->count++] = object->values[j].value.object_val;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Address an image would map at, spread by source so a process can hold
+ * the images of several files at their own addresses
+ */
+static uint64_t image_address(const SourceKey* key) {
+    if (sizeof(void*) < 8) return 0;
+    return IMAGE_BASE + (key->hash % IMAGE_SPREAD) * IMAGE_STRIDE;
+}
+
+/*
+ * Copy a string to the heap of the image
+ * Returns its address once the image is mapped
+ */
+static char* place_string(char* image, uint64_t address, uint64_t* heap, const char* text) {
+    uint64_t offset = *heap;
+    size_t length = strlen(text) + 1;
+    memcpy(image + offset, text, length);
+    *heap += length;
+    return (char*)(uintptr_t)(address + offset);
+}
+
+/*
+ * Build the image of a configuration in memory, its pointers set for the
+ * address it will be mapped at
+ * Returns the image, or NULL on failure
+ */
+static char* build_image(const ConfigObject* config, const SourceKey* key, uint64_t* image_size) {
+    ObjectList list;
+    if (list_objects(config, &list) < 0) return NULL;
+
+    uint64_t objects_offset = align_up(sizeof(ConfigCacheHeader));
+    uint64_t arrays_offset = align_up(objects_offset + list.count * sizeof(ConfigObject));
+    uint64_t heap_offset = arrays_offset;
+    uint64_t heap_size = 0;
+    for (size_t i = 0; i < list.count; i++) {
+        const ConfigObject* object = list.objects[i];
+        heap_offset += array_bytes(object->size);
+        for (size_t j = 0; j < object->size; j++) {
+            heap_size += strlen(object->keys[j]) + 1;
+            if (object->values[j].type == CONFIG_TYPE_STRING) {
+                heap_size += strlen(object->values[j].value.string_val) + 1;
+            }
+        }
+    }
+
+    *image_size = heap_offset + heap_size;
+    char* image = (char*)calloc(1, (size_t)*image_size);
+    if (!image) {
+        free(list.objects);
+        return NULL;
+    }
+
+    uint64_t address = image_address(key);
+    ConfigCacheHeader* header = (ConfigCacheHeader*)image;
+    memcpy(header->magic, CONFIG_CACHE_MAGIC, sizeof(CONFIG_CACHE_MAGIC));
+    header->version = CONFIG_CACHE_VERSION;
+    header->byte_order = CONFIG_CACHE_BYTE_ORDER;
+    header->object_size = sizeof(ConfigObject);
+    header->value_size = sizeof(ConfigValue);
+    header->source_size = key->size;
+    header->source_mtime_sec = key->mtime_sec;
+    header->source_mtime_nsec = key->mtime_nsec;
+    header->source_hash = key->hash;
+    header->image_size = *image_size;
+    header->base_address = address;
+    header->object_count = list.count;
+    header->objects_offset = objects_offset;
+    header->heap_offset = heap_offset;
+
+    /* Children were listed in the order their values are met here */
+    ConfigObject* objects = (ConfigObject*)(image + objects_offset);
+    uint64_t arrays = arrays_offset;
+    uint64_t heap = heap_offset;
+    size_t next_child = 1;
+    for (size_t i = 0; i < list.count; i++) {
+        const ConfigObject* object = list.objects[i];
+        size_t size = object->size;
+        uint64_t keys_offset = arrays;
+        uint64_t values_offset = keys_offset + align_up(size * sizeof(char*));
+        uint64_t hashes_offset = values_offset + align_up(size * sizeof(ConfigValue));
+        uint64_t slots_offset = hashes_offset + align_up(size * sizeof(uint32_t));
+        arrays += array_bytes(size);
+
+        ConfigObject* out = &objects[i];
+        out->size = size;
+        out->capacity = size;
+        out->slot_count = table_size(size);
+        out->keys = (char**)(uintptr_t)(address + keys_offset);
+        out->values = (ConfigValue*)(uintptr_t)(address + values_offset);
+        out->hashes = (uint32_t*)(uintptr_t)(address + hashes_offset);
+        out->slots = (uint32_t*)(uintptr_t)(address + slots_offset);
+
+        char** keys = (char**)(image + keys_offset);
+        ConfigValue* values = (ConfigValue*)(image + values_offset);
+        uint32_t* hashes = (uint32_t*)(image + hashes_offset);
+        uint32_t* slots = (uint32_t*)(image + slots_offset);
+        size_t mask = out->slot_count - 1;
+
+        for (size_t j = 0; j < size; j++) {
+            keys[j] = place_string(image, address, &heap, object->keys[j]);
+            values[j] = object->values[j];
+            if (values[j].type == CONFIG_TYPE_STRING) {
+                values[j].value.string_val = place_string(image, address, &heap,
+                                                          object->values[j].value.string_val);
+            } else if (values[j].type == CONFIG_TYPE_OBJECT) {
+                uint64_t offset = objects_offset + next_child++ * sizeof(ConfigObject);
+                values[j].value.object_val = (ConfigObject*)(uintptr_t)(address + offset);
+            }
+
+            hashes[j] = object->hashes[j];
+            size_t k = hashes[j] & mask;
+            while (slots[k]) k = (k + 1) & mask;
+            slots[k] = (uint32_t)j + 1;
+        }
+    }
+
+    free(list.objects);
+    return image;
+}
+
+/*
+ * Write an image for a source, then rename it into place
+ * Returns 0 on success, -1 on failure
+ */
+static int write_image(const ConfigObject* config, const SourceKey* key, const char* cache_path) {
+    uint64_t image_size;
+    char* image = build_image(config, key, &image_size);
+    if (!image) return -1;
+
+    /* Processes and threads starting together may each rebuild the
+     * image, so every writer gets a file of its own */
+    size_t path_len = strlen(cache_path);
+    char* tmp_path = (char*)malloc(path_len + 8);
+    if (!tmp_path) {
+        free(image);
+        return -1;
+    }
+    snprintf(tmp_path, path_len + 8, "%s.XXXXXX", cache_path);
+
+    int fd = mkstemp(tmp_path);
+    FILE* file = NULL;
+    if (fd >= 0) {
+        /* mkstemp creates the file private to its owner */
+        if (fchmod(fd, 0644) != 0 || !(file = fdopen(fd, "wb"))) {
+            close(fd);
+            remove(tmp_path);
+        }
+    }
+    int ok = file != NULL;
+    if (file) {
+        ok = fwrite(image, 1, (size_t)image_size, file) == image_size &&
+             fflush(file) == 0 &&
+             fsync(fileno(file)) == 0;
+        if (fclose(file) != 0) ok = 0;
+        if (ok && rename(tmp_path, cache_path) != 0) ok = 0;
+        if (!ok) remove(tmp_path);
+    }
+
+    free(tmp_path);
+    free(image);
+    return ok ? 0 : -1;
+}
+
+/*
+ * Write the image of a configuration parsed from a source file
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_config_cache_write(const ConfigObject* config, const char* source_path,
+                             const char* cache_path) {
+    if (!config || !source_path || !cache_path) return -1;
+
+    int fd = open(source_path, O_RDONLY);
+    if (fd < 0) return -1;
+
+    SourceKey key;
+    void* source = map_source(fd, &key);
+    close(fd);
+    if (source == MAP_FAILED) return -1;
+    if (source) munmap(source, (size_t)key.size);
+
+    return write_image(config, &key, cache_path);
+}
+
+/*
+ * Address of an image array, checking it is aligned and in bounds
+ * Returns the address, or NULL if it is not
+ */
+static char* image_at(char* base, uint64_t offset, uint64_t bytes, uint64_t end) {
+    if (offset % IMAGE_ALIGN != 0 || offset > end || bytes > end - offset) return NULL;
+    return base + offset;
+}
+
+/*
+ * Move the pointers of an image mapped away from its address, checking
+ * each one lands inside it
+ * Without move the pointers are only checked, for an image mapped
+ * read-only at its own address
+ * Arrays must follow each other as written, so none is moved twice
+ * Returns the root, or NULL if the image is corrupt
+ */
+static ConfigObject* relocate(char* base, const ConfigCacheHeader* header, int move) {
+    uint64_t image_size = header->image_size;
+    uint64_t heap_offset = header->heap_offset;
+    uint64_t objects_offset = header->objects_offset;
+    uint64_t count = header->object_count;
+    uint64_t address = header->base_address;
+
+    if (count == 0 || count > image_size / sizeof(ConfigObject) || heap_offset > image_size) return NULL;
+    ConfigObject* objects = (ConfigObject*)image_at(base, objects_offset, count * sizeof(ConfigObject),
+                                                    heap_offset);
+    if (!objects) return NULL;
+
+    /* Strings end within the heap when its last byte ends one */
+    if (heap_offset < image_size && base[image_size - 1] != '\0') return NULL;
+
+    uint64_t arrays = align_up(objects_offset + count * sizeof(ConfigObject));
+    for (uint64_t i = 0; i < count; i++) {
+        ConfigObject* object = &objects[i];
+        size_t size = object->size;
+        if (size > image_size || object->slot_count != table_size(size)) return NULL;
+
+        uint64_t keys_offset = arrays;
+        uint64_t values_offset = keys_offset + align_up(size * sizeof(char*));
+        uint64_t hashes_offset = values_offset + align_up(size * sizeof(ConfigValue));
+        uint64_t slots_offset = hashes_offset + align_up(size * sizeof(uint32_t));
+        if ((uint64_t)(uintptr_t)object->keys - address != keys_offset ||
+            (uint64_t)(uintptr_t)object->values - address != values_offset ||
+            (uint64_t)(uintptr_t)object->hashes - address != hashes_offset ||
+            (uint64_t)(uintptr_t)object->slots - address != slots_offset ||
+            !image_at(base, arrays, array_bytes(size), heap_offset)) {
+            return NULL;
+        }
+        arrays += array_bytes(size);
+
+        if (move) {
+            object->keys = (char**)(base + keys_offset);
+            object->values = (ConfigValue*)(base + values_offset);
+            object->hashes = (uint32_t*)(base + hashes_offset);
+            object->slots = (uint32_t*)(base + slots_offset);
+        }
+
+        for (size_t j = 0; j < size; j++) {
+            uint64_t key = (uint64_t)(uintptr_t)object->keys[j] - address;
+            if (key < heap_offset || key >= image_size) return NULL;
+            if (move) object->keys[j] = base + key;
+
+            ConfigValue* value = &object->values[j];
+            if (value->type == CONFIG_TYPE_STRING) {
+                uint64_t string = (uint64_t)(uintptr_t)value->value.string_val - address;
+                if (string < heap_offset || string >= image_size) return NULL;
+                if (move) value->value.string_val = base + string;
+            } else if (value->type == CONFIG_TYPE_OBJECT) {
+                uint64_t child = (uint64_t)(uintptr_t)value->value.object_val - address;
+                if (child < objects_offset || (child - objects_offset) % sizeof(ConfigObject) != 0 ||
+                    (child - objects_offset) / sizeof(ConfigObject) >= count) {
+                    return NULL;
+                }
+                if (move) value->value.object_val = (ConfigObject*)(base + child);
+            } else if (value->type != CONFIG_TYPE_INT && value->type != CONFIG_TYPE_FLOAT &&
+                       value->type != CONFIG_TYPE_BOOL) {
+                return NULL;
+            }
+        }
+
+        /* Lookups probe until an empty slot, so one must exist */
+        size_t used = 0;
+        for (size_t j = 0; j < object->slot_count; j++) {
+            if (object->slots[j] > size) return NULL;
+            if (object->slots[j]) used++;
+        }
+        if (used != size) return NULL;
+    }
+    return objects;
+}
+
+/*
+ * Open an image and check its header against this build
+ * Returns the open file, or -1 on failure
+ */
+static int read_header(const char* cache_path, ConfigCacheHeader* header) {
+    int fd = open(cache_path, O_RDONLY);
+    if (fd < 0) return -1;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || pread(fd, header, sizeof(*header), 0) != (ssize_t)sizeof(*header) ||
+        memcmp(header->magic, CONFIG_CACHE_MAGIC, sizeof(CONFIG_CACHE_MAGIC)) != 0 ||
+        header->version != CONFIG_CACHE_VERSION ||
+        header->byte_order != CONFIG_CACHE_BYTE_ORDER ||
+        header->object_size != sizeof(ConfigObject) ||
+        header->value_size != sizeof(ConfigValue) ||
+        header->image_size != (uint64_t)st.st_size) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/*
+ * Map an image, at its own address when that is free
+ * Returns 0 on success, -1 if it cannot be mapped or is corrupt
+ */
+static int map_image(ConfigCache* cache, int fd, const ConfigCacheHeader* header) {
+    size_t size = (size_t)header->image_size;
+
+    /* Read-only and shared with the page cache. Kernels without
+     * MAP_FIXED_NOREPLACE take the address as a hint, which the check
+     * below catches. Every pointer is still checked, as the header
+     * matching says nothing about the rest of the file. */
+    if (header->base_address) {
+        void* address = (void*)(uintptr_t)header->base_address;
+        void* map = mmap(address, size, PROT_READ, MAP_PRIVATE | MAP_FIXED_NOREPLACE, fd, 0);
+        if (map == address) {
+            ConfigObject* root = relocate((char*)map, header, 0);
+            if (root) {
+                cache->config = root;
+                cache->map = map;
+                cache->map_size = size;
+                cache->relocated = 0;
+                return 0;
+            }
+        }
+        if (map != MAP_FAILED) munmap(map, size);
+    }
+
+    /* The address is taken: map anywhere and move the pointers */
+    void* map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) return -1;
+
+    ConfigObject* config = relocate((char*)map, header, 1);
+    if (!config) {
+        munmap(map, size);
+        return -1;
+    }
+    mprotect(map, size, PROT_READ);
+
+    cache->config = config;
+    cache->map = map;
+    cache->map_size = size;
+    cache->relocated = 1;
+    return 0;
+}
+
+/*
+ * Record the new modification time of an unchanged source in its image
+ * Returns 0 on success, -1 on failure
+ */
+static int refresh_image(const char* cache_path, const SourceKey* key) {
+    int fd = open(cache_path, O_WRONLY);
+    if (fd < 0) return -1;
+
+    int64_t mtime[2] = { key->mtime_sec, key->mtime_nsec };
+    ssize_t written = pwrite(fd, mtime, sizeof(mtime), offsetof(ConfigCacheHeader, source_mtime_sec));
+    close(fd);
+    return written == (ssize_t)sizeof(mtime) ? 0 : -1;
+}
+
+/*
+ * Load a configuration through its cached image
+ * Returns the cached configuration, or NULL on failure
+ */
+ConfigCache* eliza_config_cache_load(const char* source_path, const char* cache_path) {
+    if (!source_path || !cache_path) return NULL;
+
+    int fd = open(source_path, O_RDONLY);
+    if (fd < 0) return NULL;
+
+    struct stat st;
+    ConfigCache* cache = (ConfigCache*)calloc(1, sizeof(ConfigCache));
+    if (!cache || fstat(fd, &st) != 0) {
+        free(cache);
+        close(fd);
+        return NULL;
+    }
+
+    ConfigCacheHeader header;
+    int image_fd = read_header(cache_path, &header);
+    if (image_fd >= 0 && header.source_size == (uint64_t)st.st_size &&
+        header.source_mtime_sec == (int64_t)st.st_mtim.tv_sec &&
+        header.source_mtime_nsec == (int64_t)st.st_mtim.tv_nsec) {
+        int mapped = map_image(cache, image_fd, &header);
+        close(image_fd);
+        image_fd = -1;
+        if (mapped == 0) {
+            close(fd);
+            cache->origin = CONFIG_CACHE_MAPPED;
+            return cache;
+        }
+    }
+
+    /* The contents decide once the time has moved */
+    SourceKey key;
+    void* source = map_source(fd, &key);
+    close(fd);
+    if (source == MAP_FAILED) {
+        if (image_fd >= 0) close(image_fd);
+        free(cache);
+        return NULL;
+    }
+
+    if (image_fd >= 0 && header.source_size == key.size && header.source_hash == key.hash &&
+        map_image(cache, image_fd, &header) == 0) {
+        /* On failure the next start hashes the source again */
+        refresh_image(cache_path, &key);
+        cache->origin = CONFIG_CACHE_VERIFIED;
+    } else {
+        cache->config = eliza_config_parse_buffer((const char*)source, (size_t)key.size);
+        if (cache->config) write_image(cache->config, &key, cache_path);
+        cache->origin = CONFIG_CACHE_PARSED;
+    }
+    if (image_fd >= 0) close(image_fd);
+
+    if (source) munmap(source, (size_t)key.size);
+    if (!cache->config) {
+        free(cache);
+        return NULL;
+    }
+    return cache;
+}
+
+/*
+ * Release a cached configuration
+ */
+void eliza_config_cache_close(ConfigCache* cache) {
+    if (!cache) return;
+
+    if (cache->map) {
+        munmap(cache->map, cache->map_size);
+    } else {
+        eliza_config_destroy(cache->config);
+    }
+    free(cache);
+}
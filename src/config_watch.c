@@ -0,0 +1,400 @@
+#include "../include/config_watch.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+
+/*
+ * Implementation of Configuration Hot Reload
+ */
+
+/* Default quiet time after a change, in milliseconds */
+#define DEFAULT_SETTLE_MS 50
+
+/* Retry interval for versions still held by readers, in milliseconds */
+#define RECLAIM_INTERVAL_MS 100
+
+/* Events that can leave the file with new contents */
+#define CHANGE_EVENTS (IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_MODIFY)
+
+/*
+ * Fill watch options with defaults
+ */
+void eliza_config_watch_options_default(ConfigWatchOptions* options) {
+    if (!options) return;
+
+    options->validate = NULL;
+    options->user_data = NULL;
+    options->settle_ms = DEFAULT_SETTLE_MS;
+}
+
+/*
+ * Free a version and its configuration
+ */
+static void version_destroy(ConfigVersion* version) {
+    if (!version) return;
+
+    eliza_config_destroy(version->config);
+    free(version);
+}
+
+/*
+ * Parse and validate the watched file
+ * A file without a single key is taken to be caught mid-write
+ * Returns the configuration, or NULL with *rejected set if validation
+ * refused it
+ */
+static ConfigObject* load(ConfigWatch* watch, int* rejected) {
+    *rejected = 0;
+
+    ConfigObject* config = eliza_config_parse_file(watch->path);
+    if (!config) return NULL;
+
+    if (config->size == 0 ||
+        (watch->options.validate && watch->options.validate(config, watch->options.user_data) != 0)) {
+        eliza_config_destroy(config);
+        *rejected = 1;
+        return NULL;
+    }
+    return config;
+}
+
+/*
+ * Free retired versions that no reader can still see
+ * Called with the lock held
+ */
+static void reclaim(ConfigWatch* watch) {
+    uint64_t oldest = CONFIG_EPOCH_IDLE;
+    for (size_t i = 0; i < CONFIG_WATCH_MAX_READERS; i++) {
+        uint64_t epoch = atomic_load(&watch->readers[i].epoch);
+        if (epoch < oldest) oldest = epoch;
+    }
+
+    ConfigRetired** link = &watch->retired;
+    while (*link) {
+        ConfigRetired* retired = *link;
+        if (retired->epoch < oldest) {
+            *link = retired->next;
+            version_destroy(retired->version);
+            free(retired);
+            watch->stats.reclaimed++;
+        } else {
+            link = &retired->next;
+        }
+    }
+}
+
+/*
+ * Parse, validate and publish the file
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_config_watch_reload(ConfigWatch* watch) {
+    if (!watch) return -1;
+
+    /* A reload that parsed an older file must not publish over one that
+     * parsed a newer file, so parsing and publishing happen as one step.
+     * The separate lock keeps the watcher's bookkeeping and stats
+     * readers from waiting on the parse. */
+    pthread_mutex_lock(&watch->reload_lock);
+    int rejected;
+    ConfigObject* config = load(watch, &rejected);
+
+    ConfigVersion* version = config ? (ConfigVersion*)malloc(sizeof(ConfigVersion)) : NULL;
+    ConfigRetired* retired = version ? (ConfigRetired*)malloc(sizeof(ConfigRetired)) : NULL;
+
+    pthread_mutex_lock(&watch->lock);
+    if (!retired) {
+        if (rejected) {
+            watch->stats.rejected++;
+        } else {
+            watch->stats.failed++;
+        }
+        pthread_mutex_unlock(&watch->lock);
+        pthread_mutex_unlock(&watch->reload_lock);
+        free(version);
+        eliza_config_destroy(config);
+        return -1;
+    }
+
+    ConfigVersion* old = atomic_load_explicit(&watch->current, memory_order_relaxed);
+    version->config = config;
+    version->generation = old->generation + 1;
+
+    /* Readers that announce the advanced epoch are ordered after the swap
+     * and can only load the new version */
+    atomic_store(&watch->current, version);
+    retired->version = old;
+    retired->epoch = atomic_fetch_add(&watch->epoch, 1);
+    retired->next = watch->retired;
+    watch->retired = retired;
+    watch->stats.retired++;
+    watch->stats.reloads++;
+
+    reclaim(watch);
+    pthread_mutex_unlock(&watch->lock);
+    pthread_mutex_unlock(&watch->reload_lock);
+    return 0;
+}
+
+/*
+ * Read pending inotify events
+ * Returns 1 if one of them may have changed the watched file, 0 if none
+ * did, -1 if the watch broke
+ */
+static int read_events(ConfigWatch* watch) {
+    char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    int changed = 0;
+
+    for (;;) {
+        ssize_t length = read(watch->inotify_fd, buffer, sizeof(buffer));
+        if (length < 0) {
+            if (errno == EINTR) continue;
+            return errno == EAGAIN ? changed : -1;
+        }
+        if (length == 0) return changed;
+
+        for (char* p = buffer; p < buffer + length;) {
+            const struct inotify_event* event = (const struct inotify_event*)p;
+            if (event->mask & IN_IGNORED) return -1;
+            if ((event->mask & CHANGE_EVENTS) && event->len > 0 && strcmp(event->name, watch->name) == 0) {
+                changed = 1;
+            }
+            p += sizeof(struct inotify_event) + event->len;
+        }
+    }
+}
+
+/*
+ * Watcher thread: reload once changes to the file have settled
+ */
+static void* watch_main(void* arg) {
+    ConfigWatch* watch = (ConfigWatch*)arg;
+    int pending = 0;
+
+    for (;;) {
+        pthread_mutex_lock(&watch->lock);
+        int retiring = watch->retired != NULL;
+        pthread_mutex_unlock(&watch->lock);
+
+        /* Wait for a change, for a change to settle, or to retry freeing
+         * versions readers were still holding */
+        int timeout = pending ? (int)watch->options.settle_ms : retiring ? RECLAIM_INTERVAL_MS : -1;
+        struct pollfd fds[2] = {
+            { watch->inotify_fd, POLLIN, 0 },
+            { watch->stop_fds[0], POLLIN, 0 },
+        };
+        int ready = poll(fds, 2, timeout);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (fds[1].revents) break;
+
+        if (fds[0].revents) {
+            int changed = read_events(watch);
+            if (changed < 0) break;
+            if (changed) {
+                pending = 1;
+                pthread_mutex_lock(&watch->lock);
+                watch->stats.changes++;
+                pthread_mutex_unlock(&watch->lock);
+            }
+            continue;
+        }
+
+        if (pending) {
+            pending = 0;
+            eliza_config_watch_reload(watch);
+        } else {
+            pthread_mutex_lock(&watch->lock);
+            reclaim(watch);
+            pthread_mutex_unlock(&watch->lock);
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Watch the directory holding path
+ * Returns 0 on success, -1 on failure
+ */
+static int watch_directory(ConfigWatch* watch) {
+    watch->inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (watch->inotify_fd < 0) return -1;
+
+    char* slash = strrchr(watch->path, '/');
+    watch->name = slash ? slash + 1 : watch->path;
+
+    int added;
+    if (!slash) {
+        added = inotify_add_watch(watch->inotify_fd, ".", CHANGE_EVENTS);
+    } else if (slash == watch->path) {
+        added = inotify_add_watch(watch->inotify_fd, "/", CHANGE_EVENTS);
+    } else {
+        *slash = '\0';
+        added = inotify_add_watch(watch->inotify_fd, watch->path, CHANGE_EVENTS);
+        *slash = '/';
+    }
+    return added < 0 ? -1 : 0;
+}
+
+/*
+ * Parse and validate a configuration file, then watch it
+ * Returns the watch, or NULL on failure
+ */
+ConfigWatch* eliza_config_watch_start(const char* filepath, const ConfigWatchOptions* options) {
+    if (!filepath) return NULL;
+
+    ConfigWatch* watch = (ConfigWatch*)aligned_alloc(_Alignof(ConfigWatch), sizeof(ConfigWatch));
+    if (!watch) return NULL;
+    memset(watch, 0, sizeof(ConfigWatch));
+    watch->inotify_fd = -1;
+    watch->stop_fds[0] = -1;
+    watch->stop_fds[1] = -1;
+
+    if (options) {
+        watch->options = *options;
+    } else {
+        eliza_config_watch_options_default(&watch->options);
+    }
+
+    atomic_init(&watch->current, NULL);
+    atomic_init(&watch->epoch, 1);
+    for (size_t i = 0; i < CONFIG_WATCH_MAX_READERS; i++) {
+        atomic_init(&watch->readers[i].epoch, CONFIG_EPOCH_IDLE);
+        atomic_init(&watch->readers[i].in_use, 0);
+        watch->readers[i].watch = watch;
+    }
+    pthread_mutex_init(&watch->reload_lock, NULL);
+    pthread_mutex_init(&watch->lock, NULL);
+
+    /* The first configuration must load; later failures keep the last */
+    int rejected;
+    ConfigVersion* version = NULL;
+    ConfigObject* config = NULL;
+    watch->path = strdup(filepath);
+    if (watch->path) config = load(watch, &rejected);
+    if (config) version = (ConfigVersion*)malloc(sizeof(ConfigVersion));
+    if (!version) {
+        eliza_config_destroy(config);
+        eliza_config_watch_stop(watch);
+        return NULL;
+    }
+    version->config = config;
+    version->generation = 1;
+    atomic_store(&watch->current, version);
+
+    if (watch_directory(watch) < 0 || pipe(watch->stop_fds) < 0 ||
+        pthread_create(&watch->thread, NULL, watch_main, watch) != 0) {
+        if (watch->stop_fds[0] >= 0) {
+            close(watch->stop_fds[0]);
+            close(watch->stop_fds[1]);
+            watch->stop_fds[0] = -1;
+            watch->stop_fds[1] = -1;
+        }
+        eliza_config_watch_stop(watch);
+        return NULL;
+    }
+    return watch;
+}
+
+/*
+ * Stop watching and free every configuration
+ */
+void eliza_config_watch_stop(ConfigWatch* watch) {
+    if (!watch) return;
+
+    /* The pipe only exists once the thread runs */
+    if (watch->stop_fds[1] >= 0) {
+        char byte = 0;
+        while (write(watch->stop_fds[1], &byte, 1) < 0 && errno == EINTR) {
+        }
+        pthread_join(watch->thread, NULL);
+        close(watch->stop_fds[0]);
+        close(watch->stop_fds[1]);
+    }
+    if (watch->inotify_fd >= 0) close(watch->inotify_fd);
+
+    version_destroy(atomic_load(&watch->current));
+    ConfigRetired* retired = watch->retired;
+    while (retired) {
+        ConfigRetired* next = retired->next;
+        version_destroy(retired->version);
+        free(retired);
+        retired = next;
+    }
+
+    pthread_mutex_destroy(&watch->reload_lock);
+    pthread_mutex_destroy(&watch->lock);
+    free(watch->path);
+    free(watch);
+}
+
+/*
+ * Register the calling thread as a reader
+ * Returns a reader slot, or NULL when all are taken
+ */
+ConfigReader* eliza_config_watch_reader(ConfigWatch* watch) {
+    if (!watch) return NULL;
+
+    for (size_t i = 0; i < CONFIG_WATCH_MAX_READERS; i++) {
+        int expected = 0;
+        if (atomic_compare_exchange_strong(&watch->readers[i].in_use, &expected, 1)) {
+            watch->readers[i].generation = 0;
+            return &watch->readers[i];
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Give a reader slot back
+ */
+void eliza_config_watch_reader_release(ConfigReader* reader) {
+    if (!reader) return;
+
+    atomic_store(&reader->epoch, CONFIG_EPOCH_IDLE);
+    atomic_store(&reader->in_use, 0);
+}
+
+/*
+ * Enter a read-side section
+ * Returns the current configuration
+ */
+ConfigObject* eliza_config_read_begin(ConfigReader* reader) {
+    /* Sequentially consistent, so the version load is ordered after the
+     * announcement in the view of reclaim() */
+    atomic_store(&reader->epoch, atomic_load(&reader->watch->epoch));
+
+    ConfigVersion* version = atomic_load(&reader->watch->current);
+    reader->generation = version->generation;
+    return version->config;
+}
+
+/*
+ * Leave a read-side section
+ */
+void eliza_config_read_end(ConfigReader* reader) {
+    atomic_store_explicit(&reader->epoch, CONFIG_EPOCH_IDLE, memory_order_release);
+}
+
+/*
+ * Copy the current statistics
+ */
+void eliza_config_watch_get_stats(ConfigWatch* watch, ConfigWatchStats* stats) {
+    if (!stats) return;
+    memset(stats, 0, sizeof(*stats));
+    if (!watch) return;
+
+    pthread_mutex_lock(&watch->lock);
+    *stats = watch->stats;
+    stats->generation = atomic_load(&watch->current)->generation;
+    pthread_mutex_unlock(&watch->lock);
+
+    stats->readers = 0;
+    for (size_t i = 0; i < CONFIG_WATCH_MAX_READERS; i++) {
+        if (atomic_load(&watch->readers[i].in_use)) stats->readers++;
+    }
+}
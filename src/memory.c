@@ -1,4 +1,18 @@
 #include "../include/memory.h"
+#include "../include/memory_segment.h"
+#include "../include/memory_wal.h"
+#include "../include/memory_arena.h"
+#include "../include/memory_columns.h"
+#include "../include/memory_vector.h"
+#include "../include/memory_hnsw.h"
+#include "../include/memory_evict.h"
+#include "../include/memory_cursor.h"
+#include "../include/memory_snapshot.h"
+#include "../include/memory_load.h"
+#include "../include/memory_dedup.h"
+#include "../include/memory_tier.h"
+#include "../include/memory_fuzzy.h"
+#include "../include/memory_batch.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
@@ -7,6 +21,9 @@
  * Implementation of the Memory System
  */
 
+/* Removed slots tolerated before compaction is considered */
+#define COMPACT_MIN_REMOVED 64
+
 /* 
  * Create a new memory entry
  */
@@ -53,9 +70,29 @@ MemoryStore* eliza_memory_create(size_t initial_capacity) {
         return NULL;
     }
 
+    /* Create the inverted index */
+    store->index = eliza_memory_index_create();
+    if (!store->index) {
+        free(store->entries);
+        free(store);
+        return NULL;
+    }
+
     /* Initialize the store */
     store->capacity = initial_capacity;
     store->size = 0;
+    store->removed = 0;
+    store->wal = NULL;
+    store->arena = NULL;
+    store->columns = NULL;
+    store->vectors = NULL;
+    store->hnsw = NULL;
+    store->eviction = NULL;
+    store->snapshot = NULL;
+    store->dedup = NULL;
+    store->tier = NULL;
+    store->trigrams = NULL;
+    store->batches = NULL;
     
     /* Set up function pointers */
     store->add_memory = eliza_memory_add;
@@ -66,73 +103,749 @@ MemoryStore* eliza_memory_create(size_t initial_capacity) {
     return store;
 }
 
+/*
+ * Create a new memory store backed by an arena
+ */
+MemoryStore* eliza_memory_create_arena(size_t initial_capacity) {
+    MemoryStore* store = eliza_memory_create(initial_capacity);
+    if (!store) return NULL;
+
+    store->arena = eliza_memory_arena_create();
+    if (!store->arena) {
+        eliza_memory_destroy(store);
+        return NULL;
+    }
+
+    return store;
+}
+
+/*
+ * Free every entry of the store
+ * Arena entries go all at once with their arena. While a snapshot is
+ * held, the arena is replaced instead of reset; if no new arena can be
+ * made, the old one keeps growing until the next clear.
+ */
+static void release_entries(MemoryStore* store) {
+    if (store->arena) {
+        if (!eliza_memory_snapshot_active(store)) {
+            eliza_memory_arena_reset(store->arena);
+        } else {
+            MemoryArena* arena = eliza_memory_arena_create();
+            if (arena) {
+                eliza_memory_snapshot_retire(store, MEMORY_RETIRED_ARENA, store->arena);
+                store->arena = arena;
+            }
+        }
+    } else {
+        eliza_memory_batch_release_all(store);
+    }
+    store->size = 0;
+    store->removed = 0;
+}
+
 /*
  * Destroy a memory store and all its entries
  */
 void eliza_memory_destroy(MemoryStore* store) {
     if (!store) return;
 
-    /* Free all entries */
-    for (size_t i = 0; i < store->size; i++) {
-        eliza_memory_entry_destroy(store->entries[i]);
-    }
+    /* Flush and detach the write-ahead log */
+    eliza_memory_wal_close(store->wal);
+
+    /* A snapshot still being written keeps the entries it shares */
+    eliza_memory_snapshot_detach(store);
 
+    /* Free all entries */
+    release_entries(store);
+    eliza_memory_arena_destroy(store->arena);
+    eliza_memory_columns_destroy(store->columns);
+    eliza_memory_vectors_destroy(store->vectors);
+    eliza_memory_hnsw_destroy(store->hnsw);
+    eliza_memory_eviction_destroy(store->eviction);
+    eliza_memory_dedup_destroy(store->dedup);
+    eliza_memory_tier_destroy(store->tier);
+    eliza_memory_trigrams_destroy(store->trigrams);
+    eliza_memory_batches_destroy(store->batches);
+
+    eliza_memory_index_destroy(store->index);
     free(store->entries);
     free(store);
 }
 
 /*
- * Add a new memory to the store
+ * Make room for at least capacity entries
  * Returns 0 on success, -1 on failure
  */
-int eliza_memory_add(MemoryStore* store, const char* content,
-                    float importance, const char* context, const char* category) {
-    if (!store || !content) return -1;
+int eliza_memory_reserve(MemoryStore* store, size_t capacity) {
+    if (!store) return -1;
+    if (capacity <= store->capacity) return 0;
 
-    /* Check if we need to resize */
-    if (store->size >= store->capacity) {
-        size_t new_capacity = store->capacity * 2;
+    /* An array shared with a snapshot is copied rather than moved */
+    if (eliza_memory_snapshot_unshare(store, capacity) < 0) return -1;
+
+    if (capacity > store->capacity) {
         MemoryEntry** new_entries = (MemoryEntry**)realloc(store->entries,
-                                   new_capacity * sizeof(MemoryEntry*));
+                                   capacity * sizeof(MemoryEntry*));
         if (!new_entries) return -1;
 
         store->entries = new_entries;
-        store->capacity = new_capacity;
+        store->capacity = capacity;
+    }
+
+    if (store->columns && eliza_memory_columns_reserve(store->columns, capacity) < 0) return -1;
+    if (store->vectors && eliza_memory_vectors_reserve(store->vectors, capacity) < 0) return -1;
+    if (store->hnsw && eliza_memory_hnsw_reserve(store->hnsw, capacity) < 0) return -1;
+    if (store->eviction && eliza_memory_eviction_reserve(store->eviction, capacity) < 0) return -1;
+    if (store->dedup && eliza_memory_dedup_reserve(store->dedup, capacity) < 0) return -1;
+    if (store->trigrams && eliza_memory_trigrams_reserve(store->trigrams, capacity) < 0) return -1;
+
+    return 0;
+}
+
+/*
+ * Remove and destroy all entries
+ */
+void eliza_memory_clear(MemoryStore* store) {
+    if (!store) return;
+
+    /* A failed log write fails every later one, so it is not lost */
+    if (store->wal) eliza_memory_wal_clear(store->wal);
+
+    release_entries(store);
+    eliza_memory_tier_clear(store->tier);
+    eliza_memory_index_clear(store->index);
+    eliza_memory_columns_clear(store->columns);
+    eliza_memory_vectors_clear(store->vectors);
+    eliza_memory_hnsw_clear(store->hnsw);
+    eliza_memory_eviction_clear(store->eviction);
+    eliza_memory_dedup_clear(store->dedup);
+    eliza_memory_trigrams_clear(store->trigrams);
+}
+
+/*
+ * Create an entry in the storage used by the store
+ */
+static MemoryEntry* create_entry(MemoryStore* store, const char* content, float importance,
+                                 const char* context, const char* category) {
+    if (store->arena) {
+        return eliza_memory_arena_entry(store->arena, content, importance, context, category);
+    }
+    return eliza_memory_entry_create(content, importance, context, category);
+}
+
+/*
+ * Free an entry that is no longer in the store
+ * Arena entries stay allocated until the arena is reset, batch entries
+ * until their block empties; others wait for the snapshot that may still
+ * read them
+ */
+static void discard_entry(MemoryStore* store, MemoryEntry* entry) {
+    if (store->arena || eliza_memory_batch_release(store, entry)) return;
+    eliza_memory_snapshot_retire(store, MEMORY_RETIRED_ENTRY, entry);
+}
+
+/*
+ * Make the slot at position safe to overwrite
+ * Slots past the end of a snapshot are never read by it, so appends
+ * share the array freely; overwriting a frozen slot copies it first.
+ * Returns 0 on success, -1 on failure
+ */
+static int own_slot(MemoryStore* store, size_t position) {
+    MemorySnapshot* snapshot = store->snapshot;
+    if (!snapshot || snapshot->entries != store->entries || position >= snapshot->size) return 0;
+    return eliza_memory_snapshot_unshare(store, store->capacity);
+}
+
+/*
+ * Vector to insert into the HNSW index for a new entry
+ * Without an explicit vector, the row just embedded by the vector column
+ * is reused
+ */
+static const float* hnsw_vector(const MemoryStore* store, const float* vector) {
+    if (vector) return vector;
+    if (store->vectors && store->vectors->dim == store->hnsw->dim) return store->vectors->scratch;
+    return NULL;
+}
+
+/*
+ * Run the dedup check of a store on an entry about to be added
+ * Returns 1 for a duplicate, 0 to add it, -1 on failure
+ */
+static int check_duplicate(MemoryStore* store, const MemoryEntry* entry, uint64_t* signature) {
+    *signature = 0;
+    if (!store->dedup) return 0;
+    return eliza_memory_dedup_check(store, entry, signature);
+}
+
+/*
+ * Take a failed insert at the end of the store back out of its
+ * structures, the inverted index included when indexed is set
+ * An HNSW node cannot be unlinked from its neighbors, so once the graph
+ * holds one the slot is kept as a removed entry instead, which the next
+ * compaction drops from every structure; the log has no frame for it
+ */
+static void undo_insert(MemoryStore* store, MemoryEntry* entry, int indexed) {
+    uint32_t id = (uint32_t)store->size;
+
+    if (indexed) eliza_memory_index_forget(store->index, id);
+    eliza_memory_eviction_forget(store->eviction, id, entry);
+    if (store->hnsw && store->hnsw->size > id) {
+        store->entries[store->size++] = NULL;
+        store->removed++;
+        return;
+    }
+
+    eliza_memory_index_truncate(store->index, id);
+    eliza_memory_columns_truncate(store->columns, id);
+    eliza_memory_vectors_truncate(store->vectors, id);
+    eliza_memory_dedup_truncate(store->dedup, id);
+    eliza_memory_trigrams_truncate(store->trigrams, id);
+}
+
+/*
+ * Add an entry at the end of the store to every structure but the
+ * inverted index
+ * The HNSW graph and the log cannot take an entry back, so they come
+ * last; the entry is logged before it becomes visible
+ * Returns 0 on success, -1 on failure
+ */
+static int insert_rest(MemoryStore* store, MemoryEntry* entry, const float* vector,
+                       uint64_t signature) {
+    uint32_t id = (uint32_t)store->size;
+
+    if (store->columns && eliza_memory_columns_append(store->columns, entry) < 0) return -1;
+    if (store->vectors &&
+        eliza_memory_vectors_append(store->vectors, entry->content, vector) < 0) {
+        return -1;
+    }
+    if (store->eviction && eliza_memory_eviction_add(store->eviction, id, entry) < 0) return -1;
+    if (store->dedup && eliza_memory_dedup_add(store->dedup, id, signature) < 0) return -1;
+    if (store->trigrams && eliza_memory_trigrams_add(store->trigrams, id, entry->content) < 0) {
+        return -1;
+    }
+    if (store->hnsw && eliza_memory_hnsw_add(store->hnsw, hnsw_vector(store, vector)) < 0) {
+        return -1;
+    }
+    if (store->wal && eliza_memory_wal_append(store->wal, entry, id) < 0) return -1;
+    return 0;
+}
+
+/*
+ * Append an entry to the store and its indexes
+ * vector is the entry's embedding, NULL to compute it if needed, and
+ * signature its dedup signature
+ * A failure leaves the entry in none of them
+ * Returns 0 on success, -1 on failure
+ */
+static int insert_entry(MemoryStore* store, MemoryEntry* entry, const float* vector,
+                        uint64_t signature) {
+    /* Check if we need to resize */
+    if (store->size >= store->capacity ||
+        (store->columns && store->columns->size >= store->columns->capacity) ||
+        (store->vectors && store->vectors->size >= store->vectors->capacity)) {
+        size_t new_capacity = store->capacity ? store->capacity * 2 : 16;
+        if (eliza_memory_reserve(store, new_capacity) < 0) return -1;
+    }
+    if (own_slot(store, store->size) < 0) return -1;
+
+    /* Entry ids are their position in the store */
+    if (eliza_memory_index_add(store->index, (uint32_t)store->size, entry->content) < 0) {
+        undo_insert(store, entry, 0);
+        return -1;
+    }
+    if (insert_rest(store, entry, vector, signature) < 0) {
+        undo_insert(store, entry, 1);
+        return -1;
+    }
+
+    store->entries[store->size++] = entry;
+
+    /* The entry is in even if it turns out to be the least valuable one,
+     * or if moving older entries to the cold tier fails */
+    eliza_memory_enforce_budget(store);
+    eliza_memory_tier_check(store);
+    return 0;
+}
+
+/*
+ * Remove the entry at position
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_remove(MemoryStore* store, size_t position) {
+    if (!store || position >= store->size || !store->entries[position]) return -1;
+    if (own_slot(store, position) < 0) return -1;
+    if (store->wal && eliza_memory_wal_remove(store->wal, position) < 0) return -1;
+
+    MemoryEntry* entry = store->entries[position];
+    eliza_memory_index_forget(store->index, (uint32_t)position);
+    eliza_memory_eviction_forget(store->eviction, (uint32_t)position, entry);
+
+    store->entries[position] = NULL;
+    store->removed++;
+    discard_entry(store, entry);
+
+    /* Compacting at half empty keeps the cost amortized per removal; a
+     * failed compaction is retried on the next removal */
+    if (store->removed >= COMPACT_MIN_REMOVED && store->removed * 2 >= store->size) {
+        eliza_memory_compact(store);
+    }
+    return 0;
+}
+
+/*
+ * Copy the live entries of an arena store into a fresh arena
+ * Returns the new arena, or NULL on failure
+ */
+static MemoryArena* copy_arena(MemoryStore* store, MemoryEntry** copies) {
+    MemoryArena* arena = eliza_memory_arena_create();
+    if (!arena) return NULL;
+
+    size_t kept = 0;
+    for (size_t i = 0; i < store->size; i++) {
+        MemoryEntry* entry = store->entries[i];
+        if (!entry) continue;
+
+        MemoryEntry* copy = eliza_memory_arena_entry(arena, entry->content, entry->importance,
+                                                     entry->context, entry->category);
+        if (!copy) {
+            eliza_memory_arena_destroy(arena);
+            return NULL;
+        }
+        copy->timestamp = entry->timestamp;
+        copies[kept++] = copy;
+    }
+    return arena;
+}
+
+/*
+ * Reclaim the slots of removed entries
+ * Entries keep their relative order, so every id-keyed structure can be
+ * renumbered in a single forward pass
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_compact(MemoryStore* store) {
+    if (!store) return -1;
+    if (store->removed == 0) return 0;
+
+    if (own_slot(store, 0) < 0) return -1;
+
+    uint32_t* map = (uint32_t*)malloc(store->size * sizeof(uint32_t));
+    if (!map) return -1;
+
+    /* Arena entries are copied out first so a failure changes nothing */
+    MemoryEntry** copies = NULL;
+    MemoryArena* arena = NULL;
+    if (store->arena) {
+        size_t live = store->size - store->removed;
+        copies = (MemoryEntry**)malloc((live ? live : 1) * sizeof(MemoryEntry*));
+        arena = copies ? copy_arena(store, copies) : NULL;
+        if (!arena) {
+            free(copies);
+            free(map);
+            return -1;
+        }
+    }
+
+    size_t kept = 0;
+    for (size_t i = 0; i < store->size; i++) {
+        if (!store->entries[i]) {
+            map[i] = MEMORY_ID_REMOVED;
+            continue;
+        }
+        map[i] = (uint32_t)kept;
+        store->entries[kept] = copies ? copies[kept] : store->entries[i];
+        kept++;
+    }
+
+    /* A failed rehash or graph repair leaves those structures usable */
+    eliza_memory_index_remap(store->index, map, store->size);
+    eliza_memory_columns_remap(store->columns, map, store->size);
+    eliza_memory_vectors_remap(store->vectors, map, store->size);
+    eliza_memory_hnsw_remap(store->hnsw, map, store->size);
+    eliza_memory_eviction_remap(store->eviction, map, store->size);
+    eliza_memory_dedup_remap(store->dedup, map, store->size);
+    eliza_memory_trigrams_remap(store->trigrams, map, store->size);
+    eliza_memory_wal_remap(store->wal, map, store->size);
+
+    if (arena) {
+        eliza_memory_snapshot_retire(store, MEMORY_RETIRED_ARENA, store->arena);
+        store->arena = arena;
+    }
+
+    store->size = kept;
+    store->removed = 0;
+    free(copies);
+    free(map);
+    return 0;
+}
+
+/*
+ * Change the importance and timestamp of the entry at position
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_touch(MemoryStore* store, size_t position, float importance, time_t timestamp) {
+    if (!store || position >= store->size || !store->entries[position]) return -1;
+
+    MemoryEntry* entry = store->entries[position];
+    MemoryEntry* copy = NULL;
+    if (eliza_memory_snapshot_active(store)) {
+        /* The snapshot may be reading this entry, so change a copy */
+        if (own_slot(store, position) < 0) return -1;
+        copy = create_entry(store, entry->content, importance, entry->context, entry->category);
+        if (!copy) return -1;
+    }
+
+    /* Nothing changes unless the update is logged */
+    if (store->wal && eliza_memory_wal_update(store->wal, position, importance, timestamp) < 0) {
+        if (copy) discard_entry(store, copy);
+        return -1;
+    }
+
+    if (copy) {
+        store->entries[position] = copy;
+
+        MemorySnapshot* snapshot = eliza_memory_snapshot_active(store);
+        if (snapshot) {
+            pthread_mutex_lock(&snapshot->lock);
+            snapshot->entry_copies++;
+            pthread_mutex_unlock(&snapshot->lock);
+        }
+        discard_entry(store, entry);
+        entry = copy;
+    }
+    entry->importance = importance;
+    entry->timestamp = timestamp;
+    eliza_memory_columns_update(store->columns, position, entry);
+    eliza_memory_eviction_update(store->eviction, (uint32_t)position, entry);
+
+    /* Lowering importance can make another entry the eviction victim */
+    return eliza_memory_enforce_budget(store);
+}
+
+/*
+ * Change the importance of the entry at position
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_set_importance(MemoryStore* store, size_t position, float importance) {
+    if (!store || position >= store->size || !store->entries[position]) return -1;
+    return eliza_memory_touch(store, position, importance, store->entries[position]->timestamp);
+}
+
+/*
+ * Add a copy of an entry, keeping its timestamp
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_add_copy(MemoryStore* store, const MemoryEntry* source) {
+    if (!store || !source || !source->content) return -1;
+
+    uint64_t signature;
+    int duplicate = check_duplicate(store, source, &signature);
+    if (duplicate != 0) return duplicate < 0 ? -1 : 0;
+
+    MemoryEntry* entry = create_entry(store, source->content, source->importance,
+                                      source->context, source->category);
+    if (!entry) return -1;
+    entry->timestamp = source->timestamp;
+
+    if (insert_entry(store, entry, NULL, signature) < 0) {
+        discard_entry(store, entry);
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Copy a batch into the storage used by the store
+ * Arena stores carve each copy from their arena, others put the whole
+ * batch in one block
+ * Returns 0 on success, -1 on failure
+ */
+static int copy_batch(MemoryStore* store, const MemoryEntry* entries, size_t count,
+                      MemoryEntry** copies) {
+    if (!store->arena) {
+        MemoryEntry* block = eliza_memory_batch_copy(store, entries, count);
+        if (!block) return -1;
+        for (size_t i = 0; i < count; i++) copies[i] = &block[i];
+        return 0;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        copies[i] = eliza_memory_arena_entry(store->arena, entries[i].content, entries[i].importance,
+                                             entries[i].context, entries[i].category);
+        if (!copies[i]) return -1;
+        copies[i]->timestamp = entries[i].timestamp;
     }
+    return 0;
+}
+
+/*
+ * Add the copies of a batch one at a time
+ * Whether an entry is a duplicate, and when the cold tier takes entries
+ * out, depends on every entry added before it
+ * Returns the number of copies used up, or with *failed set, the number
+ * handled before the failure
+ */
+static size_t insert_each(MemoryStore* store, MemoryEntry** copies, size_t count, int* failed) {
+    for (size_t i = 0; i < count; i++) {
+        uint64_t signature;
+        int duplicate = check_duplicate(store, copies[i], &signature);
+        if (duplicate < 0 || (duplicate == 0 && insert_entry(store, copies[i], NULL, signature) < 0)) {
+            *failed = 1;
+            return i;
+        }
+        if (duplicate) discard_entry(store, copies[i]);
+    }
+    return count;
+}
+
+/*
+ * Append the copies of a batch to the store and its indexes
+ * The inverted index takes all of them in one pass; the other
+ * structures append in order as insert_entry does
+ * Returns the number of copies added, or with *failed set, the number
+ * added before the failure; the rest are in none of the structures
+ */
+static size_t insert_batch(MemoryStore* store, MemoryEntry** copies, size_t count, int* failed) {
+    size_t first = store->size;
+    *failed = 1;
+    if (own_slot(store, first) < 0) return 0;
+
+    const char** contents = (const char**)malloc(count * sizeof(const char*));
+    if (!contents) return 0;
+    for (size_t i = 0; i < count; i++) contents[i] = copies[i]->content;
+    int indexed = eliza_memory_index_add_batch(store->index, (uint32_t)first, contents, count);
+    free(contents);
+    if (indexed < 0) return 0;
+
+    for (size_t i = 0; i < count; i++) {
+        if (insert_rest(store, copies[i], NULL, 0) < 0) {
+            /* The entries after the failed one were indexed but go no further */
+            for (size_t j = i + 1; j < count; j++) {
+                eliza_memory_index_forget(store->index, (uint32_t)(first + j));
+            }
+            eliza_memory_index_truncate(store->index, (uint32_t)(first + i + 1));
+            undo_insert(store, copies[i], 1);
+            return i;
+        }
+
+        store->entries[store->size++] = copies[i];
+    }
+
+    *failed = 0;
+    return count;
+}
+
+/*
+ * Add copies of a batch of entries, keeping their timestamps
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_add_batch(MemoryStore* store, const MemoryEntry* entries, size_t count) {
+    if (!store || (!entries && count > 0)) return -1;
+    for (size_t i = 0; i < count; i++) {
+        if (!entries[i].content) return -1;
+    }
+    if (count == 0) return 0;
+
+    if (eliza_memory_reserve(store, store->size + count) < 0) return -1;
+
+    MemoryEntry** copies = (MemoryEntry**)malloc(count * sizeof(MemoryEntry*));
+    if (!copies) return -1;
+    if (copy_batch(store, entries, count, copies) < 0) {
+        free(copies);
+        return -1;
+    }
+
+    int failed = 0;
+    size_t used = store->dedup || store->tier ? insert_each(store, copies, count, &failed)
+                                              : insert_batch(store, copies, count, &failed);
+    for (size_t i = used; i < count; i++) {
+        discard_entry(store, copies[i]);
+    }
+    free(copies);
+
+    /* Entries past the budget are evicted once the whole batch is in */
+    if (eliza_memory_enforce_budget(store) < 0) return -1;
+    return failed ? -1 : 0;
+}
+
+/*
+ * Add an existing entry to the store, taking ownership on success
+ * Arena stores copy the entry into the arena and free the original
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_add_entry(MemoryStore* store, MemoryEntry* entry) {
+    if (!store || !entry || !entry->content) return -1;
+
+    if (store->arena) {
+        if (eliza_memory_add_copy(store, entry) < 0) return -1;
+        eliza_memory_entry_destroy(entry);
+        return 0;
+    }
+
+    uint64_t signature;
+    int duplicate = check_duplicate(store, entry, &signature);
+    if (duplicate < 0) return -1;
+    if (duplicate) {
+        eliza_memory_entry_destroy(entry);
+        return 0;
+    }
+
+    return insert_entry(store, entry, NULL, signature);
+}
+
+/*
+ * Add a new memory with its embedding
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_add_vector(MemoryStore* store, const char* content,
+                           float importance, const char* context, const char* category,
+                           const float* vector) {
+    if (!store || !content) return -1;
+
+    /* Duplicates are caught before anything is allocated */
+    MemoryEntry probe = { (char*)content, time(NULL), importance, (char*)context, (char*)category };
+    uint64_t signature;
+    int duplicate = check_duplicate(store, &probe, &signature);
+    if (duplicate != 0) return duplicate < 0 ? -1 : 0;
 
     /* Create and add the new entry */
-    MemoryEntry* entry = eliza_memory_entry_create(content, importance, context, category);
+    MemoryEntry* entry = create_entry(store, content, importance, context, category);
     if (!entry) return -1;
 
-    store->entries[store->size++] = entry;
+    if (insert_entry(store, entry, vector, signature) < 0) {
+        discard_entry(store, entry);
+        return -1;
+    }
     return 0;
 }
 
 /*
- * Simple string matching search
+ * Add a new memory to the store
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_add(MemoryStore* store, const char* content,
+                    float importance, const char* context, const char* category) {
+    return eliza_memory_add_vector(store, content, importance, context, category, NULL);
+}
+
+/*
+ * Bytes of a string copy, 0 for NULL
+ */
+static size_t string_size(const char* text) {
+    return text ? strlen(text) + 1 : 0;
+}
+
+/*
+ * Copy a string to out and advance it
+ */
+static char* pack_string(char** out, const char* text) {
+    if (!text) return NULL;
+
+    char* copy = *out;
+    size_t size = strlen(text) + 1;
+    memcpy(copy, text, size);
+    *out += size;
+    return copy;
+}
+
+/*
+ * Move cold matches results[first, found) into the allocation of the
+ * result array, after its pointers, so that freeing the array frees them
+ * Returns the new array, or NULL on failure
+ */
+static MemoryEntry** pack_results(MemoryEntry** results, size_t first, size_t found) {
+    /* Entries start at a multiple of their size, which keeps them aligned */
+    size_t pointers = (found + 1) * sizeof(MemoryEntry*);
+    size_t entries_at = (pointers + sizeof(MemoryEntry) - 1) / sizeof(MemoryEntry) * sizeof(MemoryEntry);
+    size_t size = entries_at + (found - first) * sizeof(MemoryEntry);
+    for (size_t i = first; i < found; i++) {
+        size += string_size(results[i]->content) + string_size(results[i]->context) +
+                string_size(results[i]->category);
+    }
+
+    char* block = (char*)malloc(size);
+    if (!block) return NULL;
+
+    MemoryEntry** packed = (MemoryEntry**)block;
+    MemoryEntry* entries = (MemoryEntry*)(block + entries_at);
+    char* strings = (char*)(entries + (found - first));
+    memcpy(packed, results, first * sizeof(MemoryEntry*));
+    for (size_t i = first; i < found; i++) {
+        MemoryEntry* entry = &entries[i - first];
+        *entry = *results[i];
+        entry->content = pack_string(&strings, results[i]->content);
+        entry->context = pack_string(&strings, results[i]->context);
+        entry->category = pack_string(&strings, results[i]->category);
+        packed[i] = entry;
+    }
+    packed[found] = NULL;
+    return packed;
+}
+
+/*
+ * Search by string matching
+ * Multi-term queries take their candidates from the inverted index and
+ * only verify those, single terms fall back to a scan
  * Returns an array of matching entries, terminated with a NULL pointer
  */
 MemoryEntry** eliza_memory_search(MemoryStore* store, const char* query,
                                 size_t max_results) {
     if (!store || !query) return NULL;
 
+    MemoryCursor cursor;
+    if (eliza_memory_cursor_open(&cursor, store, query) < 0) return NULL;
+
     /* Allocate result array (max_results + 1 for NULL terminator) */
     MemoryEntry** results = (MemoryEntry**)malloc((max_results + 1) * sizeof(MemoryEntry*));
-    if (!results) return NULL;
+    if (!results) {
+        eliza_memory_cursor_close(&cursor);
+        return NULL;
+    }
 
     size_t found = 0;
-    
-    /* Simple string matching search */
-    for (size_t i = 0; i < store->size && found < max_results; i++) {
-        if (strstr(store->entries[i]->content, query) != NULL) {
-            results[found++] = store->entries[i];
-        }
+    size_t hot = 0;
+    const MemoryEntry* entry;
+    uint32_t id;
+    while (found < max_results && (entry = eliza_memory_cursor_next(&cursor, &id)) != NULL) {
+        results[found++] = (MemoryEntry*)entry;
+        if (id != MEMORY_ID_REMOVED) hot = found;
     }
-
     results[found] = NULL; /* NULL terminate the array */
+
+    /* Cold matches live in the cursor; copy them before closing it */
+    if (hot < found) {
+        MemoryEntry** packed = pack_results(results, hot, found);
+        free(results);
+        results = packed;
+    }
+
+    eliza_memory_cursor_close(&cursor);
     return results;
 }
 
+/*
+ * Path of a file stored next to the store file
+ * Returns a newly allocated string, or NULL on failure
+ */
+static char* sidecar_path(const char* filepath, const char* suffix) {
+    size_t path_len = strlen(filepath);
+    size_t suffix_len = strlen(suffix);
+
+    char* path = (char*)malloc(path_len + suffix_len + 1);
+    if (!path) return NULL;
+
+    memcpy(path, filepath, path_len);
+    memcpy(path + path_len, suffix, suffix_len + 1);
+    return path;
+}
+
+/*
+ * Write a cold entry to a store file
+ */
+static int write_entry(const MemoryEntry* entry, void* arg) {
+    return eliza_memory_write_text_entry((FILE*)arg, entry);
+}
+
 /*
  * Save memory store to a file
  * Returns 0 on success, -1 on failure
@@ -140,82 +853,132 @@ MemoryEntry** eliza_memory_search(MemoryStore* store, const char* query,
 int eliza_memory_save(MemoryStore* store, const char* filepath) {
     if (!store || !filepath) return -1;
 
+    /* Sidecar files are written by position, so close the gaps first */
+    if (eliza_memory_compact(store) < 0) return -1;
+
     FILE* file = fopen(filepath, "w");
     if (!file) return -1;
 
-    /* Write header */
-    fprintf(file, "ELIZA_MEMORY_STORE\n");
-    fprintf(file, "SIZE:%zu\n", store->size);
-
-    /* Write each entry */
-    for (size_t i = 0; i < store->size; i++) {
-        MemoryEntry* entry = store->entries[i];
-        fprintf(file, "---ENTRY---\n");
-        fprintf(file, "CONTENT:%s\n", entry->content);
-        fprintf(file, "TIMESTAMP:%ld\n", (long)entry->timestamp);
-        fprintf(file, "IMPORTANCE:%f\n", entry->importance);
-        fprintf(file, "CONTEXT:%s\n", entry->context ? entry->context : "");
-        fprintf(file, "CATEGORY:%s\n", entry->category ? entry->category : "");
+    /* Cold entries go first, oldest to newest, then the hot ones */
+    int result = eliza_memory_write_text_header(file, store->size + eliza_memory_tier_count(store->tier));
+    if (result == 0 && store->tier) result = eliza_memory_tier_each(store->tier, write_entry, file);
+    for (size_t i = 0; result == 0 && i < store->size; i++) {
+        result = eliza_memory_write_text_entry(file, store->entries[i]);
     }
-
-    fclose(file);
-    return 0;
+    if (fclose(file) != 0) result = -1;
+    if (result < 0) return -1;
+
+    /* Embeddings are expensive to recompute, keep them next to the entries */
+    if (store->vectors) {
+        char* path = sidecar_path(filepath, ".vec");
+        if (!path || eliza_memory_vectors_save(store, path) < 0) result = -1;
+        free(path);
+    }
+    if (store->hnsw) {
+        char* path = sidecar_path(filepath, ".hnsw");
+        if (!path || eliza_memory_hnsw_save(store->hnsw, path) < 0) result = -1;
+        free(path);
+    }
+    return result;
 }
 
 /*
- * Load memory store from a file
+ * Load the entries of a memory store from a file
  * Returns 0 on success, -1 on failure
  */
-int eliza_memory_load(MemoryStore* store, const char* filepath) {
-    if (!store || !filepath) return -1;
+static int load_entries(MemoryStore* store, const char* filepath) {
+    /* Binary segments are mapped and copied in */
+    if (eliza_memory_segment_probe(filepath)) {
+        MemorySegment* segment = eliza_memory_segment_open(filepath);
+        if (!segment) return -1;
+
+        int result = eliza_memory_segment_copy(store, segment);
+        eliza_memory_segment_close(segment);
+        return result;
+    }
 
-    FILE* file = fopen(filepath, "r");
-    if (!file) return -1;
+    /* Text files are parsed in parallel chunks */
+    return eliza_memory_load_text(store, filepath, NULL, NULL);
+}
 
-    char buffer[1024];
-    char header[64];
+/*
+ * Restore the vectors of freshly loaded entries
+ * Rows come from the sidecar file when it matches, otherwise every entry
+ * is embedded again
+ */
+static int restore_vectors(MemoryStore* store, const char* filepath) {
+    MemoryVectors* vectors = store->vectors;
+    eliza_memory_vectors_clear(vectors);
+    if (eliza_memory_vectors_reserve(vectors, store->capacity) < 0) return -1;
 
-    /* Read and verify header */
-    if (!fgets(buffer, sizeof(buffer), file) ||
-        strcmp(buffer, "ELIZA_MEMORY_STORE\n") != 0) {
-        fclose(file);
-        return -1;
-    }
+    char* path = sidecar_path(filepath, ".vec");
+    int loaded = path && eliza_memory_vectors_load(store, path) == 0;
+    free(path);
+    if (loaded) return 0;
 
-    /* Clear existing entries */
+    eliza_memory_vectors_clear(vectors);
     for (size_t i = 0; i < store->size; i++) {
-        eliza_memory_entry_destroy(store->entries[i]);
+        if (eliza_memory_vectors_append(vectors, store->entries[i]->content, NULL) < 0) {
+            return -1;
+        }
     }
-    store->size = 0;
+    return 0;
+}
 
-    /* Read entries */
-    while (fgets(buffer, sizeof(buffer), file)) {
-        if (strcmp(buffer, "---ENTRY---\n") == 0) {
-            char content[1024] = "";
-            char context[1024] = "";
-            char category[1024] = "";
-            time_t timestamp = 0;
-            float importance = 0.0f;
-
-            /* Read entry fields */
-            while (fgets(buffer, sizeof(buffer), file) &&
-                   sscanf(buffer, "%[^:]:%s", header, buffer) == 2) {
-                if (strcmp(header, "CONTENT") == 0) strcpy(content, buffer);
-                else if (strcmp(header, "TIMESTAMP") == 0) timestamp = atol(buffer);
-                else if (strcmp(header, "IMPORTANCE") == 0) importance = atof(buffer);
-                else if (strcmp(header, "CONTEXT") == 0) strcpy(context, buffer);
-                else if (strcmp(header, "CATEGORY") == 0) strcpy(category, buffer);
-            }
+/*
+ * Restore the HNSW index of freshly loaded entries
+ * The graph comes from the sidecar file when it matches, otherwise it is
+ * rebuilt from the vectors
+ */
+static int restore_hnsw(MemoryStore* store, const char* filepath) {
+    char* path = sidecar_path(filepath, ".hnsw");
+    int loaded = path && eliza_memory_hnsw_load(store, path) == 0;
+    free(path);
+    if (loaded) return 0;
 
-            /* Add the entry */
-            if (content[0] != '\0') {
-                eliza_memory_add(store, content, importance,
-                               context[0] ? context : NULL,
-                               category[0] ? category : NULL);
-            }
-        }
+    return eliza_memory_hnsw_rebuild(store);
+}
+
+/*
+ * Track the loaded entries of a bounded store again and apply its budget
+ * Returns 0 on success, -1 on failure
+ */
+static int restore_eviction(MemoryStore* store, MemoryEviction* eviction) {
+    eliza_memory_eviction_clear(eviction);
+    if (eliza_memory_eviction_reserve(eviction, store->capacity) < 0) return -1;
+
+    for (size_t i = 0; i < store->size; i++) {
+        if (eliza_memory_eviction_add(eviction, (uint32_t)i, store->entries[i]) < 0) return -1;
     }
+    store->eviction = eviction;
+    return eliza_memory_enforce_budget(store);
+}
 
-    fclose(file);
-    return 0;
-} 
\ No newline at end of file
+/*
+ * Load memory store from a file
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_load(MemoryStore* store, const char* filepath) {
+    if (!store || !filepath) return -1;
+
+    /* Entries come in without vectors, which are restored in one go, and
+     * the budget is applied once they are all in */
+    MemoryVectors* vectors = store->vectors;
+    MemoryHnsw* hnsw = store->hnsw;
+    MemoryEviction* eviction = store->eviction;
+    store->vectors = NULL;
+    store->hnsw = NULL;
+    store->eviction = NULL;
+    int result = load_entries(store, filepath);
+    if (result == 0) result = eliza_memory_compact(store);
+    store->vectors = vectors;
+    store->hnsw = hnsw;
+
+    if (result == 0 && vectors) result = restore_vectors(store, filepath);
+    if (result == 0 && hnsw) result = restore_hnsw(store, filepath);
+    if (eviction) {
+        if (restore_eviction(store, eviction) < 0) result = -1;
+        store->eviction = eviction;
+    }
+    return result;
+}
@@ -0,0 +1,297 @@
+#include "../include/memory_arena.h"
+#include "../include/memory.h"
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Implementation of the Memory Arena
+ */
+
+/* Initial number of string table ids and hash slots */
+#define INITIAL_STRINGS 64
+
+/* Default size of a string table heap block */
+#define STRING_BLOCK_SIZE 4096
+
+/*
+ * Allocate a block with at least size usable bytes
+ */
+static MemoryArenaBlock* block_create(size_t size) {
+    MemoryArenaBlock* block = (MemoryArenaBlock*)malloc(sizeof(MemoryArenaBlock) + size);
+    if (!block) return NULL;
+
+    block->next = NULL;
+    block->size = size;
+    block->used = 0;
+    return block;
+}
+
+/*
+ * Free a chain of blocks
+ */
+static void block_free_all(MemoryArenaBlock* block) {
+    while (block) {
+        MemoryArenaBlock* next = block->next;
+        free(block);
+        block = next;
+    }
+}
+
+/*
+ * Bump-allocate len bytes from a chain of blocks
+ * Requests larger than a block get a dedicated block placed behind the
+ * current one so its free space is not abandoned
+ */
+static void* bump_alloc(MemoryArenaBlock** head, size_t len, size_t block_size) {
+    MemoryArenaBlock* current = *head;
+    if (current && current->size - current->used >= len) {
+        void* ptr = current->data + current->used;
+        current->used += len;
+        return ptr;
+    }
+
+    if (len > block_size / 4) {
+        MemoryArenaBlock* block = block_create(len);
+        if (!block) return NULL;
+        block->used = len;
+        if (current) {
+            block->next = current->next;
+            current->next = block;
+        } else {
+            *head = block;
+        }
+        return block->data;
+    }
+
+    MemoryArenaBlock* block = block_create(block_size);
+    if (!block) return NULL;
+    block->next = current;
+    block->used = len;
+    *head = block;
+    return block->data;
+}
+
+/*
+ * Copy a string into a chain of blocks
+ */
+static char* bump_strdup(MemoryArenaBlock** head, const char* str, size_t block_size) {
+    size_t len = strlen(str) + 1;
+    char* copy = (char*)bump_alloc(head, len, block_size);
+    if (copy) memcpy(copy, str, len);
+    return copy;
+}
+
+/*
+ * FNV-1a hash of a string
+ */
+static uint32_t hash_string(const char* str) {
+    uint32_t hash = 2166136261u;
+    for (const unsigned char* p = (const unsigned char*)str; *p; p++) {
+        hash ^= *p;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/*
+ * Initialize an empty string table
+ */
+void eliza_memory_strings_init(MemoryStringTable* table) {
+    if (!table) return;
+    memset(table, 0, sizeof(*table));
+}
+
+/*
+ * Free all strings of a table
+ */
+void eliza_memory_strings_free(MemoryStringTable* table) {
+    if (!table) return;
+
+    free(table->strings);
+    free(table->hashes);
+    free(table->slots);
+    block_free_all(table->heap);
+    memset(table, 0, sizeof(*table));
+}
+
+/*
+ * Find the hash slot of a string, or the empty slot where it belongs
+ */
+static size_t find_string_slot(const MemoryStringTable* table, const char* str, uint32_t hash) {
+    size_t mask = table->slot_count - 1;
+    size_t i = hash & mask;
+
+    while (table->slots[i]) {
+        uint32_t id = table->slots[i] - 1;
+        if (table->hashes[id] == hash && strcmp(table->strings[id], str) == 0) break;
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+/*
+ * Grow the id arrays and rehash once the slots are half full
+ */
+static int grow_strings(MemoryStringTable* table) {
+    size_t new_capacity = table->capacity ? table->capacity * 2 : INITIAL_STRINGS;
+    char** new_strings = (char**)realloc(table->strings, new_capacity * sizeof(char*));
+    if (!new_strings) return -1;
+    table->strings = new_strings;
+
+    uint32_t* new_hashes = (uint32_t*)realloc(table->hashes, new_capacity * sizeof(uint32_t));
+    if (!new_hashes) return -1;
+    table->hashes = new_hashes;
+
+    size_t new_slot_count = new_capacity * 2;
+    uint32_t* new_slots = (uint32_t*)calloc(new_slot_count, sizeof(uint32_t));
+    if (!new_slots) return -1;
+
+    for (size_t id = 0; id < table->size; id++) {
+        size_t i = table->hashes[id] & (new_slot_count - 1);
+        while (new_slots[i]) i = (i + 1) & (new_slot_count - 1);
+        new_slots[i] = (uint32_t)id + 1;
+    }
+
+    free(table->slots);
+    table->slots = new_slots;
+    table->slot_count = new_slot_count;
+    table->capacity = new_capacity;
+    return 0;
+}
+
+/*
+ * Intern a string
+ */
+uint32_t eliza_memory_strings_intern(MemoryStringTable* table, const char* str) {
+    if (!table || !str) return MEMORY_STRING_NONE;
+
+    if (table->size >= table->capacity && grow_strings(table) < 0) return MEMORY_STRING_NONE;
+
+    uint32_t hash = hash_string(str);
+    size_t slot = find_string_slot(table, str, hash);
+    if (table->slots[slot]) return table->slots[slot] - 1;
+
+    char* copy = bump_strdup(&table->heap, str, STRING_BLOCK_SIZE);
+    if (!copy) return MEMORY_STRING_NONE;
+
+    uint32_t id = (uint32_t)table->size++;
+    table->strings[id] = copy;
+    table->hashes[id] = hash;
+    table->slots[slot] = id + 1;
+    return id;
+}
+
+/*
+ * Look up the id of a string without interning it
+ */
+uint32_t eliza_memory_strings_find(const MemoryStringTable* table, const char* str) {
+    if (!table || !str || table->size == 0) return MEMORY_STRING_NONE;
+
+    size_t slot = find_string_slot(table, str, hash_string(str));
+    return table->slots[slot] ? table->slots[slot] - 1 : MEMORY_STRING_NONE;
+}
+
+/*
+ * Get the interned string for an id
+ */
+const char* eliza_memory_strings_get(const MemoryStringTable* table, uint32_t id) {
+    if (!table || id >= table->size) return NULL;
+    return table->strings[id];
+}
+
+/*
+ * Create an empty arena
+ */
+MemoryArena* eliza_memory_arena_create(void) {
+    MemoryArena* arena = (MemoryArena*)malloc(sizeof(MemoryArena));
+    if (!arena) return NULL;
+
+    arena->slabs = NULL;
+    arena->heap = NULL;
+    arena->entries = 0;
+    eliza_memory_strings_init(&arena->strings);
+
+    return arena;
+}
+
+/*
+ * Free everything allocated from the arena
+ */
+void eliza_memory_arena_reset(MemoryArena* arena) {
+    if (!arena) return;
+
+    block_free_all(arena->slabs);
+    block_free_all(arena->heap);
+    eliza_memory_strings_free(&arena->strings);
+    arena->slabs = NULL;
+    arena->heap = NULL;
+    arena->entries = 0;
+}
+
+/*
+ * Destroy the arena
+ */
+void eliza_memory_arena_destroy(MemoryArena* arena) {
+    if (!arena) return;
+
+    eliza_memory_arena_reset(arena);
+    free(arena);
+}
+
+/*
+ * Allocate an entry from the arena
+ */
+MemoryEntry* eliza_memory_arena_entry(MemoryArena* arena, const char* content,
+                                      float importance, const char* context,
+                                      const char* category) {
+    if (!arena || !content) return NULL;
+
+    /* Take the next slot of the current slab */
+    MemoryArenaBlock* slab = arena->slabs;
+    if (!slab || slab->size - slab->used < sizeof(MemoryEntry)) {
+        slab = block_create(MEMORY_ARENA_SLAB_ENTRIES * sizeof(MemoryEntry));
+        if (!slab) return NULL;
+        slab->next = arena->slabs;
+        arena->slabs = slab;
+    }
+
+    char* text = bump_strdup(&arena->heap, content, MEMORY_ARENA_BLOCK_SIZE);
+    if (!text) return NULL;
+
+    uint32_t context_id = eliza_memory_strings_intern(&arena->strings, context);
+    uint32_t category_id = eliza_memory_strings_intern(&arena->strings, category);
+    if ((context && context_id == MEMORY_STRING_NONE) ||
+        (category && category_id == MEMORY_STRING_NONE)) {
+        return NULL;
+    }
+
+    MemoryEntry* entry = (MemoryEntry*)(slab->data + slab->used);
+    slab->used += sizeof(MemoryEntry);
+    arena->entries++;
+
+    entry->content = text;
+    entry->timestamp = time(NULL);
+    entry->importance = importance;
+    entry->context = (char*)eliza_memory_strings_get(&arena->strings, context_id);
+    entry->category = (char*)eliza_memory_strings_get(&arena->strings, category_id);
+
+    return entry;
+}
+
+/*
+ * Collect allocation statistics
+ */
+void eliza_memory_arena_get_stats(const MemoryArena* arena, MemoryArenaStats* stats) {
+    if (!stats) return;
+    memset(stats, 0, sizeof(*stats));
+    if (!arena) return;
+
+    stats->entries = arena->entries;
+    for (MemoryArenaBlock* b = arena->slabs; b; b = b->next) stats->slabs++;
+    for (MemoryArenaBlock* b = arena->heap; b; b = b->next) {
+        stats->heap_blocks++;
+        stats->heap_used += b->used;
+        stats->heap_reserved += b->size;
+    }
+    stats->strings = arena->strings.size;
+}
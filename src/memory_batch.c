@@ -0,0 +1,217 @@
+#include "../include/memory_batch.h"
+#include "../include/memory_snapshot.h"
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Implementation of Memory Batch Blocks
+ */
+
+/*
+ * Whether an optional string equals the one of the previous entry, which
+ * lets consecutive entries of a block share their context and category
+ */
+static int same_string(const char* a, const char* b) {
+    if (!a || !b) return a == b;
+    return a == b || strcmp(a, b) == 0;
+}
+
+/*
+ * Bytes of the strings of source that are not shared with previous
+ */
+static size_t string_bytes(const MemoryEntry* source, const MemoryEntry* previous) {
+    size_t bytes = strlen(source->content) + 1;
+    if (source->context && !(previous && same_string(source->context, previous->context))) {
+        bytes += strlen(source->context) + 1;
+    }
+    if (source->category && !(previous && same_string(source->category, previous->category))) {
+        bytes += strlen(source->category) + 1;
+    }
+    return bytes;
+}
+
+/*
+ * Copy a string to *heap, advancing it past the copy
+ */
+static char* place_string(char** heap, const char* text) {
+    size_t length = strlen(text) + 1;
+    char* copy = *heap;
+    memcpy(copy, text, length);
+    *heap += length;
+    return copy;
+}
+
+/*
+ * Index of the first block at a higher address than ptr
+ */
+static size_t upper_block(const MemoryBatches* batches, const void* ptr) {
+    size_t low = 0;
+    size_t high = batches->count;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if ((const char*)ptr < batches->blocks[mid].base) {
+            high = mid;
+        } else {
+            low = mid + 1;
+        }
+    }
+    return low;
+}
+
+/*
+ * Add a block to the set, keeping it sorted
+ * Returns 0 on success, -1 on failure
+ */
+static int add_block(MemoryStore* store, char* base, size_t bytes, size_t live) {
+    MemoryBatches* batches = store->batches;
+    if (!batches) {
+        batches = (MemoryBatches*)calloc(1, sizeof(MemoryBatches));
+        if (!batches) return -1;
+        store->batches = batches;
+    }
+
+    if (batches->count == batches->capacity) {
+        size_t capacity = batches->capacity ? batches->capacity * 2 : 8;
+        MemoryBatchBlock* blocks = (MemoryBatchBlock*)realloc(batches->blocks,
+                                   capacity * sizeof(MemoryBatchBlock));
+        if (!blocks) return -1;
+        batches->blocks = blocks;
+        batches->capacity = capacity;
+    }
+
+    size_t position = upper_block(batches, base);
+    memmove(&batches->blocks[position + 1], &batches->blocks[position],
+            (batches->count - position) * sizeof(MemoryBatchBlock));
+    batches->blocks[position].base = base;
+    batches->blocks[position].bytes = bytes;
+    batches->blocks[position].live = live;
+    batches->count++;
+    return 0;
+}
+
+/*
+ * Copy entries into a new block
+ * Returns the copies, or NULL on failure
+ */
+MemoryEntry* eliza_memory_batch_copy(MemoryStore* store, const MemoryEntry* entries, size_t count) {
+    if (!store || !entries || count == 0) return NULL;
+
+    size_t bytes = count * sizeof(MemoryEntry);
+    for (size_t i = 0; i < count; i++) {
+        if (!entries[i].content) return NULL;
+        bytes += string_bytes(&entries[i], i > 0 ? &entries[i - 1] : NULL);
+    }
+
+    char* base = (char*)malloc(bytes);
+    if (!base) return NULL;
+    if (add_block(store, base, bytes, count) < 0) {
+        free(base);
+        return NULL;
+    }
+
+    MemoryEntry* copies = (MemoryEntry*)base;
+    char* heap = base + count * sizeof(MemoryEntry);
+    for (size_t i = 0; i < count; i++) {
+        const MemoryEntry* source = &entries[i];
+        const MemoryEntry* previous = i > 0 ? &entries[i - 1] : NULL;
+        MemoryEntry* copy = &copies[i];
+
+        copy->content = place_string(&heap, source->content);
+        copy->timestamp = source->timestamp;
+        copy->importance = source->importance;
+
+        if (!source->context) {
+            copy->context = NULL;
+        } else if (previous && same_string(source->context, previous->context)) {
+            copy->context = copies[i - 1].context;
+        } else {
+            copy->context = place_string(&heap, source->context);
+        }
+
+        if (!source->category) {
+            copy->category = NULL;
+        } else if (previous && same_string(source->category, previous->category)) {
+            copy->category = copies[i - 1].category;
+        } else {
+            copy->category = place_string(&heap, source->category);
+        }
+    }
+    return copies;
+}
+
+/*
+ * Release an entry that is no longer in the store
+ * Returns 1 if it lives in a batch block, 0 otherwise
+ */
+int eliza_memory_batch_release(MemoryStore* store, MemoryEntry* entry) {
+    MemoryBatches* batches = store->batches;
+    if (!batches || batches->count == 0 || !entry) return 0;
+
+    size_t position = upper_block(batches, entry);
+    if (position == 0) return 0;
+    MemoryBatchBlock* block = &batches->blocks[position - 1];
+    if ((char*)entry >= block->base + block->bytes) return 0;
+
+    if (--block->live > 0) return 1;
+
+    /* A snapshot may still read the block's entries */
+    char* base = block->base;
+    memmove(block, block + 1, (batches->count - position) * sizeof(MemoryBatchBlock));
+    batches->count--;
+    eliza_memory_snapshot_retire(store, MEMORY_RETIRED_ARRAY, base);
+    return 1;
+}
+
+/*
+ * Retire every entry and block of the store
+ */
+void eliza_memory_batch_release_all(MemoryStore* store) {
+    MemoryBatches* batches = store->batches;
+
+    for (size_t i = 0; i < store->size; i++) {
+        MemoryEntry* entry = store->entries[i];
+        if (!entry) continue;
+
+        /* Blocks go whole below, whatever their count */
+        if (batches && batches->count > 0) {
+            size_t position = upper_block(batches, entry);
+            if (position > 0) {
+                const MemoryBatchBlock* block = &batches->blocks[position - 1];
+                if ((char*)entry < block->base + block->bytes) continue;
+            }
+        }
+        eliza_memory_snapshot_retire(store, MEMORY_RETIRED_ENTRY, entry);
+    }
+
+    if (!batches) return;
+    for (size_t i = 0; i < batches->count; i++) {
+        eliza_memory_snapshot_retire(store, MEMORY_RETIRED_ARRAY, batches->blocks[i].base);
+    }
+    batches->count = 0;
+}
+
+/*
+ * Destroy the block set of a store
+ */
+void eliza_memory_batches_destroy(MemoryBatches* batches) {
+    if (!batches) return;
+
+    free(batches->blocks);
+    free(batches);
+}
+
+/*
+ * Collect batch block statistics
+ */
+void eliza_memory_batch_get_stats(const MemoryStore* store, MemoryBatchStats* stats) {
+    if (!stats) return;
+    memset(stats, 0, sizeof(*stats));
+    if (!store || !store->batches) return;
+
+    const MemoryBatches* batches = store->batches;
+    stats->blocks = batches->count;
+    for (size_t i = 0; i < batches->count; i++) {
+        stats->entries += batches->blocks[i].live;
+        stats->bytes += batches->blocks[i].bytes;
+    }
+}
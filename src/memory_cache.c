@@ -0,0 +1,203 @@
+#include "../include/memory_cache.h"
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Implementation of the Memory Block Cache
+ */
+
+static inline size_t bucket_of(const MemoryBlockCache* cache, const void* source, uint64_t block) {
+    uint64_t h = (uint64_t)(uintptr_t)source * 0x9e3779b97f4a7c15ULL ^ block * 0xc2b2ae3d27d4eb4fULL;
+    h ^= h >> 29;
+    return (size_t)h & (cache->bucket_count - 1);
+}
+
+/*
+ * Create a block cache
+ * Returns the cache, or NULL on failure
+ */
+MemoryBlockCache* eliza_memory_cache_create(size_t block_size, size_t budget) {
+    if (block_size == 0) return NULL;
+
+    MemoryBlockCache* cache = (MemoryBlockCache*)calloc(1, sizeof(MemoryBlockCache));
+    if (!cache) return NULL;
+
+    cache->block_size = block_size;
+    cache->budget = budget < block_size ? block_size : budget;
+    cache->bucket_count = 64;
+    cache->buckets = (MemoryCacheBlock**)calloc(cache->bucket_count, sizeof(MemoryCacheBlock*));
+    if (!cache->buckets) {
+        free(cache);
+        return NULL;
+    }
+
+    cache->stats.budget = cache->budget;
+    return cache;
+}
+
+/*
+ * Destroy a block cache
+ */
+void eliza_memory_cache_destroy(MemoryBlockCache* cache) {
+    if (!cache) return;
+
+    MemoryCacheBlock* block = cache->head;
+    while (block) {
+        MemoryCacheBlock* next = block->next;
+        free(block);
+        block = next;
+    }
+    free(cache->buckets);
+    free(cache);
+}
+
+static void unlink_lru(MemoryBlockCache* cache, MemoryCacheBlock* block) {
+    if (block->prev) block->prev->next = block->next;
+    else cache->head = block->next;
+    if (block->next) block->next->prev = block->prev;
+    else cache->tail = block->prev;
+    block->prev = block->next = NULL;
+}
+
+static void push_lru(MemoryBlockCache* cache, MemoryCacheBlock* block) {
+    block->prev = NULL;
+    block->next = cache->head;
+    if (cache->head) cache->head->prev = block;
+    cache->head = block;
+    if (!cache->tail) cache->tail = block;
+}
+
+/*
+ * Remove a block from the table and the LRU list and free it
+ */
+static void remove_block(MemoryBlockCache* cache, MemoryCacheBlock* block) {
+    MemoryCacheBlock** link = &cache->buckets[bucket_of(cache, block->source, block->block)];
+    while (*link != block) link = &(*link)->hash_next;
+    *link = block->hash_next;
+
+    unlink_lru(cache, block);
+    cache->stats.blocks--;
+    cache->stats.bytes -= cache->block_size;
+    free(block);
+}
+
+/*
+ * Double the hash table when it gets crowded
+ * Failing to grow only makes the chains longer
+ */
+static void grow_buckets(MemoryBlockCache* cache) {
+    size_t count = cache->bucket_count * 2;
+    MemoryCacheBlock** buckets = (MemoryCacheBlock**)calloc(count, sizeof(MemoryCacheBlock*));
+    if (!buckets) return;
+
+    free(cache->buckets);
+    cache->buckets = buckets;
+    cache->bucket_count = count;
+    for (MemoryCacheBlock* block = cache->head; block; block = block->next) {
+        MemoryCacheBlock** link = &buckets[bucket_of(cache, block->source, block->block)];
+        block->hash_next = *link;
+        *link = block;
+    }
+}
+
+/*
+ * Find a block, filling it on a miss
+ * Returns its data, or NULL on failure
+ */
+const char* eliza_memory_cache_get(MemoryBlockCache* cache, void* source, uint64_t block,
+                                  MemoryCacheFill fill, size_t* size) {
+    if (!cache || !fill || !size) return NULL;
+
+    size_t bucket = bucket_of(cache, source, block);
+    for (MemoryCacheBlock* found = cache->buckets[bucket]; found; found = found->hash_next) {
+        if (found->source == source && found->block == block) {
+            cache->stats.hits++;
+            if (cache->head != found) {
+                unlink_lru(cache, found);
+                push_lru(cache, found);
+            }
+            *size = found->size;
+            return found->data;
+        }
+    }
+
+    cache->stats.misses++;
+    while (cache->tail && cache->stats.bytes + cache->block_size > cache->budget) {
+        remove_block(cache, cache->tail);
+        cache->stats.evictions++;
+    }
+
+    MemoryCacheBlock* added = (MemoryCacheBlock*)malloc(sizeof(MemoryCacheBlock) + cache->block_size);
+    if (!added) return NULL;
+
+    long filled = fill(source, block, added->data, cache->block_size);
+    if (filled < 0) {
+        free(added);
+        return NULL;
+    }
+
+    added->source = source;
+    added->block = block;
+    added->size = (size_t)filled;
+    added->hash_next = cache->buckets[bucket];
+    cache->buckets[bucket] = added;
+    push_lru(cache, added);
+    cache->stats.blocks++;
+    cache->stats.bytes += cache->block_size;
+    cache->stats.bytes_read += (uint64_t)filled;
+
+    if (cache->stats.blocks > cache->bucket_count) grow_buckets(cache);
+
+    *size = added->size;
+    return added->data;
+}
+
+/*
+ * Copy a byte range that may span several blocks
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_cache_read(MemoryBlockCache* cache, void* source, uint64_t offset,
+                           char* out, size_t length, MemoryCacheFill fill) {
+    if (!cache || (!out && length > 0)) return -1;
+
+    while (length > 0) {
+        uint64_t block = offset / cache->block_size;
+        size_t within = (size_t)(offset % cache->block_size);
+        size_t size;
+        const char* data = eliza_memory_cache_get(cache, source, block, fill, &size);
+        if (!data || size <= within) return -1;
+
+        size_t take = size - within;
+        if (take > length) take = length;
+        memcpy(out, data + within, take);
+        out += take;
+        offset += take;
+        length -= take;
+    }
+    return 0;
+}
+
+/*
+ * Drop the blocks of a source
+ */
+void eliza_memory_cache_drop(MemoryBlockCache* cache, void* source) {
+    if (!cache) return;
+
+    MemoryCacheBlock* block = cache->head;
+    while (block) {
+        MemoryCacheBlock* next = block->next;
+        if (block->source == source) remove_block(cache, block);
+        block = next;
+    }
+}
+
+/*
+ * Copy cache statistics
+ */
+void eliza_memory_cache_get_stats(const MemoryBlockCache* cache, MemoryCacheStats* stats) {
+    if (!stats) return;
+    memset(stats, 0, sizeof(*stats));
+    if (!cache) return;
+
+    *stats = cache->stats;
+}
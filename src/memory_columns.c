@@ -0,0 +1,697 @@
+#include "../include/memory_columns.h"
+#include "../include/memory_match.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86_KERNELS 1
+#endif
+
+/*
+ * Implementation of the Memory Columns
+ */
+
+/* Rows examined per filter pass when verifying content */
+#define FILTER_CHUNK 4096
+
+/* Category id that no row carries */
+#define NO_MATCH_CATEGORY (MEMORY_STRING_NONE - 1)
+
+/* Secondary indexes answer a filter when they select at most
+ * 1 / INDEX_SELECTIVITY of the rows; a column scan is cheaper beyond */
+#define INDEX_SELECTIVITY 16
+
+/*
+ * Filter bounds with unused predicates widened to match everything
+ */
+typedef struct {
+    int64_t min_timestamp;
+    int64_t max_timestamp;
+    float min_importance;
+    uint32_t category_id;
+    int use_importance;
+    int use_category;
+} FilterBounds;
+
+/* Kernel writing the rows in [begin, end) that pass to out */
+typedef size_t (*FilterKernel)(const MemoryColumns* columns, const FilterBounds* bounds,
+                               size_t begin, size_t end, uint32_t* out);
+
+/*
+ * Build the columns of a store
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_enable_columns(MemoryStore* store) {
+    if (!store) return -1;
+    if (store->columns) return 0;
+    if (eliza_memory_compact(store) < 0) return -1;
+
+    MemoryColumns* columns = (MemoryColumns*)calloc(1, sizeof(MemoryColumns));
+    if (!columns) return -1;
+    eliza_memory_strings_init(&columns->categories);
+
+    if (eliza_memory_columns_reserve(columns, store->capacity > 0 ? store->capacity : 16) < 0) {
+        eliza_memory_columns_destroy(columns);
+        return -1;
+    }
+
+    for (size_t i = 0; i < store->size; i++) {
+        if (eliza_memory_columns_append(columns, store->entries[i]) < 0) {
+            eliza_memory_columns_destroy(columns);
+            return -1;
+        }
+    }
+
+    store->columns = columns;
+    return 0;
+}
+
+/*
+ * Destroy a set of columns
+ */
+void eliza_memory_columns_destroy(MemoryColumns* columns) {
+    if (!columns) return;
+
+    free(columns->timestamps);
+    free(columns->importance);
+    free(columns->category_ids);
+    free(columns->time_order);
+    for (size_t i = 0; i < columns->category_lists; i++) free(columns->category_rows[i].rows);
+    free(columns->category_rows);
+    eliza_memory_strings_free(&columns->categories);
+    free(columns);
+}
+
+/*
+ * Make room for capacity rows
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_columns_reserve(MemoryColumns* columns, size_t capacity) {
+    if (!columns) return -1;
+    if (capacity <= columns->capacity) return 0;
+
+    int64_t* timestamps = (int64_t*)realloc(columns->timestamps, capacity * sizeof(int64_t));
+    if (!timestamps) return -1;
+    columns->timestamps = timestamps;
+
+    float* importance = (float*)realloc(columns->importance, capacity * sizeof(float));
+    if (!importance) return -1;
+    columns->importance = importance;
+
+    uint32_t* category_ids = (uint32_t*)realloc(columns->category_ids, capacity * sizeof(uint32_t));
+    if (!category_ids) return -1;
+    columns->category_ids = category_ids;
+
+    uint32_t* time_order = (uint32_t*)realloc(columns->time_order, capacity * sizeof(uint32_t));
+    if (!time_order) return -1;
+    columns->time_order = time_order;
+
+    columns->capacity = capacity;
+    return 0;
+}
+
+/*
+ * Append a row to the posting list of its category
+ * Returns 0 on success, -1 on failure
+ */
+static int add_category_row(MemoryColumns* columns, uint32_t category_id, uint32_t row) {
+    if (category_id >= columns->category_lists) {
+        size_t new_count = columns->category_lists ? columns->category_lists * 2 : 8;
+        while (new_count <= category_id) new_count *= 2;
+
+        MemoryRowList* lists = (MemoryRowList*)realloc(columns->category_rows, new_count * sizeof(MemoryRowList));
+        if (!lists) return -1;
+        memset(lists + columns->category_lists, 0, (new_count - columns->category_lists) * sizeof(MemoryRowList));
+        columns->category_rows = lists;
+        columns->category_lists = new_count;
+    }
+
+    MemoryRowList* list = &columns->category_rows[category_id];
+    if (list->size >= list->capacity) {
+        size_t new_capacity = list->capacity ? list->capacity * 2 : 16;
+        uint32_t* rows = (uint32_t*)realloc(list->rows, new_capacity * sizeof(uint32_t));
+        if (!rows) return -1;
+        list->rows = rows;
+        list->capacity = new_capacity;
+    }
+
+    list->rows[list->size++] = row;
+    return 0;
+}
+
+/*
+ * Position among the first n entries of time_order of the first row with
+ * a timestamp after ts (or at ts when inclusive is 0)
+ */
+static size_t time_bound(const MemoryColumns* columns, size_t n, int64_t ts, int inclusive) {
+    size_t lo = 0, hi = n;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        int64_t mid_ts = columns->timestamps[columns->time_order[mid]];
+        if (mid_ts < ts || (inclusive && mid_ts == ts)) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+/*
+ * Insert the newest row into the time index
+ * In-order timestamps append; late ones shift the newer rows up
+ */
+static void add_time_row(MemoryColumns* columns, uint32_t row) {
+    int64_t ts = columns->timestamps[row];
+    size_t pos = row;
+
+    if (row > 0 && columns->timestamps[columns->time_order[row - 1]] > ts) {
+        pos = time_bound(columns, row, ts, 1);
+        memmove(columns->time_order + pos + 1, columns->time_order + pos,
+                (row - pos) * sizeof(uint32_t));
+    }
+    columns->time_order[pos] = row;
+}
+
+/*
+ * Append the row of an entry
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_columns_append(MemoryColumns* columns, const MemoryEntry* entry) {
+    if (!columns || !entry) return -1;
+    if (columns->size >= columns->capacity &&
+        eliza_memory_columns_reserve(columns, columns->capacity ? columns->capacity * 2 : 16) < 0) {
+        return -1;
+    }
+
+    size_t row = columns->size;
+    uint32_t category_id = MEMORY_STRING_NONE;
+    if (entry->category) {
+        category_id = eliza_memory_strings_intern(&columns->categories, entry->category);
+        if (category_id == MEMORY_STRING_NONE) return -1;
+        if (add_category_row(columns, category_id, (uint32_t)row) < 0) return -1;
+    }
+
+    columns->timestamps[row] = (int64_t)entry->timestamp;
+    columns->importance[row] = entry->importance;
+    columns->category_ids[row] = category_id;
+    add_time_row(columns, (uint32_t)row);
+    columns->size++;
+    return 0;
+}
+
+/*
+ * Drop the rows from size on
+ * Category lists are in row order, so their last rows are the dropped
+ * ones; the time order is filtered
+ */
+void eliza_memory_columns_truncate(MemoryColumns* columns, size_t size) {
+    if (!columns || size >= columns->size) return;
+
+    size_t kept = 0;
+    for (size_t i = 0; i < columns->size; i++) {
+        if (columns->time_order[i] < size) columns->time_order[kept++] = columns->time_order[i];
+    }
+
+    for (size_t c = 0; c < columns->category_lists; c++) {
+        MemoryRowList* list = &columns->category_rows[c];
+        while (list->size > 0 && list->rows[list->size - 1] >= size) list->size--;
+    }
+
+    columns->size = size;
+}
+
+/*
+ * Refresh the row of an entry whose importance or timestamp changed
+ * A new timestamp moves the row within the time index, which keeps ties
+ * in row order
+ */
+void eliza_memory_columns_update(MemoryColumns* columns, size_t row, const MemoryEntry* entry) {
+    if (!columns || !entry || row >= columns->size) return;
+
+    columns->importance[row] = entry->importance;
+    int64_t old_ts = columns->timestamps[row];
+    int64_t new_ts = (int64_t)entry->timestamp;
+    if (new_ts == old_ts) return;
+
+    uint32_t* order = columns->time_order;
+    size_t n = columns->size;
+    size_t from = time_bound(columns, n, old_ts, 0);
+    while (order[from] != row) from++;
+    memmove(order + from, order + from + 1, (n - from - 1) * sizeof(uint32_t));
+
+    columns->timestamps[row] = new_ts;
+    size_t to = time_bound(columns, n - 1, new_ts, 0);
+    while (to < n - 1 && columns->timestamps[order[to]] == new_ts && order[to] < row) to++;
+    memmove(order + to + 1, order + to, (n - 1 - to) * sizeof(uint32_t));
+    order[to] = (uint32_t)row;
+}
+
+/*
+ * Remove all rows
+ */
+void eliza_memory_columns_clear(MemoryColumns* columns) {
+    if (!columns) return;
+
+    columns->size = 0;
+    for (size_t i = 0; i < columns->category_lists; i++) columns->category_rows[i].size = 0;
+}
+
+/*
+ * Drop the rows of removed entries, keeping the others in order
+ */
+void eliza_memory_columns_remap(MemoryColumns* columns, const uint32_t* map, size_t count) {
+    if (!columns) return;
+
+    size_t kept = 0;
+    for (size_t i = 0; i < count && i < columns->size; i++) {
+        if (map[i] == MEMORY_ID_REMOVED) continue;
+        columns->timestamps[kept] = columns->timestamps[i];
+        columns->importance[kept] = columns->importance[i];
+        columns->category_ids[kept] = columns->category_ids[i];
+        kept++;
+    }
+
+    /* Survivors keep their relative order, so both indexes only need
+     * filtering and renumbering */
+    size_t time_kept = 0;
+    for (size_t i = 0; i < columns->size; i++) {
+        uint32_t row = columns->time_order[i];
+        if (row < count && map[row] != MEMORY_ID_REMOVED) columns->time_order[time_kept++] = map[row];
+    }
+
+    for (size_t c = 0; c < columns->category_lists; c++) {
+        MemoryRowList* list = &columns->category_rows[c];
+        size_t list_kept = 0;
+        for (size_t i = 0; i < list->size; i++) {
+            uint32_t row = list->rows[i];
+            if (row < count && map[row] != MEMORY_ID_REMOVED) list->rows[list_kept++] = map[row];
+        }
+        list->size = list_kept;
+    }
+
+    columns->size = kept;
+}
+
+/*
+ * Number of rows with timestamps within [from, to]
+ */
+size_t eliza_memory_columns_count_time(const MemoryColumns* columns, time_t from, time_t to) {
+    if (!columns || from > to) return 0;
+    return time_bound(columns, columns->size, (int64_t)to, 1) -
+           time_bound(columns, columns->size, (int64_t)from, 0);
+}
+
+/*
+ * Number of rows in a category
+ */
+size_t eliza_memory_columns_count_category(const MemoryColumns* columns, const char* category) {
+    if (!columns || !category) return 0;
+
+    uint32_t id = eliza_memory_strings_find(&columns->categories, category);
+    if (id == MEMORY_STRING_NONE || id >= columns->category_lists) return 0;
+    return columns->category_rows[id].size;
+}
+
+/*
+ * Initialize a filter that matches everything
+ */
+void eliza_memory_filter_init(MemoryFilter* filter) {
+    if (!filter) return;
+
+    filter->flags = 0;
+    filter->min_timestamp = 0;
+    filter->max_timestamp = 0;
+    filter->min_importance = 0.0f;
+    filter->category_id = MEMORY_STRING_NONE;
+}
+
+/*
+ * Restrict a filter to a time range
+ */
+void eliza_memory_filter_time(MemoryFilter* filter, time_t from, time_t to) {
+    if (!filter) return;
+
+    filter->flags |= MEMORY_FILTER_TIME;
+    filter->min_timestamp = from;
+    filter->max_timestamp = to;
+}
+
+/*
+ * Restrict a filter to a minimum importance
+ */
+void eliza_memory_filter_importance(MemoryFilter* filter, float min_importance) {
+    if (!filter) return;
+
+    filter->flags |= MEMORY_FILTER_IMPORTANCE;
+    filter->min_importance = min_importance;
+}
+
+/*
+ * Restrict a filter to a category
+ * Returns 0 on success, -1 if the store has no columns
+ */
+int eliza_memory_filter_category(MemoryFilter* filter, MemoryStore* store,
+                                const char* category) {
+    if (!filter || !store || !store->columns || !category) return -1;
+
+    uint32_t id = eliza_memory_strings_find(&store->columns->categories, category);
+    filter->flags |= MEMORY_FILTER_CATEGORY;
+    filter->category_id = id == MEMORY_STRING_NONE ? NO_MATCH_CATEGORY : id;
+    return 0;
+}
+
+/*
+ * Widen the unused predicates of a filter
+ */
+static void make_bounds(const MemoryFilter* filter, FilterBounds* bounds) {
+    bounds->min_timestamp = INT64_MIN;
+    bounds->max_timestamp = INT64_MAX;
+    if (filter->flags & MEMORY_FILTER_TIME) {
+        bounds->min_timestamp = (int64_t)filter->min_timestamp;
+        bounds->max_timestamp = (int64_t)filter->max_timestamp;
+    }
+
+    bounds->use_importance = (filter->flags & MEMORY_FILTER_IMPORTANCE) != 0;
+    bounds->min_importance = filter->min_importance;
+    bounds->use_category = (filter->flags & MEMORY_FILTER_CATEGORY) != 0;
+    bounds->category_id = filter->category_id;
+}
+
+/*
+ * Check a single row
+ */
+static int row_passes(const MemoryColumns* columns, const FilterBounds* bounds, size_t row) {
+    return columns->timestamps[row] >= bounds->min_timestamp &&
+           columns->timestamps[row] <= bounds->max_timestamp &&
+           (!bounds->use_importance || columns->importance[row] >= bounds->min_importance) &&
+           (!bounds->use_category || columns->category_ids[row] == bounds->category_id);
+}
+
+/*
+ * Scalar kernel
+ */
+static size_t filter_scalar(const MemoryColumns* columns, const FilterBounds* bounds,
+                            size_t begin, size_t end, uint32_t* out) {
+    size_t found = 0;
+    for (size_t row = begin; row < end; row++) {
+        if (row_passes(columns, bounds, row)) out[found++] = (uint32_t)row;
+    }
+    return found;
+}
+
+#ifdef HAVE_X86_KERNELS
+
+/*
+ * Emit the rows whose bits are set in mask
+ */
+static inline size_t emit_rows(unsigned int mask, size_t base, uint32_t* out) {
+    size_t found = 0;
+    while (mask) {
+        out[found++] = (uint32_t)(base + (size_t)__builtin_ctz(mask));
+        mask &= mask - 1;
+    }
+    return found;
+}
+
+/*
+ * AVX2 kernel, eight rows per step
+ */
+__attribute__((target("avx2")))
+static size_t filter_avx2(const MemoryColumns* columns, const FilterBounds* bounds,
+                          size_t begin, size_t end, uint32_t* out) {
+    const __m256i min_ts = _mm256_set1_epi64x(bounds->min_timestamp);
+    const __m256i max_ts = _mm256_set1_epi64x(bounds->max_timestamp);
+    const __m256 min_imp = _mm256_set1_ps(bounds->min_importance);
+    const __m256i category = _mm256_set1_epi32((int)bounds->category_id);
+
+    size_t found = 0;
+    size_t row = begin;
+
+    for (; row + 8 <= end; row += 8) {
+        __m256i ts_lo = _mm256_loadu_si256((const __m256i*)(columns->timestamps + row));
+        __m256i ts_hi = _mm256_loadu_si256((const __m256i*)(columns->timestamps + row + 4));
+        __m256i out_lo = _mm256_or_si256(_mm256_cmpgt_epi64(min_ts, ts_lo),
+                                          _mm256_cmpgt_epi64(ts_lo, max_ts));
+        __m256i out_hi = _mm256_or_si256(_mm256_cmpgt_epi64(min_ts, ts_hi),
+                                          _mm256_cmpgt_epi64(ts_hi, max_ts));
+        unsigned int mask = ~((unsigned int)_mm256_movemask_pd(_mm256_castsi256_pd(out_lo)) |
+                              ((unsigned int)_mm256_movemask_pd(_mm256_castsi256_pd(out_hi)) << 4)) & 0xFF;
+
+        if (bounds->use_importance) {
+            __m256 imp = _mm256_loadu_ps(columns->importance + row);
+            mask &= (unsigned int)_mm256_movemask_ps(_mm256_cmp_ps(imp, min_imp, _CMP_GE_OQ));
+        }
+        if (bounds->use_category) {
+            __m256i ids = _mm256_loadu_si256((const __m256i*)(columns->category_ids + row));
+            mask &= (unsigned int)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(ids, category)));
+        }
+
+        found += emit_rows(mask, row, out + found);
+    }
+
+    return found + filter_scalar(columns, bounds, row, end, out + found);
+}
+
+/*
+ * SSE4.2 kernel, four rows per step
+ */
+__attribute__((target("sse4.2")))
+static size_t filter_sse42(const MemoryColumns* columns, const FilterBounds* bounds,
+                           size_t begin, size_t end, uint32_t* out) {
+    const __m128i min_ts = _mm_set1_epi64x(bounds->min_timestamp);
+    const __m128i max_ts = _mm_set1_epi64x(bounds->max_timestamp);
+    const __m128 min_imp = _mm_set1_ps(bounds->min_importance);
+    const __m128i category = _mm_set1_epi32((int)bounds->category_id);
+
+    size_t found = 0;
+    size_t row = begin;
+
+    for (; row + 4 <= end; row += 4) {
+        __m128i ts_lo = _mm_loadu_si128((const __m128i*)(columns->timestamps + row));
+        __m128i ts_hi = _mm_loadu_si128((const __m128i*)(columns->timestamps + row + 2));
+        __m128i out_lo = _mm_or_si128(_mm_cmpgt_epi64(min_ts, ts_lo), _mm_cmpgt_epi64(ts_lo, max_ts));
+        __m128i out_hi = _mm_or_si128(_mm_cmpgt_epi64(min_ts, ts_hi), _mm_cmpgt_epi64(ts_hi, max_ts));
+        unsigned int mask = ~((unsigned int)_mm_movemask_pd(_mm_castsi128_pd(out_lo)) |
+                              ((unsigned int)_mm_movemask_pd(_mm_castsi128_pd(out_hi)) << 2)) & 0xF;
+
+        if (bounds->use_importance) {
+            __m128 imp = _mm_loadu_ps(columns->importance + row);
+            mask &= (unsigned int)_mm_movemask_ps(_mm_cmpge_ps(imp, min_imp));
+        }
+        if (bounds->use_category) {
+            __m128i ids = _mm_loadu_si128((const __m128i*)(columns->category_ids + row));
+            mask &= (unsigned int)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(ids, category)));
+        }
+
+        found += emit_rows(mask, row, out + found);
+    }
+
+    return found + filter_scalar(columns, bounds, row, end, out + found);
+}
+
+#endif /* HAVE_X86_KERNELS */
+
+/*
+ * Pick the widest kernel the CPU supports
+ */
+static FilterKernel select_kernel(void) {
+#ifdef HAVE_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return filter_avx2;
+    if (__builtin_cpu_supports("sse4.2")) return filter_sse42;
+#endif
+    return filter_scalar;
+}
+
+static int compare_rows(const void* a, const void* b) {
+    uint32_t x = *(const uint32_t*)a;
+    uint32_t y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+/*
+ * Rows that may pass a filter, taken from the narrower secondary index
+ * Writes an ascending, newly allocated array to rows and its length to
+ * count. Returns 1 when an index was used, 0 when a column scan is
+ * cheaper, -1 on failure
+ */
+static int index_candidates(const MemoryColumns* columns, const FilterBounds* bounds,
+                            uint32_t** rows, size_t* count) {
+    size_t limit = columns->size / INDEX_SELECTIVITY;
+
+    /* Category rows, none for an unknown or unused category */
+    const uint32_t* category_rows = NULL;
+    size_t category_count = SIZE_MAX;
+    if (bounds->use_category) {
+        category_count = 0;
+        if (bounds->category_id < columns->category_lists) {
+            category_rows = columns->category_rows[bounds->category_id].rows;
+            category_count = columns->category_rows[bounds->category_id].size;
+        }
+    }
+
+    /* Slice of the time index */
+    size_t time_begin = 0, time_end = columns->size;
+    if (bounds->min_timestamp > INT64_MIN || bounds->max_timestamp < INT64_MAX) {
+        if (bounds->min_timestamp > bounds->max_timestamp) {
+            time_end = 0;
+        } else {
+            time_begin = time_bound(columns, columns->size, bounds->min_timestamp, 0);
+            time_end = time_bound(columns, columns->size, bounds->max_timestamp, 1);
+        }
+    }
+    size_t time_count = time_end - time_begin;
+
+    size_t n = category_count < time_count ? category_count : time_count;
+    if (n > limit) return 0;
+
+    *rows = (uint32_t*)malloc((n ? n : 1) * sizeof(uint32_t));
+    if (!*rows) return -1;
+    *count = n;
+
+    if (category_count <= time_count) {
+        if (n) memcpy(*rows, category_rows, n * sizeof(uint32_t));
+        return 1;
+    }
+
+    /* Time order is store order unless timestamps arrived out of order */
+    int sorted = 1;
+    for (size_t i = 0; i < n; i++) {
+        (*rows)[i] = columns->time_order[time_begin + i];
+        if (i > 0 && (*rows)[i] < (*rows)[i - 1]) sorted = 0;
+    }
+    if (!sorted) qsort(*rows, n, sizeof(uint32_t), compare_rows);
+    return 1;
+}
+
+/*
+ * Remove the positions of removed entries from a kernel's output
+ */
+static size_t drop_removed(const MemoryStore* store, uint32_t* rows, size_t n) {
+    size_t kept = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (store->entries[rows[i]]) rows[kept++] = rows[i];
+    }
+    return kept;
+}
+
+/*
+ * Collect the positions of entries passing a filter
+ */
+size_t eliza_memory_filter(MemoryStore* store, const MemoryFilter* filter,
+                          uint32_t* out, size_t max) {
+    if (!store || !store->columns || !filter || !out) return 0;
+
+    const MemoryColumns* columns = store->columns;
+    FilterBounds bounds;
+    make_bounds(filter, &bounds);
+    size_t found = 0;
+
+    /* A selective time range or category: check only the rows it names */
+    uint32_t* rows;
+    size_t count;
+    int indexed = index_candidates(columns, &bounds, &rows, &count);
+    if (indexed < 0) return 0;
+    if (indexed) {
+        for (size_t i = 0; i < count && found < max; i++) {
+            if (row_passes(columns, &bounds, rows[i]) && store->entries[rows[i]]) out[found++] = rows[i];
+        }
+        free(rows);
+        return found;
+    }
+
+    FilterKernel kernel = select_kernel();
+    uint32_t chunk[FILTER_CHUNK];
+
+    for (size_t begin = 0; begin < columns->size && found < max; begin += FILTER_CHUNK) {
+        size_t end = begin + FILTER_CHUNK < columns->size ? begin + FILTER_CHUNK : columns->size;
+        size_t n = kernel(columns, &bounds, begin, end, chunk);
+        if (store->removed) n = drop_removed(store, chunk, n);
+
+        if (n > max - found) n = max - found;
+        memcpy(out + found, chunk, n * sizeof(uint32_t));
+        found += n;
+    }
+
+    return found;
+}
+
+/*
+ * Search restricted to entries passing a filter
+ * The filter runs first over the columns, content is only compared for
+ * the rows that pass. Queries the inverted index can narrow check the
+ * filter per index hit.
+ */
+MemoryEntry** eliza_memory_search_filtered(MemoryStore* store, const char* query,
+                                         const MemoryFilter* filter, size_t max_results) {
+    if (!store || !query || !filter || !store->columns) return NULL;
+
+    MemoryMatcher matcher;
+    if (eliza_memory_matcher_init(&matcher, query, 0) < 0) return NULL;
+
+    MemoryEntry** results = (MemoryEntry**)malloc((max_results + 1) * sizeof(MemoryEntry*));
+    if (!results) {
+        eliza_memory_matcher_destroy(&matcher);
+        return NULL;
+    }
+
+    const MemoryColumns* columns = store->columns;
+    FilterBounds bounds;
+    make_bounds(filter, &bounds);
+    size_t found = 0;
+
+    MemoryIndexQuery index_query;
+    if (eliza_memory_index_query_init_substring(&index_query, store->index, query) > 0) {
+        uint32_t id;
+        while (found < max_results && eliza_memory_index_query_next(&index_query, &id)) {
+            if (id < store->size && row_passes(columns, &bounds, id) && store->entries[id] &&
+                eliza_memory_matcher_contains(&matcher, store->entries[id]->content)) {
+                results[found++] = store->entries[id];
+            }
+        }
+
+        eliza_memory_index_query_release(&index_query);
+        eliza_memory_matcher_destroy(&matcher);
+        results[found] = NULL;
+        return results;
+    }
+
+    uint32_t* rows;
+    size_t count;
+    int indexed = index_candidates(columns, &bounds, &rows, &count);
+    if (indexed < 0) {
+        eliza_memory_matcher_destroy(&matcher);
+        free(results);
+        return NULL;
+    }
+    if (indexed) {
+        for (size_t i = 0; i < count && found < max_results; i++) {
+            MemoryEntry* entry = store->entries[rows[i]];
+            if (entry && row_passes(columns, &bounds, rows[i]) &&
+                eliza_memory_matcher_contains(&matcher, entry->content)) {
+                results[found++] = entry;
+            }
+        }
+        free(rows);
+
+        eliza_memory_matcher_destroy(&matcher);
+        results[found] = NULL;
+        return results;
+    }
+
+    FilterKernel kernel = select_kernel();
+    uint32_t chunk[FILTER_CHUNK];
+
+    for (size_t begin = 0; begin < columns->size && found < max_results; begin += FILTER_CHUNK) {
+        size_t end = begin + FILTER_CHUNK < columns->size ? begin + FILTER_CHUNK : columns->size;
+        size_t n = kernel(columns, &bounds, begin, end, chunk);
+
+        for (size_t i = 0; i < n && found < max_results; i++) {
+            MemoryEntry* entry = store->entries[chunk[i]];
+            if (entry && eliza_memory_matcher_contains(&matcher, entry->content)) results[found++] = entry;
+        }
+    }
+
+    eliza_memory_matcher_destroy(&matcher);
+    results[found] = NULL;
+    return results;
+}
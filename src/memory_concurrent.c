@@ -0,0 +1,355 @@
+#include "../include/memory_concurrent.h"
+#include "../include/memory_match.h"
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Implementation of the Concurrent Memory Store
+ */
+
+/* Segment pointers in a new store's directory */
+#define INITIAL_DIRECTORY_CAPACITY 16
+
+/*
+ * Allocate a directory with room for capacity segments
+ * Returns the directory, or NULL on failure
+ */
+static MemoryConcurrentDirectory* directory_create(size_t capacity) {
+    MemoryConcurrentDirectory* directory = (MemoryConcurrentDirectory*)calloc(
+        1, sizeof(MemoryConcurrentDirectory) + capacity * sizeof(MemoryConcurrentSegment*));
+    if (!directory) return NULL;
+
+    directory->capacity = capacity;
+    return directory;
+}
+
+/*
+ * Create an empty concurrent store
+ */
+MemoryConcurrentStore* eliza_memory_concurrent_create(void) {
+    MemoryConcurrentStore* store = (MemoryConcurrentStore*)aligned_alloc(
+        _Alignof(MemoryConcurrentStore), sizeof(MemoryConcurrentStore));
+    if (!store) return NULL;
+    memset(store, 0, sizeof(MemoryConcurrentStore));
+
+    MemoryConcurrentDirectory* directory = directory_create(INITIAL_DIRECTORY_CAPACITY);
+    if (!directory) {
+        free(store);
+        return NULL;
+    }
+
+    atomic_init(&store->directory, directory);
+    atomic_init(&store->size, 0);
+    atomic_init(&store->epoch, 1);
+    for (size_t i = 0; i < MEMORY_CONCURRENT_MAX_READERS; i++) {
+        atomic_init(&store->readers[i].epoch, MEMORY_EPOCH_IDLE);
+        atomic_init(&store->readers[i].in_use, 0);
+        store->readers[i].store = store;
+    }
+    pthread_mutex_init(&store->write_lock, NULL);
+
+    return store;
+}
+
+/*
+ * Destroy a concurrent store and its entries
+ */
+void eliza_memory_concurrent_destroy(MemoryConcurrentStore* store) {
+    if (!store) return;
+
+    MemoryConcurrentDirectory* directory = atomic_load(&store->directory);
+    size_t size = atomic_load(&store->size);
+
+    for (size_t s = 0; s < store->segments; s++) {
+        MemoryConcurrentSegment* segment = directory->segments[s];
+        size_t base = s << MEMORY_CONCURRENT_SEGMENT_BITS;
+        for (size_t i = 0; i < MEMORY_CONCURRENT_SEGMENT_SIZE && base + i < size; i++) {
+            eliza_memory_entry_destroy(segment->entries[i]);
+        }
+        free(segment);
+    }
+    free(directory);
+
+    MemoryRetired* retired = store->retired;
+    while (retired) {
+        MemoryRetired* next = retired->next;
+        free(retired->ptr);
+        free(retired);
+        retired = next;
+    }
+
+    pthread_mutex_destroy(&store->write_lock);
+    free(store);
+}
+
+/*
+ * Free retired directories that no reader can still see
+ * Called with the write lock held
+ */
+static void reclaim(MemoryConcurrentStore* store) {
+    uint64_t oldest = MEMORY_EPOCH_IDLE;
+    for (size_t i = 0; i < MEMORY_CONCURRENT_MAX_READERS; i++) {
+        uint64_t epoch = atomic_load(&store->readers[i].epoch);
+        if (epoch < oldest) oldest = epoch;
+    }
+
+    MemoryRetired** link = &store->retired;
+    while (*link) {
+        MemoryRetired* retired = *link;
+        if (retired->epoch < oldest) {
+            *link = retired->next;
+            free(retired->ptr);
+            free(retired);
+            store->reclaimed_count++;
+        } else {
+            link = &retired->next;
+        }
+    }
+}
+
+/*
+ * Publish a directory twice the size of the current one
+ * Called with the write lock held
+ * Returns 0 on success, -1 on failure
+ */
+static int grow_directory(MemoryConcurrentStore* store) {
+    MemoryConcurrentDirectory* old = atomic_load_explicit(&store->directory, memory_order_relaxed);
+
+    MemoryRetired* retired = (MemoryRetired*)malloc(sizeof(MemoryRetired));
+    if (!retired) return -1;
+
+    MemoryConcurrentDirectory* directory = directory_create(old->capacity * 2);
+    if (!directory) {
+        free(retired);
+        return -1;
+    }
+    memcpy(directory->segments, old->segments, store->segments * sizeof(MemoryConcurrentSegment*));
+
+    /* Readers that announce the advanced epoch are ordered after the swap
+     * and can only load the new directory */
+    atomic_store(&store->directory, directory);
+    retired->ptr = old;
+    retired->epoch = atomic_fetch_add(&store->epoch, 1);
+    retired->next = store->retired;
+    store->retired = retired;
+    store->retired_count++;
+
+    reclaim(store);
+    return 0;
+}
+
+/*
+ * Add an entry, taking ownership
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_concurrent_add_entry(MemoryConcurrentStore* store, MemoryEntry* entry) {
+    if (!store || !entry) return -1;
+
+    pthread_mutex_lock(&store->write_lock);
+
+    size_t size = atomic_load_explicit(&store->size, memory_order_relaxed);
+    size_t segment_index = size >> MEMORY_CONCURRENT_SEGMENT_BITS;
+
+    if (segment_index == store->segments) {
+        MemoryConcurrentDirectory* directory = atomic_load_explicit(&store->directory, memory_order_relaxed);
+        if (segment_index == directory->capacity && grow_directory(store) < 0) {
+            pthread_mutex_unlock(&store->write_lock);
+            return -1;
+        }
+
+        MemoryConcurrentSegment* segment = (MemoryConcurrentSegment*)malloc(sizeof(MemoryConcurrentSegment));
+        if (!segment) {
+            pthread_mutex_unlock(&store->write_lock);
+            return -1;
+        }
+
+        /* Readers only look at this slot once the count covers it */
+        directory = atomic_load_explicit(&store->directory, memory_order_relaxed);
+        directory->segments[segment_index] = segment;
+        store->segments++;
+    }
+
+    MemoryConcurrentDirectory* directory = atomic_load_explicit(&store->directory, memory_order_relaxed);
+    directory->segments[segment_index]->entries[size & (MEMORY_CONCURRENT_SEGMENT_SIZE - 1)] = entry;
+
+    /* Publish: the entry and its segment become visible together */
+    atomic_store_explicit(&store->size, size + 1, memory_order_release);
+
+    pthread_mutex_unlock(&store->write_lock);
+    return 0;
+}
+
+/*
+ * Add a new memory
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_concurrent_add(MemoryConcurrentStore* store, const char* content,
+                               float importance, const char* context, const char* category) {
+    if (!store || !content) return -1;
+
+    /* Build the entry outside the lock */
+    MemoryEntry* entry = eliza_memory_entry_create(content, importance, context, category);
+    if (!entry) return -1;
+
+    if (eliza_memory_concurrent_add_entry(store, entry) < 0) {
+        eliza_memory_entry_destroy(entry);
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Add a copy of every entry of a store
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_concurrent_import(MemoryConcurrentStore* store, const MemoryStore* source) {
+    if (!store || !source) return -1;
+
+    for (size_t i = 0; i < source->size; i++) {
+        const MemoryEntry* original = source->entries[i];
+        if (!original) continue;
+
+        MemoryEntry* entry = eliza_memory_entry_create(original->content, original->importance,
+                                                       original->context, original->category);
+        if (!entry) return -1;
+        entry->timestamp = original->timestamp;
+
+        if (eliza_memory_concurrent_add_entry(store, entry) < 0) {
+            eliza_memory_entry_destroy(entry);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Register the calling thread as a reader
+ * Returns a reader slot, or NULL when all are taken
+ */
+MemoryReader* eliza_memory_concurrent_reader(MemoryConcurrentStore* store) {
+    if (!store) return NULL;
+
+    for (size_t i = 0; i < MEMORY_CONCURRENT_MAX_READERS; i++) {
+        int expected = 0;
+        if (atomic_compare_exchange_strong(&store->readers[i].in_use, &expected, 1)) {
+            return &store->readers[i];
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Give a reader slot back
+ */
+void eliza_memory_concurrent_reader_release(MemoryReader* reader) {
+    if (!reader) return;
+
+    atomic_store(&reader->epoch, MEMORY_EPOCH_IDLE);
+    atomic_store(&reader->in_use, 0);
+}
+
+/*
+ * Enter a read-side critical section
+ */
+void eliza_memory_concurrent_read_begin(MemoryReader* reader) {
+    /* Sequentially consistent, so later directory loads are ordered after
+     * the announcement in the view of reclaim() */
+    atomic_store(&reader->epoch, atomic_load(&reader->store->epoch));
+}
+
+/*
+ * Leave a read-side critical section
+ */
+void eliza_memory_concurrent_read_end(MemoryReader* reader) {
+    atomic_store_explicit(&reader->epoch, MEMORY_EPOCH_IDLE, memory_order_release);
+}
+
+/*
+ * Number of published entries
+ */
+size_t eliza_memory_concurrent_size(MemoryConcurrentStore* store) {
+    if (!store) return 0;
+    return atomic_load_explicit(&store->size, memory_order_acquire);
+}
+
+/*
+ * Entry at position
+ * Returns the entry, or NULL past the published count
+ */
+MemoryEntry* eliza_memory_concurrent_get(MemoryReader* reader, size_t position) {
+    if (!reader) return NULL;
+
+    MemoryConcurrentStore* store = reader->store;
+    if (position >= atomic_load_explicit(&store->size, memory_order_acquire)) return NULL;
+
+    MemoryConcurrentDirectory* directory = atomic_load(&store->directory);
+    return directory->segments[position >> MEMORY_CONCURRENT_SEGMENT_BITS]
+        ->entries[position & (MEMORY_CONCURRENT_SEGMENT_SIZE - 1)];
+}
+
+/*
+ * Search by string matching
+ * Returns an array of matching entries, terminated with a NULL pointer
+ */
+MemoryEntry** eliza_memory_concurrent_search(MemoryReader* reader, const char* query,
+                                           size_t max_results) {
+    if (!reader || !query) return NULL;
+
+    MemoryMatcher matcher;
+    if (eliza_memory_matcher_init(&matcher, query, 0) < 0) return NULL;
+
+    MemoryEntry** results = (MemoryEntry**)malloc((max_results + 1) * sizeof(MemoryEntry*));
+    if (!results) {
+        eliza_memory_matcher_destroy(&matcher);
+        return NULL;
+    }
+
+    size_t found = 0;
+    MemoryConcurrentStore* store = reader->store;
+
+    eliza_memory_concurrent_read_begin(reader);
+
+    /* The count first: the directory loaded after it covers every
+     * segment below the count */
+    size_t size = atomic_load_explicit(&store->size, memory_order_acquire);
+    MemoryConcurrentDirectory* directory = atomic_load(&store->directory);
+
+    for (size_t base = 0; base < size && found < max_results; base += MEMORY_CONCURRENT_SEGMENT_SIZE) {
+        MemoryConcurrentSegment* segment = directory->segments[base >> MEMORY_CONCURRENT_SEGMENT_BITS];
+        size_t count = size - base < MEMORY_CONCURRENT_SEGMENT_SIZE ? size - base : MEMORY_CONCURRENT_SEGMENT_SIZE;
+
+        for (size_t i = 0; i < count && found < max_results; i++) {
+            MemoryEntry* entry = segment->entries[i];
+            if (eliza_memory_matcher_contains(&matcher, entry->content)) {
+                results[found++] = entry;
+            }
+        }
+    }
+
+    eliza_memory_concurrent_read_end(reader);
+    eliza_memory_matcher_destroy(&matcher);
+
+    results[found] = NULL;
+    return results;
+}
+
+/*
+ * Copy the current statistics
+ */
+void eliza_memory_concurrent_get_stats(MemoryConcurrentStore* store, MemoryConcurrentStats* stats) {
+    if (!stats) return;
+    memset(stats, 0, sizeof(*stats));
+    if (!store) return;
+
+    pthread_mutex_lock(&store->write_lock);
+    stats->entries = atomic_load(&store->size);
+    stats->segments = store->segments;
+    stats->epoch = atomic_load(&store->epoch);
+    stats->retired = store->retired_count;
+    stats->reclaimed = store->reclaimed_count;
+    pthread_mutex_unlock(&store->write_lock);
+
+    for (size_t i = 0; i < MEMORY_CONCURRENT_MAX_READERS; i++) {
+        if (atomic_load(&store->readers[i].in_use)) stats->readers++;
+    }
+}
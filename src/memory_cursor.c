@@ -0,0 +1,138 @@
+#include "../include/memory_cursor.h"
+#include "../include/memory_arena.h"
+#include <string.h>
+
+/*
+ * Implementation of Memory Search Cursors
+ */
+
+/*
+ * Start a search
+ * Queries with terms the inverted index can look up take their
+ * candidates from it, others scan the entries, as in
+ * eliza_memory_search. A tiered
+ * store's cold segments are scanned after that
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_cursor_open(MemoryCursor* cursor, const MemoryStore* store, const char* query) {
+    if (!cursor || !store || !query) return -1;
+
+    if (eliza_memory_matcher_init_buffer(&cursor->matcher, query, 0,
+                                         cursor->needle, sizeof(cursor->needle)) < 0) {
+        return -1;
+    }
+
+    cursor->store = store;
+    cursor->use_index = eliza_memory_index_query_init_substring(&cursor->index_query,
+                                                                store->index, query) > 0;
+    cursor->position = 0;
+    cursor->cold = 0;
+    cursor->cold_segment = 0;
+    cursor->cold_record = 0;
+    cursor->cold_entries = NULL;
+    cursor->returned = 0;
+    return 0;
+}
+
+/*
+ * Fetch the next match
+ * Returns its entry, or NULL when there are no more
+ */
+const MemoryEntry* eliza_memory_cursor_next(MemoryCursor* cursor, uint32_t* id) {
+    if (!cursor || !cursor->store) return NULL;
+
+    const MemoryStore* store = cursor->store;
+    const MemoryEntry* entry = NULL;
+    uint32_t found = 0;
+
+    if (cursor->cold) {
+        /* Cold matches are decoded into storage that lives with the cursor */
+        if (!cursor->cold_entries) cursor->cold_entries = eliza_memory_arena_create();
+        entry = eliza_memory_tier_next_match(store->tier, &cursor->matcher, cursor->cold_entries,
+                                             &cursor->cold_segment, &cursor->cold_record);
+        found = MEMORY_ID_REMOVED;
+    } else if (cursor->use_index) {
+        while (eliza_memory_index_query_next(&cursor->index_query, &found)) {
+            entry = found < store->size ? store->entries[found] : NULL;
+            if (entry && eliza_memory_matcher_contains(&cursor->matcher, entry->content)) break;
+            entry = NULL;
+        }
+    } else {
+        while (cursor->position < store->size) {
+            found = (uint32_t)cursor->position++;
+            entry = store->entries[found];
+            if (entry && eliza_memory_matcher_contains(&cursor->matcher, entry->content)) break;
+            entry = NULL;
+        }
+    }
+
+    /* Older entries may have moved to the cold tier */
+    if (!entry && !cursor->cold && store->tier) {
+        cursor->cold = 1;
+        return eliza_memory_cursor_next(cursor, id);
+    }
+
+    if (!entry) return NULL;
+    cursor->returned++;
+    if (id) *id = found;
+    return entry;
+}
+
+/*
+ * Release a cursor
+ */
+void eliza_memory_cursor_close(MemoryCursor* cursor) {
+    if (!cursor || !cursor->store) return;
+
+    eliza_memory_matcher_destroy(&cursor->matcher);
+    eliza_memory_index_query_release(&cursor->index_query);
+    eliza_memory_arena_destroy(cursor->cold_entries);
+    cursor->cold_entries = NULL;
+    cursor->store = NULL;
+}
+
+/*
+ * Search into caller storage
+ * Cold matches would not outlive the cursor, so only hot ones are written
+ * Returns the number of matches written
+ */
+size_t eliza_memory_search_into(const MemoryStore* store, const char* query,
+                               const MemoryEntry** results, size_t max) {
+    if (!results || max == 0) return 0;
+
+    MemoryCursor cursor;
+    if (eliza_memory_cursor_open(&cursor, store, query) < 0) return 0;
+
+    size_t found = 0;
+    const MemoryEntry* entry;
+    uint32_t id;
+    while (found < max && (entry = eliza_memory_cursor_next(&cursor, &id)) != NULL &&
+           id != MEMORY_ID_REMOVED) {
+        results[found++] = entry;
+    }
+
+    eliza_memory_cursor_close(&cursor);
+    return found;
+}
+
+/*
+ * Visit each match until the callback asks to stop
+ * Returns the number of matches visited
+ */
+size_t eliza_memory_search_each(const MemoryStore* store, const char* query,
+                               MemoryVisitFn visit, void* arg) {
+    if (!visit) return 0;
+
+    MemoryCursor cursor;
+    if (eliza_memory_cursor_open(&cursor, store, query) < 0) return 0;
+
+    const MemoryEntry* entry;
+    uint32_t id;
+    while ((entry = eliza_memory_cursor_next(&cursor, &id)) != NULL) {
+        if (visit(entry, id, arg)) break;
+    }
+
+    size_t visited = cursor.returned;
+    eliza_memory_cursor_close(&cursor);
+    return visited;
+}
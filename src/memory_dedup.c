@@ -0,0 +1,329 @@
+#include "../include/memory_dedup.h"
+#include "../include/memory_evict.h"
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Implementation of Memory Deduplication
+ */
+
+#define BAND_VALUES ((size_t)1 << MEMORY_DEDUP_BAND_BITS)
+#define BAND_MASK (BAND_VALUES - 1)
+
+#define FNV_OFFSET 14695981039346656037ULL
+#define FNV_PRIME 1099511628211ULL
+
+/*
+ * Fill dedup options with defaults
+ */
+void eliza_memory_dedup_options_default(MemoryDedupOptions* options) {
+    if (!options) return;
+
+    options->mode = MEMORY_DEDUP_MERGE;
+    options->max_distance = 3;
+    options->merge_boost = 0.05f;
+    options->max_candidates = 64;
+}
+
+/*
+ * Spread the bits of a hash; FNV-1a alone leaves the high bits of short
+ * words poorly mixed
+ */
+static inline uint64_t mix(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+/*
+ * Words are runs of letters, digits and non-ASCII bytes
+ */
+static inline int is_word_byte(unsigned char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c >= 0x80;
+}
+
+/*
+ * Add one feature hash to the bit tallies
+ */
+static inline void tally(int* counts, uint64_t h) {
+    for (int bit = 0; bit < 64; bit++) {
+        counts[bit] += (int)((h >> bit) & 1) * 2 - 1;
+    }
+}
+
+/*
+ * 64-bit SimHash of a text
+ * Features are the lower-cased words and pairs of adjacent words, so
+ * reordering words moves the signature as well as changing them
+ */
+uint64_t eliza_memory_simhash(const char* text) {
+    if (!text) return 0;
+
+    int counts[64] = {0};
+    uint64_t previous = 0;
+    int features = 0;
+    const unsigned char* p = (const unsigned char*)text;
+
+    while (*p) {
+        while (*p && !is_word_byte(*p)) p++;
+        if (!*p) break;
+
+        uint64_t h = FNV_OFFSET;
+        for (; *p && is_word_byte(*p); p++) {
+            unsigned char c = (*p >= 'A' && *p <= 'Z') ? (unsigned char)(*p | 0x20) : *p;
+            h = (h ^ c) * FNV_PRIME;
+        }
+
+        uint64_t word = mix(h);
+        tally(counts, word);
+        if (features++) tally(counts, mix(previous * 31 + word));
+        previous = word;
+    }
+
+    /* Texts without words are compared as a whole */
+    if (features == 0) {
+        uint64_t h = FNV_OFFSET;
+        for (p = (const unsigned char*)text; *p; p++) h = (h ^ *p) * FNV_PRIME;
+        return mix(h);
+    }
+
+    uint64_t signature = 0;
+    for (int bit = 0; bit < 64; bit++) {
+        if (counts[bit] > 0) signature |= 1ULL << bit;
+    }
+    return signature;
+}
+
+static inline uint32_t band_value(uint64_t signature, int band) {
+    return (uint32_t)((signature >> (band * MEMORY_DEDUP_BAND_BITS)) & BAND_MASK);
+}
+
+static int same_category(const char* a, const char* b) {
+    if (!a || !b) return a == b;
+    return a == b || strcmp(a, b) == 0;
+}
+
+/*
+ * Destroy dedup state
+ */
+void eliza_memory_dedup_destroy(MemoryDedup* dedup) {
+    if (!dedup) return;
+
+    free(dedup->signatures);
+    free(dedup->next);
+    free(dedup->heads);
+    free(dedup);
+}
+
+/*
+ * Make room for capacity entry ids
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_dedup_reserve(MemoryDedup* dedup, size_t capacity) {
+    if (!dedup) return -1;
+    if (capacity <= dedup->capacity) return 0;
+
+    uint64_t* signatures = (uint64_t*)realloc(dedup->signatures, capacity * sizeof(uint64_t));
+    if (!signatures) return -1;
+    dedup->signatures = signatures;
+
+    uint32_t* next = (uint32_t*)realloc(dedup->next, capacity * MEMORY_DEDUP_BANDS * sizeof(uint32_t));
+    if (!next) return -1;
+    dedup->next = next;
+
+    dedup->capacity = capacity;
+    return 0;
+}
+
+/*
+ * Track the entry just added at id
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_dedup_add(MemoryDedup* dedup, uint32_t id, uint64_t signature) {
+    if (!dedup) return -1;
+    if (id >= dedup->capacity) {
+        size_t capacity = dedup->capacity ? dedup->capacity * 2 : 16;
+        if (capacity <= id) capacity = (size_t)id + 1;
+        if (eliza_memory_dedup_reserve(dedup, capacity) < 0) return -1;
+    }
+
+    dedup->signatures[id] = signature;
+    for (int band = 0; band < MEMORY_DEDUP_BANDS; band++) {
+        uint32_t* head = &dedup->heads[band * BAND_VALUES + band_value(signature, band)];
+        dedup->next[(size_t)id * MEMORY_DEDUP_BANDS + band] = *head;
+        *head = id + 1;
+    }
+    if (id >= dedup->size) dedup->size = id + 1;
+    return 0;
+}
+
+/*
+ * Stop tracking the ids from size on
+ * Chains start at their newest id, so dropped ids are unlinked from the
+ * heads
+ */
+void eliza_memory_dedup_truncate(MemoryDedup* dedup, size_t size) {
+    if (!dedup || size >= dedup->size) return;
+
+    for (size_t i = 0; i < MEMORY_DEDUP_BANDS * BAND_VALUES; i++) {
+        int band = (int)(i / BAND_VALUES);
+        uint32_t* head = &dedup->heads[i];
+        while (*head > size) *head = dedup->next[(size_t)(*head - 1) * MEMORY_DEDUP_BANDS + band];
+    }
+    dedup->size = size;
+}
+
+/*
+ * Closest live entry in the same category within max_distance bits
+ * Removed entries stay in the chains until the next remap and are
+ * skipped here
+ * Returns its id, or MEMORY_ID_REMOVED
+ */
+static uint32_t find_duplicate(const MemoryStore* store, MemoryDedup* dedup,
+                               uint64_t signature, const char* category) {
+    uint32_t best = MEMORY_ID_REMOVED;
+    int best_distance = (int)dedup->options.max_distance + 1;
+
+    for (int band = 0; band < MEMORY_DEDUP_BANDS && best_distance > 0; band++) {
+        uint32_t link = dedup->heads[band * BAND_VALUES + band_value(signature, band)];
+        for (size_t seen = 0; link && seen < dedup->options.max_candidates; seen++) {
+            uint32_t id = link - 1;
+            link = dedup->next[(size_t)id * MEMORY_DEDUP_BANDS + band];
+
+            const MemoryEntry* entry = id < store->size ? store->entries[id] : NULL;
+            if (!entry) continue;
+
+            dedup->stats.candidates++;
+            int distance = __builtin_popcountll(dedup->signatures[id] ^ signature);
+            if (distance < best_distance && same_category(entry->category, category)) {
+                best = id;
+                best_distance = distance;
+                if (distance == 0) break;
+            }
+        }
+    }
+    return best;
+}
+
+/*
+ * Handle an entry about to be added
+ * Returns 1 for a duplicate, 0 to add it, -1 on failure
+ */
+int eliza_memory_dedup_check(MemoryStore* store, const MemoryEntry* entry, uint64_t* signature) {
+    if (!store || !store->dedup || !entry || !signature) return -1;
+
+    MemoryDedup* dedup = store->dedup;
+    *signature = eliza_memory_simhash(entry->content);
+    dedup->stats.checked++;
+
+    uint32_t id = find_duplicate(store, dedup, *signature, entry->category);
+    if (id == MEMORY_ID_REMOVED) return 0;
+
+    dedup->stats.duplicates++;
+    dedup->stats.bytes_saved += eliza_memory_entry_bytes(entry);
+    if (dedup->options.mode == MEMORY_DEDUP_REJECT) {
+        dedup->stats.rejected++;
+        return 1;
+    }
+
+    /* Repetition is a sign the fact matters */
+    const MemoryEntry* existing = store->entries[id];
+    float importance = existing->importance > entry->importance ? existing->importance : entry->importance;
+    importance += dedup->options.merge_boost;
+    if (importance > 1.0f) importance = 1.0f;
+    time_t timestamp = existing->timestamp > entry->timestamp ? existing->timestamp : entry->timestamp;
+
+    dedup->stats.merged++;
+    if (eliza_memory_touch(store, id, importance, timestamp) < 0) return -1;
+    return 1;
+}
+
+/*
+ * Renumber tracked entries
+ * The chains are rebuilt from the surviving signatures, which also drops
+ * the removed entries they still held
+ */
+void eliza_memory_dedup_remap(MemoryDedup* dedup, const uint32_t* map, size_t count) {
+    if (!dedup) return;
+
+    size_t kept = 0;
+    for (size_t i = 0; i < count && i < dedup->size; i++) {
+        if (map[i] != MEMORY_ID_REMOVED) dedup->signatures[kept++] = dedup->signatures[i];
+    }
+
+    memset(dedup->heads, 0, MEMORY_DEDUP_BANDS * BAND_VALUES * sizeof(uint32_t));
+    dedup->size = 0;
+    for (size_t i = 0; i < kept; i++) {
+        eliza_memory_dedup_add(dedup, (uint32_t)i, dedup->signatures[i]);
+    }
+}
+
+/*
+ * Forget all entries
+ */
+void eliza_memory_dedup_clear(MemoryDedup* dedup) {
+    if (!dedup) return;
+
+    memset(dedup->heads, 0, MEMORY_DEDUP_BANDS * BAND_VALUES * sizeof(uint32_t));
+    dedup->size = 0;
+}
+
+/*
+ * Track every entry of a store from scratch
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_dedup_track(MemoryDedup* dedup, const MemoryStore* store) {
+    if (!dedup || !store) return -1;
+
+    eliza_memory_dedup_clear(dedup);
+    for (size_t i = 0; i < store->size; i++) {
+        const MemoryEntry* entry = store->entries[i];
+        uint64_t signature = entry ? eliza_memory_simhash(entry->content) : 0;
+        if (eliza_memory_dedup_add(dedup, (uint32_t)i, signature) < 0) return -1;
+    }
+    return 0;
+}
+
+/*
+ * Turn on deduplication for a store
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_enable_dedup(MemoryStore* store, const MemoryDedupOptions* options) {
+    if (!store || !options) return -1;
+
+    MemoryDedup* dedup = store->dedup;
+    if (!dedup) {
+        dedup = (MemoryDedup*)calloc(1, sizeof(MemoryDedup));
+        if (!dedup) return -1;
+        dedup->heads = (uint32_t*)calloc(MEMORY_DEDUP_BANDS * BAND_VALUES, sizeof(uint32_t));
+        if (!dedup->heads ||
+            eliza_memory_dedup_reserve(dedup, store->capacity > 0 ? store->capacity : 16) < 0) {
+            eliza_memory_dedup_destroy(dedup);
+            return -1;
+        }
+
+        if (eliza_memory_dedup_track(dedup, store) < 0) {
+            eliza_memory_dedup_destroy(dedup);
+            return -1;
+        }
+    }
+
+    dedup->options = *options;
+    store->dedup = dedup;
+    return 0;
+}
+
+/*
+ * Collect dedup statistics
+ */
+void eliza_memory_dedup_get_stats(const MemoryStore* store, MemoryDedupStats* stats) {
+    if (!stats) return;
+    memset(stats, 0, sizeof(*stats));
+    if (!store || !store->dedup) return;
+
+    *stats = store->dedup->stats;
+    stats->rate = stats->checked ? (double)stats->duplicates / (double)stats->checked : 0.0;
+}
@@ -0,0 +1,336 @@
+#include "../include/memory_evict.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/*
+ * Implementation of Memory Eviction
+ */
+
+/* Importance floor, so zero or negative importance still orders by age */
+#define MIN_IMPORTANCE 1e-6
+
+/*
+ * Fill a budget with defaults
+ */
+void eliza_memory_budget_default(MemoryBudget* budget) {
+    if (!budget) return;
+
+    budget->max_entries = 0;
+    budget->max_bytes = 0;
+    budget->half_life = 3.0 * 24.0 * 3600.0;
+}
+
+/*
+ * Bytes an entry counts against the byte budget
+ */
+size_t eliza_memory_entry_bytes(const MemoryEntry* entry) {
+    if (!entry) return 0;
+
+    size_t bytes = sizeof(MemoryEntry);
+    if (entry->content) bytes += strlen(entry->content) + 1;
+    if (entry->context) bytes += strlen(entry->context) + 1;
+    if (entry->category) bytes += strlen(entry->category) + 1;
+    return bytes;
+}
+
+/*
+ * Time-invariant value key of an entry, lower is evicted first
+ */
+static double value_key(const MemoryBudget* budget, const MemoryEntry* entry) {
+    double importance = entry->importance > MIN_IMPORTANCE ? entry->importance : MIN_IMPORTANCE;
+    double key = log2(importance);
+    if (budget->half_life > 0.0) key += (double)entry->timestamp / budget->half_life;
+    return key;
+}
+
+/*
+ * Place an id at a heap position
+ */
+static void heap_set(MemoryEviction* eviction, size_t pos, uint32_t id) {
+    eviction->heap[pos] = id;
+    eviction->positions[id] = (uint32_t)pos;
+}
+
+/*
+ * Move the id at pos towards the root while it beats its parent
+ */
+static void sift_up(MemoryEviction* eviction, size_t pos) {
+    uint32_t id = eviction->heap[pos];
+    double key = eviction->keys[id];
+
+    while (pos > 0) {
+        size_t parent = (pos - 1) / 2;
+        if (eviction->keys[eviction->heap[parent]] <= key) break;
+        heap_set(eviction, pos, eviction->heap[parent]);
+        pos = parent;
+    }
+    heap_set(eviction, pos, id);
+}
+
+/*
+ * Move the id at pos towards the leaves while a child beats it
+ */
+static void sift_down(MemoryEviction* eviction, size_t pos) {
+    uint32_t id = eviction->heap[pos];
+    double key = eviction->keys[id];
+
+    for (;;) {
+        size_t child = 2 * pos + 1;
+        if (child >= eviction->size) break;
+        if (child + 1 < eviction->size &&
+            eviction->keys[eviction->heap[child + 1]] < eviction->keys[eviction->heap[child]]) {
+            child++;
+        }
+        if (key <= eviction->keys[eviction->heap[child]]) break;
+        heap_set(eviction, pos, eviction->heap[child]);
+        pos = child;
+    }
+    heap_set(eviction, pos, id);
+}
+
+/*
+ * Destroy eviction state
+ */
+void eliza_memory_eviction_destroy(MemoryEviction* eviction) {
+    if (!eviction) return;
+
+    free(eviction->heap);
+    free(eviction->positions);
+    free(eviction->keys);
+    free(eviction);
+}
+
+/*
+ * Make room for capacity entry ids
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_eviction_reserve(MemoryEviction* eviction, size_t capacity) {
+    if (!eviction) return -1;
+    if (capacity <= eviction->capacity) return 0;
+
+    uint32_t* new_heap = (uint32_t*)realloc(eviction->heap, capacity * sizeof(uint32_t));
+    if (!new_heap) return -1;
+    eviction->heap = new_heap;
+
+    uint32_t* new_positions = (uint32_t*)realloc(eviction->positions, capacity * sizeof(uint32_t));
+    if (!new_positions) return -1;
+    eviction->positions = new_positions;
+
+    double* new_keys = (double*)realloc(eviction->keys, capacity * sizeof(double));
+    if (!new_keys) return -1;
+    eviction->keys = new_keys;
+
+    for (size_t i = eviction->capacity; i < capacity; i++) {
+        eviction->positions[i] = MEMORY_ID_REMOVED;
+    }
+    eviction->capacity = capacity;
+    return 0;
+}
+
+/*
+ * Track a newly added entry
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_eviction_add(MemoryEviction* eviction, uint32_t id, const MemoryEntry* entry) {
+    if (!eviction || !entry) return -1;
+
+    if (id >= eviction->capacity) {
+        size_t new_capacity = eviction->capacity ? eviction->capacity * 2 : 16;
+        while (new_capacity <= id) new_capacity *= 2;
+        if (eliza_memory_eviction_reserve(eviction, new_capacity) < 0) return -1;
+    }
+    if (eviction->positions[id] != MEMORY_ID_REMOVED) return -1;
+
+    eviction->keys[id] = value_key(&eviction->budget, entry);
+    eviction->heap[eviction->size] = id;
+    sift_up(eviction, eviction->size++);
+
+    eviction->bytes += eliza_memory_entry_bytes(entry);
+    return 0;
+}
+
+/*
+ * Stop tracking an entry
+ */
+void eliza_memory_eviction_forget(MemoryEviction* eviction, uint32_t id, const MemoryEntry* entry) {
+    if (!eviction || id >= eviction->capacity) return;
+
+    uint32_t pos = eviction->positions[id];
+    if (pos == MEMORY_ID_REMOVED) return;
+
+    eviction->positions[id] = MEMORY_ID_REMOVED;
+    eviction->size--;
+
+    /* Fill the hole with the last id and restore order either way */
+    if (pos < eviction->size) {
+        uint32_t moved = eviction->heap[eviction->size];
+        heap_set(eviction, pos, moved);
+        sift_up(eviction, pos);
+        sift_down(eviction, eviction->positions[moved]);
+    }
+
+    size_t bytes = eliza_memory_entry_bytes(entry);
+    eviction->bytes = eviction->bytes > bytes ? eviction->bytes - bytes : 0;
+}
+
+/*
+ * Reposition an entry whose importance changed
+ */
+void eliza_memory_eviction_update(MemoryEviction* eviction, uint32_t id, const MemoryEntry* entry) {
+    if (!eviction || !entry || id >= eviction->capacity) return;
+
+    uint32_t pos = eviction->positions[id];
+    if (pos == MEMORY_ID_REMOVED) return;
+
+    eviction->keys[id] = value_key(&eviction->budget, entry);
+    sift_up(eviction, pos);
+    sift_down(eviction, eviction->positions[id]);
+}
+
+/*
+ * Entry to evict next
+ */
+uint32_t eliza_memory_eviction_victim(const MemoryEviction* eviction) {
+    if (!eviction || eviction->size == 0) return MEMORY_ID_REMOVED;
+
+    const MemoryBudget* budget = &eviction->budget;
+    int over = (budget->max_entries && eviction->size > budget->max_entries) ||
+               (budget->max_bytes && eviction->bytes > budget->max_bytes);
+
+    return over ? eviction->heap[0] : MEMORY_ID_REMOVED;
+}
+
+/*
+ * Renumber tracked entries
+ * Keys do not change, so the heap keeps its shape and only ids move
+ */
+void eliza_memory_eviction_remap(MemoryEviction* eviction, const uint32_t* map, size_t count) {
+    if (!eviction) return;
+
+    /* New ids never exceed old ones, so keys compact front to back */
+    for (size_t id = 0; id < count && id < eviction->capacity; id++) {
+        if (map[id] != MEMORY_ID_REMOVED) eviction->keys[map[id]] = eviction->keys[id];
+    }
+
+    for (size_t i = 0; i < eviction->capacity; i++) eviction->positions[i] = MEMORY_ID_REMOVED;
+
+    /* Ids beyond the map are dropped and the heap repaired afterwards */
+    size_t kept = 0;
+    int dropped = 0;
+    for (size_t pos = 0; pos < eviction->size; pos++) {
+        uint32_t id = eviction->heap[pos];
+        if (id >= count || map[id] == MEMORY_ID_REMOVED) {
+            dropped = 1;
+            continue;
+        }
+        heap_set(eviction, kept++, map[id]);
+    }
+    eviction->size = kept;
+
+    if (dropped) {
+        for (size_t pos = kept / 2; pos > 0; pos--) sift_down(eviction, pos - 1);
+    }
+    eviction->stats.compactions++;
+}
+
+/*
+ * Forget all entries
+ */
+void eliza_memory_eviction_clear(MemoryEviction* eviction) {
+    if (!eviction) return;
+
+    for (size_t i = 0; i < eviction->capacity; i++) eviction->positions[i] = MEMORY_ID_REMOVED;
+    eviction->size = 0;
+    eviction->bytes = 0;
+}
+
+/*
+ * Evict entries until the store is within budget
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_enforce_budget(MemoryStore* store) {
+    if (!store || !store->eviction) return 0;
+
+    uint32_t victim;
+    while ((victim = eliza_memory_eviction_victim(store->eviction)) != MEMORY_ID_REMOVED) {
+        size_t bytes = eliza_memory_entry_bytes(store->entries[victim]);
+        if (eliza_memory_remove(store, victim) < 0) return -1;
+
+        store->eviction->stats.evictions++;
+        store->eviction->stats.evicted_bytes += bytes;
+    }
+    return 0;
+}
+
+/*
+ * Track every live entry of a store, rebuilding the heap
+ * Returns 0 on success, -1 on failure
+ */
+static int track_entries(MemoryEviction* eviction, const MemoryStore* store) {
+    eliza_memory_eviction_clear(eviction);
+    for (size_t i = 0; i < store->size; i++) {
+        if (store->entries[i] && eliza_memory_eviction_add(eviction, (uint32_t)i, store->entries[i]) < 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Bound a store by a budget
+ * A failure puts the previous budget back, or none if there was none;
+ * entries evicted before it stay evicted
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_set_budget(MemoryStore* store, const MemoryBudget* budget) {
+    if (!store || !budget) return -1;
+
+    if (eliza_memory_compact(store) < 0) return -1;
+
+    MemoryEviction* previous = store->eviction;
+    MemoryEviction* eviction = previous;
+    MemoryBudget old_budget;
+    if (previous) {
+        old_budget = previous->budget;
+    } else {
+        eviction = (MemoryEviction*)calloc(1, sizeof(MemoryEviction));
+        if (!eviction) return -1;
+        if (eliza_memory_eviction_reserve(eviction, store->capacity > 0 ? store->capacity : 16) < 0) {
+            eliza_memory_eviction_destroy(eviction);
+            return -1;
+        }
+    }
+
+    /* A new half-life changes every key, so the heap is rebuilt */
+    eviction->budget = *budget;
+    int result = track_entries(eviction, store);
+    if (result == 0) {
+        store->eviction = eviction;
+        result = eliza_memory_enforce_budget(store);
+    }
+    if (result == 0) return 0;
+
+    /* The heap already holds every id once, so rebuilding it cannot grow it */
+    if (previous) {
+        previous->budget = old_budget;
+        track_entries(previous, store);
+    } else {
+        store->eviction = NULL;
+        eliza_memory_eviction_destroy(eviction);
+    }
+    return -1;
+}
+
+/*
+ * Collect eviction statistics
+ */
+void eliza_memory_eviction_get_stats(const MemoryStore* store, MemoryEvictionStats* stats) {
+    if (!stats) return;
+    memset(stats, 0, sizeof(*stats));
+    if (!store || !store->eviction) return;
+
+    *stats = store->eviction->stats;
+    stats->entries = store->eviction->size;
+    stats->bytes = store->eviction->bytes;
+}
@@ -0,0 +1,454 @@
+#include "../include/memory_fuzzy.h"
+#include "../include/memory_index.h"
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Implementation of Fuzzy Memory Search
+ */
+
+/* Distinct trigrams a query can have */
+#define MAX_QUERY_TRIGRAMS (MEMORY_FUZZY_MAX_QUERY - 2)
+
+static inline unsigned char fold(unsigned char c) {
+    return (c >= 'A' && c <= 'Z') ? (unsigned char)(c | 0x20) : c;
+}
+
+static inline size_t slot_of(uint32_t key, size_t mask) {
+    uint32_t h = key * 2654435761u;
+    h ^= h >> 15;
+    return (size_t)h & mask;
+}
+
+/*
+ * Slot holding a trigram, or the empty slot where it belongs
+ */
+static MemoryTrigramPosting* find_slot(const MemoryTrigrams* trigrams, uint32_t key) {
+    size_t mask = trigrams->slot_count - 1;
+    size_t i = slot_of(key, mask);
+    while (trigrams->slots[i].key != 0 && trigrams->slots[i].key != key) {
+        i = (i + 1) & mask;
+    }
+    return &trigrams->slots[i];
+}
+
+/*
+ * Rehash the non-empty posting lists into slot_count slots, freeing the
+ * empty ones
+ * Returns 0 on success, -1 on failure
+ */
+static int rehash(MemoryTrigrams* trigrams, size_t slot_count) {
+    MemoryTrigramPosting* slots = (MemoryTrigramPosting*)calloc(slot_count, sizeof(MemoryTrigramPosting));
+    if (!slots) return -1;
+
+    MemoryTrigramPosting* old = trigrams->slots;
+    size_t old_count = trigrams->slot_count;
+    trigrams->slots = slots;
+    trigrams->slot_count = slot_count;
+    trigrams->size = 0;
+
+    for (size_t i = 0; i < old_count; i++) {
+        if (old[i].key == 0) continue;
+        if (old[i].size == 0) {
+            free(old[i].ids);
+            continue;
+        }
+        *find_slot(trigrams, old[i].key) = old[i];
+        trigrams->size++;
+    }
+
+    free(old);
+    return 0;
+}
+
+/*
+ * Destroy a trigram index
+ */
+void eliza_memory_trigrams_destroy(MemoryTrigrams* trigrams) {
+    if (!trigrams) return;
+
+    for (size_t i = 0; i < trigrams->slot_count; i++) {
+        free(trigrams->slots[i].ids);
+    }
+    free(trigrams->slots);
+    free(trigrams->counts);
+    free(trigrams->touched);
+    free(trigrams->matches);
+    free(trigrams);
+}
+
+/*
+ * Make room for capacity entry ids
+ * Counts start at zero and are returned to zero after every search
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_trigrams_reserve(MemoryTrigrams* trigrams, size_t capacity) {
+    if (!trigrams) return -1;
+    if (capacity <= trigrams->capacity) return 0;
+
+    uint8_t* counts = (uint8_t*)realloc(trigrams->counts, capacity);
+    if (!counts) return -1;
+    memset(counts + trigrams->capacity, 0, capacity - trigrams->capacity);
+
+    trigrams->counts = counts;
+    trigrams->capacity = capacity;
+    return 0;
+}
+
+/*
+ * Index the trigrams of an entry's content
+ * An id is listed once per trigram however often the trigram occurs
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_trigrams_add(MemoryTrigrams* trigrams, uint32_t id, const char* content) {
+    if (!trigrams || !content) return -1;
+    if (id >= trigrams->capacity) {
+        size_t capacity = trigrams->capacity ? trigrams->capacity * 2 : 16;
+        if (capacity <= id) capacity = (size_t)id + 1;
+        if (eliza_memory_trigrams_reserve(trigrams, capacity) < 0) return -1;
+    }
+
+    const unsigned char* p = (const unsigned char*)content;
+    if (!p[0] || !p[1]) return 0;
+
+    uint32_t key = (uint32_t)fold(p[0]) << 8 | fold(p[1]);
+    for (p += 2; *p; p++) {
+        key = ((key << 8) | fold(*p)) & 0xFFFFFF;
+
+        if ((trigrams->size + 1) * 2 > trigrams->slot_count &&
+            rehash(trigrams, trigrams->slot_count * 2) < 0) {
+            return -1;
+        }
+
+        MemoryTrigramPosting* posting = find_slot(trigrams, key);
+        if (posting->key == 0) {
+            posting->key = key;
+            trigrams->size++;
+        }
+        if (posting->size > 0 && posting->ids[posting->size - 1] == id) continue;
+
+        if (posting->size >= posting->capacity) {
+            uint32_t capacity = posting->capacity ? posting->capacity * 2 : 4;
+            uint32_t* ids = (uint32_t*)realloc(posting->ids, capacity * sizeof(uint32_t));
+            if (!ids) return -1;
+            posting->ids = ids;
+            posting->capacity = capacity;
+        }
+        posting->ids[posting->size++] = id;
+        trigrams->stats.postings++;
+    }
+    return 0;
+}
+
+/*
+ * Drop the postings of ids from size on
+ * Ids are appended in ascending order, so they end each posting; postings
+ * left empty stay until the next remap
+ */
+void eliza_memory_trigrams_truncate(MemoryTrigrams* trigrams, uint32_t size) {
+    if (!trigrams) return;
+
+    for (size_t i = 0; i < trigrams->slot_count; i++) {
+        MemoryTrigramPosting* posting = &trigrams->slots[i];
+        while (posting->size > 0 && posting->ids[posting->size - 1] >= size) {
+            posting->size--;
+            trigrams->stats.postings--;
+        }
+    }
+}
+
+/*
+ * Renumber entries after removals
+ * Returns 0 on success, -1 if the table could not be rebuilt; it is
+ * still correct then, only holding empty lists
+ */
+int eliza_memory_trigrams_remap(MemoryTrigrams* trigrams, const uint32_t* map, size_t count) {
+    if (!trigrams) return -1;
+
+    int emptied = 0;
+    for (size_t i = 0; i < trigrams->slot_count; i++) {
+        MemoryTrigramPosting* posting = &trigrams->slots[i];
+        if (posting->key == 0) continue;
+
+        uint32_t kept = 0;
+        for (uint32_t j = 0; j < posting->size; j++) {
+            uint32_t id = posting->ids[j];
+            if (id < count && map[id] != MEMORY_ID_REMOVED) posting->ids[kept++] = map[id];
+        }
+        trigrams->stats.postings -= posting->size - kept;
+        posting->size = kept;
+        if (kept == 0) emptied = 1;
+    }
+
+    return emptied ? rehash(trigrams, trigrams->slot_count) : 0;
+}
+
+/*
+ * Forget all entries
+ */
+void eliza_memory_trigrams_clear(MemoryTrigrams* trigrams) {
+    if (!trigrams) return;
+
+    for (size_t i = 0; i < trigrams->slot_count; i++) {
+        free(trigrams->slots[i].ids);
+    }
+    memset(trigrams->slots, 0, trigrams->slot_count * sizeof(MemoryTrigramPosting));
+    trigrams->size = 0;
+    trigrams->stats.postings = 0;
+}
+
+/*
+ * Turn on fuzzy search for a store
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_enable_fuzzy(MemoryStore* store) {
+    if (!store) return -1;
+    if (store->trigrams) return 0;
+
+    MemoryTrigrams* trigrams = (MemoryTrigrams*)calloc(1, sizeof(MemoryTrigrams));
+    if (!trigrams) return -1;
+
+    trigrams->slot_count = 1024;
+    trigrams->slots = (MemoryTrigramPosting*)calloc(trigrams->slot_count, sizeof(MemoryTrigramPosting));
+    if (!trigrams->slots ||
+        eliza_memory_trigrams_reserve(trigrams, store->capacity > 0 ? store->capacity : 16) < 0) {
+        eliza_memory_trigrams_destroy(trigrams);
+        return -1;
+    }
+
+    for (size_t i = 0; i < store->size; i++) {
+        if (!store->entries[i]) continue;
+        if (eliza_memory_trigrams_add(trigrams, (uint32_t)i, store->entries[i]->content) < 0) {
+            eliza_memory_trigrams_destroy(trigrams);
+            return -1;
+        }
+    }
+
+    store->trigrams = trigrams;
+    return 0;
+}
+
+/*
+ * Myers' bit-parallel edit distance, in the variant where a match may
+ * start anywhere in the text. Bit i of the vertical deltas describes
+ * query row i; the score tracks the last row, the cost of the best match
+ * ending at the current text position.
+ */
+static int myers_distance(const uint64_t* peq, size_t length, const char* text) {
+    uint64_t pv = ~0ULL;
+    uint64_t mv = 0;
+    uint64_t last = 1ULL << (length - 1);
+    int score = (int)length;
+    int best = score;
+
+    for (const unsigned char* p = (const unsigned char*)text; *p; p++) {
+        uint64_t eq = peq[fold(*p)];
+        uint64_t xv = eq | mv;
+        uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+        uint64_t ph = mv | ~(xh | pv);
+        uint64_t mh = pv & xh;
+
+        if (ph & last) score++;
+        else if (mh & last) score--;
+
+        /* Row 0 stays at zero: a match costs nothing to start anywhere */
+        ph <<= 1;
+        mh <<= 1;
+        pv = mh | ~(xv | ph);
+        mv = ph & xv;
+
+        if (score < best) {
+            best = score;
+            if (best == 0) break;
+        }
+    }
+    return best;
+}
+
+/*
+ * Match masks of the folded query bytes
+ */
+static void build_peq(uint64_t* peq, const unsigned char* pattern, size_t length) {
+    memset(peq, 0, 256 * sizeof(uint64_t));
+    for (size_t i = 0; i < length; i++) {
+        peq[pattern[i]] |= 1ULL << i;
+    }
+}
+
+/*
+ * Edit distance between a query and its closest substring of a text
+ * Returns the distance, or -1 for a query out of range
+ */
+int eliza_memory_fuzzy_distance(const char* query, const char* text) {
+    if (!query || !text) return -1;
+
+    size_t length = strlen(query);
+    if (length == 0 || length > MEMORY_FUZZY_MAX_QUERY) return -1;
+
+    unsigned char pattern[MEMORY_FUZZY_MAX_QUERY];
+    for (size_t i = 0; i < length; i++) pattern[i] = fold((unsigned char)query[i]);
+
+    uint64_t peq[256];
+    build_peq(peq, pattern, length);
+    return myers_distance(peq, length, text);
+}
+
+static int compare_matches(const void* a, const void* b) {
+    const MemoryFuzzyMatch* x = (const MemoryFuzzyMatch*)a;
+    const MemoryFuzzyMatch* y = (const MemoryFuzzyMatch*)b;
+    if (x->distance != y->distance) return x->distance < y->distance ? -1 : 1;
+    return (x->id > y->id) - (x->id < y->id);
+}
+
+/*
+ * Whether a sorted posting list holds an id
+ */
+static int posting_has(const MemoryTrigramPosting* posting, uint32_t id) {
+    size_t lo = 0;
+    size_t hi = posting->size;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (posting->ids[mid] < id) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo < posting->size && posting->ids[lo] == id;
+}
+
+/*
+ * Append a match, growing the match buffer
+ * Returns 0 on success, -1 on failure
+ */
+static int push_match(MemoryTrigrams* trigrams, size_t* count, const MemoryEntry* entry,
+                      uint32_t id, int distance) {
+    if (*count >= trigrams->match_capacity) {
+        size_t capacity = trigrams->match_capacity ? trigrams->match_capacity * 2 : 64;
+        MemoryFuzzyMatch* matches = (MemoryFuzzyMatch*)realloc(trigrams->matches,
+                                    capacity * sizeof(MemoryFuzzyMatch));
+        if (!matches) return -1;
+        trigrams->matches = matches;
+        trigrams->match_capacity = capacity;
+    }
+
+    MemoryFuzzyMatch* match = &trigrams->matches[(*count)++];
+    match->entry = entry;
+    match->id = id;
+    match->distance = (uint32_t)distance;
+    return 0;
+}
+
+/*
+ * Find entries containing a query with at most max_distance edits
+ * Returns the number of matches written
+ */
+size_t eliza_memory_search_fuzzy(MemoryStore* store, const char* query, unsigned int max_distance,
+                                MemoryFuzzyMatch* results, size_t max_results) {
+    if (!store || !store->trigrams || !query || !results || max_results == 0) return 0;
+
+    MemoryTrigrams* trigrams = store->trigrams;
+    size_t length = strlen(query);
+    if (length < 3 || length > MEMORY_FUZZY_MAX_QUERY) return 0;
+
+    unsigned char pattern[MEMORY_FUZZY_MAX_QUERY];
+    for (size_t i = 0; i < length; i++) pattern[i] = fold((unsigned char)query[i]);
+
+    /* Distinct query trigrams; one nobody contains gives an empty list */
+    static const MemoryTrigramPosting none = { 0, 0, 0, NULL };
+    const MemoryTrigramPosting* lists[MAX_QUERY_TRIGRAMS];
+    uint32_t keys[MAX_QUERY_TRIGRAMS];
+    size_t distinct = 0;
+    for (size_t i = 0; i + 2 < length; i++) {
+        uint32_t key = (uint32_t)pattern[i] << 16 | (uint32_t)pattern[i + 1] << 8 | pattern[i + 2];
+        size_t j = 0;
+        while (j < distinct && keys[j] != key) j++;
+        if (j < distinct) continue;
+
+        const MemoryTrigramPosting* posting = find_slot(trigrams, key);
+        keys[distinct] = key;
+        lists[distinct++] = posting->key ? posting : &none;
+    }
+
+    /* Each edit can destroy three trigrams; at least one must survive for
+     * the index to find anything */
+    size_t edits = max_distance;
+    if (3 * edits + 1 > distinct) edits = (distinct - 1) / 3;
+    size_t threshold = distinct - 3 * edits;
+    size_t walked = 3 * edits + 1;
+
+    /* Shortest lists first: a candidate is in one of the first 3k + 1 */
+    for (size_t i = 1; i < distinct; i++) {
+        const MemoryTrigramPosting* posting = lists[i];
+        size_t j = i;
+        while (j > 0 && lists[j - 1]->size > posting->size) {
+            lists[j] = lists[j - 1];
+            j--;
+        }
+        lists[j] = posting;
+    }
+
+    size_t total = 0;
+    for (size_t i = 0; i < walked; i++) total += lists[i]->size;
+    if (total > trigrams->touched_capacity) {
+        uint32_t* touched = (uint32_t*)realloc(trigrams->touched, total * sizeof(uint32_t));
+        if (!touched) return 0;
+        trigrams->touched = touched;
+        trigrams->touched_capacity = total;
+    }
+
+    trigrams->stats.searches++;
+    size_t candidates = 0;
+    for (size_t i = 0; i < walked; i++) {
+        const MemoryTrigramPosting* posting = lists[i];
+        for (uint32_t j = 0; j < posting->size; j++) {
+            uint32_t id = posting->ids[j];
+            if (trigrams->counts[id]++ == 0) trigrams->touched[candidates++] = id;
+        }
+    }
+    trigrams->stats.candidates += candidates;
+
+    uint64_t peq[256];
+    build_peq(peq, pattern, length);
+
+    size_t found = 0;
+    int failed = 0;
+    for (size_t c = 0; c < candidates; c++) {
+        uint32_t id = trigrams->touched[c];
+        size_t shared = trigrams->counts[id];
+        trigrams->counts[id] = 0;
+        if (failed) continue;
+
+        /* Probe the remaining lists while the threshold is still reachable */
+        for (size_t i = walked; i < distinct && shared < threshold &&
+                                shared + (distinct - i) >= threshold; i++) {
+            if (posting_has(lists[i], id)) shared++;
+        }
+        if (shared < threshold) continue;
+
+        const MemoryEntry* entry = id < store->size ? store->entries[id] : NULL;
+        if (!entry) continue;
+
+        trigrams->stats.verified++;
+        int distance = myers_distance(peq, length, entry->content);
+        if (distance > (int)edits) continue;
+
+        if (push_match(trigrams, &found, entry, id, distance) < 0) failed = 1;
+    }
+
+    trigrams->stats.matches += found;
+    if (found > 1) qsort(trigrams->matches, found, sizeof(MemoryFuzzyMatch), compare_matches);
+
+    size_t written = found < max_results ? found : max_results;
+    if (written > 0) memcpy(results, trigrams->matches, written * sizeof(MemoryFuzzyMatch));
+    return written;
+}
+
+/*
+ * Collect fuzzy search statistics
+ */
+void eliza_memory_fuzzy_get_stats(const MemoryStore* store, MemoryFuzzyStats* stats) {
+    if (!stats) return;
+    memset(stats, 0, sizeof(*stats));
+    if (!store || !store->trigrams) return;
+
+    *stats = store->trigrams->stats;
+    stats->trigrams = store->trigrams->size;
+}
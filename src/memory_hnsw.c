@@ -0,0 +1,840 @@
+#include "../include/memory_hnsw.h"
+#include "../include/memory_segment.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+#include <unistd.h>
+
+/*
+ * Implementation of the Memory HNSW Index
+ */
+
+/* Buffer size used when writing index files */
+#define WRITE_BUFFER_SIZE (1 << 20)
+
+/*
+ * Fill options with defaults
+ */
+void eliza_memory_hnsw_options_default(MemoryHnswOptions* options) {
+    if (!options) return;
+
+    options->m = 16;
+    options->ef_construction = 200;
+    options->ef_search = 64;
+    options->seed = 0x9E3779B97F4A7C15ull;
+}
+
+/*
+ * Push a candidate onto a max-heap
+ * Returns 0 on success, -1 on failure
+ */
+static int heap_push(MemoryHnswHeap* heap, float score, uint32_t id) {
+    if (heap->size >= heap->capacity) {
+        size_t new_capacity = heap->capacity ? heap->capacity * 2 : 64;
+        MemoryHnswCandidate* new_items = (MemoryHnswCandidate*)realloc(heap->items,
+                                         new_capacity * sizeof(MemoryHnswCandidate));
+        if (!new_items) return -1;
+        heap->items = new_items;
+        heap->capacity = new_capacity;
+    }
+
+    size_t i = heap->size++;
+    while (i > 0) {
+        size_t parent = (i - 1) / 2;
+        if (heap->items[parent].score >= score) break;
+        heap->items[i] = heap->items[parent];
+        i = parent;
+    }
+    heap->items[i].score = score;
+    heap->items[i].id = id;
+    return 0;
+}
+
+/*
+ * Pop the best candidate off a max-heap
+ */
+static MemoryHnswCandidate heap_pop(MemoryHnswHeap* heap) {
+    MemoryHnswCandidate top = heap->items[0];
+    MemoryHnswCandidate last = heap->items[--heap->size];
+
+    size_t i = 0;
+    for (;;) {
+        size_t child = 2 * i + 1;
+        if (child >= heap->size) break;
+        if (child + 1 < heap->size && heap->items[child + 1].score > heap->items[child].score) {
+            child++;
+        }
+        if (last.score >= heap->items[child].score) break;
+        heap->items[i] = heap->items[child];
+        i = child;
+    }
+    if (heap->size > 0) heap->items[i] = last;
+    return top;
+}
+
+/*
+ * Draw the top layer of a new node
+ */
+static int random_level(MemoryHnsw* hnsw) {
+    /* xorshift64* */
+    hnsw->rng ^= hnsw->rng >> 12;
+    hnsw->rng ^= hnsw->rng << 25;
+    hnsw->rng ^= hnsw->rng >> 27;
+    uint64_t bits = hnsw->rng * 2685821657736338717ull;
+
+    double uniform = ((double)(bits >> 11) + 1.0) / 9007199254740992.0;
+    int level = (int)(-log(uniform) * hnsw->level_mult);
+    return level < MEMORY_HNSW_MAX_LEVEL ? level : MEMORY_HNSW_MAX_LEVEL;
+}
+
+/*
+ * Vector of a node
+ */
+static const float* node_vector(const MemoryHnsw* hnsw, uint32_t id) {
+    return hnsw->vectors + (size_t)id * hnsw->dim;
+}
+
+/*
+ * Link list of a node on a layer: a count followed by the ids
+ */
+static uint32_t* node_links(const MemoryHnsw* hnsw, uint32_t id, int level) {
+    if (level == 0) return hnsw->links0 + (size_t)id * (hnsw->m0 + 1);
+    return hnsw->links[id] + (size_t)(level - 1) * (hnsw->m + 1);
+}
+
+/*
+ * Create an empty index
+ */
+MemoryHnsw* eliza_memory_hnsw_create(size_t dim, const MemoryHnswOptions* options) {
+    if (dim == 0 || dim > MEMORY_VECTOR_MAX_DIM) return NULL;
+
+    MemoryHnswOptions defaults;
+    if (!options) {
+        eliza_memory_hnsw_options_default(&defaults);
+        options = &defaults;
+    }
+    if (options->m < 2 || options->m > MEMORY_HNSW_MAX_M) return NULL;
+
+    MemoryHnsw* hnsw = (MemoryHnsw*)calloc(1, sizeof(MemoryHnsw));
+    if (!hnsw) return NULL;
+
+    hnsw->dim = dim;
+    hnsw->m = options->m;
+    hnsw->m0 = options->m * 2;
+    hnsw->ef_construction = options->ef_construction > options->m ? options->ef_construction : options->m;
+    hnsw->ef_search = options->ef_search ? options->ef_search : 1;
+    hnsw->max_level = -1;
+    hnsw->level_mult = 1.0 / log((double)options->m);
+    hnsw->rng = options->seed ? options->seed : 1;
+    hnsw->dot = eliza_memory_vector_dot_kernel();
+
+    hnsw->query = (float*)malloc(dim * sizeof(float));
+    if (!hnsw->query) {
+        free(hnsw);
+        return NULL;
+    }
+
+    return hnsw;
+}
+
+/*
+ * Free the upper layer links of every node
+ */
+static void free_links(MemoryHnsw* hnsw) {
+    for (size_t i = 0; i < hnsw->size; i++) {
+        free(hnsw->links[i]);
+        hnsw->links[i] = NULL;
+    }
+}
+
+/*
+ * Destroy an index
+ */
+void eliza_memory_hnsw_destroy(MemoryHnsw* hnsw) {
+    if (!hnsw) return;
+
+    if (hnsw->links) free_links(hnsw);
+    free(hnsw->vectors);
+    free(hnsw->levels);
+    free(hnsw->links0);
+    free(hnsw->links);
+    free(hnsw->visited);
+    free(hnsw->candidates.items);
+    free(hnsw->results.items);
+    free(hnsw->found);
+    free(hnsw->query);
+    free(hnsw);
+}
+
+/*
+ * Make room for capacity nodes
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_hnsw_reserve(MemoryHnsw* hnsw, size_t capacity) {
+    if (!hnsw) return -1;
+    if (capacity <= hnsw->capacity) return 0;
+
+    float* new_vectors = (float*)realloc(hnsw->vectors, capacity * hnsw->dim * sizeof(float));
+    if (!new_vectors) return -1;
+    hnsw->vectors = new_vectors;
+
+    uint8_t* new_levels = (uint8_t*)realloc(hnsw->levels, capacity);
+    if (!new_levels) return -1;
+    hnsw->levels = new_levels;
+
+    uint32_t* new_links0 = (uint32_t*)realloc(hnsw->links0,
+                           capacity * (hnsw->m0 + 1) * sizeof(uint32_t));
+    if (!new_links0) return -1;
+    hnsw->links0 = new_links0;
+
+    uint32_t** new_links = (uint32_t**)realloc(hnsw->links, capacity * sizeof(uint32_t*));
+    if (!new_links) return -1;
+    hnsw->links = new_links;
+
+    /* Fresh tags must never equal the current one */
+    uint32_t* new_visited = (uint32_t*)realloc(hnsw->visited, capacity * sizeof(uint32_t));
+    if (!new_visited) return -1;
+    memset(new_visited + hnsw->capacity, 0, (capacity - hnsw->capacity) * sizeof(uint32_t));
+    hnsw->visited = new_visited;
+
+    hnsw->capacity = capacity;
+    return 0;
+}
+
+/*
+ * Remove all nodes
+ */
+void eliza_memory_hnsw_clear(MemoryHnsw* hnsw) {
+    if (!hnsw) return;
+
+    free_links(hnsw);
+    hnsw->size = 0;
+    hnsw->max_level = -1;
+    hnsw->entry_point = 0;
+}
+
+/*
+ * Start a new round of visit tags
+ */
+static void next_visit(MemoryHnsw* hnsw) {
+    if (++hnsw->visit_tag == 0) {
+        memset(hnsw->visited, 0, hnsw->capacity * sizeof(uint32_t));
+        hnsw->visit_tag = 1;
+    }
+}
+
+/*
+ * Make room for count results of a layer search
+ * Returns 0 on success, -1 on failure
+ */
+static int reserve_found(MemoryHnsw* hnsw, size_t count) {
+    if (count <= hnsw->found_capacity) return 0;
+
+    MemoryHnswCandidate* new_found = (MemoryHnswCandidate*)realloc(hnsw->found,
+                                     count * sizeof(MemoryHnswCandidate));
+    if (!new_found) return -1;
+    hnsw->found = new_found;
+    hnsw->found_capacity = count;
+    return 0;
+}
+
+/*
+ * Walk greedily towards the query on the layers above target
+ */
+static uint32_t greedy_descent(const MemoryHnsw* hnsw, const float* query, int target) {
+    uint32_t current = hnsw->entry_point;
+    float best = hnsw->dot(query, node_vector(hnsw, current), hnsw->dim);
+
+    for (int level = hnsw->max_level; level > target; level--) {
+        int moved = 1;
+        while (moved) {
+            moved = 0;
+            const uint32_t* links = node_links(hnsw, current, level);
+            for (uint32_t i = 0; i < links[0]; i++) {
+                float score = hnsw->dot(query, node_vector(hnsw, links[i + 1]), hnsw->dim);
+                if (score > best) {
+                    best = score;
+                    current = links[i + 1];
+                    moved = 1;
+                }
+            }
+        }
+    }
+
+    return current;
+}
+
+/*
+ * Explore one layer from the given entry points, keeping the ef best
+ * nodes in hnsw->found, best first
+ * Returns the number found, or -1 on failure
+ */
+static long search_layer(MemoryHnsw* hnsw, const float* query, const uint32_t* entries,
+                         size_t num_entries, size_t ef, int level) {
+    MemoryHnswHeap* candidates = &hnsw->candidates;
+    MemoryHnswHeap* results = &hnsw->results;
+    candidates->size = 0;
+    results->size = 0;
+    next_visit(hnsw);
+
+    /* Results are a max-heap of negated scores, so the root is the worst */
+    for (size_t i = 0; i < num_entries; i++) {
+        uint32_t id = entries[i];
+        if (hnsw->visited[id] == hnsw->visit_tag) continue;
+        hnsw->visited[id] = hnsw->visit_tag;
+
+        float score = hnsw->dot(query, node_vector(hnsw, id), hnsw->dim);
+        if (heap_push(candidates, score, id) < 0 || heap_push(results, -score, id) < 0) return -1;
+        if (results->size > ef) heap_pop(results);
+    }
+
+    while (candidates->size > 0) {
+        MemoryHnswCandidate current = heap_pop(candidates);
+        float worst = -results->items[0].score;
+        if (current.score < worst && results->size >= ef) break;
+
+        const uint32_t* links = node_links(hnsw, current.id, level);
+        for (uint32_t i = 0; i < links[0]; i++) {
+            uint32_t id = links[i + 1];
+            if (hnsw->visited[id] == hnsw->visit_tag) continue;
+            hnsw->visited[id] = hnsw->visit_tag;
+
+            float score = hnsw->dot(query, node_vector(hnsw, id), hnsw->dim);
+            if (results->size < ef || score > worst) {
+                if (heap_push(candidates, score, id) < 0 || heap_push(results, -score, id) < 0) {
+                    return -1;
+                }
+                if (results->size > ef) heap_pop(results);
+                worst = -results->items[0].score;
+            }
+        }
+    }
+
+    /* Drain worst first into the back of found */
+    size_t count = results->size;
+    if (reserve_found(hnsw, count) < 0) return -1;
+    for (size_t i = count; i > 0; i--) {
+        MemoryHnswCandidate worst = heap_pop(results);
+        hnsw->found[i - 1].score = -worst.score;
+        hnsw->found[i - 1].id = worst.id;
+    }
+
+    return (long)count;
+}
+
+/*
+ * Pick up to max neighbors from candidates sorted best first
+ * A candidate is skipped when it is closer to an already selected
+ * neighbor than to the base node, which keeps links spread out
+ */
+static size_t select_neighbors(const MemoryHnsw* hnsw, const MemoryHnswCandidate* candidates,
+                               size_t count, size_t max, MemoryHnswCandidate* out) {
+    size_t selected = 0;
+
+    for (size_t i = 0; i < count && selected < max; i++) {
+        const float* vector = node_vector(hnsw, candidates[i].id);
+        int keep = 1;
+
+        for (size_t j = 0; j < selected; j++) {
+            if (hnsw->dot(vector, node_vector(hnsw, out[j].id), hnsw->dim) > candidates[i].score) {
+                keep = 0;
+                break;
+            }
+        }
+        if (keep) out[selected++] = candidates[i];
+    }
+
+    return selected;
+}
+
+/*
+ * Order candidates best first
+ */
+static int compare_candidates(const void* a, const void* b) {
+    float sa = ((const MemoryHnswCandidate*)a)->score;
+    float sb = ((const MemoryHnswCandidate*)b)->score;
+    return (sa < sb) - (sa > sb);
+}
+
+/*
+ * Add a link from node to neighbor, pruning the node's links when full
+ */
+static void add_link(MemoryHnsw* hnsw, uint32_t node, uint32_t neighbor, int level) {
+    uint32_t* links = node_links(hnsw, node, level);
+    size_t max = level == 0 ? hnsw->m0 : hnsw->m;
+
+    if (links[0] < max) {
+        links[++links[0]] = neighbor;
+        return;
+    }
+
+    MemoryHnswCandidate candidates[2 * MEMORY_HNSW_MAX_M + 1];
+    MemoryHnswCandidate selected[2 * MEMORY_HNSW_MAX_M];
+    const float* base = node_vector(hnsw, node);
+
+    for (uint32_t i = 0; i < links[0]; i++) {
+        candidates[i].id = links[i + 1];
+        candidates[i].score = hnsw->dot(base, node_vector(hnsw, links[i + 1]), hnsw->dim);
+    }
+    candidates[max].id = neighbor;
+    candidates[max].score = hnsw->dot(base, node_vector(hnsw, neighbor), hnsw->dim);
+
+    qsort(candidates, max + 1, sizeof(MemoryHnswCandidate), compare_candidates);
+    size_t count = select_neighbors(hnsw, candidates, max + 1, max, selected);
+
+    links[0] = (uint32_t)count;
+    for (size_t i = 0; i < count; i++) links[i + 1] = selected[i].id;
+}
+
+/*
+ * Insert the next node
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_hnsw_add(MemoryHnsw* hnsw, const float* vector) {
+    if (!hnsw) return -1;
+    if (hnsw->size >= UINT32_MAX) return -1;
+
+    if (hnsw->size >= hnsw->capacity) {
+        size_t new_capacity = hnsw->capacity ? hnsw->capacity * 2 : 16;
+        if (eliza_memory_hnsw_reserve(hnsw, new_capacity) < 0) return -1;
+    }
+
+    uint32_t id = (uint32_t)hnsw->size;
+    int level = random_level(hnsw);
+
+    float* row = hnsw->vectors + (size_t)id * hnsw->dim;
+    if (vector) {
+        memcpy(row, vector, hnsw->dim * sizeof(float));
+        eliza_memory_vector_normalize(row, hnsw->dim);
+    } else {
+        memset(row, 0, hnsw->dim * sizeof(float));
+    }
+
+    hnsw->links[id] = NULL;
+    if (level > 0) {
+        hnsw->links[id] = (uint32_t*)malloc((size_t)level * (hnsw->m + 1) * sizeof(uint32_t));
+        if (!hnsw->links[id]) return -1;
+        for (int l = 1; l <= level; l++) node_links(hnsw, id, l)[0] = 0;
+    }
+    node_links(hnsw, id, 0)[0] = 0;
+    hnsw->levels[id] = (uint8_t)level;
+    hnsw->size++;
+
+    if (hnsw->max_level < 0) {
+        hnsw->entry_point = id;
+        hnsw->max_level = level;
+        return 0;
+    }
+
+    /* Selected neighbors of the previous layer seed the next one */
+    MemoryHnswCandidate selected[2 * MEMORY_HNSW_MAX_M];
+    uint32_t* entries = (uint32_t*)malloc(hnsw->ef_construction * sizeof(uint32_t));
+    if (!entries) return -1;
+
+    entries[0] = greedy_descent(hnsw, row, level);
+    size_t num_entries = 1;
+
+    for (int l = level < hnsw->max_level ? level : hnsw->max_level; l >= 0; l--) {
+        long found = search_layer(hnsw, row, entries, num_entries, hnsw->ef_construction, l);
+        if (found < 0) {
+            free(entries);
+            return -1;
+        }
+
+        /* New nodes start with M links on every layer, leaving room on
+         * the bottom layer for links added by later nodes */
+        size_t count = select_neighbors(hnsw, hnsw->found, (size_t)found, hnsw->m, selected);
+
+        uint32_t* links = node_links(hnsw, id, l);
+        links[0] = (uint32_t)count;
+        for (size_t i = 0; i < count; i++) {
+            links[i + 1] = selected[i].id;
+            add_link(hnsw, selected[i].id, id, l);
+        }
+
+        num_entries = (size_t)found;
+        for (size_t i = 0; i < num_entries; i++) entries[i] = hnsw->found[i].id;
+    }
+
+    free(entries);
+
+    if (level > hnsw->max_level) {
+        hnsw->entry_point = id;
+        hnsw->max_level = level;
+    }
+    return 0;
+}
+
+/*
+ * Reconnect a node that lost most of its bottom layer links
+ * Returns 0 on success, -1 on failure
+ */
+static int repair_node(MemoryHnsw* hnsw, uint32_t id) {
+    const float* vector = node_vector(hnsw, id);
+    uint32_t entry = greedy_descent(hnsw, vector, 0);
+
+    long found = search_layer(hnsw, vector, &entry, 1, hnsw->ef_construction, 0);
+    if (found < 0) return -1;
+
+    uint32_t* links = node_links(hnsw, id, 0);
+    for (long i = 0; i < found && links[0] < hnsw->m; i++) {
+        uint32_t neighbor = hnsw->found[i].id;
+        if (neighbor == id) continue;
+
+        int linked = 0;
+        for (uint32_t j = 0; j < links[0]; j++) {
+            if (links[j + 1] == neighbor) linked = 1;
+        }
+        if (linked) continue;
+
+        links[++links[0]] = neighbor;
+        add_link(hnsw, neighbor, id, 0);
+    }
+    return 0;
+}
+
+/*
+ * Drop the nodes of removed entries, keeping the others in order
+ * Returns 0 on success, -1 if reconnecting weakened nodes failed
+ */
+int eliza_memory_hnsw_remap(MemoryHnsw* hnsw, const uint32_t* map, size_t count) {
+    if (!hnsw) return -1;
+
+    size_t old_size = hnsw->size;
+    size_t n = count < old_size ? count : old_size;
+    uint32_t old_entry = hnsw->entry_point;
+
+    /* Rewrite the links of survivors while ids are still the old ones */
+    for (size_t i = 0; i < n; i++) {
+        if (map[i] == MEMORY_ID_REMOVED) continue;
+
+        for (int l = 0; l <= hnsw->levels[i]; l++) {
+            uint32_t* links = node_links(hnsw, (uint32_t)i, l);
+            uint32_t kept = 0;
+            for (uint32_t j = 0; j < links[0]; j++) {
+                uint32_t neighbor = links[j + 1];
+                if (neighbor >= n || map[neighbor] == MEMORY_ID_REMOVED) continue;
+                links[++kept] = map[neighbor];
+            }
+            links[0] = kept;
+        }
+    }
+
+    /* Move survivors down */
+    size_t kept = 0;
+    int max_level = -1;
+    uint32_t entry_point = 0;
+
+    for (size_t i = 0; i < old_size; i++) {
+        if (i >= n || map[i] == MEMORY_ID_REMOVED) {
+            free(hnsw->links[i]);
+            continue;
+        }
+
+        if (kept != i) {
+            memcpy(hnsw->vectors + kept * hnsw->dim, hnsw->vectors + i * hnsw->dim,
+                   hnsw->dim * sizeof(float));
+            memcpy(hnsw->links0 + kept * (hnsw->m0 + 1), hnsw->links0 + i * (hnsw->m0 + 1),
+                   (hnsw->m0 + 1) * sizeof(uint32_t));
+            hnsw->levels[kept] = hnsw->levels[i];
+            hnsw->links[kept] = hnsw->links[i];
+        }
+        if ((int)hnsw->levels[kept] > max_level) {
+            max_level = hnsw->levels[kept];
+            entry_point = (uint32_t)kept;
+        }
+        kept++;
+    }
+
+    hnsw->size = kept;
+    hnsw->max_level = max_level;
+    hnsw->entry_point = entry_point;
+    if (old_entry < n && map[old_entry] != MEMORY_ID_REMOVED) {
+        hnsw->entry_point = map[old_entry];
+    }
+
+    /* Nodes that lost most of their neighbors may have become unreachable */
+    int result = 0;
+    for (size_t i = 0; i < kept; i++) {
+        if (node_links(hnsw, (uint32_t)i, 0)[0] < hnsw->m / 2 &&
+            repair_node(hnsw, (uint32_t)i) < 0) {
+            result = -1;
+        }
+    }
+    return result;
+}
+
+/*
+ * Change the number of candidates explored per search
+ */
+void eliza_memory_hnsw_set_ef(MemoryHnsw* hnsw, size_t ef_search) {
+    if (!hnsw) return;
+    hnsw->ef_search = ef_search ? ef_search : 1;
+}
+
+/*
+ * Find the k nodes nearest to a query
+ */
+size_t eliza_memory_hnsw_search(MemoryHnsw* hnsw, const float* query, size_t k,
+                               uint32_t* ids, float* scores) {
+    if (!hnsw || !query || !ids || k == 0 || hnsw->max_level < 0) return 0;
+
+    memcpy(hnsw->query, query, hnsw->dim * sizeof(float));
+    eliza_memory_vector_normalize(hnsw->query, hnsw->dim);
+
+    uint32_t entry = greedy_descent(hnsw, hnsw->query, 0);
+    size_t ef = hnsw->ef_search > k ? hnsw->ef_search : k;
+
+    long found = search_layer(hnsw, hnsw->query, &entry, 1, ef, 0);
+    if (found <= 0) return 0;
+
+    size_t count = (size_t)found < k ? (size_t)found : k;
+    for (size_t i = 0; i < count; i++) {
+        ids[i] = hnsw->found[i].id;
+        if (scores) scores[i] = hnsw->found[i].score;
+    }
+    return count;
+}
+
+/*
+ * Find the entries most similar to a query through the store's index
+ */
+size_t eliza_memory_search_hnsw(MemoryStore* store, const float* query,
+                               MemoryRankedResult* results, size_t k) {
+    if (!store || !store->hnsw || !query || !results || k == 0) return 0;
+
+    MemoryHnsw* hnsw = store->hnsw;
+    size_t ef = hnsw->ef_search > k ? hnsw->ef_search : k;
+    uint32_t* ids = (uint32_t*)malloc(ef * sizeof(uint32_t));
+    float* scores = (float*)malloc(ef * sizeof(float));
+    if (!ids || !scores) {
+        free(ids);
+        free(scores);
+        return 0;
+    }
+
+    /* Removed entries stay in the graph as waypoints until compaction,
+     * so all ef candidates are fetched and the first k live ones kept.
+     * Nodes may also run ahead of entries while an add fails part way. */
+    size_t found = eliza_memory_hnsw_search(hnsw, query, ef, ids, scores);
+    size_t written = 0;
+    for (size_t i = 0; i < found && written < k; i++) {
+        if (ids[i] >= store->size || !store->entries[ids[i]]) continue;
+        results[written].entry = store->entries[ids[i]];
+        results[written].score = scores[i];
+        written++;
+    }
+
+    free(ids);
+    free(scores);
+    return written;
+}
+
+/*
+ * Build an index of the store's current entries
+ * Returns 0 on success, -1 on failure
+ */
+static int index_entries(MemoryStore* store, MemoryHnsw* hnsw) {
+    if (eliza_memory_hnsw_reserve(hnsw, store->capacity > 0 ? store->capacity : 16) < 0) return -1;
+
+    MemoryVectors* vectors = store->vectors;
+    if (vectors && vectors->dim != hnsw->dim) vectors = NULL;
+
+    float* row = (float*)malloc(hnsw->dim * sizeof(float));
+    if (!row) return -1;
+
+    for (size_t i = 0; i < store->size; i++) {
+        int have = vectors && eliza_memory_vectors_get(vectors, i, row) == 0;
+        if (eliza_memory_hnsw_add(hnsw, have ? row : NULL) < 0) {
+            free(row);
+            return -1;
+        }
+    }
+
+    free(row);
+    return 0;
+}
+
+/*
+ * Build the HNSW index of a store
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_enable_hnsw(MemoryStore* store, size_t dim, const MemoryHnswOptions* options) {
+    if (!store || store->hnsw) return -1;
+    if (eliza_memory_compact(store) < 0) return -1;
+
+    MemoryHnsw* hnsw = eliza_memory_hnsw_create(dim, options);
+    if (!hnsw) return -1;
+
+    if (index_entries(store, hnsw) < 0) {
+        eliza_memory_hnsw_destroy(hnsw);
+        return -1;
+    }
+
+    store->hnsw = hnsw;
+    return 0;
+}
+
+/*
+ * Rebuild the index of a store from its embedding column
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_hnsw_rebuild(MemoryStore* store) {
+    if (!store || !store->hnsw) return -1;
+    if (eliza_memory_compact(store) < 0) return -1;
+
+    eliza_memory_hnsw_clear(store->hnsw);
+    return index_entries(store, store->hnsw);
+}
+
+/*
+ * Write an index to a file
+ * The file is written under a temporary name and renamed into place
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_hnsw_save(const MemoryHnsw* hnsw, const char* filepath) {
+    if (!hnsw || !filepath) return -1;
+
+    size_t path_len = strlen(filepath);
+    char* tmp_path = (char*)malloc(path_len + 5);
+    if (!tmp_path) return -1;
+    memcpy(tmp_path, filepath, path_len);
+    memcpy(tmp_path + path_len, ".tmp", 5);
+
+    FILE* file = fopen(tmp_path, "wb");
+    if (!file) {
+        free(tmp_path);
+        return -1;
+    }
+    setvbuf(file, NULL, _IOFBF, WRITE_BUFFER_SIZE);
+
+    MemoryHnswHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MEMORY_HNSW_MAGIC, sizeof(MEMORY_HNSW_MAGIC));
+    header.version = MEMORY_HNSW_VERSION;
+    header.byte_order = MEMORY_SEGMENT_BYTE_ORDER;
+    header.count = hnsw->size;
+    header.dim = (uint32_t)hnsw->dim;
+    header.m = (uint32_t)hnsw->m;
+    header.ef_construction = (uint32_t)hnsw->ef_construction;
+    header.ef_search = (uint32_t)hnsw->ef_search;
+    header.entry_point = hnsw->entry_point;
+    header.max_level = hnsw->max_level;
+    header.rng = hnsw->rng;
+
+    size_t count = hnsw->size;
+    int ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+             fwrite(hnsw->vectors, hnsw->dim * sizeof(float), count, file) == count &&
+             fwrite(hnsw->levels, 1, count, file) == count &&
+             fwrite(hnsw->links0, (hnsw->m0 + 1) * sizeof(uint32_t), count, file) == count;
+
+    for (size_t i = 0; ok && i < count; i++) {
+        size_t level = hnsw->levels[i];
+        if (level == 0) continue;
+        ok = fwrite(hnsw->links[i], (hnsw->m + 1) * sizeof(uint32_t), level, file) == level;
+    }
+
+    ok = ok && fflush(file) == 0 && fsync(fileno(file)) == 0;
+
+    if (fclose(file) != 0) ok = 0;
+    if (ok && rename(tmp_path, filepath) != 0) ok = 0;
+    if (!ok) remove(tmp_path);
+
+    free(tmp_path);
+    return ok ? 0 : -1;
+}
+
+/*
+ * Read an index written by eliza_memory_hnsw_save
+ */
+static MemoryHnsw* read_index(FILE* file, const MemoryHnswHeader* header) {
+    MemoryHnswOptions options;
+    eliza_memory_hnsw_options_default(&options);
+    options.m = header->m;
+    options.ef_construction = header->ef_construction;
+    options.ef_search = header->ef_search;
+
+    MemoryHnsw* hnsw = eliza_memory_hnsw_create(header->dim, &options);
+    if (!hnsw) return NULL;
+
+    size_t count = (size_t)header->count;
+    if (eliza_memory_hnsw_reserve(hnsw, count > 0 ? count : 16) < 0) {
+        eliza_memory_hnsw_destroy(hnsw);
+        return NULL;
+    }
+
+    int ok = fread(hnsw->vectors, hnsw->dim * sizeof(float), count, file) == count &&
+             fread(hnsw->levels, 1, count, file) == count &&
+             fread(hnsw->links0, (hnsw->m0 + 1) * sizeof(uint32_t), count, file) == count;
+
+    /* Nodes count as added once their links are in, so destroy frees them */
+    for (size_t i = 0; ok && i < count; i++) {
+        size_t level = hnsw->levels[i];
+        hnsw->links[i] = NULL;
+        hnsw->size = i + 1;
+        if (level == 0) continue;
+
+        ok = level <= MEMORY_HNSW_MAX_LEVEL &&
+             (hnsw->links[i] = (uint32_t*)malloc(level * (hnsw->m + 1) * sizeof(uint32_t))) != NULL &&
+             fread(hnsw->links[i], (hnsw->m + 1) * sizeof(uint32_t), level, file) == level;
+    }
+
+    /* Reject links that point outside the graph */
+    for (size_t i = 0; ok && i < count; i++) {
+        for (int l = 0; ok && l <= hnsw->levels[i]; l++) {
+            const uint32_t* links = node_links(hnsw, (uint32_t)i, l);
+            ok = links[0] <= (l == 0 ? hnsw->m0 : hnsw->m);
+            for (uint32_t j = 0; ok && j < links[0]; j++) ok = links[j + 1] < count;
+        }
+    }
+
+    if (!ok || header->max_level > MEMORY_HNSW_MAX_LEVEL ||
+        (count > 0 && (header->entry_point >= count ||
+                       header->max_level != hnsw->levels[header->entry_point]))) {
+        eliza_memory_hnsw_destroy(hnsw);
+        return NULL;
+    }
+
+    hnsw->size = count;
+    hnsw->entry_point = header->entry_point;
+    hnsw->max_level = count > 0 ? header->max_level : -1;
+    hnsw->rng = header->rng ? header->rng : 1;
+    return hnsw;
+}
+
+/*
+ * Replace the index of a store with one read from a file
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_hnsw_load(MemoryStore* store, const char* filepath) {
+    if (!store || !store->hnsw || !filepath) return -1;
+
+    FILE* file = fopen(filepath, "rb");
+    if (!file) return -1;
+
+    MemoryHnswHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1 ||
+        memcmp(header.magic, MEMORY_HNSW_MAGIC, sizeof(MEMORY_HNSW_MAGIC)) != 0 ||
+        header.version != MEMORY_HNSW_VERSION ||
+        header.byte_order != MEMORY_SEGMENT_BYTE_ORDER ||
+        header.count != store->size ||
+        header.dim != store->hnsw->dim) {
+        fclose(file);
+        return -1;
+    }
+
+    MemoryHnsw* hnsw = read_index(file, &header);
+    fclose(file);
+    if (!hnsw) return -1;
+
+    /* Keep room for the entries the store already has space for */
+    if (eliza_memory_hnsw_reserve(hnsw, store->capacity) < 0) {
+        eliza_memory_hnsw_destroy(hnsw);
+        return -1;
+    }
+
+    eliza_memory_hnsw_destroy(store->hnsw);
+    store->hnsw = hnsw;
+    return 0;
+}
@@ -0,0 +1,747 @@
+#include "../include/memory_index.h"
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Implementation of the Memory Inverted Index
+ */
+
+/* Initial number of hash table slots (must be a power of two) */
+#define INITIAL_BUCKETS 1024
+
+/* Initial capacity of a posting list */
+#define INITIAL_POSTING_CAPACITY 4
+
+/* Recent terms remembered by a batch add (must be a power of two) */
+#define INDEX_BATCH_RECENT 4096
+
+/*
+ * FNV-1a hash of a normalized term
+ */
+static uint32_t hash_term(const char* term, size_t len) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (unsigned char)term[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/*
+ * Token characters are ASCII letters and digits plus any non-ASCII
+ * byte, so UTF-8 words are kept whole
+ */
+static int is_token_char(unsigned char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+           (c >= '0' && c <= '9') || c >= 0x80;
+}
+
+/*
+ * Read the next normalized token from a string
+ */
+size_t eliza_memory_next_token(const char** text, char* out) {
+    const unsigned char* p = (const unsigned char*)*text;
+
+    /* Skip separators */
+    while (*p && !is_token_char(*p)) p++;
+
+    size_t len = 0;
+    while (*p && is_token_char(*p)) {
+        if (len < MEMORY_INDEX_MAX_TOKEN) {
+            unsigned char c = *p;
+            out[len++] = (c >= 'A' && c <= 'Z') ? (char)(c + ('a' - 'A')) : (char)c;
+        }
+        p++;
+    }
+
+    out[len] = '\0';
+    *text = (const char*)p;
+    return len;
+}
+
+/*
+ * Create an empty inverted index
+ */
+MemoryIndex* eliza_memory_index_create(void) {
+    MemoryIndex* index = (MemoryIndex*)malloc(sizeof(MemoryIndex));
+    if (!index) return NULL;
+
+    index->buckets = (MemoryPosting*)calloc(INITIAL_BUCKETS, sizeof(MemoryPosting));
+    if (!index->buckets) {
+        free(index);
+        return NULL;
+    }
+
+    index->capacity = INITIAL_BUCKETS;
+    index->size = 0;
+    index->lengths = NULL;
+    index->documents = 0;
+    index->lengths_capacity = 0;
+    index->total_length = 0;
+
+    return index;
+}
+
+/*
+ * Remove all terms from the index, keeping the table allocated
+ */
+void eliza_memory_index_clear(MemoryIndex* index) {
+    if (!index) return;
+
+    for (size_t i = 0; i < index->capacity; i++) {
+        free(index->buckets[i].term);
+        free(index->buckets[i].ids);
+        free(index->buckets[i].freqs);
+    }
+    memset(index->buckets, 0, index->capacity * sizeof(MemoryPosting));
+    index->size = 0;
+    index->documents = 0;
+    index->total_length = 0;
+}
+
+/*
+ * Destroy an index and all posting lists
+ */
+void eliza_memory_index_destroy(MemoryIndex* index) {
+    if (!index) return;
+
+    eliza_memory_index_clear(index);
+    free(index->buckets);
+    free(index->lengths);
+    free(index);
+}
+
+/*
+ * Find the slot holding a term, or the empty slot where it belongs
+ */
+static MemoryPosting* find_slot(MemoryPosting* buckets, size_t capacity,
+                                const char* term, size_t len, uint32_t hash) {
+    size_t mask = capacity - 1;
+    size_t i = hash & mask;
+
+    while (buckets[i].term) {
+        if (buckets[i].hash == hash &&
+            strncmp(buckets[i].term, term, len) == 0 &&
+            buckets[i].term[len] == '\0') {
+            break;
+        }
+        i = (i + 1) & mask;
+    }
+    return &buckets[i];
+}
+
+/*
+ * Double the hash table once it is half full
+ */
+static int grow_table(MemoryIndex* index) {
+    size_t new_capacity = index->capacity * 2;
+    MemoryPosting* new_buckets = (MemoryPosting*)calloc(new_capacity, sizeof(MemoryPosting));
+    if (!new_buckets) return -1;
+
+    for (size_t i = 0; i < index->capacity; i++) {
+        MemoryPosting* old = &index->buckets[i];
+        if (!old->term) continue;
+
+        size_t j = old->hash & (new_capacity - 1);
+        while (new_buckets[j].term) j = (j + 1) & (new_capacity - 1);
+        new_buckets[j] = *old;
+    }
+
+    free(index->buckets);
+    index->buckets = new_buckets;
+    index->capacity = new_capacity;
+    return 0;
+}
+
+/*
+ * Posting list of a term, created empty if the term is new
+ * Returns NULL on failure
+ */
+static MemoryPosting* term_posting(MemoryIndex* index, const char* term, size_t len, uint32_t hash) {
+    if (index->size * 2 >= index->capacity && grow_table(index) < 0) return NULL;
+
+    MemoryPosting* posting = find_slot(index->buckets, index->capacity, term, len, hash);
+    if (!posting->term) {
+        posting->term = (char*)malloc(len + 1);
+        if (!posting->term) return NULL;
+        memcpy(posting->term, term, len);
+        posting->term[len] = '\0';
+        posting->hash = hash;
+        posting->ids = NULL;
+        posting->freqs = NULL;
+        posting->size = 0;
+        posting->capacity = 0;
+        index->size++;
+    }
+    return posting;
+}
+
+/*
+ * Make room for count more ids in a posting list
+ * Returns 0 on success, -1 on failure
+ */
+static int reserve_posting(MemoryPosting* posting, size_t count) {
+    if (posting->size + count <= posting->capacity) return 0;
+
+    size_t new_capacity = posting->capacity ? posting->capacity * 2 : INITIAL_POSTING_CAPACITY;
+    while (new_capacity < posting->size + count) new_capacity *= 2;
+
+    uint32_t* new_ids = (uint32_t*)realloc(posting->ids, new_capacity * sizeof(uint32_t));
+    if (!new_ids) return -1;
+    posting->ids = new_ids;
+
+    uint16_t* new_freqs = (uint16_t*)realloc(posting->freqs, new_capacity * sizeof(uint16_t));
+    if (!new_freqs) return -1;
+    posting->freqs = new_freqs;
+
+    posting->capacity = new_capacity;
+    return 0;
+}
+
+/*
+ * Append an id to a posting list with room for it
+ * Terms repeated within one entry are only posted once
+ */
+static inline void append_posting(MemoryPosting* posting, uint32_t id) {
+    if (posting->size > 0 && posting->ids[posting->size - 1] == id) {
+        if (posting->freqs[posting->size - 1] < UINT16_MAX) posting->freqs[posting->size - 1]++;
+        return;
+    }
+    posting->ids[posting->size] = id;
+    posting->freqs[posting->size] = 1;
+    posting->size++;
+}
+
+/*
+ * Append an id to the posting list of a term
+ */
+static int add_posting(MemoryIndex* index, const char* term, size_t len, uint32_t id) {
+    MemoryPosting* posting = term_posting(index, term, len, hash_term(term, len));
+    if (!posting || reserve_posting(posting, 1) < 0) return -1;
+
+    append_posting(posting, id);
+    return 0;
+}
+
+/*
+ * Make room in the entry lengths for ids below end
+ * Returns 0 on success, -1 on failure
+ */
+static int reserve_lengths(MemoryIndex* index, size_t end) {
+    if (end <= index->lengths_capacity) return 0;
+
+    size_t new_capacity = index->lengths_capacity ? index->lengths_capacity * 2 : 1024;
+    while (new_capacity < end) new_capacity *= 2;
+
+    uint32_t* new_lengths = (uint32_t*)realloc(index->lengths, new_capacity * sizeof(uint32_t));
+    if (!new_lengths) return -1;
+    memset(new_lengths + index->lengths_capacity, 0,
+           (new_capacity - index->lengths_capacity) * sizeof(uint32_t));
+    index->lengths = new_lengths;
+    index->lengths_capacity = new_capacity;
+    return 0;
+}
+
+/*
+ * Drop the postings of ids from size on
+ * New ids are appended, so they sit at the end of each posting list;
+ * lists left empty stay until the next remap
+ */
+void eliza_memory_index_truncate(MemoryIndex* index, uint32_t size) {
+    if (!index) return;
+
+    for (size_t i = 0; i < index->capacity; i++) {
+        MemoryPosting* posting = &index->buckets[i];
+        while (posting->size > 0 && posting->ids[posting->size - 1] >= size) posting->size--;
+    }
+}
+
+/*
+ * Index the tokens of an entry
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_index_add(MemoryIndex* index, uint32_t id, const char* content) {
+    if (!index || !content) return -1;
+
+    /* Entry lengths are kept by id for relevance scoring */
+    if (reserve_lengths(index, (size_t)id + 1) < 0) return -1;
+
+    char token[MEMORY_INDEX_MAX_TOKEN + 1];
+    const char* cursor = content;
+    uint32_t tokens = 0;
+    size_t len;
+
+    while ((len = eliza_memory_next_token(&cursor, token)) > 0) {
+        if (add_posting(index, token, len, id) < 0) return -1;
+        tokens++;
+    }
+
+    index->lengths[id] = tokens;
+    index->total_length += tokens;
+    index->documents++;
+    return 0;
+}
+
+/*
+ * Take back the entries of a failed batch: those before failed_id were
+ * counted, failed_id itself only has postings
+ */
+static void undo_batch(MemoryIndex* index, uint32_t first_id, uint32_t failed_id) {
+    for (uint32_t id = first_id; id < failed_id; id++) {
+        eliza_memory_index_forget(index, id);
+    }
+    eliza_memory_index_truncate(index, first_id);
+}
+
+/*
+ * Index the tokens of consecutive entries
+ * A small direct-mapped table remembers the posting list of each recent
+ * term, so the frequent terms of a batch skip the probe of the main table
+ * A failure leaves none of the batch indexed
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_index_add_batch(MemoryIndex* index, uint32_t first_id,
+                                 const char* const* contents, size_t count) {
+    if (!index || (!contents && count > 0)) return -1;
+    if (count == 0) return 0;
+    if (reserve_lengths(index, (size_t)first_id + count) < 0) return -1;
+
+    MemoryPosting** recent = (MemoryPosting**)calloc(INDEX_BATCH_RECENT, sizeof(MemoryPosting*));
+    if (!recent) return -1;
+    MemoryPosting* buckets = index->buckets;
+
+    char token[MEMORY_INDEX_MAX_TOKEN + 1];
+    for (size_t i = 0; i < count; i++) {
+        uint32_t id = first_id + (uint32_t)i;
+        const char* cursor = contents[i];
+        uint32_t tokens = 0;
+        size_t len;
+
+        while ((len = eliza_memory_next_token(&cursor, token)) > 0) {
+            uint32_t hash = hash_term(token, len);
+            MemoryPosting** slot = &recent[hash & (INDEX_BATCH_RECENT - 1)];
+            MemoryPosting* posting = *slot;
+
+            if (!posting || posting->hash != hash || memcmp(posting->term, token, len + 1) != 0) {
+                posting = term_posting(index, token, len, hash);
+                if (!posting) {
+                    free(recent);
+                    undo_batch(index, first_id, id);
+                    return -1;
+                }
+                /* Growing the table moves every posting list */
+                if (index->buckets != buckets) {
+                    memset(recent, 0, INDEX_BATCH_RECENT * sizeof(MemoryPosting*));
+                    buckets = index->buckets;
+                }
+                *slot = posting;
+            }
+
+            if (reserve_posting(posting, 1) < 0) {
+                free(recent);
+                undo_batch(index, first_id, id);
+                return -1;
+            }
+            append_posting(posting, id);
+            tokens++;
+        }
+
+        index->lengths[id] = tokens;
+        index->total_length += tokens;
+        index->documents++;
+    }
+
+    free(recent);
+    return 0;
+}
+
+/*
+ * Token count of an indexed entry
+ */
+uint32_t eliza_memory_index_length(const MemoryIndex* index, uint32_t id) {
+    if (!index || id >= index->lengths_capacity) return 0;
+    return index->lengths[id];
+}
+
+/*
+ * Drop an entry from the relevance statistics
+ */
+void eliza_memory_index_forget(MemoryIndex* index, uint32_t id) {
+    if (!index || id >= index->lengths_capacity) return;
+
+    index->total_length -= index->lengths[id];
+    index->lengths[id] = 0;
+    if (index->documents > 0) index->documents--;
+}
+
+/*
+ * Renumber entries after removals
+ * Posting lists are filtered in place, then the surviving terms are
+ * rehashed into a table sized for them so removed vocabulary is released
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_index_remap(MemoryIndex* index, const uint32_t* map, size_t count) {
+    if (!index || (!map && count > 0)) return -1;
+
+    size_t live_terms = 0;
+    for (size_t i = 0; i < index->capacity; i++) {
+        MemoryPosting* posting = &index->buckets[i];
+        if (!posting->term) continue;
+
+        size_t kept = 0;
+        for (size_t j = 0; j < posting->size; j++) {
+            uint32_t id = posting->ids[j];
+            if (id >= count || map[id] == MEMORY_ID_REMOVED) continue;
+            posting->ids[kept] = map[id];
+            posting->freqs[kept] = posting->freqs[j];
+            kept++;
+        }
+        posting->size = kept;
+        if (kept > 0) live_terms++;
+    }
+
+    /* New ids never exceed old ones, so lengths compact front to back */
+    size_t new_count = 0;
+    for (size_t id = 0; id < count && id < index->lengths_capacity; id++) {
+        if (map[id] == MEMORY_ID_REMOVED) continue;
+        index->lengths[map[id]] = index->lengths[id];
+        new_count = (size_t)map[id] + 1;
+    }
+    if (new_count < index->lengths_capacity) {
+        memset(index->lengths + new_count, 0,
+               (index->lengths_capacity - new_count) * sizeof(uint32_t));
+    }
+
+    /* Empty postings still probe correctly, so a failed rehash is harmless */
+    size_t new_capacity = INITIAL_BUCKETS;
+    while (live_terms * 2 >= new_capacity) new_capacity *= 2;
+
+    MemoryPosting* new_buckets = (MemoryPosting*)calloc(new_capacity, sizeof(MemoryPosting));
+    if (!new_buckets) return -1;
+
+    for (size_t i = 0; i < index->capacity; i++) {
+        MemoryPosting* old = &index->buckets[i];
+        if (!old->term) continue;
+
+        if (old->size == 0) {
+            free(old->term);
+            free(old->ids);
+            free(old->freqs);
+            continue;
+        }
+
+        size_t j = old->hash & (new_capacity - 1);
+        while (new_buckets[j].term) j = (j + 1) & (new_capacity - 1);
+        new_buckets[j] = *old;
+    }
+
+    free(index->buckets);
+    index->buckets = new_buckets;
+    index->capacity = new_capacity;
+    index->size = live_terms;
+    return 0;
+}
+
+/*
+ * Look up the posting list of a term
+ */
+const MemoryPosting* eliza_memory_index_lookup(const MemoryIndex* index,
+                                             const char* term, size_t len) {
+    if (!index || !term || len == 0) return NULL;
+
+    /* Normalize the term the same way the tokenizer does */
+    char normalized[MEMORY_INDEX_MAX_TOKEN + 1];
+    if (len > MEMORY_INDEX_MAX_TOKEN) len = MEMORY_INDEX_MAX_TOKEN;
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = (unsigned char)term[i];
+        normalized[i] = (c >= 'A' && c <= 'Z') ? (char)(c + ('a' - 'A')) : (char)c;
+    }
+    normalized[len] = '\0';
+
+    uint32_t hash = hash_term(normalized, len);
+    MemoryPosting* posting = find_slot(index->buckets, index->capacity, normalized, len, hash);
+    return posting->term ? posting : NULL;
+}
+
+/*
+ * Start a query with no terms
+ */
+static void query_reset(MemoryIndexQuery* query) {
+    query->num_terms = 0;
+    query->empty = 0;
+    for (size_t i = 0; i < 2; i++) {
+        query->partial[i].ids = NULL;
+        query->partial[i].size = 0;
+    }
+}
+
+/*
+ * Add a posting list to a query, skipping duplicates
+ * Posting lists are ordered shortest first so the rarest term drives
+ * the intersection
+ */
+static void query_add(MemoryIndexQuery* query, const MemoryPosting* posting) {
+    for (size_t i = 0; i < query->num_terms; i++) {
+        if (query->postings[i] == posting) return;
+    }
+
+    size_t i = query->num_terms++;
+    while (i > 0 && query->postings[i - 1]->size > posting->size) {
+        query->postings[i] = query->postings[i - 1];
+        i--;
+    }
+    query->postings[i] = posting;
+}
+
+/*
+ * Prepare an intersection query over the terms of a string
+ */
+size_t eliza_memory_index_query_init(MemoryIndexQuery* query,
+                                   const MemoryIndex* index, const char* text) {
+    if (!query) return 0;
+
+    query_reset(query);
+    if (!index || !text) {
+        query->empty = 1;
+        return 0;
+    }
+
+    char token[MEMORY_INDEX_MAX_TOKEN + 1];
+    const char* cursor = text;
+    size_t terms = 0;
+    size_t len;
+
+    while (terms < MEMORY_INDEX_MAX_QUERY_TERMS &&
+           (len = eliza_memory_next_token(&cursor, token)) > 0) {
+        terms++;
+
+        /* A term that was never indexed cannot match anything */
+        const MemoryPosting* posting = eliza_memory_index_lookup(index, token, len);
+        if (!posting) {
+            query->empty = 1;
+            continue;
+        }
+        query_add(query, posting);
+    }
+
+    for (size_t i = 0; i < query->num_terms; i++) {
+        query->positions[i] = 0;
+    }
+
+    return terms;
+}
+
+static int compare_ids(const void* a, const void* b) {
+    uint32_t x = *(const uint32_t*)a;
+    uint32_t y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+/*
+ * Whether an indexed token can contain a partial term at its end
+ * (suffix) or start. Tokens cut at MEMORY_INDEX_MAX_TOKEN have lost
+ * their end, so they may hold any suffix.
+ */
+static int token_has_part(const char* token, const char* part, size_t len, int suffix) {
+    size_t token_len = strlen(token);
+    if (suffix && token_len == MEMORY_INDEX_MAX_TOKEN) return 1;
+    if (token_len < len) return 0;
+    return memcmp(suffix ? token + token_len - len : token, part, len) == 0;
+}
+
+/*
+ * Merge the postings of every token holding a partial term into the
+ * query's next partial slot
+ * A term found in more postings than there are entries hardly narrows
+ * the search and is left out.
+ * Returns 1 if the term constrains the query, 0 if it was left out, -1
+ * on failure
+ */
+static int add_partial(MemoryIndexQuery* query, const MemoryIndex* index,
+                       const char* part, size_t len, int suffix, size_t slot) {
+    size_t total = 0;
+    for (size_t i = 0; i < index->capacity; i++) {
+        const MemoryPosting* posting = &index->buckets[i];
+        if (posting->term && token_has_part(posting->term, part, len, suffix)) total += posting->size;
+        if (total > index->documents) return 0;
+    }
+    if (total == 0) {
+        query->empty = 1;
+        return 1;
+    }
+
+    uint32_t* ids = (uint32_t*)malloc(total * sizeof(uint32_t));
+    if (!ids) return -1;
+
+    size_t count = 0;
+    for (size_t i = 0; i < index->capacity; i++) {
+        const MemoryPosting* posting = &index->buckets[i];
+        if (!posting->term || !token_has_part(posting->term, part, len, suffix)) continue;
+        memcpy(ids + count, posting->ids, posting->size * sizeof(uint32_t));
+        count += posting->size;
+    }
+
+    qsort(ids, count, sizeof(uint32_t), compare_ids);
+    size_t kept = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (kept == 0 || ids[kept - 1] != ids[i]) ids[kept++] = ids[i];
+    }
+
+    MemoryPosting* merged = &query->partial[slot];
+    merged->term = NULL;
+    merged->ids = ids;
+    merged->freqs = NULL;
+    merged->size = kept;
+    merged->capacity = count;
+    query_add(query, merged);
+    return 1;
+}
+
+/*
+ * Prepare a candidate query for a substring search
+ * Only the first term can continue to the left and only the last one to
+ * the right, everything in between is bounded by separators
+ * Matching a partial term means walking every bucket of the index, so
+ * the partial terms are only looked up when no whole term narrows the
+ * candidates; otherwise the verifier checks them.
+ */
+size_t eliza_memory_index_query_init_substring(MemoryIndexQuery* query,
+                                             const MemoryIndex* index, const char* text) {
+    if (!query) return 0;
+
+    query_reset(query);
+    if (!index || !text) {
+        query->empty = 1;
+        return 0;
+    }
+
+    char token[MEMORY_INDEX_MAX_TOKEN + 1];
+    char parts[2][MEMORY_INDEX_MAX_TOKEN + 1];
+    size_t part_lens[2];
+    int part_suffix[2];
+    size_t num_parts = 0;
+    const char* cursor = text;
+    int open_start = is_token_char((unsigned char)text[0]);
+    size_t terms = 0;
+    size_t constraints = 0;
+    size_t len;
+
+    while (terms < MEMORY_INDEX_MAX_QUERY_TERMS &&
+           (len = eliza_memory_next_token(&cursor, token)) > 0) {
+        int at_start = terms == 0 && open_start;
+        int at_end = *cursor == '\0';
+        terms++;
+
+        /* A lone term may lie anywhere inside a token */
+        if (at_start && at_end) continue;
+
+        if (!at_start && !at_end) {
+            const MemoryPosting* posting = eliza_memory_index_lookup(index, token, len);
+            if (posting) query_add(query, posting);
+            else query->empty = 1;
+            constraints++;
+            continue;
+        }
+
+        memcpy(parts[num_parts], token, len + 1);
+        part_lens[num_parts] = len;
+        part_suffix[num_parts] = at_start;
+        num_parts++;
+    }
+
+    size_t partials = 0;
+    if (constraints > 0) num_parts = 0;
+    for (size_t i = 0; i < num_parts; i++) {
+        int added = add_partial(query, index, parts[i], part_lens[i], part_suffix[i], partials);
+        if (added < 0) {
+            /* Without the term the query only finds more candidates */
+            continue;
+        }
+        if (added) {
+            if (query->partial[partials].ids) partials++;
+            constraints++;
+        }
+    }
+
+    for (size_t i = 0; i < query->num_terms; i++) {
+        query->positions[i] = 0;
+    }
+
+    return constraints;
+}
+
+/*
+ * Free the merged postings of a query
+ */
+void eliza_memory_index_query_release(MemoryIndexQuery* query) {
+    if (!query) return;
+
+    for (size_t i = 0; i < 2; i++) {
+        free(query->partial[i].ids);
+        query->partial[i].ids = NULL;
+        query->partial[i].size = 0;
+    }
+}
+
+/*
+ * Advance a position to the first id >= target using galloping search
+ */
+static size_t gallop(const MemoryPosting* posting, size_t pos, uint32_t target) {
+    size_t step = 1;
+    size_t low = pos;
+    size_t high = pos;
+
+    while (high < posting->size && posting->ids[high] < target) {
+        low = high + 1;
+        high += step;
+        step *= 2;
+    }
+    if (high > posting->size) high = posting->size;
+
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if (posting->ids[mid] < target) low = mid + 1;
+        else high = mid;
+    }
+    return low;
+}
+
+/*
+ * Fetch the next id present in every posting list
+ */
+int eliza_memory_index_query_next(MemoryIndexQuery* query, uint32_t* id) {
+    if (!query || !id || query->empty || query->num_terms == 0) return 0;
+
+    const MemoryPosting* driver = query->postings[0];
+
+    while (query->positions[0] < driver->size) {
+        uint32_t candidate = driver->ids[query->positions[0]];
+        size_t j = 1;
+
+        while (j < query->num_terms) {
+            const MemoryPosting* other = query->postings[j];
+            query->positions[j] = gallop(other, query->positions[j], candidate);
+            if (query->positions[j] >= other->size) {
+                query->empty = 1;
+                return 0;
+            }
+
+            uint32_t found = other->ids[query->positions[j]];
+            if (found != candidate) {
+                /* Leap the driver forward and restart the check */
+                query->positions[0] = gallop(driver, query->positions[0], found);
+                break;
+            }
+            j++;
+        }
+
+        if (j == query->num_terms) {
+            *id = candidate;
+            query->positions[0]++;
+            return 1;
+        }
+    }
+
+    query->empty = 1;
+    return 0;
+}
@@ -0,0 +1,504 @@
+#include "../include/memory_load.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/*
+ * Implementation of the Memory Text Loader
+ */
+
+#define FILE_MAGIC "ELIZA_MEMORY_STORE\n"
+#define ENTRY_MARKER "---ENTRY---\n"
+#define ENTRY_MARKER_LEN (sizeof(ENTRY_MARKER) - 1)
+
+/* Smallest entry the SIZE: header is trusted to describe, in bytes */
+#define MIN_ENTRY_BYTES 16
+
+/* Chunk states */
+#define CHUNK_PENDING 0
+#define CHUNK_READY   1
+#define CHUNK_FAILED  2
+
+/*
+ * Chunk structure
+ * Text from begin up to end, starting at an entry marker, and the entries
+ * parsed from it
+ */
+typedef struct {
+    const char* begin;
+    const char* end;
+    MemoryEntry** entries;
+    size_t count;
+    size_t capacity;
+    size_t skipped;
+    int escaped;             /* Text fields are escaped */
+    int state;               /* CHUNK_*, guarded by the loader lock */
+} LoadChunk;
+
+/*
+ * Loader structure
+ * Shared by the calling thread and the parser threads
+ */
+typedef struct {
+    LoadChunk* chunks;
+    size_t chunk_count;
+    size_t next;             /* Next chunk to parse */
+    int stop;                /* Set when the load is abandoned */
+    pthread_mutex_t lock;
+    pthread_cond_t ready;    /* Signals a finished chunk */
+} Loader;
+
+/*
+ * Fields of the entry being parsed, pointing into the text
+ */
+typedef struct {
+    const char* content;
+    size_t content_len;
+    const char* context;
+    size_t context_len;
+    const char* category;
+    size_t category_len;
+    time_t timestamp;
+    int has_timestamp;
+    float importance;
+} EntryFields;
+
+/*
+ * Fill load options with defaults
+ */
+void eliza_memory_load_options_default(MemoryLoadOptions* options) {
+    if (!options) return;
+
+    options->threads = 0;
+    options->chunk_bytes = MEMORY_LOAD_CHUNK_BYTES;
+}
+
+static double elapsed_ms(const struct timespec* start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec) * 1e3 + (double)(now.tv_nsec - start->tv_nsec) / 1e6;
+}
+
+/*
+ * Copy length bytes into a NUL-terminated string
+ */
+static char* copy_string(const char* text, size_t length) {
+    char* copy = (char*)malloc(length + 1);
+    if (!copy) return NULL;
+
+    memcpy(copy, text, length);
+    copy[length] = '\0';
+    return copy;
+}
+
+/*
+ * Copy an escaped field into a NUL-terminated string
+ * Unknown escapes are kept as written
+ */
+static char* unescape_string(const char* text, size_t length) {
+    char* copy = (char*)malloc(length + 1);
+    if (!copy) return NULL;
+
+    size_t out = 0;
+    for (size_t i = 0; i < length; i++) {
+        char c = text[i];
+        if (c == '\\' && i + 1 < length) {
+            switch (text[i + 1]) {
+                case 'n': c = '\n'; i++; break;
+                case 'r': c = '\r'; i++; break;
+                case '\\': i++; break;
+                default: break;
+            }
+        }
+        copy[out++] = c;
+    }
+    copy[out] = '\0';
+    return copy;
+}
+
+/*
+ * Copy a text field of the chunk's format
+ */
+static char* copy_field(const LoadChunk* chunk, const char* text, size_t length) {
+    return chunk->escaped ? unescape_string(text, length) : copy_string(text, length);
+}
+
+/*
+ * Parse a decimal integer that is not NUL-terminated
+ */
+static long long parse_integer(const char* text, size_t length) {
+    size_t i = 0;
+    int negative = 0;
+    if (i < length && (text[i] == '-' || text[i] == '+')) negative = text[i++] == '-';
+
+    long long value = 0;
+    for (; i < length && text[i] >= '0' && text[i] <= '9'; i++) {
+        value = value * 10 + (text[i] - '0');
+    }
+    return negative ? -value : value;
+}
+
+/*
+ * Parse a float that is not NUL-terminated
+ */
+static float parse_float(const char* text, size_t length) {
+    char buffer[64];
+    if (length >= sizeof(buffer)) length = sizeof(buffer) - 1;
+
+    memcpy(buffer, text, length);
+    buffer[length] = '\0';
+    return strtof(buffer, NULL);
+}
+
+/*
+ * Whether a line holds the given key
+ */
+static int is_key(const char* line, size_t key_len, const char* key) {
+    return strlen(key) == key_len && memcmp(line, key, key_len) == 0;
+}
+
+/*
+ * Turn parsed fields into an entry and add it to the chunk
+ * Entries without content are counted and dropped, as before
+ * Returns 0 on success, -1 on failure
+ */
+static int emit_entry(LoadChunk* chunk, const EntryFields* fields) {
+    if (fields->content_len == 0) {
+        chunk->skipped++;
+        return 0;
+    }
+
+    if (chunk->count == chunk->capacity) {
+        size_t new_capacity = chunk->capacity ? chunk->capacity * 2 : 256;
+        MemoryEntry** entries = (MemoryEntry**)realloc(chunk->entries,
+                                new_capacity * sizeof(MemoryEntry*));
+        if (!entries) return -1;
+        chunk->entries = entries;
+        chunk->capacity = new_capacity;
+    }
+
+    MemoryEntry* entry = (MemoryEntry*)malloc(sizeof(MemoryEntry));
+    if (!entry) return -1;
+
+    entry->content = copy_field(chunk, fields->content, fields->content_len);
+    entry->timestamp = fields->has_timestamp ? fields->timestamp : time(NULL);
+    entry->importance = fields->importance;
+    entry->context = fields->context_len ? copy_field(chunk, fields->context, fields->context_len) : NULL;
+    entry->category = fields->category_len ? copy_field(chunk, fields->category, fields->category_len) : NULL;
+
+    if (!entry->content || (fields->context_len && !entry->context) ||
+        (fields->category_len && !entry->category)) {
+        eliza_memory_entry_destroy(entry);
+        return -1;
+    }
+
+    chunk->entries[chunk->count++] = entry;
+    return 0;
+}
+
+/*
+ * Parse the entries of a chunk
+ * Lines outside an entry and unknown keys are ignored
+ * Returns 0 on success, -1 on failure
+ */
+static int parse_chunk(LoadChunk* chunk) {
+    EntryFields fields;
+    int in_entry = 0;
+    const char* p = chunk->begin;
+
+    while (p < chunk->end) {
+        const char* newline = (const char*)memchr(p, '\n', (size_t)(chunk->end - p));
+        const char* line_end = newline ? newline : chunk->end;
+        size_t line_len = (size_t)(line_end - p);
+
+        if (line_len == ENTRY_MARKER_LEN - 1 && memcmp(p, ENTRY_MARKER, line_len) == 0) {
+            if (in_entry && emit_entry(chunk, &fields) < 0) return -1;
+            memset(&fields, 0, sizeof(fields));
+            in_entry = 1;
+        } else if (in_entry) {
+            const char* colon = (const char*)memchr(p, ':', line_len);
+            if (colon) {
+                size_t key_len = (size_t)(colon - p);
+                const char* value = colon + 1;
+                size_t value_len = (size_t)(line_end - value);
+
+                if (is_key(p, key_len, "CONTENT")) {
+                    fields.content = value;
+                    fields.content_len = value_len;
+                } else if (is_key(p, key_len, "TIMESTAMP")) {
+                    fields.timestamp = (time_t)parse_integer(value, value_len);
+                    fields.has_timestamp = 1;
+                } else if (is_key(p, key_len, "IMPORTANCE")) {
+                    fields.importance = parse_float(value, value_len);
+                } else if (is_key(p, key_len, "CONTEXT")) {
+                    fields.context = value;
+                    fields.context_len = value_len;
+                } else if (is_key(p, key_len, "CATEGORY")) {
+                    fields.category = value;
+                    fields.category_len = value_len;
+                }
+            }
+        }
+
+        p = line_end + 1;
+    }
+
+    if (in_entry && emit_entry(chunk, &fields) < 0) return -1;
+    return 0;
+}
+
+/*
+ * Start of the first entry marker line at or after p
+ * Returns end when there is none
+ */
+static const char* next_entry(const char* p, const char* body, const char* end) {
+    /* Step to the start of a line */
+    if (p > body && p[-1] != '\n') {
+        p = (const char*)memchr(p, '\n', (size_t)(end - p));
+        if (!p) return end;
+        p++;
+    }
+
+    while ((size_t)(end - p) >= ENTRY_MARKER_LEN) {
+        if (memcmp(p, ENTRY_MARKER, ENTRY_MARKER_LEN) == 0) return p;
+        p = (const char*)memchr(p, '\n', (size_t)(end - p));
+        if (!p) return end;
+        p++;
+    }
+    return end;
+}
+
+/*
+ * Free the entries of a chunk that were not added to the store
+ */
+static void discard_chunk(LoadChunk* chunk) {
+    for (size_t i = 0; i < chunk->count; i++) {
+        eliza_memory_entry_destroy(chunk->entries[i]);
+    }
+    free(chunk->entries);
+    chunk->entries = NULL;
+    chunk->count = 0;
+}
+
+/*
+ * Parser thread: parse chunks in order until none are left
+ */
+static void* parser_main(void* arg) {
+    Loader* loader = (Loader*)arg;
+
+    pthread_mutex_lock(&loader->lock);
+    while (!loader->stop && loader->next < loader->chunk_count) {
+        LoadChunk* chunk = &loader->chunks[loader->next++];
+        pthread_mutex_unlock(&loader->lock);
+
+        int result = parse_chunk(chunk);
+
+        pthread_mutex_lock(&loader->lock);
+        chunk->state = result == 0 ? CHUNK_READY : CHUNK_FAILED;
+        pthread_cond_broadcast(&loader->ready);
+    }
+    pthread_mutex_unlock(&loader->lock);
+    return NULL;
+}
+
+/*
+ * Number of parser threads to use
+ */
+static size_t parser_threads(const MemoryLoadOptions* options, size_t chunks) {
+    size_t threads = options->threads;
+    if (threads == 0) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = online > 0 ? (size_t)online : 1;
+    }
+    if (threads > MEMORY_LOAD_MAX_THREADS) threads = MEMORY_LOAD_MAX_THREADS;
+    if (threads > chunks) threads = chunks;
+
+    /* A single chunk is parsed by the calling thread */
+    return chunks > 1 ? threads : 0;
+}
+
+/*
+ * Parse the body and replace the entries of the store with its entries
+ * The store is left alone when parsing fails
+ * Returns 0 on success, -1 on failure
+ */
+static int load_body(MemoryStore* store, const char* body, const char* end, int escaped,
+                     const MemoryLoadOptions* options, MemoryLoadStats* stats) {
+    size_t bytes = (size_t)(end - body);
+    size_t chunk_bytes = options->chunk_bytes ? options->chunk_bytes : MEMORY_LOAD_CHUNK_BYTES;
+    size_t chunk_count = bytes / chunk_bytes + 1;
+
+    Loader loader;
+    memset(&loader, 0, sizeof(loader));
+    loader.chunks = (LoadChunk*)calloc(chunk_count, sizeof(LoadChunk));
+    if (!loader.chunks) return -1;
+
+    /* Cut at entry markers near even offsets; empty chunks are dropped */
+    const char* begin = next_entry(body, body, end);
+    for (size_t i = 0; i < chunk_count && begin < end; i++) {
+        const char* chunk_end = i + 1 == chunk_count ? end :
+                                next_entry(body + bytes / chunk_count * (i + 1), body, end);
+        if (chunk_end <= begin) continue;
+
+        LoadChunk* chunk = &loader.chunks[loader.chunk_count++];
+        chunk->begin = begin;
+        chunk->end = chunk_end;
+        chunk->escaped = escaped;
+        begin = chunk_end;
+    }
+
+    size_t thread_count = parser_threads(options, loader.chunk_count);
+    pthread_t threads[MEMORY_LOAD_MAX_THREADS];
+    size_t started = 0;
+
+    pthread_mutex_init(&loader.lock, NULL);
+    pthread_cond_init(&loader.ready, NULL);
+    for (; started < thread_count; started++) {
+        if (pthread_create(&threads[started], NULL, parser_main, &loader) != 0) break;
+    }
+
+    /* Without threads, or with those that did start, the chunks still
+     * get parsed; the store is only touched once all of them are */
+    int result = 0;
+    for (size_t i = 0; i < loader.chunk_count; i++) {
+        LoadChunk* chunk = &loader.chunks[i];
+
+        if (started == 0) {
+            chunk->state = parse_chunk(chunk) == 0 ? CHUNK_READY : CHUNK_FAILED;
+        } else {
+            pthread_mutex_lock(&loader.lock);
+            while (chunk->state == CHUNK_PENDING) pthread_cond_wait(&loader.ready, &loader.lock);
+            pthread_mutex_unlock(&loader.lock);
+        }
+
+        if (chunk->state == CHUNK_FAILED) {
+            result = -1;
+            break;
+        }
+    }
+
+    pthread_mutex_lock(&loader.lock);
+    loader.stop = 1;
+    pthread_mutex_unlock(&loader.lock);
+    for (size_t i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    /* Parsed, so replace the entries in file order */
+    if (result == 0) {
+        eliza_memory_clear(store);
+        result = eliza_memory_reserve(store, stats->size_hint);
+    }
+    for (size_t i = 0; i < loader.chunk_count && result == 0; i++) {
+        LoadChunk* chunk = &loader.chunks[i];
+
+        for (size_t j = 0; j < chunk->count; j++) {
+            if (eliza_memory_add_entry(store, chunk->entries[j]) < 0) {
+                /* The remaining entries are still owned by the chunk */
+                memmove(chunk->entries, chunk->entries + j, (chunk->count - j) * sizeof(MemoryEntry*));
+                chunk->count -= j;
+                result = -1;
+                break;
+            }
+            stats->entries++;
+        }
+        if (result < 0) break;
+
+        stats->skipped += chunk->skipped;
+        chunk->count = 0;
+        free(chunk->entries);
+        chunk->entries = NULL;
+    }
+
+    for (size_t i = 0; i < loader.chunk_count; i++) {
+        discard_chunk(&loader.chunks[i]);
+    }
+
+    stats->chunks = loader.chunk_count;
+    stats->threads = started;
+    pthread_mutex_destroy(&loader.lock);
+    pthread_cond_destroy(&loader.ready);
+    free(loader.chunks);
+    return result;
+}
+
+/*
+ * Replace the entries of a store with those of a text file
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_load_text(MemoryStore* store, const char* filepath,
+                          const MemoryLoadOptions* options, MemoryLoadStats* stats) {
+    if (!store || !filepath) return -1;
+
+    MemoryLoadOptions defaults;
+    if (!options) {
+        eliza_memory_load_options_default(&defaults);
+        options = &defaults;
+    }
+
+    MemoryLoadStats local_stats;
+    if (!stats) stats = &local_stats;
+    memset(stats, 0, sizeof(*stats));
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    int fd = open(filepath, O_RDONLY);
+    if (fd < 0) return -1;
+
+    struct stat st;
+    size_t magic_len = sizeof(FILE_MAGIC) - 1;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < magic_len) {
+        close(fd);
+        return -1;
+    }
+
+    size_t size = (size_t)st.st_size;
+    void* map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return -1;
+    madvise(map, size, MADV_SEQUENTIAL);
+
+    const char* text = (const char*)map;
+    const char* end = text + size;
+    if (memcmp(text, FILE_MAGIC, magic_len) != 0) {
+        munmap(map, size);
+        return -1;
+    }
+    stats->bytes = size;
+
+    /* The SIZE: header sizes the store once; a value the file could not
+     * possibly hold is capped rather than trusted */
+    const char* body = text + magic_len;
+    if ((size_t)(end - body) > 5 && memcmp(body, "SIZE:", 5) == 0) {
+        const char* line_end = (const char*)memchr(body, '\n', (size_t)(end - body));
+        if (!line_end) line_end = end;
+        long long hint = parse_integer(body + 5, (size_t)(line_end - body - 5));
+        if (hint > 0) {
+            stats->size_hint = (size_t)hint;
+            if (stats->size_hint > size / MIN_ENTRY_BYTES) stats->size_hint = size / MIN_ENTRY_BYTES;
+        }
+        body = line_end < end ? line_end + 1 : end;
+    }
+
+    /* Older files have no FORMAT: header and were written unescaped */
+    int escaped = 0;
+    if ((size_t)(end - body) > 7 && memcmp(body, "FORMAT:", 7) == 0) {
+        const char* line_end = (const char*)memchr(body, '\n', (size_t)(end - body));
+        if (!line_end) line_end = end;
+        escaped = parse_integer(body + 7, (size_t)(line_end - body - 7)) >= 2;
+        body = line_end < end ? line_end + 1 : end;
+    }
+
+    int result = load_body(store, body, end, escaped, options, stats);
+
+    munmap(map, size);
+    stats->elapsed_ms = elapsed_ms(&start);
+    return result;
+}
@@ -0,0 +1,185 @@
+#include "../include/memory_lz.h"
+#include <stdint.h>
+#include <string.h>
+
+/*
+ * Implementation of the Memory Block Codec
+ */
+
+#define HASH_BITS 12
+#define MIN_MATCH 4
+#define MAX_OFFSET 65535
+
+/* A block ends with at least this many literals, and its last match
+ * starts at least MATCH_LIMIT bytes before the end, as in LZ4 */
+#define LAST_LITERALS 5
+#define MATCH_LIMIT 12
+
+static inline uint32_t read32(const char* p) {
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static inline uint32_t hash32(uint32_t sequence) {
+    return (sequence * 2654435761u) >> (32 - HASH_BITS);
+}
+
+/*
+ * Largest compressed size of a block
+ */
+size_t eliza_memory_lz_bound(size_t length) {
+    return length + length / 255 + 16;
+}
+
+/*
+ * Write a length continuation: runs of 255 and a final smaller byte
+ */
+static inline unsigned char* put_length(unsigned char* op, size_t length) {
+    while (length >= 255) {
+        *op++ = 255;
+        length -= 255;
+    }
+    *op++ = (unsigned char)length;
+    return op;
+}
+
+/*
+ * Write one sequence; a match length of 0 ends the block with literals only
+ * Returns the new output position, or NULL if it does not fit
+ */
+static unsigned char* put_sequence(unsigned char* op, const unsigned char* end,
+                                   const char* literals, size_t literal_length,
+                                   size_t offset, size_t match_length) {
+    size_t needed = 1 + literal_length / 255 + 1 + literal_length + 2 + match_length / 255 + 1;
+    if ((size_t)(end - op) < needed) return NULL;
+
+    unsigned char* token = op++;
+    size_t match_code = match_length ? match_length - MIN_MATCH : 0;
+    *token = (unsigned char)((literal_length >= 15 ? 15 : literal_length) << 4 |
+                             (match_code >= 15 ? 15 : match_code));
+
+    if (literal_length >= 15) op = put_length(op, literal_length - 15);
+    memcpy(op, literals, literal_length);
+    op += literal_length;
+    if (match_length == 0) return op;
+
+    *op++ = (unsigned char)(offset & 0xFF);
+    *op++ = (unsigned char)(offset >> 8);
+    if (match_code >= 15) op = put_length(op, match_code - 15);
+    return op;
+}
+
+/*
+ * Compress a block
+ * Returns the compressed size, or 0 if it does not fit
+ */
+size_t eliza_memory_lz_compress(const char* src, size_t length, char* dst, size_t capacity) {
+    if (!src || !dst) return 0;
+
+    unsigned char* op = (unsigned char*)dst;
+    const unsigned char* end = op + capacity;
+    size_t anchor = 0;
+
+    if (length > MATCH_LIMIT) {
+        uint32_t table[1 << HASH_BITS];
+        memset(table, 0, sizeof(table));
+
+        size_t limit = length - MATCH_LIMIT;
+        size_t match_end = length - LAST_LITERALS;
+        size_t ip = 0;
+
+        while (ip < limit) {
+            uint32_t sequence = read32(src + ip);
+            uint32_t h = hash32(sequence);
+            size_t ref = table[h];
+            table[h] = (uint32_t)ip;
+
+            if (ref >= ip || ip - ref > MAX_OFFSET || read32(src + ref) != sequence) {
+                /* Skip faster through data that does not compress */
+                ip += 1 + ((ip - anchor) >> 6);
+                continue;
+            }
+
+            while (ip > anchor && ref > 0 && src[ip - 1] == src[ref - 1]) {
+                ip--;
+                ref--;
+            }
+            size_t match_length = MIN_MATCH;
+            while (ip + match_length < match_end && src[ip + match_length] == src[ref + match_length]) {
+                match_length++;
+            }
+
+            op = put_sequence(op, end, src + anchor, ip - anchor, ip - ref, match_length);
+            if (!op) return 0;
+
+            ip += match_length;
+            anchor = ip;
+            if (ip - 2 < limit) table[hash32(read32(src + ip - 2))] = (uint32_t)(ip - 2);
+        }
+    }
+
+    op = put_sequence(op, end, src + anchor, length - anchor, 0, 0);
+    if (!op) return 0;
+    return (size_t)(op - (unsigned char*)dst);
+}
+
+/*
+ * Read a length continuation
+ * Returns 0 on success, -1 if the input ends first
+ */
+static inline int get_length(const unsigned char** ip, const unsigned char* end, size_t* length) {
+    unsigned char byte;
+    do {
+        if (*ip >= end) return -1;
+        byte = *(*ip)++;
+        *length += byte;
+    } while (byte == 255);
+    return 0;
+}
+
+/*
+ * Decompress a block
+ * Returns the decompressed size, or -1 on failure
+ */
+long eliza_memory_lz_decompress(const char* src, size_t length, char* dst, size_t capacity) {
+    if (!src || !dst) return -1;
+
+    const unsigned char* ip = (const unsigned char*)src;
+    const unsigned char* end = ip + length;
+    size_t op = 0;
+
+    while (ip < end) {
+        unsigned char token = *ip++;
+
+        size_t literal_length = token >> 4;
+        if (literal_length == 15 && get_length(&ip, end, &literal_length) < 0) return -1;
+        if (literal_length > (size_t)(end - ip) || literal_length > capacity - op) return -1;
+        memcpy(dst + op, ip, literal_length);
+        ip += literal_length;
+        op += literal_length;
+
+        /* The last sequence has no match */
+        if (ip == end) break;
+
+        if (end - ip < 2) return -1;
+        size_t offset = (size_t)ip[0] | (size_t)ip[1] << 8;
+        ip += 2;
+        if (offset == 0 || offset > op) return -1;
+
+        size_t match_length = token & 15;
+        if (match_length == 15 && get_length(&ip, end, &match_length) < 0) return -1;
+        match_length += MIN_MATCH;
+        if (match_length > capacity - op) return -1;
+
+        /* Overlapping matches repeat the bytes just written */
+        const char* match = dst + op - offset;
+        if (offset >= match_length) {
+            memcpy(dst + op, match, match_length);
+        } else {
+            for (size_t i = 0; i < match_length; i++) dst[op + i] = match[i];
+        }
+        op += match_length;
+    }
+    return (long)op;
+}
@@ -0,0 +1,309 @@
+#include "../include/memory_match.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86_KERNELS 1
+#endif
+
+/*
+ * Implementation of the Memory Substring Matcher
+ */
+
+/*
+ * Lower-case an ASCII letter, leaving other bytes alone
+ */
+static inline unsigned char fold(unsigned char c) {
+    return (c >= 'A' && c <= 'Z') ? (unsigned char)(c | 0x20) : c;
+}
+
+static inline int is_letter(unsigned char c) {
+    return (c >= 'a' && c <= 'z');
+}
+
+/*
+ * Compare n bytes of text against a lower-cased needle, folding the text
+ */
+static int fold_equal(const char* text, const char* needle, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        if (fold((unsigned char)text[i]) != (unsigned char)needle[i]) return 0;
+    }
+    return 1;
+}
+
+/*
+ * Empty needles match at the start
+ */
+static const char* find_empty(const MemoryMatcher* matcher, const char* haystack, size_t length) {
+    (void)matcher;
+    (void)length;
+    return haystack;
+}
+
+/*
+ * Scalar kernel: memchr for the first byte, then verify
+ */
+static const char* find_scalar(const MemoryMatcher* matcher, const char* haystack, size_t length) {
+    size_t n = matcher->length;
+    if (length < n) return NULL;
+
+    const char* p = haystack;
+    const char* end = haystack + length - n + 1;
+
+    while (p < end) {
+        p = (const char*)memchr(p, matcher->first, (size_t)(end - p));
+        if (!p) return NULL;
+        if (memcmp(p + 1, matcher->needle + 1, n - 1) == 0) return p;
+        p++;
+    }
+    return NULL;
+}
+
+/*
+ * Scalar case-insensitive kernel
+ */
+static const char* find_scalar_nocase(const MemoryMatcher* matcher, const char* haystack, size_t length) {
+    size_t n = matcher->length;
+    if (length < n) return NULL;
+
+    for (size_t i = 0; i + n <= length; i++) {
+        if (fold((unsigned char)haystack[i]) == matcher->first &&
+            fold_equal(haystack + i + 1, matcher->needle + 1, n - 1)) {
+            return haystack + i;
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Scan kernel for texts of unknown length
+ */
+static const char* scan_generic(const MemoryMatcher* matcher, const char* text) {
+    return matcher->find(matcher, text, strlen(text));
+}
+
+#ifdef HAVE_X86_KERNELS
+
+/*
+ * AVX2 scan of a NUL-terminated text, both case modes
+ * Reads aligned 32-byte blocks, which never cross into another page, so
+ * it may look at bytes around the text but never past the page holding
+ * its NUL. The first-byte hits of the previous block are kept so a needle
+ * of up to 33 bytes can straddle two blocks.
+ */
+__attribute__((target("avx2"), no_sanitize_address))
+static const char* scan_avx2(const MemoryMatcher* matcher, const char* text) {
+    size_t span = matcher->length - 1;
+    int ignore_case = (matcher->flags & MEMORY_MATCH_IGNORE_CASE) != 0;
+
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i first = _mm256_set1_epi8((char)matcher->first);
+    const __m256i last = _mm256_set1_epi8((char)matcher->last);
+    const __m256i first_fold = _mm256_set1_epi8(ignore_case && is_letter(matcher->first) ? 0x20 : 0);
+    const __m256i last_fold = _mm256_set1_epi8(ignore_case && is_letter(matcher->last) ? 0x20 : 0);
+
+    const char* block = (const char*)((uintptr_t)text & ~(uintptr_t)31);
+    uint32_t valid = ~0u << (unsigned int)(text - block);
+    uint32_t previous_firsts = 0;
+
+    for (;; block += 32) {
+        __m256i bytes = _mm256_load_si256((const __m256i*)block);
+        uint32_t nuls = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, zero)) & valid;
+        if (nuls) valid &= (nuls & (0u - nuls)) - 1;
+
+        uint32_t firsts = (uint32_t)_mm256_movemask_epi8(
+            _mm256_cmpeq_epi8(_mm256_or_si256(bytes, first_fold), first)) & valid;
+        uint32_t lasts = (uint32_t)_mm256_movemask_epi8(
+            _mm256_cmpeq_epi8(_mm256_or_si256(bytes, last_fold), last)) & valid;
+
+        /* A last byte at bit j completes a match if a first byte sits
+         * span positions earlier, possibly in the previous block */
+        uint64_t window = ((uint64_t)firsts << 32) | previous_firsts;
+        uint32_t candidates = lasts & (uint32_t)(window >> (32 - span));
+
+        while (candidates) {
+            const char* start = block + __builtin_ctz(candidates) - span;
+            if (ignore_case ? fold_equal(start, matcher->needle, span + 1)
+                            : memcmp(start + 1, matcher->needle + 1, span - 1) == 0) {
+                return start;
+            }
+            candidates &= candidates - 1;
+        }
+
+        if (nuls) return NULL;
+        previous_firsts = firsts;
+        valid = ~0u;
+    }
+}
+
+/*
+ * AVX2 kernel, 32 candidate positions per step
+ * A position is verified only when the needle's first byte and last byte
+ * both line up; the remainder is handed to the scalar kernel.
+ */
+__attribute__((target("avx2")))
+static const char* find_avx2(const MemoryMatcher* matcher, const char* haystack, size_t length) {
+    size_t n = matcher->length;
+    if (length < n) return NULL;
+
+    const __m256i first = _mm256_set1_epi8((char)matcher->first);
+    const __m256i last = _mm256_set1_epi8((char)matcher->last);
+
+    size_t i = 0;
+    for (; i + n + 31 <= length; i += 32) {
+        __m256i block_first = _mm256_loadu_si256((const __m256i*)(haystack + i));
+        __m256i block_last = _mm256_loadu_si256((const __m256i*)(haystack + i + n - 1));
+        unsigned int mask = (unsigned int)_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(block_first, first), _mm256_cmpeq_epi8(block_last, last)));
+
+        while (mask) {
+            size_t pos = i + (size_t)__builtin_ctz(mask);
+            if (memcmp(haystack + pos + 1, matcher->needle + 1, n - 2) == 0) return haystack + pos;
+            mask &= mask - 1;
+        }
+    }
+
+    return find_scalar(matcher, haystack + i, length - i);
+}
+
+/*
+ * AVX2 case-insensitive kernel
+ * Setting bit 0x20 lower-cases every ASCII letter; the few non-letters it
+ * also maps onto a letter are rejected by the folding verification.
+ */
+__attribute__((target("avx2")))
+static const char* find_avx2_nocase(const MemoryMatcher* matcher, const char* haystack, size_t length) {
+    size_t n = matcher->length;
+    if (length < n) return NULL;
+
+    const __m256i first = _mm256_set1_epi8((char)matcher->first);
+    const __m256i last = _mm256_set1_epi8((char)matcher->last);
+    const __m256i first_fold = _mm256_set1_epi8(is_letter(matcher->first) ? 0x20 : 0);
+    const __m256i last_fold = _mm256_set1_epi8(is_letter(matcher->last) ? 0x20 : 0);
+
+    size_t i = 0;
+    for (; i + n + 31 <= length; i += 32) {
+        __m256i block_first = _mm256_or_si256(_mm256_loadu_si256((const __m256i*)(haystack + i)), first_fold);
+        __m256i block_last = _mm256_or_si256(_mm256_loadu_si256((const __m256i*)(haystack + i + n - 1)), last_fold);
+        unsigned int mask = (unsigned int)_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(block_first, first), _mm256_cmpeq_epi8(block_last, last)));
+
+        while (mask) {
+            size_t pos = i + (size_t)__builtin_ctz(mask);
+            if (fold_equal(haystack + pos, matcher->needle, n)) return haystack + pos;
+            mask &= mask - 1;
+        }
+    }
+
+    return find_scalar_nocase(matcher, haystack + i, length - i);
+}
+
+#endif /* HAVE_X86_KERNELS */
+
+/*
+ * Pick the kernels for a needle
+ */
+static void select_kernels(MemoryMatcher* matcher, int ignore_case) {
+    matcher->find = ignore_case ? find_scalar_nocase : find_scalar;
+    matcher->scan = scan_generic;
+    if (matcher->length == 0) {
+        matcher->find = find_empty;
+        return;
+    }
+
+#ifdef HAVE_X86_KERNELS
+    /* Single bytes are left to memchr, which is already vectorized */
+    __builtin_cpu_init();
+    if (matcher->length >= 2 && __builtin_cpu_supports("avx2")) {
+        matcher->find = ignore_case ? find_avx2_nocase : find_avx2;
+        if (matcher->length <= 33) matcher->scan = scan_avx2;
+    }
+#endif
+}
+
+/*
+ * Compile a query into caller storage when it fits
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_matcher_init_buffer(MemoryMatcher* matcher, const char* query, int flags,
+                                    char* buffer, size_t size) {
+    if (!matcher || !query) return -1;
+
+    size_t length = strlen(query);
+    matcher->owns_needle = !buffer || length >= size;
+    matcher->needle = matcher->owns_needle ? (char*)malloc(length + 1) : buffer;
+    if (!matcher->needle) return -1;
+
+    int ignore_case = (flags & MEMORY_MATCH_IGNORE_CASE) != 0;
+    for (size_t i = 0; i <= length; i++) {
+        matcher->needle[i] = ignore_case ? (char)fold((unsigned char)query[i]) : query[i];
+    }
+
+    matcher->length = length;
+    matcher->flags = flags;
+    matcher->first = length ? (unsigned char)matcher->needle[0] : 0;
+    matcher->last = length ? (unsigned char)matcher->needle[length - 1] : 0;
+    select_kernels(matcher, ignore_case);
+    return 0;
+}
+
+/*
+ * Compile a query
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_matcher_init(MemoryMatcher* matcher, const char* query, int flags) {
+    return eliza_memory_matcher_init_buffer(matcher, query, flags, NULL, 0);
+}
+
+/*
+ * Release a compiled query
+ */
+void eliza_memory_matcher_destroy(MemoryMatcher* matcher) {
+    if (!matcher) return;
+
+    if (matcher->owns_needle) free(matcher->needle);
+    matcher->needle = NULL;
+    matcher->length = 0;
+}
+
+/*
+ * First match in length bytes of haystack
+ * Returns a pointer into haystack, or NULL
+ */
+const char* eliza_memory_matcher_find(const MemoryMatcher* matcher, const char* haystack, size_t length) {
+    if (!matcher || !haystack) return NULL;
+    return matcher->find(matcher, haystack, length);
+}
+
+/*
+ * Whether a NUL-terminated text contains the query
+ */
+int eliza_memory_matcher_contains(const MemoryMatcher* matcher, const char* text) {
+    if (!matcher || !text) return 0;
+    return matcher->scan(matcher, text) != NULL;
+}
+
+/*
+ * Search by compiled query
+ * Returns an array of matching entries, terminated with a NULL pointer
+ */
+MemoryEntry** eliza_memory_search_matching(MemoryStore* store, const MemoryMatcher* matcher,
+                                         size_t max_results) {
+    if (!store || !matcher) return NULL;
+
+    MemoryEntry** results = (MemoryEntry**)malloc((max_results + 1) * sizeof(MemoryEntry*));
+    if (!results) return NULL;
+
+    size_t found = 0;
+    for (size_t i = 0; i < store->size && found < max_results; i++) {
+        MemoryEntry* entry = store->entries[i];
+        if (entry && eliza_memory_matcher_contains(matcher, entry->content)) {
+            results[found++] = entry;
+        }
+    }
+
+    results[found] = NULL;
+    return results;
+}
@@ -0,0 +1,203 @@
+#include "../include/memory_rank.h"
+#include "../include/memory_columns.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/*
+ * Implementation of Ranked Memory Recall
+ */
+
+/*
+ * Restore the heap property below position i
+ */
+static void sift_down(MemoryTopK* heap, size_t i) {
+    for (;;) {
+        size_t smallest = i;
+        size_t left = 2 * i + 1;
+        size_t right = left + 1;
+
+        if (left < heap->size && heap->items[left].score < heap->items[smallest].score) smallest = left;
+        if (right < heap->size && heap->items[right].score < heap->items[smallest].score) smallest = right;
+        if (smallest == i) return;
+
+        MemoryRankedResult tmp = heap->items[i];
+        heap->items[i] = heap->items[smallest];
+        heap->items[smallest] = tmp;
+        i = smallest;
+    }
+}
+
+/*
+ * Start collecting the k best results
+ */
+void eliza_memory_topk_init(MemoryTopK* topk, MemoryRankedResult* storage, size_t k) {
+    if (!topk) return;
+
+    topk->items = storage;
+    topk->size = 0;
+    topk->capacity = storage ? k : 0;
+}
+
+/*
+ * Offer a scored entry to the heap
+ * Once full, an entry only gets in by beating the current minimum
+ */
+void eliza_memory_topk_offer(MemoryTopK* heap, MemoryEntry* entry, float score) {
+    if (!heap || heap->capacity == 0) return;
+
+    if (heap->size < heap->capacity) {
+        size_t i = heap->size++;
+        heap->items[i].entry = entry;
+        heap->items[i].score = score;
+
+        while (i > 0) {
+            size_t parent = (i - 1) / 2;
+            if (heap->items[parent].score <= heap->items[i].score) break;
+            MemoryRankedResult tmp = heap->items[i];
+            heap->items[i] = heap->items[parent];
+            heap->items[parent] = tmp;
+            i = parent;
+        }
+        return;
+    }
+
+    if (score <= heap->items[0].score) return;
+    heap->items[0].entry = entry;
+    heap->items[0].score = score;
+    sift_down(heap, 0);
+}
+
+/*
+ * Sort the heap in place, best first
+ */
+size_t eliza_memory_topk_finish(MemoryTopK* heap) {
+    if (!heap) return 0;
+
+    size_t size = heap->size;
+    while (heap->size > 1) {
+        MemoryRankedResult tmp = heap->items[0];
+        heap->items[0] = heap->items[heap->size - 1];
+        heap->items[heap->size - 1] = tmp;
+        heap->size--;
+        sift_down(heap, 0);
+    }
+    heap->size = size;
+    return size;
+}
+
+/*
+ * Fill options with defaults
+ */
+void eliza_memory_rank_options_default(MemoryRankOptions* options) {
+    if (!options) return;
+
+    options->text_weight = 1.0f;
+    options->importance_weight = 0.3f;
+    options->recency_weight = 0.2f;
+    options->half_life = 3.0 * 24.0 * 3600.0;
+    options->k1 = 1.2f;
+    options->b = 0.75f;
+    options->now = 0;
+}
+
+/*
+ * Importance and recency part of the score
+ */
+static float prior_score(const MemoryStore* store, const MemoryRankOptions* options,
+                         uint32_t id, time_t now) {
+    float importance;
+    time_t timestamp;
+
+    if (store->columns) {
+        importance = store->columns->importance[id];
+        timestamp = (time_t)store->columns->timestamps[id];
+    } else {
+        importance = store->entries[id]->importance;
+        timestamp = store->entries[id]->timestamp;
+    }
+
+    double age = now > timestamp ? (double)(now - timestamp) : 0.0;
+    double recency = options->half_life > 0.0 ? exp2(-age / options->half_life) : 1.0;
+
+    return options->importance_weight * importance + options->recency_weight * (float)recency;
+}
+
+/*
+ * Rank the entries matching a query
+ */
+size_t eliza_memory_search_ranked(MemoryStore* store, const char* query,
+                                 const MemoryRankOptions* options,
+                                 MemoryRankedResult* results, size_t k) {
+    if (!store || !query || !results || k == 0) return 0;
+
+    MemoryRankOptions defaults;
+    if (!options) {
+        eliza_memory_rank_options_default(&defaults);
+        options = &defaults;
+    }
+
+    time_t now = options->now ? options->now : time(NULL);
+    MemoryTopK heap;
+    eliza_memory_topk_init(&heap, results, k);
+
+    /* Gather the posting lists of the query terms */
+    MemoryIndexQuery terms;
+    size_t num_terms = eliza_memory_index_query_init(&terms, store->index, query);
+
+    if (num_terms == 0) {
+        for (size_t i = 0; i < store->size; i++) {
+            if (!store->entries[i]) continue;
+            eliza_memory_topk_offer(&heap, store->entries[i], prior_score(store, options, (uint32_t)i, now));
+        }
+        return eliza_memory_topk_finish(&heap);
+    }
+
+    /* Inverse document frequency of each term */
+    const MemoryIndex* index = store->index;
+    double documents = (double)index->documents;
+    double avg_length = index->documents ? (double)index->total_length / documents : 1.0;
+    if (avg_length <= 0.0) avg_length = 1.0;
+
+    double idf[MEMORY_INDEX_MAX_QUERY_TERMS];
+    for (size_t t = 0; t < terms.num_terms; t++) {
+        double df = (double)terms.postings[t]->size;
+        idf[t] = log(1.0 + (documents - df + 0.5) / (df + 0.5));
+    }
+
+    /* Merge the posting lists one entry at a time */
+    for (;;) {
+        uint32_t id = UINT32_MAX;
+        for (size_t t = 0; t < terms.num_terms; t++) {
+            const MemoryPosting* posting = terms.postings[t];
+            if (terms.positions[t] < posting->size && posting->ids[terms.positions[t]] < id) {
+                id = posting->ids[terms.positions[t]];
+            }
+        }
+        if (id == UINT32_MAX) break;
+
+        double length_norm = options->k1 * (1.0 - options->b +
+                             options->b * eliza_memory_index_length(index, id) / avg_length);
+        double bm25 = 0.0;
+
+        for (size_t t = 0; t < terms.num_terms; t++) {
+            const MemoryPosting* posting = terms.postings[t];
+            size_t pos = terms.positions[t];
+            if (pos >= posting->size || posting->ids[pos] != id) continue;
+
+            double tf = posting->freqs[pos];
+            bm25 += idf[t] * tf * (options->k1 + 1.0) / (tf + length_norm);
+            terms.positions[t]++;
+        }
+
+        /* Postings may name an entry whose add failed part way, or one
+         * removed since */
+        if (id >= store->size || !store->entries[id]) continue;
+
+        float score = options->text_weight * (float)(bm25 / (bm25 + 1.0)) +
+                      prior_score(store, options, id, now);
+        eliza_memory_topk_offer(&heap, store->entries[id], score);
+    }
+
+    return eliza_memory_topk_finish(&heap);
+}
@@ -0,0 +1,509 @@
+#include "../include/memory_segment.h"
+#include "../include/memory_lz.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/*
+ * Implementation of the Memory Segment Format
+ */
+
+/* Buffer size used when writing segment files */
+#define WRITE_BUFFER_SIZE (1 << 20)
+
+/* Records copied into a store per batch when loading */
+#define LOAD_BATCH 4096
+
+/*
+ * Length of an optional string as stored in a record
+ */
+static uint32_t string_length(const char* str) {
+    return str ? (uint32_t)strlen(str) : MEMORY_SEGMENT_NO_STRING;
+}
+
+/*
+ * Start writing a segment file
+ * Strings are streamed straight after the header, the record table is
+ * appended by eliza_memory_segment_writer_finish
+ */
+MemorySegmentWriter* eliza_memory_segment_writer_open(const char* filepath) {
+    if (!filepath) return NULL;
+
+    MemorySegmentWriter* writer = (MemorySegmentWriter*)calloc(1, sizeof(MemorySegmentWriter));
+    if (!writer) return NULL;
+
+    size_t path_len = strlen(filepath);
+    writer->filepath = strdup(filepath);
+    writer->tmp_path = (char*)malloc(path_len + 5);
+    if (!writer->filepath || !writer->tmp_path) {
+        free(writer->filepath);
+        free(writer->tmp_path);
+        free(writer);
+        return NULL;
+    }
+    memcpy(writer->tmp_path, filepath, path_len);
+    memcpy(writer->tmp_path + path_len, ".tmp", 5);
+
+    writer->file = fopen(writer->tmp_path, "wb");
+    if (!writer->file) {
+        free(writer->filepath);
+        free(writer->tmp_path);
+        free(writer);
+        return NULL;
+    }
+    setvbuf(writer->file, NULL, _IOFBF, WRITE_BUFFER_SIZE);
+
+    /* Leave room for the header, written last so a partial file never
+     * looks valid */
+    if (fseek(writer->file, sizeof(MemorySegmentHeader), SEEK_SET) != 0) {
+        writer->failed = 1;
+    }
+
+    return writer;
+}
+
+/*
+ * Start writing a segment file with a compressed heap
+ */
+MemorySegmentWriter* eliza_memory_segment_writer_open_compressed(const char* filepath,
+                                                               uint32_t block_size) {
+    if (block_size == 0) return NULL;
+
+    MemorySegmentWriter* writer = eliza_memory_segment_writer_open(filepath);
+    if (!writer) return NULL;
+
+    writer->block_size = block_size;
+    writer->block = (char*)malloc(block_size);
+    writer->packed = (char*)malloc(eliza_memory_lz_bound(block_size));
+    if (!writer->block || !writer->packed) {
+        eliza_memory_segment_writer_abort(writer);
+        return NULL;
+    }
+    return writer;
+}
+
+/*
+ * Compress and write the block being filled
+ */
+static void flush_block(MemorySegmentWriter* writer) {
+    if (writer->block_used == 0 || writer->failed) return;
+
+    if (writer->block_count >= writer->block_capacity) {
+        size_t capacity = writer->block_capacity ? writer->block_capacity * 2 : 64;
+        uint64_t* ends = (uint64_t*)realloc(writer->block_ends, capacity * sizeof(uint64_t));
+        if (!ends) {
+            writer->failed = 1;
+            return;
+        }
+        writer->block_ends = ends;
+        writer->block_capacity = capacity;
+    }
+
+    size_t packed = eliza_memory_lz_compress(writer->block, writer->block_used, writer->packed,
+                                             eliza_memory_lz_bound(writer->block_size));
+    if (packed == 0 || fwrite(writer->packed, 1, packed, writer->file) != packed) {
+        writer->failed = 1;
+        return;
+    }
+
+    writer->stored_size += packed;
+    writer->block_ends[writer->block_count++] = writer->stored_size;
+    writer->block_used = 0;
+}
+
+/*
+ * Write an optional string to the heap, returning its length
+ */
+static uint32_t write_heap_string(MemorySegmentWriter* writer, const char* str,
+                                  uint64_t* offset) {
+    uint32_t length = string_length(str);
+    *offset = writer->heap_size;
+    if (!str) return length;
+
+    size_t remaining = (size_t)length + 1;
+    writer->heap_size += remaining;
+    if (!writer->block_size) {
+        if (fwrite(str, 1, remaining, writer->file) != remaining) writer->failed = 1;
+        return length;
+    }
+
+    /* Strings may span blocks */
+    while (remaining > 0 && !writer->failed) {
+        size_t take = writer->block_size - writer->block_used;
+        if (take > remaining) take = remaining;
+        memcpy(writer->block + writer->block_used, str, take);
+        writer->block_used += take;
+        str += take;
+        remaining -= take;
+        if (writer->block_used == writer->block_size) flush_block(writer);
+    }
+    return length;
+}
+
+/*
+ * Append an entry to a segment being written
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_segment_writer_add(MemorySegmentWriter* writer, const MemoryEntry* entry) {
+    if (!writer || !entry || !entry->content || writer->failed) return -1;
+
+    if (writer->count >= writer->capacity) {
+        size_t new_capacity = writer->capacity ? writer->capacity * 2 : 1024;
+        MemorySegmentRecord* new_records = (MemorySegmentRecord*)realloc(writer->records,
+                                           new_capacity * sizeof(MemorySegmentRecord));
+        if (!new_records) {
+            writer->failed = 1;
+            return -1;
+        }
+        writer->records = new_records;
+
+        if (writer->ids) {
+            uint64_t* new_ids = (uint64_t*)realloc(writer->ids, new_capacity * sizeof(uint64_t));
+            if (!new_ids) {
+                writer->failed = 1;
+                return -1;
+            }
+            writer->ids = new_ids;
+        }
+        writer->capacity = new_capacity;
+    }
+
+    MemorySegmentRecord* record = &writer->records[writer->count];
+    memset(record, 0, sizeof(*record));
+    record->timestamp = (int64_t)entry->timestamp;
+    record->importance = entry->importance;
+    record->content_length = write_heap_string(writer, entry->content, &record->content_offset);
+    record->context_length = write_heap_string(writer, entry->context, &record->context_offset);
+    record->category_length = write_heap_string(writer, entry->category, &record->category_offset);
+
+    if (writer->failed) return -1;
+    writer->count++;
+    return 0;
+}
+
+/*
+ * Append an entry with its log id
+ * The id table is allocated with the first id, which must come before
+ * any entry without one
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_segment_writer_add_id(MemorySegmentWriter* writer, const MemoryEntry* entry,
+                                     uint64_t id) {
+    if (!writer || writer->failed) return -1;
+
+    if (!writer->ids) {
+        if (writer->count > 0) return -1;
+        writer->ids = (uint64_t*)malloc((writer->capacity ? writer->capacity : 1) * sizeof(uint64_t));
+        if (!writer->ids) {
+            writer->failed = 1;
+            return -1;
+        }
+    }
+
+    if (eliza_memory_segment_writer_add(writer, entry) < 0) return -1;
+    writer->ids[writer->count - 1] = id;
+    return 0;
+}
+
+/*
+ * Free a writer after finishing or aborting
+ */
+static void free_writer(MemorySegmentWriter* writer) {
+    free(writer->ids);
+    free(writer->block);
+    free(writer->packed);
+    free(writer->block_ends);
+    free(writer->records);
+    free(writer->filepath);
+    free(writer->tmp_path);
+    free(writer);
+}
+
+/*
+ * Discard a segment being written
+ */
+void eliza_memory_segment_writer_abort(MemorySegmentWriter* writer) {
+    if (!writer) return;
+
+    fclose(writer->file);
+    remove(writer->tmp_path);
+    free_writer(writer);
+}
+
+/*
+ * Write the record table and header, then rename the file into place
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_segment_writer_finish(MemorySegmentWriter* writer, uint64_t last_lsn) {
+    if (!writer) return -1;
+
+    MemorySegmentHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MEMORY_SEGMENT_MAGIC, sizeof(MEMORY_SEGMENT_MAGIC));
+    header.version = MEMORY_SEGMENT_VERSION;
+    header.byte_order = MEMORY_SEGMENT_BYTE_ORDER;
+    header.count = writer->count;
+    header.heap_offset = sizeof(MemorySegmentHeader);
+    header.heap_size = writer->heap_size;
+    header.record_size = sizeof(MemorySegmentRecord);
+    header.last_lsn = last_lsn;
+    if (writer->ids) header.flags |= MEMORY_SEGMENT_IDS;
+
+    /* A compressed heap ends with its block table and trailer */
+    if (writer->block_size) {
+        flush_block(writer);
+
+        MemorySegmentBlocks blocks;
+        memset(&blocks, 0, sizeof(blocks));
+        blocks.raw_size = writer->heap_size;
+        blocks.block_size = writer->block_size;
+        blocks.block_count = (uint32_t)writer->block_count;
+        if (!writer->failed &&
+            ((writer->block_count &&
+              fwrite(writer->block_ends, sizeof(uint64_t), writer->block_count,
+                     writer->file) != writer->block_count) ||
+             fwrite(&blocks, sizeof(blocks), 1, writer->file) != 1)) {
+            writer->failed = 1;
+        }
+
+        header.version = MEMORY_SEGMENT_VERSION_COMPRESSED;
+        header.flags |= MEMORY_SEGMENT_COMPRESSED;
+        header.heap_size = writer->stored_size + writer->block_count * sizeof(uint64_t) +
+                           sizeof(MemorySegmentBlocks);
+    }
+
+    /* Pad the heap so the record table is 8-byte aligned */
+    static const char padding[8] = { 0 };
+    size_t pad = (size_t)((8 - (header.heap_offset + header.heap_size) % 8) % 8);
+    header.records_offset = header.heap_offset + header.heap_size + pad;
+
+    int ok = !writer->failed &&
+             fwrite(padding, 1, pad, writer->file) == pad &&
+             (!writer->count ||
+              fwrite(writer->records, sizeof(MemorySegmentRecord), writer->count,
+                     writer->file) == writer->count) &&
+             (!writer->ids || !writer->count ||
+              fwrite(writer->ids, sizeof(uint64_t), writer->count, writer->file) == writer->count) &&
+             fseek(writer->file, 0, SEEK_SET) == 0 &&
+             fwrite(&header, sizeof(header), 1, writer->file) == 1 &&
+             fflush(writer->file) == 0 &&
+             fsync(fileno(writer->file)) == 0;
+
+    if (fclose(writer->file) != 0) ok = 0;
+    if (ok && rename(writer->tmp_path, writer->filepath) != 0) ok = 0;
+    if (!ok) remove(writer->tmp_path);
+
+    free_writer(writer);
+    return ok ? 0 : -1;
+}
+
+/*
+ * Write the entries of a store to a segment file
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_segment_write(MemoryStore* store, const char* filepath) {
+    if (!store || !filepath) return -1;
+
+    MemorySegmentWriter* writer = eliza_memory_segment_writer_open(filepath);
+    if (!writer) return -1;
+
+    for (size_t i = 0; i < store->size; i++) {
+        if (!store->entries[i]) continue;
+        if (eliza_memory_segment_writer_add(writer, store->entries[i]) < 0) {
+            eliza_memory_segment_writer_abort(writer);
+            return -1;
+        }
+    }
+
+    return eliza_memory_segment_writer_finish(writer, 0);
+}
+
+/*
+ * Check a header against the size of its file
+ * Returns 1 if it is valid, 0 otherwise
+ */
+int eliza_memory_segment_header_valid(const MemorySegmentHeader* header, uint64_t file_size) {
+    if (!header) return 0;
+
+    int compressed = (header->flags & MEMORY_SEGMENT_COMPRESSED) != 0;
+    size_t row_size = sizeof(MemorySegmentRecord) +
+                      ((header->flags & MEMORY_SEGMENT_IDS) ? sizeof(uint64_t) : 0);
+    return memcmp(header->magic, MEMORY_SEGMENT_MAGIC, sizeof(MEMORY_SEGMENT_MAGIC)) == 0 &&
+           header->version == (compressed ? MEMORY_SEGMENT_VERSION_COMPRESSED : MEMORY_SEGMENT_VERSION) &&
+           header->byte_order == MEMORY_SEGMENT_BYTE_ORDER &&
+           header->record_size == sizeof(MemorySegmentRecord) &&
+           header->records_offset % sizeof(uint64_t) == 0 &&
+           header->records_offset <= file_size &&
+           header->count <= (file_size - header->records_offset) / row_size &&
+           header->heap_offset <= file_size &&
+           header->heap_size <= file_size - header->heap_offset;
+}
+
+/*
+ * Map a segment file and validate its header
+ */
+MemorySegment* eliza_memory_segment_open(const char* filepath) {
+    if (!filepath) return NULL;
+
+    int fd = open(filepath, O_RDONLY);
+    if (fd < 0) return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(MemorySegmentHeader)) {
+        close(fd);
+        return NULL;
+    }
+
+    size_t map_size = (size_t)st.st_size;
+    void* map = mmap(NULL, map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return NULL;
+
+    const MemorySegmentHeader* header = (const MemorySegmentHeader*)map;
+    int valid = eliza_memory_segment_header_valid(header, map_size) &&
+                !(header->flags & MEMORY_SEGMENT_COMPRESSED);
+
+    MemorySegment* segment = valid ? (MemorySegment*)malloc(sizeof(MemorySegment)) : NULL;
+    if (!segment) {
+        munmap(map, map_size);
+        return NULL;
+    }
+
+    segment->map = map;
+    segment->map_size = map_size;
+    segment->header = header;
+    segment->records = (const MemorySegmentRecord*)((const char*)map + header->records_offset);
+    segment->ids = (header->flags & MEMORY_SEGMENT_IDS)
+                 ? (const uint64_t*)(segment->records + header->count) : NULL;
+    segment->heap = (const char*)map + header->heap_offset;
+
+    return segment;
+}
+
+/*
+ * Unmap a segment
+ */
+void eliza_memory_segment_close(MemorySegment* segment) {
+    if (!segment) return;
+
+    munmap(segment->map, segment->map_size);
+    free(segment);
+}
+
+/*
+ * Last write-ahead log record contained in a segment
+ */
+uint64_t eliza_memory_segment_last_lsn(const MemorySegment* segment) {
+    return segment ? segment->header->last_lsn : 0;
+}
+
+/*
+ * Number of entries in a segment
+ */
+size_t eliza_memory_segment_count(const MemorySegment* segment) {
+    return segment ? (size_t)segment->header->count : 0;
+}
+
+/*
+ * Write-ahead log id of a record
+ */
+uint64_t eliza_memory_segment_id(const MemorySegment* segment, size_t index) {
+    if (!segment || !segment->ids || index >= segment->header->count) return 0;
+    return segment->ids[index];
+}
+
+/*
+ * Resolve a heap string, checking it lies inside the heap
+ */
+static int heap_string(const MemorySegment* segment, uint64_t offset,
+                       uint32_t length, char** out) {
+    if (length == MEMORY_SEGMENT_NO_STRING) {
+        *out = NULL;
+        return 0;
+    }
+
+    uint64_t heap_size = segment->header->heap_size;
+    if (offset >= heap_size || length >= heap_size - offset ||
+        segment->heap[offset + length] != '\0') {
+        return -1;
+    }
+
+    *out = (char*)(segment->heap + offset);
+    return 0;
+}
+
+/*
+ * Fill an entry view from a record
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_segment_get(const MemorySegment* segment, size_t index,
+                            MemoryEntry* entry) {
+    if (!segment || !entry || index >= segment->header->count) return -1;
+
+    const MemorySegmentRecord* record = &segment->records[index];
+
+    if (heap_string(segment, record->content_offset, record->content_length, &entry->content) < 0 ||
+        !entry->content ||
+        heap_string(segment, record->context_offset, record->context_length, &entry->context) < 0 ||
+        heap_string(segment, record->category_offset, record->category_length, &entry->category) < 0) {
+        return -1;
+    }
+
+    entry->timestamp = (time_t)record->timestamp;
+    entry->importance = record->importance;
+    return 0;
+}
+
+/*
+ * Copy every entry of a segment into a store
+ * Views of the records go in through eliza_memory_add_batch, so each
+ * batch costs one allocation for its entries and strings and one pass
+ * of the inverted index
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_segment_copy(MemoryStore* store, const MemorySegment* segment) {
+    if (!store || !segment) return -1;
+
+    eliza_memory_clear(store);
+
+    size_t count = eliza_memory_segment_count(segment);
+    if (count == 0) return 0;
+    if (eliza_memory_reserve(store, count) < 0) return -1;
+
+    size_t batch = count < LOAD_BATCH ? count : LOAD_BATCH;
+    MemoryEntry* views = (MemoryEntry*)malloc(batch * sizeof(MemoryEntry));
+    if (!views) return -1;
+
+    int result = 0;
+    for (size_t begin = 0; begin < count && result == 0; begin += batch) {
+        size_t n = count - begin < batch ? count - begin : batch;
+        for (size_t i = 0; i < n && result == 0; i++) {
+            result = eliza_memory_segment_get(segment, begin + i, &views[i]);
+        }
+        if (result == 0) result = eliza_memory_add_batch(store, views, n);
+    }
+
+    free(views);
+    return result;
+}
+
+/*
+ * Check whether a file starts with the segment magic
+ */
+int eliza_memory_segment_probe(const char* filepath) {
+    if (!filepath) return 0;
+
+    FILE* file = fopen(filepath, "rb");
+    if (!file) return 0;
+
+    char magic[8];
+    int match = fread(magic, 1, sizeof(magic), file) == sizeof(magic) &&
+                memcmp(magic, MEMORY_SEGMENT_MAGIC, sizeof(MEMORY_SEGMENT_MAGIC)) == 0;
+
+    fclose(file);
+    return match;
+}
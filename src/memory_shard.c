@@ -0,0 +1,475 @@
+#include "../include/memory_shard.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+
+/*
+ * Implementation of the Sharded Memory Store
+ */
+
+/* Initial conversation slots per partition (must be a power of two) */
+#define INITIAL_PARTITION_CAPACITY 8
+
+/*
+ * Search fanned out over every partition
+ */
+typedef struct MemoryShardFanout {
+    const char* query;
+    size_t max_results;
+    atomic_size_t next;      /* Next partition to claim */
+    MemoryEntry*** partial;  /* Results of each partition, NULL terminated */
+    atomic_int failed;
+} MemoryShardFanout;
+
+/*
+ * FNV-1a hash of a conversation key
+ */
+static uint32_t hash_key(const char* key) {
+    uint32_t hash = 2166136261u;
+    for (const unsigned char* p = (const unsigned char*)key; *p; p++) {
+        hash ^= *p;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/*
+ * Partition holding a hash; the low bits pick the partition, so tables
+ * probe with the bits above them
+ */
+static MemoryShardPartition* partition_for(MemoryShardedStore* store, uint32_t hash) {
+    return &store->partitions[hash & (store->partition_count - 1)];
+}
+
+static size_t home_slot(const MemoryShardedStore* store, uint32_t hash, size_t capacity) {
+    return (hash / store->partition_count) & (capacity - 1);
+}
+
+/*
+ * Find the slot of a key, or the free slot where it belongs
+ */
+static MemoryShard* find_shard(const MemoryShardedStore* store, const MemoryShardPartition* partition,
+                               const char* key, uint32_t hash) {
+    size_t mask = partition->capacity - 1;
+    size_t i = home_slot(store, hash, partition->capacity);
+
+    while (partition->shards[i].key) {
+        if (partition->shards[i].hash == hash && strcmp(partition->shards[i].key, key) == 0) {
+            return &partition->shards[i];
+        }
+        i = (i + 1) & mask;
+    }
+    return &partition->shards[i];
+}
+
+/*
+ * Double a partition table once it is half full
+ * Returns 0 on success, -1 on failure
+ */
+static int grow_partition(const MemoryShardedStore* store, MemoryShardPartition* partition) {
+    size_t new_capacity = partition->capacity * 2;
+    MemoryShard* shards = (MemoryShard*)calloc(new_capacity, sizeof(MemoryShard));
+    if (!shards) return -1;
+
+    for (size_t i = 0; i < partition->capacity; i++) {
+        MemoryShard* old = &partition->shards[i];
+        if (!old->key) continue;
+
+        size_t j = home_slot(store, old->hash, new_capacity);
+        while (shards[j].key) j = (j + 1) & (new_capacity - 1);
+        shards[j] = *old;
+    }
+
+    free(partition->shards);
+    partition->shards = shards;
+    partition->capacity = new_capacity;
+    return 0;
+}
+
+/*
+ * Search every conversation of a partition, up to max_results in total
+ * Returns a NULL terminated array, or NULL on failure
+ */
+static MemoryEntry** search_partition(MemoryShardPartition* partition, const char* query,
+                                      size_t max_results) {
+    MemoryEntry** results = (MemoryEntry**)malloc((max_results + 1) * sizeof(MemoryEntry*));
+    if (!results) return NULL;
+
+    size_t found = 0;
+    pthread_rwlock_rdlock(&partition->lock);
+
+    for (size_t i = 0; i < partition->capacity && found < max_results; i++) {
+        if (!partition->shards[i].key) continue;
+
+        MemoryEntry** matches = eliza_memory_search(partition->shards[i].store, query, max_results - found);
+        if (!matches) {
+            pthread_rwlock_unlock(&partition->lock);
+            free(results);
+            return NULL;
+        }
+        for (size_t j = 0; matches[j]; j++) results[found++] = matches[j];
+        free(matches);
+    }
+
+    pthread_rwlock_unlock(&partition->lock);
+    results[found] = NULL;
+    return results;
+}
+
+/*
+ * Claim and search partitions until none are left
+ */
+static void run_fanout(MemoryShardedStore* store, MemoryShardFanout* fanout) {
+    size_t p;
+    while ((p = atomic_fetch_add(&fanout->next, 1)) < store->partition_count) {
+        fanout->partial[p] = search_partition(&store->partitions[p], fanout->query, fanout->max_results);
+        if (!fanout->partial[p]) atomic_store(&fanout->failed, 1);
+    }
+}
+
+/*
+ * Fan-out worker thread
+ */
+static void* worker_main(void* arg) {
+    MemoryShardedStore* store = (MemoryShardedStore*)arg;
+    uint64_t seen = 0;
+
+    pthread_mutex_lock(&store->pool_lock);
+    for (;;) {
+        while (store->running && store->generation == seen) {
+            pthread_cond_wait(&store->work_cond, &store->pool_lock);
+        }
+        if (!store->running) break;
+
+        seen = store->generation;
+        MemoryShardFanout* fanout = store->fanout;
+        pthread_mutex_unlock(&store->pool_lock);
+
+        run_fanout(store, fanout);
+
+        pthread_mutex_lock(&store->pool_lock);
+        if (--store->busy == 0) pthread_cond_signal(&store->done_cond);
+    }
+    pthread_mutex_unlock(&store->pool_lock);
+    return NULL;
+}
+
+/*
+ * Fill options with defaults
+ */
+void eliza_memory_shard_options_default(MemoryShardOptions* options) {
+    if (!options) return;
+
+    options->partitions = MEMORY_SHARD_DEFAULT_PARTITIONS;
+    options->initial_capacity = 16;
+    options->threads = 0;
+}
+
+/*
+ * Create a sharded store
+ */
+MemoryShardedStore* eliza_memory_sharded_create(const MemoryShardOptions* options) {
+    MemoryShardOptions defaults;
+    if (!options) {
+        eliza_memory_shard_options_default(&defaults);
+        options = &defaults;
+    }
+
+    MemoryShardedStore* store = (MemoryShardedStore*)calloc(1, sizeof(MemoryShardedStore));
+    if (!store) return NULL;
+
+    size_t partitions = 1;
+    while (partitions < options->partitions) partitions *= 2;
+    store->partition_count = partitions;
+    store->initial_capacity = options->initial_capacity ? options->initial_capacity : 16;
+
+    store->partitions = (MemoryShardPartition*)calloc(partitions, sizeof(MemoryShardPartition));
+    if (!store->partitions) {
+        free(store);
+        return NULL;
+    }
+
+    pthread_mutex_init(&store->fanout_lock, NULL);
+    pthread_mutex_init(&store->pool_lock, NULL);
+    pthread_cond_init(&store->work_cond, NULL);
+    pthread_cond_init(&store->done_cond, NULL);
+    store->running = 1;
+
+    for (size_t p = 0; p < partitions; p++) {
+        MemoryShardPartition* partition = &store->partitions[p];
+        partition->shards = (MemoryShard*)calloc(INITIAL_PARTITION_CAPACITY, sizeof(MemoryShard));
+        if (!partition->shards) {
+            store->partition_count = p;
+            eliza_memory_sharded_destroy(store);
+            return NULL;
+        }
+        partition->capacity = INITIAL_PARTITION_CAPACITY;
+        pthread_rwlock_init(&partition->lock, NULL);
+    }
+
+    if (options->threads > 1) {
+        store->workers = (pthread_t*)malloc(options->threads * sizeof(pthread_t));
+        if (!store->workers) {
+            eliza_memory_sharded_destroy(store);
+            return NULL;
+        }
+        for (size_t i = 0; i < options->threads; i++) {
+            if (pthread_create(&store->workers[i], NULL, worker_main, store) != 0) break;
+            store->worker_count++;
+        }
+    }
+
+    return store;
+}
+
+/*
+ * Destroy a sharded store and every conversation in it
+ */
+void eliza_memory_sharded_destroy(MemoryShardedStore* store) {
+    if (!store) return;
+
+    if (store->workers) {
+        pthread_mutex_lock(&store->pool_lock);
+        store->running = 0;
+        pthread_cond_broadcast(&store->work_cond);
+        pthread_mutex_unlock(&store->pool_lock);
+
+        for (size_t i = 0; i < store->worker_count; i++) pthread_join(store->workers[i], NULL);
+        free(store->workers);
+    }
+
+    for (size_t p = 0; p < store->partition_count; p++) {
+        MemoryShardPartition* partition = &store->partitions[p];
+        for (size_t i = 0; i < partition->capacity; i++) {
+            if (!partition->shards[i].key) continue;
+            free(partition->shards[i].key);
+            eliza_memory_destroy(partition->shards[i].store);
+        }
+        free(partition->shards);
+        pthread_rwlock_destroy(&partition->lock);
+    }
+    free(store->partitions);
+
+    pthread_mutex_destroy(&store->fanout_lock);
+    pthread_mutex_destroy(&store->pool_lock);
+    pthread_cond_destroy(&store->work_cond);
+    pthread_cond_destroy(&store->done_cond);
+    free(store);
+}
+
+/*
+ * Add a memory to a conversation, creating it if needed
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_sharded_add(MemoryShardedStore* store, const char* key, const char* content,
+                            float importance, const char* context, const char* category) {
+    if (!store || !key || !content) return -1;
+
+    uint32_t hash = hash_key(key);
+    MemoryShardPartition* partition = partition_for(store, hash);
+    int result = -1;
+
+    pthread_rwlock_wrlock(&partition->lock);
+
+    MemoryShard* shard = find_shard(store, partition, key, hash);
+    if (!shard->key) {
+        if ((partition->count + 1) * 2 > partition->capacity) {
+            if (grow_partition(store, partition) < 0) goto out;
+            shard = find_shard(store, partition, key, hash);
+        }
+
+        MemoryStore* conversation = eliza_memory_create(store->initial_capacity);
+        char* copy = strdup(key);
+        if (!conversation || !copy) {
+            eliza_memory_destroy(conversation);
+            free(copy);
+            goto out;
+        }
+
+        shard->key = copy;
+        shard->hash = hash;
+        shard->store = conversation;
+        partition->count++;
+    }
+
+    result = eliza_memory_add(shard->store, content, importance, context, category);
+
+out:
+    pthread_rwlock_unlock(&partition->lock);
+    return result;
+}
+
+/*
+ * Search one conversation
+ * Returns a NULL terminated array of matching entries, or NULL on failure
+ */
+MemoryEntry** eliza_memory_sharded_search(MemoryShardedStore* store, const char* key,
+                                        const char* query, size_t max_results) {
+    if (!store || !key || !query) return NULL;
+
+    uint32_t hash = hash_key(key);
+    MemoryShardPartition* partition = partition_for(store, hash);
+    MemoryEntry** results;
+
+    pthread_rwlock_rdlock(&partition->lock);
+
+    MemoryShard* shard = find_shard(store, partition, key, hash);
+    if (shard->key) {
+        results = eliza_memory_search(shard->store, query, max_results);
+    } else {
+        results = (MemoryEntry**)malloc(sizeof(MemoryEntry*));
+        if (results) results[0] = NULL;
+    }
+
+    pthread_rwlock_unlock(&partition->lock);
+    return results;
+}
+
+/*
+ * Search every conversation
+ * Returns a NULL terminated array of matching entries, or NULL on failure
+ */
+MemoryEntry** eliza_memory_sharded_search_all(MemoryShardedStore* store, const char* query,
+                                            size_t max_results) {
+    if (!store || !query) return NULL;
+
+    MemoryEntry** results = (MemoryEntry**)malloc((max_results + 1) * sizeof(MemoryEntry*));
+    MemoryEntry*** partial = (MemoryEntry***)calloc(store->partition_count, sizeof(MemoryEntry**));
+    if (!results || !partial) {
+        free(results);
+        free(partial);
+        return NULL;
+    }
+
+    MemoryShardFanout fanout;
+    fanout.query = query;
+    fanout.max_results = max_results;
+    fanout.partial = partial;
+    atomic_init(&fanout.next, 0);
+    atomic_init(&fanout.failed, 0);
+
+    if (store->worker_count > 0) {
+        pthread_mutex_lock(&store->fanout_lock);
+
+        pthread_mutex_lock(&store->pool_lock);
+        store->fanout = &fanout;
+        store->generation++;
+        store->busy = store->worker_count;
+        pthread_cond_broadcast(&store->work_cond);
+        pthread_mutex_unlock(&store->pool_lock);
+
+        /* The caller searches too instead of waiting idle */
+        run_fanout(store, &fanout);
+
+        pthread_mutex_lock(&store->pool_lock);
+        while (store->busy > 0) pthread_cond_wait(&store->done_cond, &store->pool_lock);
+        store->fanout = NULL;
+        pthread_mutex_unlock(&store->pool_lock);
+
+        pthread_mutex_unlock(&store->fanout_lock);
+    } else {
+        run_fanout(store, &fanout);
+    }
+
+    /* Merge in partition order */
+    size_t found = 0;
+    for (size_t p = 0; p < store->partition_count; p++) {
+        if (!partial[p]) continue;
+        for (size_t i = 0; partial[p][i] && found < max_results; i++) results[found++] = partial[p][i];
+        free(partial[p]);
+    }
+    free(partial);
+
+    if (atomic_load(&fanout.failed)) {
+        free(results);
+        return NULL;
+    }
+
+    results[found] = NULL;
+    return results;
+}
+
+/*
+ * Number of entries in one conversation
+ */
+size_t eliza_memory_sharded_count(MemoryShardedStore* store, const char* key) {
+    if (!store || !key) return 0;
+
+    uint32_t hash = hash_key(key);
+    MemoryShardPartition* partition = partition_for(store, hash);
+
+    pthread_rwlock_rdlock(&partition->lock);
+    MemoryShard* shard = find_shard(store, partition, key, hash);
+    size_t count = shard->key ? shard->store->size - shard->store->removed : 0;
+    pthread_rwlock_unlock(&partition->lock);
+
+    return count;
+}
+
+/*
+ * Remove a conversation and destroy its entries
+ * Returns 0 on success, -1 when the conversation does not exist
+ */
+int eliza_memory_sharded_drop(MemoryShardedStore* store, const char* key) {
+    if (!store || !key) return -1;
+
+    uint32_t hash = hash_key(key);
+    MemoryShardPartition* partition = partition_for(store, hash);
+
+    pthread_rwlock_wrlock(&partition->lock);
+
+    MemoryShard* shard = find_shard(store, partition, key, hash);
+    if (!shard->key) {
+        pthread_rwlock_unlock(&partition->lock);
+        return -1;
+    }
+
+    free(shard->key);
+    eliza_memory_destroy(shard->store);
+    shard->key = NULL;
+    shard->store = NULL;
+    partition->count--;
+
+    /* Shift later members of the probe run back so lookups still find them */
+    size_t mask = partition->capacity - 1;
+    size_t hole = (size_t)(shard - partition->shards);
+    for (size_t i = (hole + 1) & mask; partition->shards[i].key; i = (i + 1) & mask) {
+        size_t home = home_slot(store, partition->shards[i].hash, partition->capacity);
+        /* Movable unless its home lies cyclically in (hole, i] */
+        if (((i - home) & mask) >= ((i - hole) & mask)) {
+            partition->shards[hole] = partition->shards[i];
+            partition->shards[i].key = NULL;
+            partition->shards[i].store = NULL;
+            hole = i;
+        }
+    }
+
+    pthread_rwlock_unlock(&partition->lock);
+    return 0;
+}
+
+/*
+ * Collect statistics over all partitions
+ */
+void eliza_memory_sharded_get_stats(MemoryShardedStore* store, MemoryShardStats* stats) {
+    if (!stats) return;
+    memset(stats, 0, sizeof(*stats));
+    if (!store) return;
+
+    for (size_t p = 0; p < store->partition_count; p++) {
+        MemoryShardPartition* partition = &store->partitions[p];
+        pthread_rwlock_rdlock(&partition->lock);
+
+        stats->conversations += partition->count;
+        if (partition->count > stats->busiest_partition) stats->busiest_partition = partition->count;
+
+        for (size_t i = 0; i < partition->capacity; i++) {
+            if (!partition->shards[i].key) continue;
+            size_t entries = partition->shards[i].store->size - partition->shards[i].store->removed;
+            stats->entries += entries;
+            if (entries > stats->largest) stats->largest = entries;
+        }
+
+        pthread_rwlock_unlock(&partition->lock);
+    }
+}
@@ -0,0 +1,471 @@
+#include "../include/memory_snapshot.h"
+#include "../include/memory_arena.h"
+#include "../include/memory_batch.h"
+#include "../include/memory_load.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * Implementation of Memory Snapshots
+ */
+
+/* stdio buffer for snapshot files */
+#define WRITE_BUFFER_SIZE (1 << 20)
+
+/*
+ * Free storage of a MEMORY_RETIRED_* kind
+ */
+static void free_storage(int kind, void* ptr) {
+    switch (kind) {
+    case MEMORY_RETIRED_ARRAY:
+        free(ptr);
+        break;
+    case MEMORY_RETIRED_ENTRY:
+        eliza_memory_entry_destroy((MemoryEntry*)ptr);
+        break;
+    case MEMORY_RETIRED_ARENA:
+        eliza_memory_arena_destroy((MemoryArena*)ptr);
+        break;
+    }
+}
+
+/*
+ * Free a list of retired storage
+ */
+static void free_retired(MemoryRetiredBlock* block) {
+    while (block) {
+        MemoryRetiredBlock* next = block->next;
+        free_storage(block->kind, block->ptr);
+        free(block);
+        block = next;
+    }
+}
+
+/*
+ * Free a snapshot and everything retired to it
+ */
+static void destroy_snapshot(MemorySnapshot* snapshot) {
+    free_retired(snapshot->retired);
+    pthread_mutex_destroy(&snapshot->lock);
+    free(snapshot);
+}
+
+/*
+ * Drop one reference, freeing the snapshot with the last
+ * Called with the snapshot lock held; unlocks it
+ */
+static void unref_locked(MemorySnapshot* snapshot) {
+    int last = --snapshot->refs == 0;
+    pthread_mutex_unlock(&snapshot->lock);
+    if (last) destroy_snapshot(snapshot);
+}
+
+/*
+ * Freeze the entries of a store
+ * Returns a snapshot, or NULL on failure
+ */
+MemorySnapshot* eliza_memory_snapshot(MemoryStore* store) {
+    if (!store || eliza_memory_snapshot_active(store)) return NULL;
+
+    MemorySnapshot* snapshot = (MemorySnapshot*)calloc(1, sizeof(MemorySnapshot));
+    if (!snapshot) return NULL;
+
+    pthread_mutex_init(&snapshot->lock, NULL);
+    snapshot->entries = store->entries;
+    snapshot->size = store->size;
+    snapshot->refs = 2;
+
+    store->snapshot = snapshot;
+    return snapshot;
+}
+
+/*
+ * Mark a snapshot released, adding its copy-on-write counters to stats
+ * Nothing is retired to a released snapshot, so the storage retired so
+ * far is freed here rather than by the store's next write
+ */
+static void finish_snapshot(MemorySnapshot* snapshot, MemorySaverStats* stats) {
+    pthread_mutex_lock(&snapshot->lock);
+    if (stats) {
+        stats->array_copies += snapshot->array_copies;
+        stats->entry_copies += snapshot->entry_copies;
+        stats->deferred += snapshot->deferred;
+    }
+    snapshot->released = 1;
+    MemoryRetiredBlock* retired = snapshot->retired;
+    snapshot->retired = NULL;
+    unref_locked(snapshot);
+
+    free_retired(retired);
+}
+
+/*
+ * Let go of a snapshot
+ */
+void eliza_memory_snapshot_release(MemorySnapshot* snapshot) {
+    if (snapshot) finish_snapshot(snapshot, NULL);
+}
+
+/*
+ * Number of live entries in a snapshot
+ */
+size_t eliza_memory_snapshot_count(const MemorySnapshot* snapshot) {
+    if (!snapshot) return 0;
+
+    size_t count = 0;
+    for (size_t i = 0; i < snapshot->size; i++) {
+        if (snapshot->entries[i]) count++;
+    }
+    return count;
+}
+
+/*
+ * The store's snapshot if it is still held
+ */
+MemorySnapshot* eliza_memory_snapshot_active(MemoryStore* store) {
+    MemorySnapshot* snapshot = store->snapshot;
+    if (!snapshot) return NULL;
+
+    pthread_mutex_lock(&snapshot->lock);
+    if (!snapshot->released) {
+        pthread_mutex_unlock(&snapshot->lock);
+        return snapshot;
+    }
+
+    /* The holder is done: nothing the store does is visible any more */
+    store->snapshot = NULL;
+    unref_locked(snapshot);
+    return NULL;
+}
+
+/*
+ * Free storage the store no longer uses, or hand it to the snapshot
+ */
+void eliza_memory_snapshot_retire(MemoryStore* store, int kind, void* ptr) {
+    if (!ptr) return;
+
+    MemorySnapshot* snapshot = eliza_memory_snapshot_active(store);
+    if (!snapshot) {
+        free_storage(kind, ptr);
+        return;
+    }
+
+    /* Leaking beats freeing storage the snapshot may still read */
+    MemoryRetiredBlock* block = (MemoryRetiredBlock*)malloc(sizeof(MemoryRetiredBlock));
+    if (!block) return;
+    block->kind = kind;
+    block->ptr = ptr;
+
+    pthread_mutex_lock(&snapshot->lock);
+    block->next = snapshot->retired;
+    snapshot->retired = block;
+    snapshot->deferred++;
+    pthread_mutex_unlock(&snapshot->lock);
+}
+
+/*
+ * Move the store to a private entry array if it shares one
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_snapshot_unshare(MemoryStore* store, size_t capacity) {
+    MemorySnapshot* snapshot = eliza_memory_snapshot_active(store);
+    if (!snapshot || snapshot->entries != store->entries) return 0;
+
+    if (capacity < store->capacity) capacity = store->capacity;
+    MemoryEntry** entries = (MemoryEntry**)malloc((capacity ? capacity : 1) * sizeof(MemoryEntry*));
+    if (!entries) return -1;
+    memcpy(entries, store->entries, store->size * sizeof(MemoryEntry*));
+
+    pthread_mutex_lock(&snapshot->lock);
+    snapshot->array_copies++;
+    pthread_mutex_unlock(&snapshot->lock);
+
+    /* May finish the snapshot, so it is not touched afterwards */
+    eliza_memory_snapshot_retire(store, MEMORY_RETIRED_ARRAY, store->entries);
+    store->entries = entries;
+    store->capacity = capacity;
+    return 0;
+}
+
+/*
+ * Hand everything a snapshot may read to it before the store goes away
+ */
+void eliza_memory_snapshot_detach(MemoryStore* store) {
+    if (!eliza_memory_snapshot_active(store)) return;
+
+    if (!store->arena) eliza_memory_batch_release_all(store);
+    eliza_memory_snapshot_retire(store, MEMORY_RETIRED_ARENA, store->arena);
+    eliza_memory_snapshot_retire(store, MEMORY_RETIRED_ARRAY, store->entries);
+
+    store->entries = NULL;
+    store->arena = NULL;
+    store->size = 0;
+    store->removed = 0;
+
+    /* Drop the store's reference unless the holder finished meanwhile */
+    MemorySnapshot* snapshot = eliza_memory_snapshot_active(store);
+    if (!snapshot) return;
+    pthread_mutex_lock(&snapshot->lock);
+    store->snapshot = NULL;
+    unref_locked(snapshot);
+}
+
+/*
+ * Write a text field on one line; backslashes and line breaks are escaped
+ * so that a value cannot end its line or start a new entry
+ */
+static void write_field(FILE* file, const char* key, const char* value) {
+    fputs(key, file);
+    for (const char* p = value ? value : ""; *p; p++) {
+        switch (*p) {
+            case '\\': fputs("\\\\", file); break;
+            case '\n': fputs("\\n", file); break;
+            case '\r': fputs("\\r", file); break;
+            default: putc(*p, file); break;
+        }
+    }
+    putc('\n', file);
+}
+
+/*
+ * Write the header of the text format
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_write_text_header(FILE* file, size_t count) {
+    fprintf(file, "ELIZA_MEMORY_STORE\n");
+    fprintf(file, "SIZE:%zu\n", count);
+    fprintf(file, "FORMAT:%d\n", MEMORY_TEXT_FORMAT);
+    return ferror(file) ? -1 : 0;
+}
+
+/*
+ * Write one entry in the text format
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_write_text_entry(FILE* file, const MemoryEntry* entry) {
+    fprintf(file, "---ENTRY---\n");
+    write_field(file, "CONTENT:", entry->content);
+    fprintf(file, "TIMESTAMP:%ld\n", (long)entry->timestamp);
+    fprintf(file, "IMPORTANCE:%.9g\n", entry->importance);
+    write_field(file, "CONTEXT:", entry->context);
+    write_field(file, "CATEGORY:", entry->category);
+    return ferror(file) ? -1 : 0;
+}
+
+/*
+ * Write entries in the text format
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_write_text(FILE* file, MemoryEntry* const* entries, size_t count) {
+    size_t live = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (entries[i]) live++;
+    }
+
+    eliza_memory_write_text_header(file, live);
+    for (size_t i = 0; i < count; i++) {
+        if (entries[i]) eliza_memory_write_text_entry(file, entries[i]);
+    }
+    return ferror(file) ? -1 : 0;
+}
+
+/*
+ * Write a snapshot to a file
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_snapshot_save(const MemorySnapshot* snapshot, const char* filepath, uint64_t* bytes) {
+    if (!snapshot || !filepath) return -1;
+
+    size_t path_len = strlen(filepath);
+    char* tmp_path = (char*)malloc(path_len + 5);
+    if (!tmp_path) return -1;
+    memcpy(tmp_path, filepath, path_len);
+    memcpy(tmp_path + path_len, ".tmp", 5);
+
+    FILE* file = fopen(tmp_path, "w");
+    if (!file) {
+        free(tmp_path);
+        return -1;
+    }
+    setvbuf(file, NULL, _IOFBF, WRITE_BUFFER_SIZE);
+
+    int ok = eliza_memory_write_text(file, snapshot->entries, snapshot->size) == 0 &&
+             fflush(file) == 0;
+    long written = ok ? ftell(file) : -1;
+    ok = ok && written >= 0 && fsync(fileno(file)) == 0;
+
+    if (fclose(file) != 0) ok = 0;
+    if (ok && rename(tmp_path, filepath) != 0) ok = 0;
+    if (!ok) remove(tmp_path);
+
+    free(tmp_path);
+    if (ok && bytes) *bytes = (uint64_t)written;
+    return ok ? 0 : -1;
+}
+
+static double elapsed_ms(const struct timespec* start, const struct timespec* end) {
+    return (double)(end->tv_sec - start->tv_sec) * 1e3 + (double)(end->tv_nsec - start->tv_nsec) / 1e6;
+}
+
+/*
+ * Saver thread: write queued snapshots until stopped
+ */
+static void* saver_main(void* arg) {
+    MemorySaver* saver = (MemorySaver*)arg;
+
+    pthread_mutex_lock(&saver->lock);
+    for (;;) {
+        while (saver->running && !saver->pending) {
+            pthread_cond_wait(&saver->work_cond, &saver->lock);
+        }
+        if (!saver->pending) break;
+
+        MemorySnapshot* snapshot = saver->pending;
+        char* path = saver->path;
+        saver->pending = NULL;
+        saver->path = NULL;
+        pthread_mutex_unlock(&saver->lock);
+
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        uint64_t bytes = 0;
+        size_t entries = eliza_memory_snapshot_count(snapshot);
+        int result = eliza_memory_snapshot_save(snapshot, path, &bytes);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        free(path);
+
+        pthread_mutex_lock(&saver->lock);
+        MemorySaverStats* stats = &saver->stats;
+        double duration = elapsed_ms(&start, &end);
+        if (result == 0) {
+            stats->saves++;
+            stats->bytes_written += bytes;
+            stats->last_bytes = bytes;
+            stats->last_entries = entries;
+        } else {
+            stats->failures++;
+        }
+        stats->last_duration_ms = duration;
+        stats->total_duration_ms += duration;
+        if (duration > stats->max_duration_ms) stats->max_duration_ms = duration;
+
+        /* Count the copy-on-write work in the same step that ends it */
+        finish_snapshot(snapshot, stats);
+
+        saver->result = result;
+        saver->busy = 0;
+        pthread_cond_broadcast(&saver->idle_cond);
+    }
+    pthread_mutex_unlock(&saver->lock);
+    return NULL;
+}
+
+/*
+ * Start a saver thread for a store
+ */
+MemorySaver* eliza_memory_saver_create(MemoryStore* store) {
+    /* Snapshots would leave out the cold tier */
+    if (!store || store->tier) return NULL;
+
+    MemorySaver* saver = (MemorySaver*)calloc(1, sizeof(MemorySaver));
+    if (!saver) return NULL;
+
+    saver->store = store;
+    saver->running = 1;
+    pthread_mutex_init(&saver->lock, NULL);
+    pthread_cond_init(&saver->work_cond, NULL);
+    pthread_cond_init(&saver->idle_cond, NULL);
+
+    if (pthread_create(&saver->thread, NULL, saver_main, saver) != 0) {
+        pthread_mutex_destroy(&saver->lock);
+        pthread_cond_destroy(&saver->work_cond);
+        pthread_cond_destroy(&saver->idle_cond);
+        free(saver);
+        return NULL;
+    }
+    return saver;
+}
+
+/*
+ * Wait for a running save, then stop the thread
+ */
+void eliza_memory_saver_destroy(MemorySaver* saver) {
+    if (!saver) return;
+
+    pthread_mutex_lock(&saver->lock);
+    saver->running = 0;
+    pthread_cond_signal(&saver->work_cond);
+    pthread_mutex_unlock(&saver->lock);
+    pthread_join(saver->thread, NULL);
+
+    pthread_mutex_destroy(&saver->lock);
+    pthread_cond_destroy(&saver->work_cond);
+    pthread_cond_destroy(&saver->idle_cond);
+    free(saver);
+}
+
+/*
+ * Snapshot the store and write it in the background
+ * Returns 0 once queued, -1 on failure
+ */
+int eliza_memory_saver_save(MemorySaver* saver, const char* filepath) {
+    if (!saver || !filepath || saver->store->tier) return -1;
+
+    pthread_mutex_lock(&saver->lock);
+    if (saver->busy) {
+        saver->stats.busy++;
+        pthread_mutex_unlock(&saver->lock);
+        return -1;
+    }
+    pthread_mutex_unlock(&saver->lock);
+
+    char* path = strdup(filepath);
+    if (!path) return -1;
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    MemorySnapshot* snapshot = eliza_memory_snapshot(saver->store);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    if (!snapshot) {
+        free(path);
+        return -1;
+    }
+
+    pthread_mutex_lock(&saver->lock);
+    saver->stats.last_freeze_us = elapsed_ms(&start, &end) * 1e3;
+    saver->pending = snapshot;
+    saver->path = path;
+    saver->busy = 1;
+    pthread_cond_signal(&saver->work_cond);
+    pthread_mutex_unlock(&saver->lock);
+    return 0;
+}
+
+/*
+ * Block until no save is running
+ * Returns the result of the last save
+ */
+int eliza_memory_saver_wait(MemorySaver* saver) {
+    if (!saver) return -1;
+
+    pthread_mutex_lock(&saver->lock);
+    while (saver->busy) pthread_cond_wait(&saver->idle_cond, &saver->lock);
+    int result = saver->result;
+    pthread_mutex_unlock(&saver->lock);
+    return result;
+}
+
+/*
+ * Copy the current statistics
+ */
+void eliza_memory_saver_get_stats(MemorySaver* saver, MemorySaverStats* stats) {
+    if (!stats) return;
+    memset(stats, 0, sizeof(*stats));
+    if (!saver) return;
+
+    pthread_mutex_lock(&saver->lock);
+    *stats = saver->stats;
+    pthread_mutex_unlock(&saver->lock);
+}
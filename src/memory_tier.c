@@ -0,0 +1,708 @@
+#include "../include/memory_tier.h"
+#include "../include/memory_arena.h"
+#include "../include/memory_lz.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+/* Largest block size accepted from a compressed segment */
+#define MAX_BLOCK_SIZE (16u * 1024 * 1024)
+
+/*
+ * Implementation of Tiered Memory
+ */
+
+/*
+ * Fill tier options with defaults
+ */
+void eliza_memory_tier_options_default(MemoryTierOptions* options) {
+    if (!options) return;
+
+    options->directory = NULL;
+    options->max_hot_entries = 100000;
+    options->hot_age = 3600.0;
+    options->hot_importance = 0.8f;
+    options->cache_bytes = 16 * 1024 * 1024;
+    options->block_size = MEMORY_CACHE_BLOCK_SIZE;
+    options->compress = 1;
+    options->resident = 0;
+}
+
+/*
+ * Read exactly length bytes at offset
+ * Returns 0 on success, -1 on failure
+ */
+static int read_full(int fd, void* out, size_t length, uint64_t offset) {
+    char* p = (char*)out;
+    while (length > 0) {
+        ssize_t n = pread(fd, p, length, (off_t)offset);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        p += n;
+        offset += (uint64_t)n;
+        length -= (size_t)n;
+    }
+    return 0;
+}
+
+/*
+ * Grow a tier buffer to size bytes
+ * Returns 0 on success, -1 on failure
+ */
+static int reserve_buffer(char** buffer, size_t* capacity, size_t size) {
+    if (size <= *capacity) return 0;
+
+    char* grown = (char*)realloc(*buffer, size);
+    if (!grown) return -1;
+    *buffer = grown;
+    *capacity = size;
+    return 0;
+}
+
+static inline uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/*
+ * Decode compressed block index of a segment into out
+ * Returns its size, or -1 on failure
+ */
+static long decode_block(MemoryColdSegment* cold, uint64_t index, char* out, size_t capacity) {
+    MemoryTier* tier = cold->tier;
+    if (index >= cold->blocks.block_count) return -1;
+
+    uint64_t start = index ? cold->block_ends[index - 1] : 0;
+    size_t packed_size = (size_t)(cold->block_ends[index] - start);
+    uint64_t raw_start = index * cold->blocks.block_size;
+    size_t expected = cold->blocks.block_size;
+    if (cold->heap_size - raw_start < expected) expected = (size_t)(cold->heap_size - raw_start);
+    if (expected > capacity) return -1;
+
+    const char* packed;
+    if (cold->resident) {
+        packed = cold->resident + start;
+    } else {
+        if (reserve_buffer(&tier->packed, &tier->packed_capacity, packed_size ? packed_size : 1) < 0 ||
+            read_full(cold->fd, tier->packed, packed_size, cold->header.heap_offset + start) < 0) {
+            return -1;
+        }
+        packed = tier->packed;
+    }
+
+    uint64_t began = now_ns();
+    long decoded = eliza_memory_lz_decompress(packed, packed_size, out, expected);
+    tier->stats.decode_ns += now_ns() - began;
+    if (decoded != (long)expected) return -1;
+
+    tier->stats.blocks_decoded++;
+    tier->stats.decoded_bytes += (uint64_t)decoded;
+    return decoded;
+}
+
+/*
+ * Cache fill function for cold segments
+ * Cache blocks are blocks of the uncompressed heap. They line up with
+ * the compressed blocks unless the tier's block size was changed after
+ * the segment was written; then each one is assembled from the decoded
+ * blocks it overlaps.
+ */
+static long fill_block(void* source, uint64_t block, char* out, size_t capacity) {
+    MemoryColdSegment* cold = (MemoryColdSegment*)source;
+    uint64_t start = block * capacity;
+    if (start >= cold->heap_size) return 0;
+
+    size_t length = capacity;
+    if (cold->heap_size - start < length) length = (size_t)(cold->heap_size - start);
+
+    if (!cold->block_ends) {
+        return read_full(cold->fd, out, length, cold->header.heap_offset + start) < 0 ? -1 : (long)length;
+    }
+
+    uint32_t block_size = cold->blocks.block_size;
+    if (block_size == capacity) return decode_block(cold, block, out, capacity);
+
+    MemoryTier* tier = cold->tier;
+    if (reserve_buffer(&tier->decoded, &tier->decoded_capacity, block_size) < 0) return -1;
+    for (uint64_t at = start; at < start + length;) {
+        uint64_t index = at / block_size;
+        size_t within = (size_t)(at - index * block_size);
+        long decoded = decode_block(cold, index, tier->decoded, block_size);
+        if (decoded < 0 || (size_t)decoded <= within) return -1;
+
+        size_t take = (size_t)decoded - within;
+        if (take > start + length - at) take = (size_t)(start + length - at);
+        memcpy(out + (at - start), tier->decoded + within, take);
+        at += take;
+    }
+    return (long)length;
+}
+
+static void free_segment(MemoryColdSegment* cold) {
+    if (cold->fd >= 0) close(cold->fd);
+    free(cold->records);
+    free(cold->block_ends);
+    free(cold->resident);
+    free(cold);
+}
+
+static void close_segment(MemoryTier* tier, MemoryColdSegment* cold) {
+    eliza_memory_cache_drop(tier->cache, cold);
+    free_segment(cold);
+}
+
+/*
+ * Read and check the block table of a compressed heap
+ * Returns 0 on success, -1 on failure
+ */
+static int open_blocks(MemoryTier* tier, MemoryColdSegment* cold) {
+    uint64_t heap_size = cold->header.heap_size;
+    uint64_t heap_offset = cold->header.heap_offset;
+    MemorySegmentBlocks* blocks = &cold->blocks;
+    if (heap_size < sizeof(MemorySegmentBlocks) ||
+        read_full(cold->fd, blocks, sizeof(*blocks), heap_offset + heap_size - sizeof(*blocks)) < 0) {
+        return -1;
+    }
+
+    uint64_t table = (uint64_t)blocks->block_count * sizeof(uint64_t);
+    if (blocks->block_size == 0 || blocks->block_size > MAX_BLOCK_SIZE ||
+        table > heap_size - sizeof(*blocks) ||
+        blocks->raw_size > (uint64_t)blocks->block_count * blocks->block_size ||
+        (blocks->block_count > 0 &&
+         blocks->raw_size <= (uint64_t)(blocks->block_count - 1) * blocks->block_size)) {
+        return -1;
+    }
+
+    uint64_t stored = heap_size - sizeof(*blocks) - table;
+    cold->block_ends = (uint64_t*)malloc(table ? (size_t)table : 1);
+    if (!cold->block_ends ||
+        read_full(cold->fd, cold->block_ends, (size_t)table, heap_offset + stored) < 0) {
+        return -1;
+    }
+
+    /* Compressed blocks are never larger than their bound */
+    uint64_t previous = 0;
+    for (uint32_t i = 0; i < blocks->block_count; i++) {
+        uint64_t end = cold->block_ends[i];
+        if (end < previous || end > stored ||
+            end - previous > eliza_memory_lz_bound(blocks->block_size)) {
+            return -1;
+        }
+        previous = end;
+    }
+
+    cold->heap_size = blocks->raw_size;
+    if (tier->options.resident) {
+        cold->resident = (char*)malloc(previous ? (size_t)previous : 1);
+        if (!cold->resident || read_full(cold->fd, cold->resident, (size_t)previous, heap_offset) < 0) {
+            return -1;
+        }
+        tier->stats.resident_bytes += previous;
+    }
+    return 0;
+}
+
+/*
+ * Open a cold segment and append it to the tier
+ * Returns 0 on success, -1 on failure
+ */
+static int open_segment(MemoryTier* tier, const char* path, uint32_t number) {
+    if (tier->segment_count >= tier->segment_capacity) {
+        size_t capacity = tier->segment_capacity ? tier->segment_capacity * 2 : 8;
+        MemoryColdSegment** segments = (MemoryColdSegment**)realloc(tier->segments,
+                                       capacity * sizeof(MemoryColdSegment*));
+        if (!segments) return -1;
+        tier->segments = segments;
+        tier->segment_capacity = capacity;
+    }
+
+    MemoryColdSegment* cold = (MemoryColdSegment*)calloc(1, sizeof(MemoryColdSegment));
+    if (!cold) return -1;
+
+    cold->number = number;
+    cold->tier = tier;
+    cold->fd = open(path, O_RDONLY);
+    if (cold->fd < 0) {
+        free(cold);
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(cold->fd, &st) != 0 || (uint64_t)st.st_size < sizeof(MemorySegmentHeader) ||
+        read_full(cold->fd, &cold->header, sizeof(cold->header), 0) < 0 ||
+        !eliza_memory_segment_header_valid(&cold->header, (uint64_t)st.st_size)) {
+        free_segment(cold);
+        return -1;
+    }
+
+    cold->heap_size = cold->header.heap_size;
+    uint64_t resident_before = tier->stats.resident_bytes;
+    if ((cold->header.flags & MEMORY_SEGMENT_COMPRESSED) && open_blocks(tier, cold) < 0) {
+        tier->stats.resident_bytes = resident_before;
+        free_segment(cold);
+        return -1;
+    }
+
+    size_t table = (size_t)cold->header.count * sizeof(MemorySegmentRecord);
+    cold->records = (MemorySegmentRecord*)malloc(table ? table : 1);
+    if (!cold->records || read_full(cold->fd, cold->records, table, cold->header.records_offset) < 0) {
+        tier->stats.resident_bytes = resident_before;
+        free_segment(cold);
+        return -1;
+    }
+
+    tier->segments[tier->segment_count++] = cold;
+    tier->stats.cold_entries += (size_t)cold->header.count;
+    tier->stats.raw_bytes += cold->heap_size;
+    tier->stats.stored_bytes += cold->header.heap_size;
+    if (number >= tier->next_number) tier->next_number = number + 1;
+    return 0;
+}
+
+/*
+ * Path of the segment with a sequence number, or NULL on failure
+ */
+static char* segment_path(const MemoryTier* tier, uint32_t number) {
+    size_t size = strlen(tier->directory) + sizeof(MEMORY_TIER_SEGMENT_PREFIX) + 16;
+    char* path = (char*)malloc(size);
+    if (path) {
+        snprintf(path, size, "%s/%s%06u.seg", tier->directory, MEMORY_TIER_SEGMENT_PREFIX, number);
+    }
+    return path;
+}
+
+static int compare_numbers(const void* a, const void* b) {
+    uint32_t x = *(const uint32_t*)a;
+    uint32_t y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+/*
+ * Open the segments already in the directory, oldest first
+ * Leftover temporary files of interrupted migrations are ignored
+ * Returns 0 on success, -1 on failure
+ */
+static int open_directory(MemoryTier* tier) {
+    DIR* dir = opendir(tier->directory);
+    if (!dir) return -1;
+
+    uint32_t* numbers = NULL;
+    size_t count = 0;
+    size_t capacity = 0;
+    int result = 0;
+    struct dirent* item;
+
+    while ((item = readdir(dir)) != NULL) {
+        unsigned int number;
+        int end = 0;
+        if (sscanf(item->d_name, MEMORY_TIER_SEGMENT_PREFIX "%u.seg%n", &number, &end) != 1 ||
+            end == 0 || item->d_name[end] != '\0') {
+            continue;
+        }
+
+        if (count >= capacity) {
+            capacity = capacity ? capacity * 2 : 16;
+            uint32_t* grown = (uint32_t*)realloc(numbers, capacity * sizeof(uint32_t));
+            if (!grown) {
+                result = -1;
+                break;
+            }
+            numbers = grown;
+        }
+        numbers[count++] = (uint32_t)number;
+    }
+    closedir(dir);
+
+    if (result == 0 && count > 1) qsort(numbers, count, sizeof(uint32_t), compare_numbers);
+    for (size_t i = 0; result == 0 && i < count; i++) {
+        char* path = segment_path(tier, numbers[i]);
+        if (!path || open_segment(tier, path, numbers[i]) < 0) result = -1;
+        free(path);
+    }
+
+    free(numbers);
+    return result;
+}
+
+/*
+ * Destroy tier state
+ */
+void eliza_memory_tier_destroy(MemoryTier* tier) {
+    if (!tier) return;
+
+    for (size_t i = 0; i < tier->segment_count; i++) {
+        close_segment(tier, tier->segments[i]);
+    }
+    free(tier->segments);
+    eliza_memory_cache_destroy(tier->cache);
+    free(tier->scratch);
+    free(tier->packed);
+    free(tier->decoded);
+    free(tier->directory);
+    free(tier);
+}
+
+/*
+ * Turn on tiering for a store
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_enable_tier(MemoryStore* store, const MemoryTierOptions* options) {
+    if (!store || !options || !options->directory || store->tier) return -1;
+
+    if (mkdir(options->directory, 0755) != 0 && errno != EEXIST) return -1;
+
+    MemoryTier* tier = (MemoryTier*)calloc(1, sizeof(MemoryTier));
+    if (!tier) return -1;
+
+    tier->options = *options;
+    if (tier->options.block_size == 0) tier->options.block_size = MEMORY_CACHE_BLOCK_SIZE;
+    tier->directory = strdup(options->directory);
+    tier->options.directory = tier->directory;
+    tier->cache = eliza_memory_cache_create(tier->options.block_size, tier->options.cache_bytes);
+    if (!tier->directory || !tier->cache || open_directory(tier) < 0) {
+        eliza_memory_tier_destroy(tier);
+        return -1;
+    }
+
+    store->tier = tier;
+    return 0;
+}
+
+/*
+ * Whether an entry should move to the cold tier
+ */
+static int is_cold(const MemoryTier* tier, const MemoryEntry* entry, time_t now) {
+    return entry && entry->importance < tier->options.hot_importance &&
+           difftime(now, entry->timestamp) >= tier->options.hot_age;
+}
+
+/*
+ * Cut the newest segment down to its first moved records after a failed
+ * migration, so entries still in RAM are not in both tiers
+ * The shorter count is written to the file as well; if that fails, the
+ * next open sees the whole segment again
+ */
+static void keep_moved(MemoryTier* tier, const char* path, size_t moved) {
+    MemoryColdSegment* cold = tier->segments[tier->segment_count - 1];
+    tier->stats.cold_entries -= (size_t)cold->header.count - moved;
+
+    if (moved == 0) {
+        tier->stats.raw_bytes -= cold->heap_size;
+        tier->stats.stored_bytes -= cold->header.heap_size;
+        if (cold->resident && cold->blocks.block_count > 0) {
+            tier->stats.resident_bytes -= cold->block_ends[cold->blocks.block_count - 1];
+        }
+        tier->segment_count--;
+        tier->next_number = cold->number;
+        close_segment(tier, cold);
+        remove(path);
+        return;
+    }
+
+    cold->header.count = moved;
+    int fd = open(path, O_WRONLY);
+    if (fd < 0) return;
+    if (pwrite(fd, &cold->header, sizeof(cold->header), 0) == (ssize_t)sizeof(cold->header)) fsync(fd);
+    close(fd);
+}
+
+/*
+ * Move cold entries to a new segment if there are at least minimum
+ * The segment is complete on disk before any entry leaves RAM, and a
+ * failure cuts it back to the entries that did, so every entry stays in
+ * exactly one tier
+ * Returns the number of entries moved, -1 on failure
+ */
+static long migrate(MemoryStore* store, size_t minimum) {
+    MemoryTier* tier = store->tier;
+    time_t now = time(NULL);
+
+    size_t count = 0;
+    for (size_t i = 0; i < store->size; i++) {
+        if (is_cold(tier, store->entries[i], now)) count++;
+    }
+    if (count == 0 || count < minimum) return 0;
+
+    uint32_t number = tier->next_number;
+    char* path = segment_path(tier, number);
+    MemorySegmentWriter* writer = NULL;
+    if (path) {
+        writer = tier->options.compress
+               ? eliza_memory_segment_writer_open_compressed(path, (uint32_t)tier->options.block_size)
+               : eliza_memory_segment_writer_open(path);
+    }
+    if (!writer) {
+        free(path);
+        return -1;
+    }
+
+    for (size_t i = 0; i < store->size; i++) {
+        if (!is_cold(tier, store->entries[i], now)) continue;
+        if (eliza_memory_segment_writer_add(writer, store->entries[i]) < 0) {
+            eliza_memory_segment_writer_abort(writer);
+            free(path);
+            return -1;
+        }
+    }
+
+    if (eliza_memory_segment_writer_finish(writer, 0) < 0) {
+        free(path);
+        return -1;
+    }
+    if (open_segment(tier, path, number) < 0) {
+        /* Unreadable, so it must not be picked up on the next open either */
+        remove(path);
+        free(path);
+        return -1;
+    }
+
+    /* A removal may compact the store, which closes every gap and leaves
+     * the entries kept so far at the front. Entries leave in the order
+     * they were written, so after a failure the segment keeps exactly
+     * those already removed. */
+    size_t kept = 0;
+    size_t moved = 0;
+    size_t i = 0;
+    while (i < store->size) {
+        if (!is_cold(tier, store->entries[i], now)) {
+            if (store->entries[i]) kept++;
+            i++;
+            continue;
+        }
+        if (eliza_memory_remove(store, i) < 0) {
+            keep_moved(tier, path, moved);
+            free(path);
+            return -1;
+        }
+        moved++;
+        i = store->removed == 0 ? kept : i + 1;
+    }
+    free(path);
+
+    tier->stats.migrations++;
+    tier->stats.migrated += count;
+    return (long)count;
+}
+
+/*
+ * Move every cold entry to a new segment
+ * Returns the number of entries moved, -1 on failure
+ */
+long eliza_memory_tier_migrate(MemoryStore* store) {
+    if (!store || !store->tier) return -1;
+
+    return migrate(store, 1);
+}
+
+/*
+ * Migrate once the hot tier is over its limit
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_tier_check(MemoryStore* store) {
+    if (!store || !store->tier) return 0;
+
+    MemoryTier* tier = store->tier;
+    size_t hot = store->size - store->removed;
+    if (hot <= tier->options.max_hot_entries || hot < tier->next_check) return 0;
+
+    /* Migrating in batches of an eighth of the limit keeps segments from
+     * being written for a handful of entries, and entries too recent or
+     * important to move from being rescanned on every add */
+    size_t batch = tier->options.max_hot_entries / 8 + 1;
+    long moved = migrate(store, batch);
+    tier->next_check = store->size - store->removed + batch;
+    return moved < 0 ? -1 : 0;
+}
+
+/*
+ * Make room for size bytes of scratch
+ */
+static int reserve_scratch(MemoryTier* tier, size_t size) {
+    if (size <= tier->scratch_capacity) return 0;
+
+    size_t capacity = tier->scratch_capacity ? tier->scratch_capacity : 256;
+    while (capacity < size) capacity *= 2;
+    char* scratch = (char*)realloc(tier->scratch, capacity);
+    if (!scratch) return -1;
+    tier->scratch = scratch;
+    tier->scratch_capacity = capacity;
+    return 0;
+}
+
+/*
+ * Bytes of scratch a heap string takes, 0 for an absent one
+ */
+static size_t string_bytes(uint32_t length) {
+    return length == MEMORY_SEGMENT_NO_STRING ? 0 : (size_t)length + 1;
+}
+
+/*
+ * Read a heap string into scratch at position, checking it lies inside
+ * the heap and is terminated
+ * Returns 0 on success, -1 on failure
+ */
+static int read_string(MemoryTier* tier, MemoryColdSegment* cold, uint64_t offset,
+                       uint32_t length, size_t position) {
+    if (length == MEMORY_SEGMENT_NO_STRING) return 0;
+
+    if (offset >= cold->heap_size || length >= cold->heap_size - offset) return -1;
+
+    char* out = tier->scratch + position;
+    if (eliza_memory_cache_read(tier->cache, cold, offset, out, (size_t)length + 1, fill_block) < 0 ||
+        out[length] != '\0') {
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Read the content of a record into the start of scratch
+ * Returns 0 on success, -1 on failure
+ */
+static int read_content(MemoryTier* tier, MemoryColdSegment* cold, const MemorySegmentRecord* rec) {
+    if (rec->content_length == MEMORY_SEGMENT_NO_STRING ||
+        reserve_scratch(tier, (size_t)rec->content_length + 1) < 0) {
+        return -1;
+    }
+    return read_string(tier, cold, rec->content_offset, rec->content_length, 0);
+}
+
+/*
+ * Read the rest of a record whose content is in scratch, and point entry
+ * at its fields
+ * Returns 0 on success, -1 on failure
+ */
+static int read_fields(MemoryTier* tier, MemoryColdSegment* cold, const MemorySegmentRecord* rec,
+                       MemoryEntry* entry) {
+    size_t context_at = (size_t)rec->content_length + 1;
+    size_t category_at = context_at + string_bytes(rec->context_length);
+    if (reserve_scratch(tier, category_at + string_bytes(rec->category_length)) < 0 ||
+        read_string(tier, cold, rec->context_offset, rec->context_length, context_at) < 0 ||
+        read_string(tier, cold, rec->category_offset, rec->category_length, category_at) < 0) {
+        return -1;
+    }
+
+    entry->content = tier->scratch;
+    entry->timestamp = (time_t)rec->timestamp;
+    entry->importance = rec->importance;
+    entry->context = rec->context_length == MEMORY_SEGMENT_NO_STRING ? NULL : tier->scratch + context_at;
+    entry->category = rec->category_length == MEMORY_SEGMENT_NO_STRING ? NULL : tier->scratch + category_at;
+    return 0;
+}
+
+/*
+ * Find the next matching cold record
+ * Segments are visited newest first, records in the order written, which
+ * reads each segment's heap front to back
+ * The match is decoded into the caller's arena
+ */
+const MemoryEntry* eliza_memory_tier_next_match(MemoryTier* tier, const MemoryMatcher* matcher,
+                                              struct MemoryArena* arena, size_t* segment, size_t* record) {
+    if (!tier || !matcher || !arena || !segment || !record) return NULL;
+
+    while (*segment < tier->segment_count) {
+        MemoryColdSegment* cold = tier->segments[tier->segment_count - 1 - *segment];
+
+        while (*record < cold->header.count) {
+            const MemorySegmentRecord* rec = &cold->records[(*record)++];
+            tier->stats.cold_scanned++;
+
+            /* Corrupt records are skipped rather than ending the search */
+            MemoryEntry fields;
+            if (read_content(tier, cold, rec) < 0 ||
+                !eliza_memory_matcher_contains(matcher, tier->scratch) ||
+                read_fields(tier, cold, rec, &fields) < 0) {
+                continue;
+            }
+
+            MemoryEntry* entry = eliza_memory_arena_entry(arena, fields.content, fields.importance,
+                                                          fields.context, fields.category);
+            if (!entry) return NULL;
+
+            entry->timestamp = fields.timestamp;
+            tier->stats.cold_matches++;
+            return entry;
+        }
+
+        (*segment)++;
+        *record = 0;
+    }
+    return NULL;
+}
+
+/*
+ * Visit every cold entry, oldest segment first
+ * Returns 0 on success, -1 if a record cannot be read or visit fails
+ */
+int eliza_memory_tier_each(MemoryTier* tier, int (*visit)(const MemoryEntry* entry, void* arg), void* arg) {
+    if (!tier || !visit) return -1;
+
+    for (size_t i = 0; i < tier->segment_count; i++) {
+        MemoryColdSegment* cold = tier->segments[i];
+        for (uint32_t j = 0; j < cold->header.count; j++) {
+            const MemorySegmentRecord* rec = &cold->records[j];
+            MemoryEntry entry;
+            if (read_content(tier, cold, rec) < 0 || read_fields(tier, cold, rec, &entry) < 0 ||
+                visit(&entry, arg) < 0) {
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+/*
+ * Close every cold segment and delete its file
+ */
+void eliza_memory_tier_clear(MemoryTier* tier) {
+    if (!tier) return;
+
+    for (size_t i = 0; i < tier->segment_count; i++) {
+        MemoryColdSegment* cold = tier->segments[i];
+        char* path = segment_path(tier, cold->number);
+        if (path) remove(path);
+        free(path);
+        close_segment(tier, cold);
+    }
+    tier->segment_count = 0;
+    tier->stats.cold_entries = 0;
+    tier->stats.raw_bytes = 0;
+    tier->stats.stored_bytes = 0;
+    tier->stats.resident_bytes = 0;
+}
+
+/*
+ * Total number of cold entries
+ */
+size_t eliza_memory_tier_count(const MemoryTier* tier) {
+    return tier ? tier->stats.cold_entries : 0;
+}
+
+/*
+ * Collect tier statistics
+ */
+void eliza_memory_tier_get_stats(const MemoryStore* store, MemoryTierStats* stats) {
+    if (!stats) return;
+    memset(stats, 0, sizeof(*stats));
+    if (!store) return;
+
+    stats->hot_entries = store->size - store->removed;
+    if (!store->tier) return;
+
+    const MemoryTier* tier = store->tier;
+    *stats = tier->stats;
+    stats->hot_entries = store->size - store->removed;
+    stats->segments = tier->segment_count;
+    eliza_memory_cache_get_stats(tier->cache, &stats->cache);
+
+    uint64_t requests = stats->cache.hits + stats->cache.misses;
+    stats->hit_rate = requests ? (double)stats->cache.hits / (double)requests : 0.0;
+    stats->compression_ratio = stats->stored_bytes ? (double)stats->raw_bytes / (double)stats->stored_bytes : 0.0;
+    stats->decode_mb_per_s = stats->decode_ns ? (double)stats->decoded_bytes * 1e3 / (double)stats->decode_ns : 0.0;
+}
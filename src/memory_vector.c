@@ -0,0 +1,517 @@
+#include "../include/memory_vector.h"
+#include "../include/memory_segment.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86_KERNELS 1
+#endif
+
+/*
+ * Implementation of the Memory Vectors
+ */
+
+/* Buffer size used when writing vector files */
+#define WRITE_BUFFER_SIZE (1 << 20)
+
+/* Kernels computing the dot product of a float query with one row */
+typedef float (*DotKernelF32)(const float* query, const float* row, size_t dim);
+typedef float (*DotKernelI8)(const float* query, const int8_t* row, size_t dim);
+
+/*
+ * Size in bytes of one row
+ */
+static size_t row_size(const MemoryVectors* vectors) {
+    return vectors->dim * (vectors->format == MEMORY_VECTOR_INT8 ? sizeof(int8_t) : sizeof(float));
+}
+
+/*
+ * Scale a vector to unit length
+ * Zero vectors stay zero and therefore never match anything
+ */
+void eliza_memory_vector_normalize(float* vector, size_t dim) {
+    double sum = 0.0;
+    for (size_t i = 0; i < dim; i++) sum += (double)vector[i] * vector[i];
+    if (sum <= 0.0) return;
+
+    float inv = (float)(1.0 / sqrt(sum));
+    for (size_t i = 0; i < dim; i++) vector[i] *= inv;
+}
+
+/*
+ * Store a normalized vector as row i
+ * Int8 rows map the largest component to +-127
+ */
+static void store_row(MemoryVectors* vectors, size_t i, const float* vector) {
+    if (vectors->format == MEMORY_VECTOR_FLOAT32) {
+        memcpy((float*)vectors->rows + i * vectors->dim, vector, vectors->dim * sizeof(float));
+        return;
+    }
+
+    float max_abs = 0.0f;
+    for (size_t d = 0; d < vectors->dim; d++) {
+        float v = fabsf(vector[d]);
+        if (v > max_abs) max_abs = v;
+    }
+
+    int8_t* row = (int8_t*)vectors->rows + i * vectors->dim;
+    float scale = max_abs / 127.0f;
+    vectors->scales[i] = scale;
+
+    for (size_t d = 0; d < vectors->dim; d++) {
+        row[d] = scale > 0.0f ? (int8_t)lrintf(vector[d] / scale) : 0;
+    }
+}
+
+/*
+ * Build the vectors of a store
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_enable_vectors(MemoryStore* store, size_t dim, MemoryVectorFormat format,
+                               MemoryEmbedFn embed, void* user_data) {
+    if (!store || dim == 0 || dim > MEMORY_VECTOR_MAX_DIM) return -1;
+    if (format != MEMORY_VECTOR_FLOAT32 && format != MEMORY_VECTOR_INT8) return -1;
+    if (store->vectors) return -1;
+    if (eliza_memory_compact(store) < 0) return -1;
+
+    MemoryVectors* vectors = (MemoryVectors*)calloc(1, sizeof(MemoryVectors));
+    if (!vectors) return -1;
+
+    vectors->dim = dim;
+    vectors->format = format;
+    vectors->embed = embed;
+    vectors->user_data = user_data;
+    vectors->scratch = (float*)malloc(dim * sizeof(float));
+
+    if (!vectors->scratch ||
+        eliza_memory_vectors_reserve(vectors, store->capacity > 0 ? store->capacity : 16) < 0) {
+        eliza_memory_vectors_destroy(vectors);
+        return -1;
+    }
+
+    for (size_t i = 0; i < store->size; i++) {
+        if (eliza_memory_vectors_append(vectors, store->entries[i]->content, NULL) < 0) {
+            eliza_memory_vectors_destroy(vectors);
+            return -1;
+        }
+    }
+
+    store->vectors = vectors;
+    return 0;
+}
+
+/*
+ * Destroy a set of vectors
+ */
+void eliza_memory_vectors_destroy(MemoryVectors* vectors) {
+    if (!vectors) return;
+
+    free(vectors->rows);
+    free(vectors->scales);
+    free(vectors->scratch);
+    free(vectors);
+}
+
+/*
+ * Make room for capacity rows
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_vectors_reserve(MemoryVectors* vectors, size_t capacity) {
+    if (!vectors) return -1;
+    if (capacity <= vectors->capacity) return 0;
+
+    void* new_rows = realloc(vectors->rows, capacity * row_size(vectors));
+    if (!new_rows) return -1;
+    vectors->rows = new_rows;
+
+    if (vectors->format == MEMORY_VECTOR_INT8) {
+        float* new_scales = (float*)realloc(vectors->scales, capacity * sizeof(float));
+        if (!new_scales) return -1;
+        vectors->scales = new_scales;
+    }
+
+    vectors->capacity = capacity;
+    return 0;
+}
+
+/*
+ * Append the row of an entry
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_vectors_append(MemoryVectors* vectors, const char* content,
+                               const float* vector) {
+    if (!vectors || vectors->size >= vectors->capacity) return -1;
+
+    float* scratch = vectors->scratch;
+    if (vector) {
+        memcpy(scratch, vector, vectors->dim * sizeof(float));
+    } else if (!vectors->embed || !content ||
+               vectors->embed(content, scratch, vectors->dim, vectors->user_data) != 0) {
+        /* An entry without an embedding is still worth keeping */
+        if (vectors->embed) vectors->embed_failures++;
+        memset(scratch, 0, vectors->dim * sizeof(float));
+    }
+
+    eliza_memory_vector_normalize(scratch, vectors->dim);
+    store_row(vectors, vectors->size++, scratch);
+    return 0;
+}
+
+/*
+ * Remove all rows
+ */
+void eliza_memory_vectors_clear(MemoryVectors* vectors) {
+    if (!vectors) return;
+    vectors->size = 0;
+}
+
+/*
+ * Drop the rows from size on
+ */
+void eliza_memory_vectors_truncate(MemoryVectors* vectors, size_t size) {
+    if (!vectors || size >= vectors->size) return;
+    vectors->size = size;
+}
+
+/*
+ * Drop the rows of removed entries, keeping the others in order
+ */
+void eliza_memory_vectors_remap(MemoryVectors* vectors, const uint32_t* map, size_t count) {
+    if (!vectors) return;
+
+    size_t size = row_size(vectors);
+    char* rows = (char*)vectors->rows;
+    size_t kept = 0;
+
+    for (size_t i = 0; i < count && i < vectors->size; i++) {
+        if (map[i] == MEMORY_ID_REMOVED) continue;
+        if (kept != i) {
+            memcpy(rows + kept * size, rows + i * size, size);
+            if (vectors->scales) vectors->scales[kept] = vectors->scales[i];
+        }
+        kept++;
+    }
+    vectors->size = kept;
+}
+
+/*
+ * Read the row at position back as floats
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_vectors_get(const MemoryVectors* vectors, size_t position, float* out) {
+    if (!vectors || !out || position >= vectors->size) return -1;
+
+    if (vectors->format == MEMORY_VECTOR_FLOAT32) {
+        memcpy(out, (const float*)vectors->rows + position * vectors->dim,
+               vectors->dim * sizeof(float));
+        return 0;
+    }
+
+    const int8_t* row = (const int8_t*)vectors->rows + position * vectors->dim;
+    float scale = vectors->scales[position];
+    for (size_t d = 0; d < vectors->dim; d++) out[d] = scale * (float)row[d];
+    return 0;
+}
+
+/*
+ * Replace the row of the entry at position
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_vectors_set(MemoryStore* store, size_t position, const float* vector) {
+    if (!store || !store->vectors || !vector) return -1;
+
+    MemoryVectors* vectors = store->vectors;
+    if (position >= vectors->size) return -1;
+
+    memcpy(vectors->scratch, vector, vectors->dim * sizeof(float));
+    eliza_memory_vector_normalize(vectors->scratch, vectors->dim);
+    store_row(vectors, position, vectors->scratch);
+    return 0;
+}
+
+/*
+ * Portable kernels
+ */
+static float dot_f32_scalar(const float* query, const float* row, size_t dim) {
+    float sum = 0.0f;
+    for (size_t i = 0; i < dim; i++) sum += query[i] * row[i];
+    return sum;
+}
+
+static float dot_i8_scalar(const float* query, const int8_t* row, size_t dim) {
+    float sum = 0.0f;
+    for (size_t i = 0; i < dim; i++) sum += query[i] * (float)row[i];
+    return sum;
+}
+
+#ifdef HAVE_X86_KERNELS
+/*
+ * Sum the lanes of an AVX register
+ */
+__attribute__((target("avx2")))
+static float hsum_avx2(__m256 v) {
+    __m128 low = _mm256_castps256_ps128(v);
+    __m128 high = _mm256_extractf128_ps(v, 1);
+    low = _mm_add_ps(low, high);
+    low = _mm_add_ps(low, _mm_movehl_ps(low, low));
+    low = _mm_add_ss(low, _mm_shuffle_ps(low, low, 1));
+    return _mm_cvtss_f32(low);
+}
+
+/*
+ * AVX2 kernels, 16 floats or 8 int8 values per step
+ */
+__attribute__((target("avx2,fma")))
+static float dot_f32_avx2(const float* query, const float* row, size_t dim) {
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    size_t i = 0;
+
+    for (; i + 16 <= dim; i += 16) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(query + i), _mm256_loadu_ps(row + i), acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(query + i + 8), _mm256_loadu_ps(row + i + 8), acc1);
+    }
+    for (; i + 8 <= dim; i += 8) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(query + i), _mm256_loadu_ps(row + i), acc0);
+    }
+
+    float sum = hsum_avx2(_mm256_add_ps(acc0, acc1));
+    for (; i < dim; i++) sum += query[i] * row[i];
+    return sum;
+}
+
+__attribute__((target("avx2,fma")))
+static float dot_i8_avx2(const float* query, const int8_t* row, size_t dim) {
+    __m256 acc = _mm256_setzero_ps();
+    size_t i = 0;
+
+    for (; i + 8 <= dim; i += 8) {
+        __m128i bytes = _mm_loadl_epi64((const __m128i*)(row + i));
+        __m256 values = _mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(bytes));
+        acc = _mm256_fmadd_ps(_mm256_loadu_ps(query + i), values, acc);
+    }
+
+    float sum = hsum_avx2(acc);
+    for (; i < dim; i++) sum += query[i] * (float)row[i];
+    return sum;
+}
+
+/*
+ * AVX-512 kernels, 16 values per step
+ */
+__attribute__((target("avx512f")))
+static float dot_f32_avx512(const float* query, const float* row, size_t dim) {
+    __m512 acc = _mm512_setzero_ps();
+    size_t i = 0;
+
+    for (; i + 16 <= dim; i += 16) {
+        acc = _mm512_fmadd_ps(_mm512_loadu_ps(query + i), _mm512_loadu_ps(row + i), acc);
+    }
+
+    float sum = _mm512_reduce_add_ps(acc);
+    for (; i < dim; i++) sum += query[i] * row[i];
+    return sum;
+}
+
+__attribute__((target("avx512f")))
+static float dot_i8_avx512(const float* query, const int8_t* row, size_t dim) {
+    __m512 acc = _mm512_setzero_ps();
+    size_t i = 0;
+
+    for (; i + 16 <= dim; i += 16) {
+        __m128i bytes = _mm_loadu_si128((const __m128i*)(row + i));
+        __m512 values = _mm512_cvtepi32_ps(_mm512_cvtepi8_epi32(bytes));
+        acc = _mm512_fmadd_ps(_mm512_loadu_ps(query + i), values, acc);
+    }
+
+    float sum = _mm512_reduce_add_ps(acc);
+    for (; i < dim; i++) sum += query[i] * (float)row[i];
+    return sum;
+}
+#endif
+
+/*
+ * Pick the widest kernels the CPU supports
+ */
+static void select_kernels(DotKernelF32* f32, DotKernelI8* i8) {
+    *f32 = dot_f32_scalar;
+    *i8 = dot_i8_scalar;
+#ifdef HAVE_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        *f32 = dot_f32_avx512;
+        *i8 = dot_i8_avx512;
+    } else if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        *f32 = dot_f32_avx2;
+        *i8 = dot_i8_avx2;
+    }
+#endif
+}
+
+/*
+ * The fastest float dot product kernel
+ */
+MemoryDotFn eliza_memory_vector_dot_kernel(void) {
+    DotKernelF32 f32;
+    DotKernelI8 i8;
+    select_kernels(&f32, &i8);
+    return f32;
+}
+
+/*
+ * Find the rows most similar to a query vector
+ */
+size_t eliza_memory_search_similar(MemoryStore* store, const float* query,
+                                  MemoryRankedResult* results, size_t k) {
+    if (!store || !store->vectors || !query || !results || k == 0) return 0;
+
+    MemoryVectors* vectors = store->vectors;
+    size_t dim = vectors->dim;
+
+    float* unit = (float*)malloc(dim * sizeof(float));
+    if (!unit) return 0;
+    memcpy(unit, query, dim * sizeof(float));
+    eliza_memory_vector_normalize(unit, dim);
+
+    DotKernelF32 dot_f32;
+    DotKernelI8 dot_i8;
+    select_kernels(&dot_f32, &dot_i8);
+
+    MemoryTopK heap;
+    eliza_memory_topk_init(&heap, results, k);
+
+    /* Rows may run ahead of entries while an add fails part way */
+    size_t rows = vectors->size < store->size ? vectors->size : store->size;
+
+    if (vectors->format == MEMORY_VECTOR_INT8) {
+        const int8_t* row = (const int8_t*)vectors->rows;
+        for (size_t i = 0; i < rows; i++, row += dim) {
+            if (!store->entries[i]) continue;
+            float score = vectors->scales[i] * dot_i8(unit, row, dim);
+            eliza_memory_topk_offer(&heap, store->entries[i], score);
+        }
+    } else {
+        const float* row = (const float*)vectors->rows;
+        for (size_t i = 0; i < rows; i++, row += dim) {
+            if (!store->entries[i]) continue;
+            eliza_memory_topk_offer(&heap, store->entries[i], dot_f32(unit, row, dim));
+        }
+    }
+
+    free(unit);
+    return eliza_memory_topk_finish(&heap);
+}
+
+/*
+ * Embed a query and find the rows most similar to it
+ */
+size_t eliza_memory_search_similar_text(MemoryStore* store, const char* text,
+                                       MemoryRankedResult* results, size_t k) {
+    if (!store || !store->vectors || !store->vectors->embed || !text) return 0;
+
+    MemoryVectors* vectors = store->vectors;
+    float* query = (float*)malloc(vectors->dim * sizeof(float));
+    if (!query) return 0;
+
+    size_t found = 0;
+    if (vectors->embed(text, query, vectors->dim, vectors->user_data) == 0) {
+        found = eliza_memory_search_similar(store, query, results, k);
+    }
+
+    free(query);
+    return found;
+}
+
+/*
+ * Write the rows of a store to a vector file
+ * The file is written under a temporary name and renamed into place
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_vectors_save(MemoryStore* store, const char* filepath) {
+    if (!store || !store->vectors || !filepath) return -1;
+
+    MemoryVectors* vectors = store->vectors;
+    size_t count = vectors->size < store->size ? vectors->size : store->size;
+
+    size_t path_len = strlen(filepath);
+    char* tmp_path = (char*)malloc(path_len + 5);
+    if (!tmp_path) return -1;
+    memcpy(tmp_path, filepath, path_len);
+    memcpy(tmp_path + path_len, ".tmp", 5);
+
+    FILE* file = fopen(tmp_path, "wb");
+    if (!file) {
+        free(tmp_path);
+        return -1;
+    }
+    setvbuf(file, NULL, _IOFBF, WRITE_BUFFER_SIZE);
+
+    MemoryVectorHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MEMORY_VECTOR_MAGIC, sizeof(MEMORY_VECTOR_MAGIC));
+    header.version = MEMORY_VECTOR_VERSION;
+    header.byte_order = MEMORY_SEGMENT_BYTE_ORDER;
+    header.count = count;
+    header.dim = (uint32_t)vectors->dim;
+    header.format = (uint32_t)vectors->format;
+
+    int ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    if (ok && vectors->format == MEMORY_VECTOR_INT8) {
+        ok = fwrite(vectors->scales, sizeof(float), count, file) == count;
+    }
+    ok = ok && fwrite(vectors->rows, row_size(vectors), count, file) == count &&
+         fflush(file) == 0 &&
+         fsync(fileno(file)) == 0;
+
+    if (fclose(file) != 0) ok = 0;
+    if (ok && rename(tmp_path, filepath) != 0) ok = 0;
+    if (!ok) remove(tmp_path);
+
+    free(tmp_path);
+    return ok ? 0 : -1;
+}
+
+/*
+ * Read the rows of a store from a vector file
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_vectors_load(MemoryStore* store, const char* filepath) {
+    if (!store || !store->vectors || !filepath) return -1;
+
+    MemoryVectors* vectors = store->vectors;
+    FILE* file = fopen(filepath, "rb");
+    if (!file) return -1;
+
+    MemoryVectorHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1 ||
+        memcmp(header.magic, MEMORY_VECTOR_MAGIC, sizeof(MEMORY_VECTOR_MAGIC)) != 0 ||
+        header.version != MEMORY_VECTOR_VERSION ||
+        header.byte_order != MEMORY_SEGMENT_BYTE_ORDER ||
+        header.count != store->size ||
+        header.dim != vectors->dim ||
+        header.format != (uint32_t)vectors->format) {
+        fclose(file);
+        return -1;
+    }
+
+    size_t count = (size_t)header.count;
+    if (eliza_memory_vectors_reserve(vectors, count) < 0) {
+        fclose(file);
+        return -1;
+    }
+
+    int ok = 1;
+    if (vectors->format == MEMORY_VECTOR_INT8) {
+        ok = fread(vectors->scales, sizeof(float), count, file) == count;
+    }
+    ok = ok && fread(vectors->rows, row_size(vectors), count, file) == count;
+    fclose(file);
+
+    /* A short file leaves the previous rows in an unknown state */
+    vectors->size = ok ? count : 0;
+    return ok ? 0 : -1;
+}
@@ -0,0 +1,997 @@
+#include "../include/memory_wal.h"
+#include "../include/memory_segment.h"
+#include "../include/memory_dedup.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/*
+ * Implementation of the Memory Write-Ahead Log
+ */
+
+/* Log file header */
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+} WalFileHeader;
+
+/* Fixed part of a frame payload. Add frames follow it with the three
+ * strings each with a NUL terminator (absent strings take no space),
+ * remove and update frames with the uint64_t id of their entry, and
+ * clear frames with nothing. */
+typedef struct {
+    uint32_t type;
+    uint32_t content_length;
+    uint32_t context_length;
+    uint32_t category_length;
+    uint64_t lsn;
+    int64_t timestamp;
+    float importance;
+    uint32_t reserved;
+} WalRecord;
+
+/* Every frame starts with the payload length and its CRC-32 */
+#define FRAME_HEADER_SIZE (2 * sizeof(uint32_t))
+
+/* Oldest log version still replayed; version 1 logs only hold adds */
+#define WAL_MIN_VERSION 1
+
+/*
+ * Replayed entry
+ * Strings point into the mapped snapshot or log
+ */
+typedef struct {
+    MemoryEntry entry;
+    uint64_t id;             /* Sequence number of the frame that added it */
+    int live;
+} WalItem;
+
+/*
+ * Replay state structure
+ * The entries of a snapshot and a log with every frame applied, in the
+ * order they were added, plus a hash table finding them by id
+ */
+typedef struct {
+    MemorySegment* snapshot;
+    void* log;               /* Mapping of the log, or NULL */
+    size_t log_size;
+    WalItem* items;
+    size_t count;
+    size_t capacity;
+    size_t* slots;           /* Item index + 1 by id, 0 when empty */
+    size_t slot_capacity;    /* Always a power of two */
+    uint64_t last_lsn;       /* Last frame folded into the snapshot */
+    uint64_t max_lsn;        /* Highest sequence number or id seen */
+    off_t valid_len;         /* Length of the intact prefix of the log */
+    long applied;            /* Log frames applied */
+} WalReplay;
+
+/* CRC-32 lookup table, built once */
+static uint32_t crc_table[256];
+static pthread_once_t crc_table_once = PTHREAD_ONCE_INIT;
+
+static void build_crc_table(void) {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        crc_table[i] = c;
+    }
+}
+
+/*
+ * CRC-32 (IEEE 802.3) of a buffer
+ */
+static uint32_t crc32(const void* data, size_t len) {
+    pthread_once(&crc_table_once, build_crc_table);
+
+    const unsigned char* p = (const unsigned char*)data;
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < len; i++) {
+        crc = crc_table[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+/*
+ * Fill options with defaults
+ */
+void eliza_memory_wal_options_default(MemoryWalOptions* options) {
+    if (!options) return;
+
+    options->sync_interval_ms = 10;
+    options->sync_batch = 256;
+    options->compact_bytes = 64u << 20;
+    options->compact_interval_ms = 10u * 60u * 1000u;
+}
+
+/*
+ * Build "<base><suffix>"
+ */
+static char* path_with_suffix(const char* base, const char* suffix) {
+    size_t base_len = strlen(base);
+    size_t suffix_len = strlen(suffix);
+    char* path = (char*)malloc(base_len + suffix_len + 1);
+    if (!path) return NULL;
+
+    memcpy(path, base, base_len);
+    memcpy(path + base_len, suffix, suffix_len + 1);
+    return path;
+}
+
+/*
+ * Space taken by an optional string in a frame
+ */
+static size_t frame_string_space(const char* str) {
+    return str ? strlen(str) + 1 : 0;
+}
+
+/*
+ * Append one encoded frame to the pending buffer
+ * entry gives the strings of an add and the fields of an update, target
+ * the entry a remove or update applies to
+ * Must be called with the lock held
+ */
+static int encode_frame(MemoryWal* wal, uint32_t type, const MemoryEntry* entry,
+                        uint64_t target, uint64_t lsn) {
+    size_t payload_len = sizeof(WalRecord);
+    if (type == MEMORY_WAL_RECORD_ADD) {
+        payload_len += frame_string_space(entry->content) + frame_string_space(entry->context) +
+                       frame_string_space(entry->category);
+    } else if (type != MEMORY_WAL_RECORD_CLEAR) {
+        payload_len += sizeof(uint64_t);
+    }
+    size_t frame_len = FRAME_HEADER_SIZE + payload_len;
+
+    if (wal->pending_len + frame_len > wal->pending_capacity) {
+        size_t new_capacity = wal->pending_capacity ? wal->pending_capacity : 4096;
+        while (new_capacity < wal->pending_len + frame_len) new_capacity *= 2;
+
+        char* new_pending = (char*)realloc(wal->pending, new_capacity);
+        if (!new_pending) return -1;
+        wal->pending = new_pending;
+        wal->pending_capacity = new_capacity;
+    }
+
+    char* frame = wal->pending + wal->pending_len;
+    char* payload = frame + FRAME_HEADER_SIZE;
+
+    WalRecord record;
+    memset(&record, 0, sizeof(record));
+    record.type = type;
+    record.lsn = lsn;
+    record.content_length = MEMORY_SEGMENT_NO_STRING;
+    record.context_length = MEMORY_SEGMENT_NO_STRING;
+    record.category_length = MEMORY_SEGMENT_NO_STRING;
+    if (entry) {
+        record.timestamp = (int64_t)entry->timestamp;
+        record.importance = entry->importance;
+    }
+
+    char* cursor = payload + sizeof(record);
+    if (type == MEMORY_WAL_RECORD_ADD) {
+        record.content_length = (uint32_t)strlen(entry->content);
+        record.context_length = entry->context ? (uint32_t)strlen(entry->context) : MEMORY_SEGMENT_NO_STRING;
+        record.category_length = entry->category ? (uint32_t)strlen(entry->category) : MEMORY_SEGMENT_NO_STRING;
+
+        const char* strings[3] = { entry->content, entry->context, entry->category };
+        for (int i = 0; i < 3; i++) {
+            size_t space = frame_string_space(strings[i]);
+            if (space) memcpy(cursor, strings[i], space);
+            cursor += space;
+        }
+    } else if (type != MEMORY_WAL_RECORD_CLEAR) {
+        memcpy(cursor, &target, sizeof(target));
+    }
+    memcpy(payload, &record, sizeof(record));
+
+    uint32_t header[2] = { (uint32_t)payload_len, crc32(payload, payload_len) };
+    memcpy(frame, header, sizeof(header));
+
+    wal->pending_len += frame_len;
+    return 0;
+}
+
+/*
+ * Resolve one string of a frame, checking its terminator
+ */
+static const char* frame_string(const char** cursor, const char* end, uint32_t length) {
+    if (length == MEMORY_SEGMENT_NO_STRING) return NULL;
+
+    const char* str = *cursor;
+    if (str > end || (size_t)(end - str) <= length || str[length] != '\0') {
+        *cursor = end + 1;
+        return NULL;
+    }
+    *cursor = str + length + 1;
+    return str;
+}
+
+/*
+ * Item added under an id, or NULL
+ */
+static WalItem* replay_find(WalReplay* replay, uint64_t id) {
+    if (replay->slot_capacity == 0) return NULL;
+
+    size_t mask = replay->slot_capacity - 1;
+    for (size_t i = (size_t)(id * 0x9E3779B97F4A7C15ull) & mask; replay->slots[i]; i = (i + 1) & mask) {
+        WalItem* item = &replay->items[replay->slots[i] - 1];
+        if (item->id == id) return item;
+    }
+    return NULL;
+}
+
+/*
+ * Point the slot of an id at an item
+ */
+static void replay_link(WalReplay* replay, uint64_t id, size_t item) {
+    size_t mask = replay->slot_capacity - 1;
+    size_t i = (size_t)(id * 0x9E3779B97F4A7C15ull) & mask;
+    while (replay->slots[i] && replay->items[replay->slots[i] - 1].id != id) i = (i + 1) & mask;
+    replay->slots[i] = item + 1;
+}
+
+/*
+ * Add an entry under an id
+ * Returns 0 on success, -1 on failure
+ */
+static int replay_add(WalReplay* replay, uint64_t id, const MemoryEntry* view) {
+    if (replay->count >= replay->capacity) {
+        size_t capacity = replay->capacity ? replay->capacity * 2 : 1024;
+        WalItem* items = (WalItem*)realloc(replay->items, capacity * sizeof(WalItem));
+        if (!items) return -1;
+        replay->items = items;
+        replay->capacity = capacity;
+    }
+
+    /* Keep the table at most half full */
+    if ((replay->count + 1) * 2 > replay->slot_capacity) {
+        size_t capacity = replay->slot_capacity ? replay->slot_capacity * 2 : 2048;
+        size_t* slots = (size_t*)calloc(capacity, sizeof(size_t));
+        if (!slots) return -1;
+        free(replay->slots);
+        replay->slots = slots;
+        replay->slot_capacity = capacity;
+        for (size_t i = 0; i < replay->count; i++) replay_link(replay, replay->items[i].id, i);
+    }
+
+    WalItem* item = &replay->items[replay->count];
+    item->entry = *view;
+    item->id = id;
+    item->live = 1;
+    replay_link(replay, id, replay->count++);
+    if (id > replay->max_lsn) replay->max_lsn = id;
+    return 0;
+}
+
+/*
+ * Apply one decoded frame
+ * Removes and updates of entries no longer known are ignored
+ * Returns 0 on success, -1 on failure
+ */
+static int replay_apply(WalReplay* replay, const WalRecord* record, const MemoryEntry* view,
+                        uint64_t target) {
+    WalItem* item;
+    switch (record->type) {
+    case MEMORY_WAL_RECORD_ADD:
+        return replay_add(replay, record->lsn, view);
+    case MEMORY_WAL_RECORD_REMOVE:
+        if ((item = replay_find(replay, target)) != NULL) item->live = 0;
+        return 0;
+    case MEMORY_WAL_RECORD_UPDATE:
+        if ((item = replay_find(replay, target)) != NULL) {
+            item->entry.timestamp = (time_t)record->timestamp;
+            item->entry.importance = record->importance;
+        }
+        return 0;
+    default:
+        for (size_t i = 0; i < replay->count; i++) replay->items[i].live = 0;
+        return 0;
+    }
+}
+
+/*
+ * Replay the frames of the mapped log
+ * Frames up to the snapshot's last sequence number are skipped. Replay
+ * stops at the first torn or corrupt frame, valid_len receives the length
+ * of the intact prefix.
+ * Returns 0 on success, -1 on failure
+ */
+static int replay_frames(WalReplay* replay) {
+    const char* map = (const char*)replay->log;
+    size_t size = replay->log_size;
+
+    WalFileHeader file_header;
+    memcpy(&file_header, map, sizeof(file_header));
+    if (memcmp(file_header.magic, MEMORY_WAL_MAGIC, sizeof(MEMORY_WAL_MAGIC)) != 0 ||
+        file_header.version < WAL_MIN_VERSION || file_header.version > MEMORY_WAL_VERSION ||
+        file_header.byte_order != MEMORY_SEGMENT_BYTE_ORDER) {
+        return -1;
+    }
+
+    size_t pos = sizeof(WalFileHeader);
+    while (size - pos >= FRAME_HEADER_SIZE) {
+        uint32_t header[2];
+        memcpy(header, map + pos, sizeof(header));
+
+        size_t payload_len = header[0];
+        const char* payload = map + pos + FRAME_HEADER_SIZE;
+        if (payload_len < sizeof(WalRecord) ||
+            payload_len > size - pos - FRAME_HEADER_SIZE ||
+            crc32(payload, payload_len) != header[1]) {
+            break;
+        }
+
+        WalRecord record;
+        memcpy(&record, payload, sizeof(record));
+
+        const char* end = payload + payload_len;
+        const char* cursor = payload + sizeof(record);
+        MemoryEntry entry;
+        memset(&entry, 0, sizeof(entry));
+        uint64_t target = 0;
+
+        if (record.type == MEMORY_WAL_RECORD_ADD) {
+            entry.content = (char*)frame_string(&cursor, end, record.content_length);
+            entry.context = (char*)frame_string(&cursor, end, record.context_length);
+            entry.category = (char*)frame_string(&cursor, end, record.category_length);
+            entry.timestamp = (time_t)record.timestamp;
+            entry.importance = record.importance;
+            if (cursor > end || !entry.content) break;
+        } else if (record.type == MEMORY_WAL_RECORD_REMOVE || record.type == MEMORY_WAL_RECORD_UPDATE) {
+            if ((size_t)(end - cursor) < sizeof(target)) break;
+            memcpy(&target, cursor, sizeof(target));
+        } else if (record.type != MEMORY_WAL_RECORD_CLEAR) {
+            break;
+        }
+
+        if (record.lsn > replay->last_lsn) {
+            if (replay_apply(replay, &record, &entry, target) < 0) return -1;
+            replay->applied++;
+        }
+        if (record.lsn > replay->max_lsn) replay->max_lsn = record.lsn;
+
+        pos += FRAME_HEADER_SIZE + payload_len;
+    }
+
+    replay->valid_len = (off_t)pos;
+    return 0;
+}
+
+/*
+ * Release a replay state and its mappings
+ */
+static void replay_close(WalReplay* replay) {
+    eliza_memory_segment_close(replay->snapshot);
+    if (replay->log) munmap(replay->log, replay->log_size);
+    free(replay->items);
+    free(replay->slots);
+}
+
+/*
+ * Map a log file; a missing or empty one leaves replay->log NULL
+ * Returns 0 on success, -1 on failure
+ */
+static int map_log(WalReplay* replay, const char* path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return errno == ENOENT ? 0 : -1;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return -1;
+    }
+    if ((size_t)st.st_size < sizeof(WalFileHeader)) {
+        close(fd);
+        return 0;
+    }
+
+    void* map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return -1;
+
+    replay->log = map;
+    replay->log_size = (size_t)st.st_size;
+    return 0;
+}
+
+/*
+ * Read the snapshot and a log into a replay state
+ * Entries of snapshots written before ids were kept are numbered from 1
+ * in file order; only their adds were ever logged. A snapshot that exists
+ * but cannot be read fails the replay rather than being taken for an
+ * empty store.
+ * Returns 0 on success, -1 on failure; the state must be closed either way
+ */
+static int replay_open(WalReplay* replay, const char* snapshot_path, const char* log_path) {
+    memset(replay, 0, sizeof(*replay));
+
+    replay->snapshot = eliza_memory_segment_open(snapshot_path);
+    if (!replay->snapshot && access(snapshot_path, F_OK) == 0) return -1;
+
+    replay->last_lsn = eliza_memory_segment_last_lsn(replay->snapshot);
+    replay->max_lsn = replay->last_lsn;
+
+    size_t count = eliza_memory_segment_count(replay->snapshot);
+    for (size_t i = 0; i < count; i++) {
+        MemoryEntry view;
+        uint64_t id = replay->snapshot->ids ? eliza_memory_segment_id(replay->snapshot, i) : i + 1;
+        if (eliza_memory_segment_get(replay->snapshot, i, &view) < 0 ||
+            replay_add(replay, id, &view) < 0) {
+            return -1;
+        }
+    }
+
+    if (map_log(replay, log_path) < 0) return -1;
+    return replay->log ? replay_frames(replay) : 0;
+}
+
+/*
+ * Fold the old log into the snapshot
+ * Only entries still live are written, each with its id so later frames
+ * still find it. The new snapshot carries the last sequence number it
+ * contains, so a crash before the old log is removed does not replay it
+ * twice.
+ */
+static int compact_logs(MemoryWal* wal) {
+    WalReplay replay;
+    if (replay_open(&replay, wal->snapshot_path, wal->old_log_path) < 0) {
+        replay_close(&replay);
+        return -1;
+    }
+
+    MemorySegmentWriter* writer = eliza_memory_segment_writer_open(wal->snapshot_path);
+    if (!writer) {
+        replay_close(&replay);
+        return -1;
+    }
+
+    for (size_t i = 0; i < replay.count; i++) {
+        const WalItem* item = &replay.items[i];
+        if (item->live && eliza_memory_segment_writer_add_id(writer, &item->entry, item->id) < 0) {
+            eliza_memory_segment_writer_abort(writer);
+            replay_close(&replay);
+            return -1;
+        }
+    }
+
+    int result = eliza_memory_segment_writer_finish(writer, replay.max_lsn);
+    replay_close(&replay);
+    if (result < 0) return -1;
+
+    unlink(wal->old_log_path);
+    return 0;
+}
+
+/*
+ * Open the active log for appending, writing a header if it is new
+ */
+static int open_log(MemoryWal* wal, off_t valid_len) {
+    int fd = open(wal->log_path, O_WRONLY | O_CREAT, 0644);
+    if (fd < 0) return -1;
+
+    WalFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MEMORY_WAL_MAGIC, sizeof(MEMORY_WAL_MAGIC));
+    header.version = MEMORY_WAL_VERSION;
+    header.byte_order = MEMORY_SEGMENT_BYTE_ORDER;
+
+    /* Drop a torn tail left by a crash; a log of an older version is
+     * continued under the current one, which can read all its frames */
+    if (valid_len >= (off_t)sizeof(WalFileHeader)) {
+        if (ftruncate(fd, valid_len) != 0 ||
+            pwrite(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header) ||
+            lseek(fd, valid_len, SEEK_SET) < 0) {
+            close(fd);
+            return -1;
+        }
+        wal->log_bytes = (uint64_t)valid_len;
+    } else {
+        if (ftruncate(fd, 0) != 0 ||
+            write(fd, &header, sizeof(header)) != (ssize_t)sizeof(header) ||
+            fdatasync(fd) != 0) {
+            close(fd);
+            return -1;
+        }
+        wal->log_bytes = sizeof(header);
+    }
+
+    wal->fd = fd;
+    return 0;
+}
+
+/*
+ * Write a buffer fully, retrying short writes
+ */
+static int write_all(int fd, const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, data, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+/*
+ * Set deadline to ms milliseconds from now, on the clock of the
+ * condition variables
+ */
+static void deadline_in(struct timespec* deadline, unsigned int ms) {
+    clock_gettime(CLOCK_REALTIME, deadline);
+    deadline->tv_nsec += (long)(ms % 1000) * 1000000L;
+    deadline->tv_sec += ms / 1000 + deadline->tv_nsec / 1000000000L;
+    deadline->tv_nsec %= 1000000000L;
+}
+
+/*
+ * Whether the active log holds frames and has reached compact_interval_ms
+ * Called with the lock held
+ */
+static int log_aged(const MemoryWal* wal) {
+    if (wal->options.compact_interval_ms == 0 || wal->log_bytes <= sizeof(WalFileHeader)) return 0;
+
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    return now.tv_sec > wal->compact_deadline.tv_sec ||
+           (now.tv_sec == wal->compact_deadline.tv_sec && now.tv_nsec >= wal->compact_deadline.tv_nsec);
+}
+
+/*
+ * Move the active log aside and start a new one
+ * Called by the sync thread with the lock held
+ */
+static void rotate_log(MemoryWal* wal) {
+    if (rename(wal->log_path, wal->old_log_path) != 0) return;
+
+    int old_fd = wal->fd;
+    if (open_log(wal, 0) < 0) {
+        /* Keep appending to the renamed file, it is still replayed */
+        wal->fd = old_fd;
+        return;
+    }
+
+    close(old_fd);
+    wal->compact_requested = 0;
+    wal->compact_at = wal->options.compact_bytes;
+    deadline_in(&wal->compact_deadline, wal->options.compact_interval_ms);
+    wal->compacting = 1;
+    pthread_cond_signal(&wal->compact_cond);
+}
+
+/*
+ * Start a due compaction
+ * A log left behind by a failed compaction is folded in first, renaming
+ * the active log over it would lose its frames. A pending request stays
+ * set so the active log follows once that succeeds.
+ * Called by the sync thread with the lock held
+ */
+static void start_compaction(MemoryWal* wal) {
+    if (access(wal->old_log_path, F_OK) == 0) {
+        wal->compacting = 1;
+        pthread_cond_signal(&wal->compact_cond);
+        return;
+    }
+    rotate_log(wal);
+}
+
+/*
+ * Sync thread
+ * Collects frames for up to sync_interval_ms (or until sync_batch frames
+ * are pending), then writes them with a single fdatasync
+ */
+static void* sync_thread_main(void* arg) {
+    MemoryWal* wal = (MemoryWal*)arg;
+    char* batch = NULL;
+    size_t batch_capacity = 0;
+
+    pthread_mutex_lock(&wal->lock);
+    for (;;) {
+        while (wal->running && wal->pending_len == 0 &&
+               !(wal->compact_requested && !wal->compacting)) {
+            /* An idle log is still compacted once it is old enough */
+            if (wal->options.compact_interval_ms > 0 && !wal->compacting &&
+                wal->log_bytes > sizeof(WalFileHeader)) {
+                if (log_aged(wal) ||
+                    pthread_cond_timedwait(&wal->work_cond, &wal->lock, &wal->compact_deadline) == ETIMEDOUT) {
+                    break;
+                }
+            } else {
+                pthread_cond_wait(&wal->work_cond, &wal->lock);
+            }
+        }
+        if (!wal->running && wal->pending_len == 0) break;
+
+        /* Group commit window */
+        if (wal->running && wal->pending_len > 0 && !wal->flush_requested &&
+            wal->pending_records < wal->options.sync_batch) {
+            struct timespec deadline;
+            deadline_in(&deadline, wal->options.sync_interval_ms);
+
+            while (wal->running && wal->pending_records < wal->options.sync_batch &&
+                   !wal->flush_requested) {
+                if (pthread_cond_timedwait(&wal->work_cond, &wal->lock, &deadline) == ETIMEDOUT) break;
+            }
+        }
+
+        /* Take the pending frames, leaving the spare buffer for appenders */
+        char* frames = wal->pending;
+        size_t frames_len = wal->pending_len;
+        size_t frames_capacity = wal->pending_capacity;
+        uint64_t batch_lsn = wal->next_lsn - 1;
+
+        wal->pending = batch;
+        wal->pending_capacity = batch_capacity;
+        wal->pending_len = 0;
+        wal->pending_records = 0;
+        wal->flush_requested = 0;
+        batch = frames;
+        batch_capacity = frames_capacity;
+        int fd = wal->fd;
+        pthread_mutex_unlock(&wal->lock);
+
+        int ok = frames_len == 0 ||
+                 (write_all(fd, frames, frames_len) == 0 && fdatasync(fd) == 0);
+
+        pthread_mutex_lock(&wal->lock);
+        if (ok) {
+            wal->synced_lsn = batch_lsn;
+            wal->log_bytes += frames_len;
+            wal->stats.bytes_written += frames_len;
+            if (frames_len > 0) wal->stats.syncs++;
+        } else {
+            wal->failed = 1;
+        }
+        pthread_cond_broadcast(&wal->synced_cond);
+
+        if (wal->running && !wal->compacting) {
+            /* The age restarts even if the log cannot be moved aside, so
+             * a failing rotation is not retried in a tight loop */
+            int aged = log_aged(wal);
+            if (aged) deadline_in(&wal->compact_deadline, wal->options.compact_interval_ms);
+            if (aged || wal->compact_requested || wal->log_bytes >= wal->compact_at) start_compaction(wal);
+        }
+    }
+    pthread_mutex_unlock(&wal->lock);
+
+    free(batch);
+    return NULL;
+}
+
+/*
+ * Compaction thread
+ */
+static void* compact_thread_main(void* arg) {
+    MemoryWal* wal = (MemoryWal*)arg;
+
+    pthread_mutex_lock(&wal->lock);
+    for (;;) {
+        while (wal->running && !wal->compacting) {
+            pthread_cond_wait(&wal->compact_cond, &wal->lock);
+        }
+        if (!wal->compacting) break;
+        pthread_mutex_unlock(&wal->lock);
+
+        int result = compact_logs(wal);
+
+        pthread_mutex_lock(&wal->lock);
+        wal->compacting = 0;
+        if (result == 0) {
+            wal->stats.compactions++;
+            wal->compact_at = wal->options.compact_bytes;
+        } else {
+            /* The old log stays and is retried once another compaction is
+             * due, rather than on every group commit */
+            wal->stats.compact_failures++;
+            wal->compact_requested = 0;
+            wal->compact_at = wal->log_bytes + wal->options.compact_bytes;
+        }
+
+        /* A compaction requested meanwhile, or a log that aged meanwhile,
+         * is picked up by the sync thread */
+        pthread_cond_signal(&wal->work_cond);
+    }
+    pthread_mutex_unlock(&wal->lock);
+
+    return NULL;
+}
+
+/*
+ * Free a WAL that has no running threads
+ */
+static void free_wal(MemoryWal* wal) {
+    if (wal->fd >= 0) close(wal->fd);
+    free(wal->pending);
+    free(wal->ids);
+    free(wal->snapshot_path);
+    free(wal->log_path);
+    free(wal->old_log_path);
+    free(wal);
+}
+
+/*
+ * Add the live entries of a replay to an empty store
+ * The WAL is attached while restoring so each entry's position is
+ * recorded under its id, but nothing is logged. Cold entries were never
+ * logged, so the tier is detached to keep its segments through the clear
+ * and to hold off migrating until the replay is in
+ * Returns 0 on success, -1 on failure
+ */
+static int restore_store(MemoryWal* wal, const WalReplay* replay) {
+    MemoryStore* store = wal->store;
+    struct MemoryTier* tier = store->tier;
+    struct MemoryDedup* dedup = store->dedup;
+    /* Logged entries were deduplicated when they were first added, and
+     * merging them again would change what the log says */
+    store->tier = NULL;
+    store->dedup = NULL;
+    eliza_memory_clear(store);
+
+    store->wal = wal;
+    wal->replaying = 1;
+    int result = 0;
+    for (size_t i = 0; i < replay->count && result == 0; i++) {
+        const WalItem* item = &replay->items[i];
+        if (!item->live) continue;
+        wal->replay_id = item->id;
+        result = eliza_memory_add_copy(store, &item->entry);
+    }
+    wal->replaying = 0;
+    store->wal = NULL;
+    store->tier = tier;
+    store->dedup = dedup;
+    if (dedup && eliza_memory_dedup_track(dedup, store) < 0) result = -1;
+    return result;
+}
+
+/*
+ * Load the snapshot, replay the logs and attach a new WAL to the store
+ */
+MemoryWal* eliza_memory_wal_open(MemoryStore* store, const char* filepath,
+                                const MemoryWalOptions* options) {
+    if (!store || !filepath || store->wal) return NULL;
+
+    MemoryWal* wal = (MemoryWal*)calloc(1, sizeof(MemoryWal));
+    if (!wal) return NULL;
+
+    wal->store = store;
+    wal->fd = -1;
+    if (options) wal->options = *options;
+    else eliza_memory_wal_options_default(&wal->options);
+    if (wal->options.sync_batch == 0) wal->options.sync_batch = 1;
+
+    wal->snapshot_path = strdup(filepath);
+    wal->log_path = path_with_suffix(filepath, ".wal");
+    wal->old_log_path = path_with_suffix(filepath, ".wal.old");
+    if (!wal->snapshot_path || !wal->log_path || !wal->old_log_path) {
+        free_wal(wal);
+        return NULL;
+    }
+
+    /* Finish a compaction interrupted by a crash */
+    if (access(wal->old_log_path, F_OK) == 0 && compact_logs(wal) < 0) {
+        free_wal(wal);
+        return NULL;
+    }
+
+    /* Rebuild the store from the snapshot and the active log */
+    WalReplay replay;
+    if (replay_open(&replay, wal->snapshot_path, wal->log_path) < 0 ||
+        restore_store(wal, &replay) < 0 || open_log(wal, replay.valid_len) < 0) {
+        replay_close(&replay);
+        free_wal(wal);
+        return NULL;
+    }
+
+    wal->stats.replayed = (uint64_t)replay.applied;
+    wal->compact_at = wal->options.compact_bytes;
+    deadline_in(&wal->compact_deadline, wal->options.compact_interval_ms);
+    wal->next_lsn = replay.max_lsn + 1;
+    wal->synced_lsn = replay.max_lsn;
+    wal->running = 1;
+    replay_close(&replay);
+
+    pthread_mutex_init(&wal->lock, NULL);
+    pthread_cond_init(&wal->work_cond, NULL);
+    pthread_cond_init(&wal->synced_cond, NULL);
+    pthread_cond_init(&wal->compact_cond, NULL);
+
+    if (pthread_create(&wal->sync_thread, NULL, sync_thread_main, wal) != 0) {
+        free_wal(wal);
+        return NULL;
+    }
+    if (pthread_create(&wal->compact_thread, NULL, compact_thread_main, wal) != 0) {
+        pthread_mutex_lock(&wal->lock);
+        wal->running = 0;
+        pthread_cond_signal(&wal->work_cond);
+        pthread_mutex_unlock(&wal->lock);
+        pthread_join(wal->sync_thread, NULL);
+        free_wal(wal);
+        return NULL;
+    }
+
+    store->wal = wal;
+    return wal;
+}
+
+/*
+ * Flush, stop the threads and detach the WAL
+ */
+void eliza_memory_wal_close(MemoryWal* wal) {
+    if (!wal) return;
+
+    pthread_mutex_lock(&wal->lock);
+    wal->running = 0;
+    pthread_cond_broadcast(&wal->work_cond);
+    pthread_cond_broadcast(&wal->compact_cond);
+    pthread_mutex_unlock(&wal->lock);
+
+    /* The sync thread drains pending frames before exiting */
+    pthread_join(wal->sync_thread, NULL);
+    pthread_join(wal->compact_thread, NULL);
+
+    pthread_mutex_destroy(&wal->lock);
+    pthread_cond_destroy(&wal->work_cond);
+    pthread_cond_destroy(&wal->synced_cond);
+    pthread_cond_destroy(&wal->compact_cond);
+
+    if (wal->store && wal->store->wal == wal) wal->store->wal = NULL;
+    free_wal(wal);
+}
+
+/*
+ * Make room for the id of the entry at position
+ * Returns 0 on success, -1 on failure
+ */
+static int reserve_ids(MemoryWal* wal, size_t position) {
+    if (position < wal->ids_capacity) return 0;
+
+    size_t capacity = wal->ids_capacity ? wal->ids_capacity : 1024;
+    while (capacity <= position) capacity *= 2;
+    uint64_t* ids = (uint64_t*)realloc(wal->ids, capacity * sizeof(uint64_t));
+    if (!ids) return -1;
+
+    wal->ids = ids;
+    wal->ids_capacity = capacity;
+    return 0;
+}
+
+/*
+ * Queue a frame for the sync thread
+ * Returns its sequence number, or 0 on failure
+ */
+static uint64_t log_frame(MemoryWal* wal, uint32_t type, const MemoryEntry* entry, uint64_t target) {
+    pthread_mutex_lock(&wal->lock);
+    if (wal->failed || encode_frame(wal, type, entry, target, wal->next_lsn) < 0) {
+        pthread_mutex_unlock(&wal->lock);
+        return 0;
+    }
+
+    uint64_t lsn = wal->next_lsn++;
+    wal->stats.records++;
+
+    /* Wake the sync thread to open a window, or to flush a full batch */
+    if (++wal->pending_records == 1 || wal->pending_records >= wal->options.sync_batch) {
+        pthread_cond_signal(&wal->work_cond);
+    }
+    pthread_mutex_unlock(&wal->lock);
+    return lsn;
+}
+
+/*
+ * Append an entry to the log
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_wal_append(MemoryWal* wal, const MemoryEntry* entry, size_t position) {
+    if (!wal || !entry || !entry->content) return -1;
+    if (reserve_ids(wal, position) < 0) return -1;
+
+    if (wal->replaying) {
+        wal->ids[position] = wal->replay_id;
+        return 0;
+    }
+
+    uint64_t lsn = log_frame(wal, MEMORY_WAL_RECORD_ADD, entry, 0);
+    if (lsn == 0) return -1;
+    wal->ids[position] = lsn;
+    return 0;
+}
+
+/*
+ * Log the removal of the entry at position
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_wal_remove(MemoryWal* wal, size_t position) {
+    if (!wal || position >= wal->ids_capacity) return -1;
+    if (wal->replaying) return 0;
+
+    return log_frame(wal, MEMORY_WAL_RECORD_REMOVE, NULL, wal->ids[position]) ? 0 : -1;
+}
+
+/*
+ * Log a new importance and timestamp for the entry at position
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_wal_update(MemoryWal* wal, size_t position, float importance, time_t timestamp) {
+    if (!wal || position >= wal->ids_capacity) return -1;
+    if (wal->replaying) return 0;
+
+    MemoryEntry fields = { NULL, timestamp, importance, NULL, NULL };
+    return log_frame(wal, MEMORY_WAL_RECORD_UPDATE, &fields, wal->ids[position]) ? 0 : -1;
+}
+
+/*
+ * Log the removal of every entry
+ * Returns 0 on success, -1 on failure
+ */
+int eliza_memory_wal_clear(MemoryWal* wal) {
+    if (!wal) return -1;
+    if (wal->replaying) return 0;
+
+    return log_frame(wal, MEMORY_WAL_RECORD_CLEAR, NULL, 0) ? 0 : -1;
+}
+
+/*
+ * Renumber the entry ids after the store is compacted
+ */
+void eliza_memory_wal_remap(MemoryWal* wal, const uint32_t* map, size_t count) {
+    if (!wal || !map) return;
+
+    /* New positions never exceed old ones, so ids move front to back */
+    for (size_t i = 0; i < count && i < wal->ids_capacity; i++) {
+        if (map[i] != MEMORY_ID_REMOVED) wal->ids[map[i]] = wal->ids[i];
+    }
+}
+
+/*
+ * Block until every appended frame is durable
+ * Returns 0 on success, -1 if the log could not be written
+ */
+int eliza_memory_wal_sync(MemoryWal* wal) {
+    if (!wal) return -1;
+
+    pthread_mutex_lock(&wal->lock);
+    uint64_t target = wal->next_lsn - 1;
+    wal->flush_requested = 1;
+    pthread_cond_signal(&wal->work_cond);
+
+    while (wal->synced_lsn < target && !wal->failed) {
+        pthread_cond_wait(&wal->synced_cond, &wal->lock);
+    }
+    int result = wal->failed ? -1 : 0;
+    pthread_mutex_unlock(&wal->lock);
+
+    return result;
+}
+
+/*
+ * Request a compaction at the next opportunity
+ */
+void eliza_memory_wal_compact(MemoryWal* wal) {
+    if (!wal) return;
+
+    pthread_mutex_lock(&wal->lock);
+    wal->compact_requested = 1;
+    pthread_cond_signal(&wal->work_cond);
+    pthread_mutex_unlock(&wal->lock);
+}
+
+/*
+ * Copy the current statistics
+ */
+void eliza_memory_wal_get_stats(MemoryWal* wal, MemoryWalStats* stats) {
+    if (!wal || !stats) return;
+
+    pthread_mutex_lock(&wal->lock);
+    *stats = wal->stats;
+    pthread_mutex_unlock(&wal->lock);
+}